@@ -2,6 +2,7 @@
 #include "Simulation.h"
 #include "ClimateData.h"
 #include "Cells/DebugCell.h"
+#include "Util/SnowOutputRecord.h"
 
 
 #define NUM_THREADS_PER_GROUP_DIMENSION 4 // This has to be the same as in the compute shaders spec [X, X, 1]
@@ -29,6 +30,16 @@ void FSimulationComputeShader::Initialize(
 {
 	NumCells = Cells.Num();
 
+	// Fill constant parameters
+	ConstantParameters = CreateConstantParameters(k_e, k_m, TMeltA, TMeltB, TSnowA, TSnowB, CellsDimensionX, CellsDimensionY, MeasurementAltitude);
+
+	if (!RecordDirectory.IsEmpty())
+	{
+		// Record the input before the buffers take over the resource arrays, so the records can be replayed on the CPU
+		SaveComputeShaderInputRecord(GetComputeShaderInputRecordPath(RecordDirectory), static_cast<uint32>(InitialMaxSnow), ConstantParameters,
+			Cells.GetData(), Cells.Num(), ClimateData.GetData(), ClimateData.Num());
+	}
+
 	// Create output texture
 	FRHIResourceCreateInfo CreateInfo;
 	Texture = RHICreateTexture2D(CellsDimensionX, CellsDimensionY, PF_R32_UINT, 1, 1, TexCreate_ShaderResource | TexCreate_UAV, CreateInfo);
@@ -50,22 +61,27 @@ void FSimulationComputeShader::Initialize(
 	SnowOutputBuffer = new FRWStructuredBuffer();
 	SnowOutputBuffer->Initialize(sizeof(float), CellsDimensionX * CellsDimensionY, nullptr, 0, true, false);
 
-	// Fill constant parameters
-	ConstantParameters.CellsDimensionX = CellsDimensionX;
-	ConstantParameters.ThreadGroupCountX = Texture->GetSizeX() / NUM_THREADS_PER_GROUP_DIMENSION;
-	ConstantParameters.ThreadGroupCountY = Texture->GetSizeY() / NUM_THREADS_PER_GROUP_DIMENSION;
-	ConstantParameters.k_e = k_e;
-	ConstantParameters.k_m = k_m;
-	ConstantParameters.TMeltA = TMeltA;
-	ConstantParameters.TMeltB = TMeltB;
-	ConstantParameters.TSnowA = TSnowA;
-	ConstantParameters.TSnowB = TSnowB;
-	ConstantParameters.MeasurementAltitude = MeasurementAltitude;
-
 	VariableParameters = FComputeShaderVariableParameters();
 }
 
-void FSimulationComputeShader::ExecuteComputeShader(int CurrentTimeStep, int32 Timesteps, int HourOfDay, bool CaptureDebugInformation, TArray<FDebugCell>& CellDebugInformation)
+FComputeShaderConstantParameters FSimulationComputeShader::CreateConstantParameters(float k_e, float k_m, float TMeltA, float TMeltB, float TSnowA, float TSnowB,
+	int32 CellsDimensionX, int32 CellsDimensionY, float MeasurementAltitude)
+{
+	FComputeShaderConstantParameters Parameters;
+	Parameters.CellsDimensionX = CellsDimensionX;
+	Parameters.ThreadGroupCountX = CellsDimensionX / NUM_THREADS_PER_GROUP_DIMENSION;
+	Parameters.ThreadGroupCountY = CellsDimensionY / NUM_THREADS_PER_GROUP_DIMENSION;
+	Parameters.k_e = k_e;
+	Parameters.k_m = k_m;
+	Parameters.TMeltA = TMeltA;
+	Parameters.TMeltB = TMeltB;
+	Parameters.TSnowA = TSnowA;
+	Parameters.TSnowB = TSnowB;
+	Parameters.MeasurementAltitude = MeasurementAltitude;
+	return Parameters;
+}
+
+void FSimulationComputeShader::ExecuteComputeShader(int CurrentTimeStep, int32 Timesteps, int DayOfYear, int HourOfDay, bool CaptureDebugInformation, TArray<FDebugCell>& CellDebugInformation)
 {
 	// Skip this execution round if we are already executing
 	if (IsUnloading || IsComputeShaderExecuting) return;
@@ -73,6 +89,7 @@ void FSimulationComputeShader::ExecuteComputeShader(int CurrentTimeStep, int32 T
 	IsComputeShaderExecuting = true;
 
 	// Set the variable parameters
+	VariableParameters.DayOfYear = DayOfYear;
 	VariableParameters.HourOfDay = HourOfDay;
 	VariableParameters.CurrentSimulationStep = CurrentTimeStep;
 	VariableParameters.Timesteps = Timesteps;
@@ -153,6 +170,18 @@ void FSimulationComputeShader::ExecuteComputeShaderInternal(bool CaptureDebugInf
 	MaxSnow = MaxSnowArray[0] / 100000.0f;
 	UE_LOG(SnowComputeShader, Display, TEXT("Max snow \"%f\""), MaxSnow);
 
+	if (!RecordDirectory.IsEmpty())
+	{
+		// Record the output for the comparison with the CPU execution of the compute shader
+		TArray<float> SnowArray;
+		SnowArray.AddUninitialized(NumCells);
+		float* SnowBuffer = (float*)RHICmdList.LockStructuredBuffer(SnowOutputBuffer->Buffer, 0, SnowOutputBuffer->NumBytes, RLM_ReadOnly);
+		FMemory::Memcpy(SnowArray.GetData(), SnowBuffer, SnowOutputBuffer->NumBytes);
+		RHICmdList.UnlockStructuredBuffer(SnowOutputBuffer->Buffer);
+
+		SaveSnowOutputRecord(GetSnowOutputRecordPath(RecordDirectory, VariableParameters.CurrentSimulationStep), VariableParameters, MaxSnowArray[0], SnowArray);
+	}
+
 	ComputeShader->UnbindBuffers(RHICmdList);
 	IsComputeShaderExecuting = false;
 
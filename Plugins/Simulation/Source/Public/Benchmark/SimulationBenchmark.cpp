@@ -0,0 +1,1517 @@
+#include "Simulation.h"
+#include "SimulationBenchmark.h"
+#include "SnowSimulationActor.h"
+#include "Cells/SimulationCellStore.h"
+#include "DegreeDay/CPU/DegreeDayCPUKernel.h"
+#include "DegreeDay/CPU/DegreeDayEnsembleKernel.h"
+#include "DegreeDay/CPU/ComputeShaderCPUKernel.h"
+#include "DegreeDay/CPU/DegreeDayCompactCPUSimulation.h"
+#include "DegreeDay/CPU/DegreeDayMultiResolutionCPUSimulation.h"
+#include "DegreeDay/CPU/TemporalTileScheduler.h"
+#include "DegreeDay/CPU/SnowRedistribution.h"
+#include "DegreeDay/CPU/WindTransport.h"
+#include "EnergyBalance/EnergyBalanceKernel.h"
+#include "EnergyBalance/SnowpackKernel.h"
+#include "Cells/CompactCellStore.h"
+#include "Cells/CellQuadtree.h"
+#include "Cells/MultiResolutionGrid.h"
+#include "Radiation/SolarRadiation.h"
+#include "Radiation/SolarRadiationTable.h"
+#include "Radiation/FactoredSolarRadiation.h"
+#include "Util/SnowOutputRecord.h"
+#include "ParallelFor.h"
+
+void FSimulationBenchmark::CreateTerrain(int32 DimensionX, int32 DimensionY, TArray<FLandscapeCell>& OutCells, float LatitudeSpan)
+{
+	FRandomStream Random(1337);
+
+	const float CellSize = 1000.0f; // cm
+	OutCells.Empty(DimensionX * DimensionY);
+
+	int32 Index = 0;
+	for (int32 Y = 0; Y < DimensionY; ++Y)
+	{
+		const float Latitude = FMath::DegreesToRadians(47 + LatitudeSpan * Y / FMath::Max(1, DimensionY - 1));
+
+		for (int32 X = 0; X < DimensionX; ++X)
+		{
+			const float Altitude = (1500 + 900 * FMath::Sin(X * 0.02f) * FMath::Cos(Y * 0.015f) + Random.FRandRange(-50, 50)) * 100;
+			const float Inclination = FMath::DegreesToRadians(Random.FRandRange(0, 50));
+			const float Aspect = Random.FRandRange(0, 2 * PI);
+			const float AreaXY = CellSize * CellSize;
+			const float Area = AreaXY / FMath::Cos(Inclination);
+
+			FVector P1(X * CellSize, Y * CellSize, Altitude);
+			FVector P2 = P1 + FVector(CellSize, 0, 0);
+			FVector P3 = P1 + FVector(0, CellSize, 0);
+			FVector P4 = P1 + FVector(CellSize, CellSize, 0);
+			FVector Normal(FMath::Sin(Inclination) * FMath::Cos(Aspect), FMath::Sin(Inclination) * FMath::Sin(Aspect), FMath::Cos(Inclination));
+			FVector Centroid = (P1 + P4) / 2;
+
+			FLandscapeCell Cell(Index, P1, P2, P3, P4, Normal, Area, AreaXY, Centroid, Altitude, Aspect, Inclination, Latitude, 0.0f);
+			Cell.Curvature = Random.FRandRange(-0.005f, 0.005f);
+			OutCells.Add(Cell);
+
+			Index++;
+		}
+	}
+}
+
+void FSimulationBenchmark::CreateValleyTerrain(int32 DimensionX, int32 DimensionY, TArray<FLandscapeCell>& OutCells)
+{
+	FRandomStream Random(1337);
+
+	const float CellSize = 1000.0f; // cm
+	const float SlopeInclination = FMath::DegreesToRadians(25);
+	const float Latitude = FMath::DegreesToRadians(47);
+	OutCells.Empty(DimensionX * DimensionY);
+
+	int32 Index = 0;
+	for (int32 Y = 0; Y < DimensionY; ++Y)
+	{
+		for (int32 X = 0; X < DimensionX; ++X)
+		{
+			// Distance from the center line of the valley in cells
+			const float Center = (DimensionX - 1) / 2.0f;
+			const float Distance = FMath::Abs(X - Center);
+			const float FloorHalfWidth = DimensionX / 6.0f;
+			const float SlopeEnd = DimensionX * 0.4f;
+
+			float Altitude = 1200 * 100;
+			float Inclination = 0;
+			float Aspect = 0;
+			float Curvature = 0;
+
+			if (Distance > FloorHalfWidth)
+			{
+				// The slopes face the valley floor
+				Altitude += (FMath::Min(Distance, SlopeEnd) - FloorHalfWidth) * CellSize * FMath::Tan(SlopeInclination);
+				Inclination = SlopeInclination;
+				Aspect = X < Center ? PI / 2 : 3 * PI / 2;
+			}
+			if (Distance > SlopeEnd)
+			{
+				Altitude += Random.FRandRange(0, 200) * 100;
+				Inclination = FMath::DegreesToRadians(Random.FRandRange(20, 60));
+				Aspect = Random.FRandRange(0, 2 * PI);
+				Curvature = Random.FRandRange(-0.005f, 0.005f);
+			}
+
+			const float AreaXY = CellSize * CellSize;
+			const float Area = AreaXY / FMath::Cos(Inclination);
+
+			FVector P1(X * CellSize, Y * CellSize, Altitude);
+			FVector P2 = P1 + FVector(CellSize, 0, 0);
+			FVector P3 = P1 + FVector(0, CellSize, 0);
+			FVector P4 = P1 + FVector(CellSize, CellSize, 0);
+			FVector Normal(FMath::Sin(Inclination) * FMath::Cos(Aspect), FMath::Sin(Inclination) * FMath::Sin(Aspect), FMath::Cos(Inclination));
+			FVector Centroid = (P1 + P4) / 2;
+
+			FLandscapeCell Cell(Index, P1, P2, P3, P4, Normal, Area, AreaXY, Centroid, Altitude, Aspect, Inclination, Latitude, 0.0f);
+			Cell.Curvature = Curvature;
+			OutCells.Add(Cell);
+
+			Index++;
+		}
+	}
+}
+
+void FSimulationBenchmark::CreateClimate(int32 Hours, TArray<FClimateData>& OutClimateData)
+{
+	FRandomStream Random(4711);
+
+	OutClimateData.Empty(Hours);
+
+	bool Wet = false;
+	for (int32 Hour = 0; Hour < Hours; ++Hour)
+	{
+		// The series starts on the first of october, the coldest day is in the middle of january
+		const float DayOfYear = Hour / 24.0f + 274;
+		const float SeasonalTemperature = -10 * FMath::Cos((DayOfYear - 15) * 2 * PI / 365.0f);
+		const float DiurnalTemperature = -4 * FMath::Cos(((Hour % 24) - 3) * 2 * PI / 24.0f);
+
+		// Two state markov chain for wet and dry hours
+		Wet = Random.FRand() < (Wet ? 0.75f : 0.05f);
+		const float Precipitation = Wet ? Random.FRandRange(0.2f, 2.5f) : 0.0f;
+
+		OutClimateData.Add(FClimateData(Precipitation, 5 + SeasonalTemperature + DiurnalTemperature));
+	}
+}
+
+/** Returns the forcing of the given hour of the synthetic climate series. */
+static FDegreeDayForcing GetBenchmarkForcing(const TArray<FClimateData>& ClimateData, int32 Hour)
+{
+	FDegreeDayForcing Forcing;
+	Forcing.Temperature = ClimateData[Hour].Temperature;
+	Forcing.Precipitation = ClimateData[Hour].Precipitation;
+	Forcing.MeasurementAltitude = FSimulationBenchmark::GetMeasurementAltitude();
+	Forcing.DayOfYear = (FDateTime(2015, 10, 1) + FTimespan(Hour, 0, 0)).GetDayOfYear();
+	return Forcing;
+}
+
+/**
+* Runs the scalar and the vectorized degree day kernel on the same cells and compares the results after every hour. The
+* vector cells continue from the state of the scalar cells, so every hour is checked against the relative tolerance of a
+* single hour and the error cannot accumulate.
+*/
+static void ValidateVectorKernel(const TArray<FString>& Args)
+{
+	const int32 DimensionX = FSimulationBenchmark::GetArgument(Args, 0, 256);
+	const int32 DimensionY = FSimulationBenchmark::GetArgument(Args, 1, 256);
+	const int32 Hours = FSimulationBenchmark::GetArgument(Args, 2, 24 * 180);
+
+	TArray<FLandscapeCell> LandscapeCells;
+	FSimulationBenchmark::CreateTerrain(DimensionX, DimensionY, LandscapeCells);
+
+	TArray<FClimateData> ClimateData;
+	FSimulationBenchmark::CreateClimate(Hours, ClimateData);
+
+	FSimulationCellStore ScalarCells;
+	FSimulationCellStore VectorCells;
+	ScalarCells.Initialize(LandscapeCells, DimensionX, DimensionY);
+	VectorCells.Initialize(LandscapeCells, DimensionX, DimensionY);
+
+	const int32 NumCells = LandscapeCells.Num();
+	const FDegreeDayParameters Parameters;
+
+	// The stated tolerance of the vector kernel is a relative error of 1e-5 per hour
+	const float Tolerance = 1e-5f;
+
+	float MaxAbsoluteError = 0;
+	float MaxRelativeError = 0;
+	int32 NumHoursOutsideTolerance = 0;
+	int32 FirstHourOutsideTolerance = -1;
+
+	double ScalarSeconds = 0;
+	double VectorSeconds = 0;
+	for (int32 Hour = 0; Hour < Hours; ++Hour)
+	{
+		const FDegreeDayForcing Forcing = GetBenchmarkForcing(ClimateData, Hour);
+
+		double StartSeconds = FPlatformTime::Seconds();
+		FDegreeDayCPUKernel::SimulateScalar(FDegreeDayCellRange(ScalarCells, 0, NumCells), Parameters, Forcing);
+		ScalarSeconds += FPlatformTime::Seconds() - StartSeconds;
+
+		StartSeconds = FPlatformTime::Seconds();
+		FDegreeDayCPUKernel::SimulateVector(FDegreeDayCellRange(VectorCells, 0, NumCells), Parameters, Forcing);
+		VectorSeconds += FPlatformTime::Seconds() - StartSeconds;
+
+		float HourMaxRelativeError = 0;
+		for (int32 Index = 0; Index < NumCells; ++Index)
+		{
+			const float AbsoluteError = FMath::Abs(ScalarCells.SnowWaterEquivalent[Index] - VectorCells.SnowWaterEquivalent[Index]);
+			const float RelativeError = AbsoluteError / FMath::Max(FMath::Abs(ScalarCells.SnowWaterEquivalent[Index]), 1.0f);
+
+			MaxAbsoluteError = FMath::Max(MaxAbsoluteError, AbsoluteError);
+			HourMaxRelativeError = FMath::Max(HourMaxRelativeError, RelativeError);
+		}
+
+		MaxRelativeError = FMath::Max(MaxRelativeError, HourMaxRelativeError);
+		if (HourMaxRelativeError > Tolerance)
+		{
+			NumHoursOutsideTolerance++;
+			if (FirstHourOutsideTolerance < 0) FirstHourOutsideTolerance = Hour;
+		}
+
+		// The next hour starts from the state of the scalar kernel
+		VectorCells.SnowWaterEquivalent = ScalarCells.SnowWaterEquivalent;
+		VectorCells.InterpolatedSnowWaterEquivalent = ScalarCells.InterpolatedSnowWaterEquivalent;
+		VectorCells.SnowAlbedo = ScalarCells.SnowAlbedo;
+		VectorCells.DaysSinceLastSnowfall = ScalarCells.DaysSinceLastSnowfall;
+	}
+
+	if (NumHoursOutsideTolerance > 0)
+	{
+		UE_LOG(SimulationLog, Error, TEXT("Vector kernel validation FAILED: %d of %d hours outside the relative tolerance of %e from hour %d, max relative error %e, max absolute SWE error %f l"),
+			NumHoursOutsideTolerance, Hours, Tolerance, FirstHourOutsideTolerance, MaxRelativeError, MaxAbsoluteError);
+	}
+	else
+	{
+		UE_LOG(SimulationLog, Display, TEXT("Vector kernel validation passed: %d cells, %d hours within the relative tolerance of %e, max relative error %e, max absolute SWE error %f l"),
+			NumCells, Hours, Tolerance, MaxRelativeError, MaxAbsoluteError);
+	}
+	UE_LOG(SimulationLog, Display, TEXT("Scalar kernel took %f ms, vector kernel took %f ms (%.2fx)"),
+		ScalarSeconds * 1000, VectorSeconds * 1000, ScalarSeconds / FMath::Max(VectorSeconds, 1e-9));
+}
+
+static FAutoConsoleCommand ValidateVectorKernelCommand(
+	TEXT("Simulation.ValidateVectorKernel"),
+	TEXT("Compares the vectorized degree day kernel with the scalar kernel. Arguments: [CellsX] [CellsY] [Hours]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&ValidateVectorKernel));
+
+/** Compares the evaluations of the solar radiation index. */
+static void BenchmarkRadiation(const TArray<FString>& Args)
+{
+	const int32 DimensionX = FSimulationBenchmark::GetArgument(Args, 0, 256);
+	const int32 DimensionY = FSimulationBenchmark::GetArgument(Args, 1, 256);
+	const int32 Days = FMath::Clamp(FSimulationBenchmark::GetArgument(Args, 2, 30), 1, FSolarRadiationTable::NumDays);
+	const float LatitudeSpan = FSimulationBenchmark::GetArgument(Args, 3, 2);
+
+	TArray<FLandscapeCell> LandscapeCells;
+	FSimulationBenchmark::CreateTerrain(DimensionX, DimensionY, LandscapeCells, LatitudeSpan);
+
+	FSimulationCellStore Cells;
+	Cells.Initialize(LandscapeCells, DimensionX, DimensionY);
+
+	const int32 NumCells = Cells.Num();
+	FAlignedFloatArray Direct;
+	FAlignedFloatArray Factored;
+	Direct.SetNumUninitialized(NumCells);
+	Factored.SetNumUninitialized(NumCells);
+
+	double StartSeconds = FPlatformTime::Seconds();
+	FFactoredSolarRadiation FactoredRadiation;
+	FactoredRadiation.Initialize(Cells);
+	const double FactoredInitializeSeconds = FPlatformTime::Seconds() - StartSeconds;
+
+	double DirectSeconds = 0;
+	double FactoredSeconds = 0;
+	float MaxError = 0;
+	for (int32 Day = 1; Day <= Days; ++Day)
+	{
+		// Spread the days over the year
+		const int32 DayOfYear = 1 + (Day - 1) * FSolarRadiationTable::NumDays / Days;
+
+		StartSeconds = FPlatformTime::Seconds();
+		for (int32 Index = 0; Index < NumCells; ++Index)
+		{
+			Direct[Index] = FSolarRadiation::SolarRadiationIndex(Cells.Inclination[Index], Cells.Aspect[Index], Cells.Latitude[Index], DayOfYear);
+		}
+		DirectSeconds += FPlatformTime::Seconds() - StartSeconds;
+
+		StartSeconds = FPlatformTime::Seconds();
+		FFactoredSolarRadiation::FDay FactoredDay;
+		FactoredRadiation.ComputeDay(DayOfYear, FactoredDay);
+		FactoredRadiation.Evaluate(FactoredDay, 0, NumCells, Factored.GetData());
+		FactoredSeconds += FPlatformTime::Seconds() - StartSeconds;
+
+		for (int32 Index = 0; Index < NumCells; ++Index)
+		{
+			MaxError = FMath::Max(MaxError, FMath::Abs(Direct[Index] - Factored[Index]));
+		}
+	}
+
+	const double Evaluations = static_cast<double>(NumCells) * Days;
+
+	UE_LOG(SimulationLog, Display, TEXT("Radiation: %d cells, %d days, %d latitudes"), NumCells, Days, FactoredRadiation.GetNumLatitudes());
+	UE_LOG(SimulationLog, Display, TEXT("Direct evaluation took %f ns per cell and day"), DirectSeconds * 1e9 / Evaluations);
+	UE_LOG(SimulationLog, Display, TEXT("Factored evaluation took %f ns per cell and day (%.2fx), %f ms to initialize and uses %.2f MB, max absolute error %e"),
+		FactoredSeconds * 1e9 / Evaluations, DirectSeconds / FMath::Max(FactoredSeconds, 1e-9), FactoredInitializeSeconds * 1000,
+		FactoredRadiation.GetAllocatedSize() / (1024.0f * 1024.0f), MaxError);
+}
+
+static FAutoConsoleCommand BenchmarkRadiationCommand(
+	TEXT("Simulation.BenchmarkRadiation"),
+	TEXT("Compares the direct and the factored evaluation of the solar radiation index. Arguments: [CellsX] [CellsY] [Days] [LatitudeSpan]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkRadiation));
+
+/** Compares the ensemble kernel with separate runs of the vectorized kernel for every member. */
+static void BenchmarkEnsemble(const TArray<FString>& Args)
+{
+	const int32 DimensionX = FSimulationBenchmark::GetArgument(Args, 0, 128);
+	const int32 DimensionY = FSimulationBenchmark::GetArgument(Args, 1, 128);
+	const int32 Hours = FSimulationBenchmark::GetArgument(Args, 2, 24 * 30);
+	const int32 NumMembers = FMath::Max(1, FSimulationBenchmark::GetArgument(Args, 3, 8));
+
+	TArray<FLandscapeCell> LandscapeCells;
+	FSimulationBenchmark::CreateTerrain(DimensionX, DimensionY, LandscapeCells);
+
+	TArray<FClimateData> ClimateData;
+	FSimulationBenchmark::CreateClimate(Hours, ClimateData);
+
+	FSimulationCellStore Cells;
+	Cells.Initialize(LandscapeCells, DimensionX, DimensionY);
+
+	FSolarRadiationTable RadiationTable;
+	RadiationTable.Build(Cells, 1);
+
+	// Members around the default parameters
+	TArray<FDegreeDayParameters> Parameters;
+	for (int32 Member = 0; Member < NumMembers; ++Member)
+	{
+		FDegreeDayParameters MemberParameters;
+		MemberParameters.k_m = 2 + 4.0f * Member / NumMembers;
+		MemberParameters.TMeltA = -6 + 2.0f * (Member % 3);
+		MemberParameters.TSnowB = 1 + (Member % 2);
+		Parameters.Add(MemberParameters);
+	}
+
+	FDegreeDayEnsembleMembers Members;
+	Members.Initialize(Parameters);
+
+	FDegreeDayEnsembleState State;
+	State.Initialize(Cells, Members);
+
+	const int32 NumCells = Cells.Num();
+
+	double StartSeconds = FPlatformTime::Seconds();
+	for (int32 Hour = 0; Hour < Hours; ++Hour)
+	{
+		const FDegreeDayForcing Forcing = GetBenchmarkForcing(ClimateData, Hour);
+		FDegreeDayEnsembleKernel::Simulate(State, Members, Cells, 0, NumCells, Forcing, RadiationTable.GetDay(Forcing.DayOfYear));
+	}
+	const double EnsembleSeconds = FPlatformTime::Seconds() - StartSeconds;
+
+	double SeparateSeconds = 0;
+	float MaxRelativeError = 0;
+	for (int32 Member = 0; Member < NumMembers; ++Member)
+	{
+		FSimulationCellStore MemberCells;
+		MemberCells.Initialize(LandscapeCells, DimensionX, DimensionY);
+
+		StartSeconds = FPlatformTime::Seconds();
+		for (int32 Hour = 0; Hour < Hours; ++Hour)
+		{
+			const FDegreeDayForcing Forcing = GetBenchmarkForcing(ClimateData, Hour);
+			FDegreeDayCPUKernel::SimulateVector(FDegreeDayCellRange(MemberCells, 0, NumCells, RadiationTable.GetDay(Forcing.DayOfYear)), Parameters[Member], Forcing);
+		}
+		SeparateSeconds += FPlatformTime::Seconds() - StartSeconds;
+
+		for (int32 Index = 0; Index < NumCells; ++Index)
+		{
+			const float Expected = MemberCells.SnowWaterEquivalent[Index];
+			const float AbsoluteError = FMath::Abs(Expected - State.SnowWaterEquivalent[Index * State.Stride + Member]);
+			MaxRelativeError = FMath::Max(MaxRelativeError, AbsoluteError / FMath::Max(FMath::Abs(Expected), 1.0f));
+		}
+	}
+
+	UE_LOG(SimulationLog, Display, TEXT("Ensemble: %d cells, %d hours, %d members, max relative SWE error %e, state uses %.2f MB"),
+		NumCells, Hours, NumMembers, MaxRelativeError, State.GetAllocatedSize() / (1024.0f * 1024.0f));
+	UE_LOG(SimulationLog, Display, TEXT("Separate runs took %f ms, ensemble took %f ms (%.2fx)"),
+		SeparateSeconds * 1000, EnsembleSeconds * 1000, SeparateSeconds / FMath::Max(EnsembleSeconds, 1e-9));
+}
+
+static FAutoConsoleCommand BenchmarkEnsembleCommand(
+	TEXT("Simulation.BenchmarkEnsemble"),
+	TEXT("Compares the ensemble kernel with separate runs of every member. Arguments: [CellsX] [CellsY] [Hours] [Members]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkEnsemble));
+
+/**
+* Compares every vector kernel variant with the variant which evaluates all features on parameters and forcing for which
+* both give the same results.
+*/
+static void BenchmarkKernelVariants(const TArray<FString>& Args)
+{
+	const int32 DimensionX = FSimulationBenchmark::GetArgument(Args, 0, 128);
+	const int32 DimensionY = FSimulationBenchmark::GetArgument(Args, 1, 128);
+	const int32 Hours = FSimulationBenchmark::GetArgument(Args, 2, 24 * 60);
+
+	TArray<FLandscapeCell> LandscapeCells;
+	FSimulationBenchmark::CreateTerrain(DimensionX, DimensionY, LandscapeCells);
+
+	TArray<FClimateData> ClimateData;
+	FSimulationBenchmark::CreateClimate(Hours, ClimateData);
+
+	FSimulationCellStore InitialCells;
+	InitialCells.Initialize(LandscapeCells, DimensionX, DimensionY);
+
+	// The radiation index is looked up, so the benchmark measures the kernels and not the solar radiation
+	FSolarRadiationTable RadiationTable;
+	RadiationTable.Build(InitialCells, 1);
+
+	const int32 NumCells = InitialCells.Num();
+	const double Evaluations = static_cast<double>(NumCells) * Hours;
+
+	UE_LOG(SimulationLog, Display, TEXT("Kernel variants: %d cells, %d hours"), NumCells, Hours);
+
+	for (int32 Variant = 0; Variant < FDegreeDayKernelFeatures::NumVariants; ++Variant)
+	{
+		const FDegreeDayKernelFeatures Features = FDegreeDayKernelFeatures::FromVariant(Variant);
+
+		// The variant with all features except the interpolation of this variant
+		FDegreeDayKernelFeatures AllFeatures;
+		AllFeatures.Interpolation = Features.Interpolation;
+
+		// Parameters for which the disabled features have no effect
+		FDegreeDayParameters Parameters;
+		Parameters.TSnowB = Features.Rain ? Parameters.TSnowB : 50.0f;
+		Parameters.VegetationDensity = Features.Vegetation ? 0.3f : 0.0f;
+		Parameters.TMeltB = Features.QuadraticMelt ? Parameters.TMeltB : Parameters.TMeltA;
+
+		const FDegreeDayKernelFunction VariantKernel = FDegreeDayCPUKernel::GetVectorKernel(Features);
+		const FDegreeDayKernelFunction AllFeaturesKernel = FDegreeDayCPUKernel::GetVectorKernel(AllFeatures);
+
+		FSimulationCellStore VariantCells = InitialCells;
+		FSimulationCellStore AllFeaturesCells = InitialCells;
+
+		double VariantSeconds = 0;
+		double AllFeaturesSeconds = 0;
+		for (int32 Hour = 0; Hour < Hours; ++Hour)
+		{
+			FDegreeDayForcing Forcing = GetBenchmarkForcing(ClimateData, Hour);
+			Forcing.DiurnalFactor = Features.DiurnalRadiation ? 1.0f + 0.5f * FMath::Sin(Hour * 2 * PI / 24) : 1.0f;
+
+			const float* RadiationIndex = RadiationTable.GetDay(Forcing.DayOfYear);
+
+			double StartSeconds = FPlatformTime::Seconds();
+			VariantKernel(FDegreeDayCellRange(VariantCells, 0, NumCells, RadiationIndex), Parameters, Forcing);
+			VariantSeconds += FPlatformTime::Seconds() - StartSeconds;
+
+			StartSeconds = FPlatformTime::Seconds();
+			AllFeaturesKernel(FDegreeDayCellRange(AllFeaturesCells, 0, NumCells, RadiationIndex), Parameters, Forcing);
+			AllFeaturesSeconds += FPlatformTime::Seconds() - StartSeconds;
+		}
+
+		float MaxError = 0;
+		for (int32 Index = 0; Index < NumCells; ++Index)
+		{
+			MaxError = FMath::Max(MaxError, FMath::Abs(VariantCells.SnowWaterEquivalent[Index] - AllFeaturesCells.SnowWaterEquivalent[Index]));
+		}
+
+		UE_LOG(SimulationLog, Display, TEXT("%2d (%s): %f ns per cell and hour, all features %f ns (%.2fx), max absolute SWE error %e l"),
+			Variant, *Features.ToString(), VariantSeconds * 1e9 / Evaluations, AllFeaturesSeconds * 1e9 / Evaluations,
+			AllFeaturesSeconds / FMath::Max(VariantSeconds, 1e-9), MaxError);
+	}
+}
+
+static FAutoConsoleCommand BenchmarkKernelVariantsCommand(
+	TEXT("Simulation.BenchmarkKernelVariants"),
+	TEXT("Compares the throughput of the degree day kernel variants with the variant with all features. Arguments: [CellsX] [CellsY] [Hours]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkKernelVariants));
+
+/**
+* Replays a directory recorded by the GPU simulation (see UDegreeDayGPUSimulation::RecordDirectory) with the CPU execution
+* of the compute shader. The recorded steps are executed in order with their recorded variable parameters, the validation
+* fails if the output of any step differs from the recorded GPU output by more than the tolerance.
+*/
+static void ValidateComputeShaderCPU(const TArray<FString>& Args)
+{
+	const FString Directory = Args.IsValidIndex(0) ? Args[0] : FPaths::Combine(*FPaths::GamePluginsDir(), TEXT("Simulation/Fixtures/ComputeShader"));
+	const float Tolerance = Args.IsValidIndex(1) ? FCString::Atof(*Args[1]) : 1e-3f;
+
+	uint32 ScaledMaxSnow;
+	FComputeShaderConstantParameters Constants;
+	TArray<FGPUSimulationCell> Cells;
+	TArray<FClimateData> WeatherData;
+	if (!LoadComputeShaderInputRecord(GetComputeShaderInputRecordPath(Directory), ScaledMaxSnow, Constants, Cells, WeatherData))
+	{
+		UE_LOG(SimulationLog, Error, TEXT("Compute shader validation FAILED: no recorded input in %s"), *Directory);
+		return;
+	}
+
+	TArray<FString> RecordFiles;
+	IFileManager::Get().FindFiles(RecordFiles, *FPaths::Combine(*Directory, TEXT("SnowOutput_*.bin")), true, false);
+	RecordFiles.Sort();
+	if (RecordFiles.Num() == 0)
+	{
+		UE_LOG(SimulationLog, Error, TEXT("Compute shader validation FAILED: no recorded output in %s"), *Directory);
+		return;
+	}
+
+	const int32 NumRows = FMath::Min(FComputeShaderCPUKernel::GetNumDispatchedRows(Constants), Cells.Num() / FMath::Max(1, Constants.CellsDimensionX));
+	const int32 RowsPerTile = 8;
+	const int32 NumTiles = FMath::DivideAndRoundUp(NumRows, RowsPerTile);
+
+	TArray<float> SnowOutput;
+	SnowOutput.SetNumZeroed(Cells.Num());
+	TArray<uint32> TileMaxSnow;
+
+	float MaxAbsoluteError = 0;
+	int32 NumFailedSteps = 0;
+	for (const FString& RecordFile : RecordFiles)
+	{
+		FComputeShaderVariableParameters Variables;
+		uint32 RecordedMaxSnow;
+		TArray<float> RecordedSnowOutput;
+		if (!LoadSnowOutputRecord(FPaths::Combine(*Directory, *RecordFile), Variables, RecordedMaxSnow, RecordedSnowOutput) || RecordedSnowOutput.Num() != Cells.Num())
+		{
+			UE_LOG(SimulationLog, Error, TEXT("Compute shader validation FAILED: the record %s cannot be read or does not match the %d recorded cells"), *RecordFile, Cells.Num());
+			return;
+		}
+
+		// The max snow buffer of the compute shader is not reset between the executions
+		TileMaxSnow.Init(0, NumTiles);
+		ParallelFor(NumTiles, [&](int32 Tile)
+		{
+			const int32 BeginRow = Tile * RowsPerTile;
+			const int32 EndRow = FMath::Min(BeginRow + RowsPerTile, NumRows);
+			TileMaxSnow[Tile] = FComputeShaderCPUKernel::SimulateRows(Cells.GetData(), WeatherData, Constants, Variables, BeginRow, EndRow, SnowOutput.GetData());
+		});
+		for (uint32 TileMax : TileMaxSnow)
+		{
+			ScaledMaxSnow = FMath::Max(ScaledMaxSnow, TileMax);
+		}
+
+		float StepMaxAbsoluteError;
+		const int32 NumMismatches = FComputeShaderCPUKernel::CompareWithRecord(SnowOutput, ScaledMaxSnow, RecordedSnowOutput, RecordedMaxSnow, Tolerance, StepMaxAbsoluteError);
+		MaxAbsoluteError = FMath::Max(MaxAbsoluteError, StepMaxAbsoluteError);
+		if (NumMismatches > 0)
+		{
+			UE_LOG(SimulationLog, Error, TEXT("Step %d: %d mismatches, max absolute error %f mm, max snow %f mm instead of %f mm"), Variables.CurrentSimulationStep, NumMismatches,
+				StepMaxAbsoluteError, ScaledMaxSnow / FComputeShaderCPUKernel::GetUintFloatScale(), RecordedMaxSnow / FComputeShaderCPUKernel::GetUintFloatScale());
+			NumFailedSteps++;
+		}
+	}
+
+	if (NumFailedSteps > 0)
+	{
+		UE_LOG(SimulationLog, Error, TEXT("Compute shader validation FAILED: %d of %d steps outside the tolerance of %e, max absolute error %f mm"),
+			NumFailedSteps, RecordFiles.Num(), Tolerance, MaxAbsoluteError);
+	}
+	else
+	{
+		UE_LOG(SimulationLog, Display, TEXT("Compute shader validation passed: %d cells, %d steps within the tolerance of %e, max absolute error %f mm"),
+			Cells.Num(), RecordFiles.Num(), Tolerance, MaxAbsoluteError);
+	}
+}
+
+static FAutoConsoleCommand ValidateComputeShaderCPUCommand(
+	TEXT("Simulation.ValidateComputeShaderCPU"),
+	TEXT("Replays the input recorded by the GPU simulation on the CPU and fails if the output differs from the recorded output. Arguments: [RecordDirectory] [Tolerance]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&ValidateComputeShaderCPU));
+
+/**
+* Simulates the same cells at full precision and with the compact cell store and compares the snow. The compact cells are
+* compressed after every step like in UDegreeDayCompactCPUSimulation, so the quantization error of the snow accumulates
+* over the steps. The drift is reported every 30 days and the validation fails if it exceeds the tolerance in mm.
+*/
+static void ValidateCompactStorage(const TArray<FString>& Args)
+{
+	const int32 DimensionX = FSimulationBenchmark::GetArgument(Args, 0, 256);
+	const int32 DimensionY = FSimulationBenchmark::GetArgument(Args, 1, 256);
+	const int32 Hours = FSimulationBenchmark::GetArgument(Args, 2, 24 * 180);
+	const int32 HoursPerStep = FMath::Max(1, FSimulationBenchmark::GetArgument(Args, 3, 1));
+	const float Tolerance = Args.IsValidIndex(4) ? FCString::Atof(*Args[4]) : 1.0f;
+
+	TArray<FLandscapeCell> LandscapeCells;
+	FSimulationBenchmark::CreateTerrain(DimensionX, DimensionY, LandscapeCells);
+
+	TArray<FClimateData> ClimateData;
+	FSimulationBenchmark::CreateClimate(Hours, ClimateData);
+
+	FCompactTileBuffers FullPrecision;
+	FullPrecision.Cells.Initialize(LandscapeCells, DimensionX, DimensionY);
+
+	FCompactCellStore CompactCells;
+	CompactCells.Initialize(LandscapeCells, DimensionX, DimensionY);
+	FCompactTileBuffers CompactBuffers;
+
+	const int32 NumCells = LandscapeCells.Num();
+	const FDegreeDayParameters Parameters;
+	const FBloeschlParameters Interpolation;
+
+	// Returns the maximum absolute error of the snow height in mm
+	auto GetMaxError = [&]()
+	{
+		float MaxError = 0;
+		for (int32 Index = 0; Index < NumCells; ++Index)
+		{
+			const float SnowHeight = FullPrecision.Cells.SnowWaterEquivalent[Index] * FullPrecision.Cells.InverseAreaSquareMeters[Index];
+			MaxError = FMath::Max(MaxError, FMath::Abs(SnowHeight - CompactCells.GetSnowHeight(Index)));
+		}
+		return MaxError;
+	};
+
+	// The compact cells are decompressed and compressed again after every step
+	const int32 ReportInterval = 24 * 30;
+	double FullPrecisionSeconds = 0;
+	double CompactSeconds = 0;
+	for (int32 Step = 0; Step < Hours; Step += HoursPerStep)
+	{
+		const int32 EndHour = FMath::Min(Step + HoursPerStep, Hours);
+
+		TArray<FDegreeDayForcing> HourForcing;
+		for (int32 Hour = Step; Hour < EndHour; ++Hour)
+		{
+			HourForcing.Add(GetBenchmarkForcing(ClimateData, Hour));
+		}
+
+		double StartSeconds = FPlatformTime::Seconds();
+		UDegreeDayCompactCPUSimulation::SimulateTile(FullPrecision, Parameters, Interpolation, HourForcing, true);
+		FullPrecisionSeconds += FPlatformTime::Seconds() - StartSeconds;
+
+		StartSeconds = FPlatformTime::Seconds();
+		CompactCells.Decompress(0, NumCells, CompactBuffers.Cells);
+		UDegreeDayCompactCPUSimulation::SimulateTile(CompactBuffers, Parameters, Interpolation, HourForcing, true);
+		CompactCells.Compress(0, CompactBuffers.Cells);
+		CompactSeconds += FPlatformTime::Seconds() - StartSeconds;
+
+		if (EndHour / ReportInterval != Step / ReportInterval && EndHour < Hours)
+		{
+			UE_LOG(SimulationLog, Display, TEXT("Compact storage after %d hours: max SWE error %f mm"), EndHour, GetMaxError());
+		}
+	}
+
+	float MaxError = 0;
+	double SumError = 0;
+	float MaxRelativeError = 0;
+	float MaxInterpolatedError = 0;
+	for (int32 Index = 0; Index < NumCells; ++Index)
+	{
+		const float SnowHeight = FullPrecision.Cells.SnowWaterEquivalent[Index] * FullPrecision.Cells.InverseAreaSquareMeters[Index];
+		const float Error = FMath::Abs(SnowHeight - CompactCells.GetSnowHeight(Index));
+
+		MaxError = FMath::Max(MaxError, Error);
+		SumError += Error;
+		MaxRelativeError = FMath::Max(MaxRelativeError, Error / FMath::Max(SnowHeight, 1.0f));
+		MaxInterpolatedError = FMath::Max(MaxInterpolatedError, FMath::Abs(FullPrecision.Cells.GetInterpolatedSnowHeight(Index) - CompactCells.GetInterpolatedSnowHeight(Index)));
+	}
+
+	UE_LOG(SimulationLog, Display, TEXT("Compact storage: %d cells, %d hours in steps of %d hours, max SWE error %f mm, mean SWE error %f mm, max relative error %e, max interpolated snow error %f mm"),
+		NumCells, Hours, HoursPerStep, MaxError, NumCells > 0 ? SumError / NumCells : 0.0, MaxRelativeError, MaxInterpolatedError);
+	UE_LOG(SimulationLog, Display, TEXT("Full precision uses %.1f bytes per cell and took %f ms, compact storage uses %.1f bytes per cell and took %f ms"),
+		static_cast<float>(FullPrecision.Cells.GetAllocatedSize()) / NumCells, FullPrecisionSeconds * 1000,
+		static_cast<float>(CompactCells.GetAllocatedSize()) / NumCells, CompactSeconds * 1000);
+
+	if (MaxError > Tolerance)
+	{
+		UE_LOG(SimulationLog, Error, TEXT("Compact storage validation FAILED: the SWE drifted by %f mm, more than the tolerance of %f mm"), MaxError, Tolerance);
+	}
+	else
+	{
+		UE_LOG(SimulationLog, Display, TEXT("Compact storage validation passed: the SWE drifted by %f mm, within the tolerance of %f mm"), MaxError, Tolerance);
+	}
+}
+
+static FAutoConsoleCommand ValidateCompactStorageCommand(
+	TEXT("Simulation.ValidateCompactStorage"),
+	TEXT("Compares the snow of the compact cell store with full precision over a season. Arguments: [CellsX] [CellsY] [Hours] [HoursPerStep] [Tolerance]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&ValidateCompactStorage));
+
+/** Redistributes snow on a large grid in parallel and serially and checks that the snow is conserved and the results are identical. */
+static void BenchmarkRedistribution(const TArray<FString>& Args)
+{
+	const int32 DimensionX = FSimulationBenchmark::GetArgument(Args, 0, 1024);
+	const int32 DimensionY = FSimulationBenchmark::GetArgument(Args, 1, 1024);
+	const int32 SnowHeight = FSimulationBenchmark::GetArgument(Args, 2, 500);
+
+	TArray<FLandscapeCell> LandscapeCells;
+	FSimulationBenchmark::CreateTerrain(DimensionX, DimensionY, LandscapeCells);
+
+	FSimulationCellStore ParallelCells;
+	ParallelCells.Initialize(LandscapeCells, DimensionX, DimensionY);
+
+	const int32 NumCells = ParallelCells.Num();
+	double InitialSnow = 0;
+	for (int32 Index = 0; Index < NumCells; ++Index)
+	{
+		ParallelCells.SnowWaterEquivalent[Index] = SnowHeight * ParallelCells.Area[Index] / (100 * 100);
+		InitialSnow += ParallelCells.SnowWaterEquivalent[Index];
+	}
+
+	FSimulationCellStore SerialCells = ParallelCells;
+
+	const FSnowRedistributionParameters Parameters;
+	FSnowRedistribution Redistribution;
+	Redistribution.Initialize(ParallelCells);
+
+	double StartSeconds = FPlatformTime::Seconds();
+	const int32 ParallelIterations = Redistribution.Redistribute(ParallelCells, Parameters, true);
+	const double ParallelSeconds = FPlatformTime::Seconds() - StartSeconds;
+	const double MovedSnow = Redistribution.GetMovedSnow();
+
+	StartSeconds = FPlatformTime::Seconds();
+	const int32 SerialIterations = Redistribution.Redistribute(SerialCells, Parameters, false);
+	const double SerialSeconds = FPlatformTime::Seconds() - StartSeconds;
+
+	double FinalSnow = 0;
+	int32 NumDifferences = 0;
+	for (int32 Index = 0; Index < NumCells; ++Index)
+	{
+		FinalSnow += ParallelCells.SnowWaterEquivalent[Index];
+		if (ParallelCells.SnowWaterEquivalent[Index] != SerialCells.SnowWaterEquivalent[Index]) NumDifferences++;
+	}
+
+	UE_LOG(SimulationLog, Display, TEXT("Snow redistribution: %d cells, %d iterations moved %.0f of %.0f liters, relative mass error %e, grids use %.2f MB"),
+		NumCells, ParallelIterations, MovedSnow, InitialSnow, InitialSnow > 0 ? FMath::Abs(FinalSnow - InitialSnow) / InitialSnow : 0.0,
+		Redistribution.GetAllocatedSize() / (1024.0f * 1024.0f));
+	UE_LOG(SimulationLog, Display, TEXT("Parallel took %f ms (%f ms per iteration), serial took %f ms (%d iterations), %d cells differ"),
+		ParallelSeconds * 1000, ParallelSeconds * 1000 / FMath::Max(1, ParallelIterations), SerialSeconds * 1000, SerialIterations, NumDifferences);
+}
+
+static FAutoConsoleCommand BenchmarkRedistributionCommand(
+	TEXT("Simulation.BenchmarkRedistribution"),
+	TEXT("Measures the snow redistribution and compares the parallel with the serial result. Arguments: [CellsX] [CellsY] [SnowMM]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkRedistribution));
+
+/** Transports snow with a stormy wind in parallel and serially, reports the throughput and the time of the phases and compares the results. */
+static void BenchmarkWindTransport(const TArray<FString>& Args)
+{
+	const int32 DimensionX = FSimulationBenchmark::GetArgument(Args, 0, 1024);
+	const int32 DimensionY = FSimulationBenchmark::GetArgument(Args, 1, 1024);
+	const int32 Hours = FSimulationBenchmark::GetArgument(Args, 2, 24);
+	const int32 RowsPerTile = FMath::Max(1, FSimulationBenchmark::GetArgument(Args, 3, 8));
+
+	TArray<FLandscapeCell> LandscapeCells;
+	FSimulationBenchmark::CreateTerrain(DimensionX, DimensionY, LandscapeCells);
+
+	FSimulationCellStore ParallelCells;
+	ParallelCells.Initialize(LandscapeCells, DimensionX, DimensionY);
+
+	const int32 NumCells = ParallelCells.Num();
+	double InitialSnow = 0;
+	for (int32 Index = 0; Index < NumCells; ++Index)
+	{
+		ParallelCells.SnowWaterEquivalent[Index] = 200 * ParallelCells.Area[Index] / (100 * 100);
+		InitialSnow += ParallelCells.SnowWaterEquivalent[Index];
+	}
+
+	FSimulationCellStore SerialCells = ParallelCells;
+
+	FDegreeDayForcing Forcing;
+	Forcing.Temperature = -10;
+	Forcing.Precipitation = 0;
+	Forcing.MeasurementAltitude = FSimulationBenchmark::GetMeasurementAltitude();
+	Forcing.DayOfYear = 15;
+
+	const FWindTransportParameters Parameters;
+	FWindTransport Transport;
+	Transport.Initialize(ParallelCells, RowsPerTile);
+
+	// A westerly storm which turns and changes its strength
+	auto GetWind = [](int32 Hour)
+	{
+		return FWindData::FromDirection(14 + 4 * FMath::Sin(Hour * 0.3f), 270 + 30 * FMath::Sin(Hour * 0.2f));
+	};
+
+	double TransportedSnow = 0;
+	for (int32 Hour = 0; Hour < Hours; ++Hour)
+	{
+		TransportedSnow += Transport.SimulateHour(ParallelCells, GetWind(Hour), Forcing, Parameters, true);
+	}
+	const FWindTransportTimings ParallelTimings = Transport.GetTimings();
+
+	Transport.ResetTimings();
+	for (int32 Hour = 0; Hour < Hours; ++Hour)
+	{
+		Transport.SimulateHour(SerialCells, GetWind(Hour), Forcing, Parameters, false);
+	}
+	const FWindTransportTimings SerialTimings = Transport.GetTimings();
+
+	double FinalSnow = 0;
+	int32 NumDifferences = 0;
+	for (int32 Index = 0; Index < NumCells; ++Index)
+	{
+		FinalSnow += ParallelCells.SnowWaterEquivalent[Index];
+		if (ParallelCells.SnowWaterEquivalent[Index] != SerialCells.SnowWaterEquivalent[Index]) NumDifferences++;
+	}
+
+	const double ParallelSeconds = ParallelTimings.GetTotalSeconds();
+	UE_LOG(SimulationLog, Display, TEXT("Wind transport: %d cells in tiles of %d rows, %d hours moved %.0f liters, net loss across the border %.0f of %.0f liters, uses %.2f MB"),
+		NumCells, RowsPerTile, Hours, TransportedSnow, InitialSnow - FinalSnow, InitialSnow, Transport.GetAllocatedSize() / (1024.0f * 1024.0f));
+	UE_LOG(SimulationLog, Display, TEXT("Parallel took %f ms per hour (%.1f million cells per second): transport %f ms, halo exchange %f ms, apply %f ms"),
+		ParallelSeconds * 1000 / FMath::Max(1, Hours), ParallelSeconds > 0 ? static_cast<double>(NumCells) * Hours / ParallelSeconds / 1e6 : 0.0,
+		ParallelTimings.TransportSeconds * 1000, ParallelTimings.ExchangeSeconds * 1000, ParallelTimings.ApplySeconds * 1000);
+	UE_LOG(SimulationLog, Display, TEXT("Serial took %f ms per hour, %d cells differ from the parallel result"), SerialTimings.GetTotalSeconds() * 1000 / FMath::Max(1, Hours), NumDifferences);
+}
+
+static FAutoConsoleCommand BenchmarkWindTransportCommand(
+	TEXT("Simulation.BenchmarkWindTransport"),
+	TEXT("Measures the throughput of the wind transport and compares the parallel with the serial result. Arguments: [CellsX] [CellsY] [Hours] [RowsPerTile]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkWindTransport));
+
+/**
+* Simulates the same cells with the degree day and the energy balance vector kernel in parallel row tiles which are
+* advanced through all hours and compares their throughput. Also compares the scalar and the vector energy balance kernel.
+*/
+static void BenchmarkEnergyBalance(const TArray<FString>& Args)
+{
+	const int32 DimensionX = FSimulationBenchmark::GetArgument(Args, 0, 512);
+	const int32 DimensionY = FSimulationBenchmark::GetArgument(Args, 1, 512);
+	const int32 Hours = FSimulationBenchmark::GetArgument(Args, 2, 24 * 60);
+	const int32 RowsPerTile = FMath::Max(1, FSimulationBenchmark::GetArgument(Args, 3, 8));
+
+	TArray<FLandscapeCell> LandscapeCells;
+	FSimulationBenchmark::CreateTerrain(DimensionX, DimensionY, LandscapeCells);
+
+	TArray<FClimateData> ClimateData;
+	FSimulationBenchmark::CreateClimate(Hours, ClimateData);
+
+	FSimulationCellStore DegreeDayCells;
+	DegreeDayCells.Initialize(LandscapeCells, DimensionX, DimensionY);
+	FSimulationCellStore EnergyBalanceCells = DegreeDayCells;
+	FSimulationCellStore ScalarCells = DegreeDayCells;
+
+	// Both engines look up the radiation index and the diurnal factors
+	FSolarRadiationTable RadiationTable;
+	RadiationTable.Build(DegreeDayCells, 1);
+	RadiationTable.BuildDiurnalFactors(DegreeDayCells);
+
+	const int32 NumCells = DegreeDayCells.Num();
+	const FDegreeDayParameters DegreeDayParameters;
+	const FEnergyBalanceParameters EnergyBalanceParameters;
+
+	FAlignedFloatArray SensibleTransfer;
+	SensibleTransfer.SetNumUninitialized(NumCells);
+	double LatitudeSum = 0;
+	for (int32 Index = 0; Index < NumCells; ++Index)
+	{
+		SensibleTransfer[Index] = FEnergyBalanceKernel::GetSensibleTransfer(EnergyBalanceParameters, DegreeDayCells.Altitude[Index]);
+		LatitudeSum += DegreeDayCells.Latitude[Index];
+	}
+	const float MeanLatitude = NumCells > 0 ? LatitudeSum / NumCells : 0.0f;
+
+	TArray<FDegreeDayForcing> DegreeDayForcing;
+	TArray<FEnergyBalanceForcing> EnergyBalanceForcing;
+	for (int32 Hour = 0; Hour < Hours; ++Hour)
+	{
+		FDegreeDayForcing Forcing = GetBenchmarkForcing(ClimateData, Hour);
+		Forcing.DiurnalFactor = RadiationTable.GetDiurnalFactor(Forcing.DayOfYear, Hour % 24);
+		DegreeDayForcing.Add(Forcing);
+
+		EnergyBalanceForcing.Add(FEnergyBalanceKernel::GetForcing(EnergyBalanceParameters, ClimateData[Hour], nullptr, Forcing.MeasurementAltitude, MeanLatitude,
+			Forcing.DayOfYear, Forcing.DiurnalFactor));
+	}
+
+	const FDegreeDayKernelFunction DegreeDayKernel = FDegreeDayCPUKernel::GetVectorKernel(
+		FDegreeDayCPUKernel::GetFeatures(FDegreeDayCellRange(DegreeDayCells, 0, NumCells), DegreeDayParameters, DegreeDayForcing[0]));
+
+	const int32 CellsPerTile = RowsPerTile * DimensionX;
+	const int32 NumTiles = FMath::DivideAndRoundUp(NumCells, CellsPerTile);
+
+	double StartSeconds = FPlatformTime::Seconds();
+	ParallelFor(NumTiles, [&](int32 Tile)
+	{
+		const int32 BeginIndex = Tile * CellsPerTile;
+		const int32 EndIndex = FMath::Min(BeginIndex + CellsPerTile, NumCells);
+		for (int32 Hour = 0; Hour < Hours; ++Hour)
+		{
+			DegreeDayKernel(FDegreeDayCellRange(DegreeDayCells, BeginIndex, EndIndex, RadiationTable.GetDay(DegreeDayForcing[Hour].DayOfYear)), DegreeDayParameters, DegreeDayForcing[Hour]);
+		}
+	});
+	const double DegreeDaySeconds = FPlatformTime::Seconds() - StartSeconds;
+
+	StartSeconds = FPlatformTime::Seconds();
+	ParallelFor(NumTiles, [&](int32 Tile)
+	{
+		const int32 BeginIndex = Tile * CellsPerTile;
+		const int32 EndIndex = FMath::Min(BeginIndex + CellsPerTile, NumCells);
+		for (int32 Hour = 0; Hour < Hours; ++Hour)
+		{
+			FEnergyBalanceKernel::SimulateVector(FEnergyBalanceCellRange(EnergyBalanceCells, BeginIndex, EndIndex, RadiationTable.GetDay(DegreeDayForcing[Hour].DayOfYear),
+				SensibleTransfer.GetData()), EnergyBalanceParameters, EnergyBalanceForcing[Hour]);
+		}
+	});
+	const double EnergyBalanceSeconds = FPlatformTime::Seconds() - StartSeconds;
+
+	StartSeconds = FPlatformTime::Seconds();
+	for (int32 Hour = 0; Hour < Hours; ++Hour)
+	{
+		FEnergyBalanceKernel::SimulateScalar(FEnergyBalanceCellRange(ScalarCells, 0, NumCells, RadiationTable.GetDay(DegreeDayForcing[Hour].DayOfYear), SensibleTransfer.GetData()),
+			EnergyBalanceParameters, EnergyBalanceForcing[Hour]);
+	}
+	const double ScalarSeconds = FPlatformTime::Seconds() - StartSeconds;
+
+	double DegreeDaySnow = 0;
+	double EnergyBalanceSnow = 0;
+	float MaxRelativeError = 0;
+	for (int32 Index = 0; Index < NumCells; ++Index)
+	{
+		DegreeDaySnow += DegreeDayCells.SnowWaterEquivalent[Index] * DegreeDayCells.InverseAreaSquareMeters[Index];
+		EnergyBalanceSnow += EnergyBalanceCells.SnowWaterEquivalent[Index] * EnergyBalanceCells.InverseAreaSquareMeters[Index];
+
+		const float Expected = ScalarCells.SnowWaterEquivalent[Index];
+		MaxRelativeError = FMath::Max(MaxRelativeError, FMath::Abs(Expected - EnergyBalanceCells.SnowWaterEquivalent[Index]) / FMath::Max(FMath::Abs(Expected), 1.0f));
+	}
+
+	const double Evaluations = static_cast<double>(NumCells) * Hours;
+	const double DegreeDayRate = Evaluations / FMath::Max(DegreeDaySeconds, 1e-9) / 1e6;
+	const double EnergyBalanceRate = Evaluations / FMath::Max(EnergyBalanceSeconds, 1e-9) / 1e6;
+	const double Ratio = EnergyBalanceRate / FMath::Max(DegreeDayRate, 1e-9);
+
+	UE_LOG(SimulationLog, Display, TEXT("Energy balance: %d cells in tiles of %d rows, %d hours, mean snow %.1f mm (degree day %.1f mm)"),
+		NumCells, RowsPerTile, Hours, NumCells > 0 ? EnergyBalanceSnow / NumCells : 0.0, NumCells > 0 ? DegreeDaySnow / NumCells : 0.0);
+	UE_LOG(SimulationLog, Display, TEXT("Degree day took %f ms (%.1f million cells per second), energy balance took %f ms (%.1f million cells per second)"),
+		DegreeDaySeconds * 1000, DegreeDayRate, EnergyBalanceSeconds * 1000, EnergyBalanceRate);
+	UE_LOG(SimulationLog, Display, TEXT("Scalar energy balance took %f ms on one thread, max relative SWE error of the vector kernel %e"), ScalarSeconds * 1000, MaxRelativeError);
+
+	if (Ratio >= 0.5)
+	{
+		UE_LOG(SimulationLog, Display, TEXT("Energy balance reaches %.0f%% of the degree day throughput (target 50%%)"), Ratio * 100);
+	}
+	else
+	{
+		UE_LOG(SimulationLog, Warning, TEXT("Energy balance reaches %.0f%% of the degree day throughput (target 50%%)"), Ratio * 100);
+	}
+}
+
+static FAutoConsoleCommand BenchmarkEnergyBalanceCommand(
+	TEXT("Simulation.BenchmarkEnergyBalance"),
+	TEXT("Compares the throughput of the energy balance with the degree day kernel on the same grid. Arguments: [CellsX] [CellsY] [Hours] [RowsPerTile]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkEnergyBalance));
+
+/**
+* Simulates the same cells with the bulk energy balance and with the layered snowpack, compares the throughput and checks
+* that the snow water equivalent of the cells matches the sum of their layers.
+*/
+static void BenchmarkSnowpack(const TArray<FString>& Args)
+{
+	const int32 DimensionX = FSimulationBenchmark::GetArgument(Args, 0, 256);
+	const int32 DimensionY = FSimulationBenchmark::GetArgument(Args, 1, 256);
+	const int32 Hours = FSimulationBenchmark::GetArgument(Args, 2, 24 * 60);
+	const int32 RowsPerTile = FMath::Max(1, FSimulationBenchmark::GetArgument(Args, 3, 8));
+
+	TArray<FLandscapeCell> LandscapeCells;
+	FSimulationBenchmark::CreateTerrain(DimensionX, DimensionY, LandscapeCells);
+
+	TArray<FClimateData> ClimateData;
+	FSimulationBenchmark::CreateClimate(Hours, ClimateData);
+
+	FSimulationCellStore BulkCells;
+	BulkCells.Initialize(LandscapeCells, DimensionX, DimensionY);
+	FSimulationCellStore LayeredCells = BulkCells;
+
+	FSolarRadiationTable RadiationTable;
+	RadiationTable.Build(BulkCells, 1);
+	RadiationTable.BuildDiurnalFactors(BulkCells);
+
+	const int32 NumCells = BulkCells.Num();
+	const FEnergyBalanceParameters Parameters;
+	const FSnowpackParameters Snowpack;
+
+	FAlignedFloatArray SensibleTransfer;
+	SensibleTransfer.SetNumUninitialized(NumCells);
+	double LatitudeSum = 0;
+	for (int32 Index = 0; Index < NumCells; ++Index)
+	{
+		SensibleTransfer[Index] = FEnergyBalanceKernel::GetSensibleTransfer(Parameters, BulkCells.Altitude[Index]);
+		LatitudeSum += BulkCells.Latitude[Index];
+	}
+	const float MeanLatitude = NumCells > 0 ? LatitudeSum / NumCells : 0.0f;
+
+	TArray<FEnergyBalanceForcing> Forcing;
+	TArray<const float*> RadiationIndex;
+	for (int32 Hour = 0; Hour < Hours; ++Hour)
+	{
+		const FDegreeDayForcing DegreeDayForcing = GetBenchmarkForcing(ClimateData, Hour);
+		Forcing.Add(FEnergyBalanceKernel::GetForcing(Parameters, ClimateData[Hour], nullptr, DegreeDayForcing.MeasurementAltitude, MeanLatitude, DegreeDayForcing.DayOfYear,
+			RadiationTable.GetDiurnalFactor(DegreeDayForcing.DayOfYear, Hour % 24)));
+		RadiationIndex.Add(RadiationTable.GetDay(DegreeDayForcing.DayOfYear));
+	}
+
+	FSnowLayerStore Layers;
+	Layers.Initialize(LayeredCells, Snowpack.InitialDensity);
+	FAlignedFloatArray Snowfall, Melt, Sublimation, Refreezing;
+	Snowfall.SetNumZeroed(NumCells);
+	Melt.SetNumZeroed(NumCells);
+	Sublimation.SetNumZeroed(NumCells);
+	Refreezing.SetNumZeroed(NumCells);
+
+	const int32 CellsPerTile = RowsPerTile * DimensionX;
+	const int32 NumTiles = FMath::DivideAndRoundUp(NumCells, CellsPerTile);
+
+	double StartSeconds = FPlatformTime::Seconds();
+	ParallelFor(NumTiles, [&](int32 Tile)
+	{
+		const int32 BeginIndex = Tile * CellsPerTile;
+		const int32 EndIndex = FMath::Min(BeginIndex + CellsPerTile, NumCells);
+		for (int32 Hour = 0; Hour < Hours; ++Hour)
+		{
+			FEnergyBalanceKernel::SimulateVector(FEnergyBalanceCellRange(BulkCells, BeginIndex, EndIndex, RadiationIndex[Hour], SensibleTransfer.GetData()), Parameters, Forcing[Hour]);
+		}
+	});
+	const double BulkSeconds = FPlatformTime::Seconds() - StartSeconds;
+
+	StartSeconds = FPlatformTime::Seconds();
+	ParallelFor(NumTiles, [&](int32 Tile)
+	{
+		const int32 BeginIndex = Tile * CellsPerTile;
+		const int32 EndIndex = FMath::Min(BeginIndex + CellsPerTile, NumCells);
+		for (int32 Hour = 0; Hour < Hours; ++Hour)
+		{
+			FEnergyBalanceCellRange Range(LayeredCells, BeginIndex, EndIndex, RadiationIndex[Hour], SensibleTransfer.GetData());
+			Range.Snowfall = Snowfall.GetData() + BeginIndex;
+			Range.Melt = Melt.GetData() + BeginIndex;
+			Range.Sublimation = Sublimation.GetData() + BeginIndex;
+			Range.Refreezing = Refreezing.GetData() + BeginIndex;
+
+			FEnergyBalanceKernel::SimulateVector(Range, Parameters, Forcing[Hour]);
+			FSnowpackKernel::Simulate(Layers, Range, BeginIndex, Parameters, Snowpack, Forcing[Hour]);
+		}
+	});
+	const double LayeredSeconds = FPlatformTime::Seconds() - StartSeconds;
+
+	double BulkSnow = 0;
+	double LayeredSnow = 0;
+	double Depth = 0;
+	double Runoff = 0;
+	int64 NumLayers = 0;
+	int32 NumSnowCells = 0;
+	float MaxStoreError = 0;
+	for (int32 Index = 0; Index < NumCells; ++Index)
+	{
+		// The energy balance and the layers store their water per horizontal area
+		const float AreaSquareMeters = LayeredCells.AreaXY[Index] / (100 * 100); // m^2
+		const float SnowWaterEquivalent = LayeredCells.SnowWaterEquivalent[Index] / AreaSquareMeters; // mm
+
+		BulkSnow += BulkCells.SnowWaterEquivalent[Index] / AreaSquareMeters;
+		LayeredSnow += SnowWaterEquivalent;
+		Runoff += Layers.Runoff[Index] / AreaSquareMeters;
+
+		if (Layers.NumLayers[Index] > 0)
+		{
+			NumLayers += Layers.NumLayers[Index];
+			Depth += Layers.GetDepth(Index);
+			++NumSnowCells;
+		}
+
+		// The snow water equivalent of the cells has to match their layers
+		const float Expected = Layers.GetSnowWaterEquivalent(Index);
+		MaxStoreError = FMath::Max(MaxStoreError, FMath::Abs(Expected - SnowWaterEquivalent) / FMath::Max(Expected, 1.0f));
+	}
+
+	const double Evaluations = static_cast<double>(NumCells) * Hours;
+	UE_LOG(SimulationLog, Display, TEXT("Snowpack: %d cells, %d hours, %.2f MB of layers, mean snow %.1f mm (bulk %.1f mm), mean runoff %.1f mm"),
+		NumCells, Hours, Layers.GetAllocatedSize() / (1024.0f * 1024.0f), NumCells > 0 ? LayeredSnow / NumCells : 0.0, NumCells > 0 ? BulkSnow / NumCells : 0.0,
+		NumCells > 0 ? Runoff / NumCells : 0.0);
+	UE_LOG(SimulationLog, Display, TEXT("Cells with snow have %.2f layers and %.2f m depth on average, max relative difference between cells and layers %e"),
+		NumSnowCells > 0 ? static_cast<double>(NumLayers) / NumSnowCells : 0.0, NumSnowCells > 0 ? Depth / NumSnowCells : 0.0, MaxStoreError);
+	UE_LOG(SimulationLog, Display, TEXT("Bulk snow took %f ms (%.1f million cells per second), layered snowpack took %f ms (%.1f million cells per second)"),
+		BulkSeconds * 1000, Evaluations / FMath::Max(BulkSeconds, 1e-9) / 1e6, LayeredSeconds * 1000, Evaluations / FMath::Max(LayeredSeconds, 1e-9) / 1e6);
+}
+
+static FAutoConsoleCommand BenchmarkSnowpackCommand(
+	TEXT("Simulation.BenchmarkSnowpack"),
+	TEXT("Compares the energy balance with and without a layered snowpack and checks the layers against the cells. Arguments: [CellsX] [CellsY] [Hours] [RowsPerTile]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkSnowpack));
+
+/**
+* Compares the degree day kernel with the melt coefficients precomputed per cell with the kernel which evaluates the
+* vegetation factor from the parameters, then simulates a random vegetation raster with canopy interception.
+*/
+static void BenchmarkVegetation(const TArray<FString>& Args)
+{
+	const int32 DimensionX = FSimulationBenchmark::GetArgument(Args, 0, 256);
+	const int32 DimensionY = FSimulationBenchmark::GetArgument(Args, 1, 256);
+	const int32 Hours = FSimulationBenchmark::GetArgument(Args, 2, 24 * 60);
+
+	TArray<FLandscapeCell> LandscapeCells;
+	FSimulationBenchmark::CreateTerrain(DimensionX, DimensionY, LandscapeCells);
+
+	TArray<FClimateData> ClimateData;
+	FSimulationBenchmark::CreateClimate(Hours, ClimateData);
+
+	FSimulationCellStore ParameterCells;
+	ParameterCells.Initialize(LandscapeCells, DimensionX, DimensionY);
+
+	FRandomStream Random(42);
+	for (FLandscapeCell& Cell : LandscapeCells)
+	{
+		Cell.VegetationDensity = Random.FRand();
+	}
+	FSimulationCellStore RasterCells;
+	RasterCells.Initialize(LandscapeCells, DimensionX, DimensionY);
+
+	FSolarRadiationTable RadiationTable;
+	RadiationTable.Build(ParameterCells, 1);
+
+	// The same vegetation for all cells, without interception both kernels have to agree
+	FDegreeDayParameters Parameters;
+	Parameters.VegetationDensity = 0.3f;
+	Parameters.CanopyInterception = 0;
+
+	FSimulationCellStore PrecomputedCells = ParameterCells;
+	FDegreeDayCPUKernel::UpdateMeltCoefficients(PrecomputedCells, Parameters);
+
+	const int32 NumCells = ParameterCells.Num();
+
+	FDegreeDayKernelFeatures Features;
+	Features.Interpolation = false;
+	const FDegreeDayKernelFunction ParameterKernel = FDegreeDayCPUKernel::GetVectorKernel(Features);
+	Features.Vegetation = false;
+	const FDegreeDayKernelFunction PrecomputedKernel = FDegreeDayCPUKernel::GetVectorKernel(Features);
+
+	FDegreeDayParameters RasterParameters;
+	RasterParameters.CanopyInterception = 0.4f;
+	FDegreeDayCPUKernel::UpdateMeltCoefficients(RasterCells, RasterParameters);
+
+	double ParameterSeconds = 0;
+	double PrecomputedSeconds = 0;
+	for (int32 Hour = 0; Hour < Hours; ++Hour)
+	{
+		const FDegreeDayForcing Forcing = GetBenchmarkForcing(ClimateData, Hour);
+		const float* RadiationIndex = RadiationTable.GetDay(Forcing.DayOfYear);
+
+		double StartSeconds = FPlatformTime::Seconds();
+		ParameterKernel(FDegreeDayCellRange(ParameterCells, 0, NumCells, RadiationIndex), Parameters, Forcing);
+		ParameterSeconds += FPlatformTime::Seconds() - StartSeconds;
+
+		StartSeconds = FPlatformTime::Seconds();
+		PrecomputedKernel(FDegreeDayCellRange(PrecomputedCells, 0, NumCells, RadiationIndex), Parameters, Forcing);
+		PrecomputedSeconds += FPlatformTime::Seconds() - StartSeconds;
+
+		PrecomputedKernel(FDegreeDayCellRange(RasterCells, 0, NumCells, RadiationIndex), RasterParameters, Forcing);
+	}
+
+	float MaxRelativeError = 0;
+	double ParameterSnow = 0;
+	double RasterSnow = 0;
+	for (int32 Index = 0; Index < NumCells; ++Index)
+	{
+		const float Expected = ParameterCells.SnowWaterEquivalent[Index];
+		MaxRelativeError = FMath::Max(MaxRelativeError, FMath::Abs(Expected - PrecomputedCells.SnowWaterEquivalent[Index]) / FMath::Max(FMath::Abs(Expected), 1.0f));
+
+		ParameterSnow += ParameterCells.SnowWaterEquivalent[Index] * ParameterCells.InverseAreaSquareMeters[Index];
+		RasterSnow += RasterCells.SnowWaterEquivalent[Index] * RasterCells.InverseAreaSquareMeters[Index];
+	}
+
+	const double Evaluations = static_cast<double>(NumCells) * Hours;
+	UE_LOG(SimulationLog, Display, TEXT("Vegetation: %d cells, %d hours, max relative SWE error of the precomputed melt coefficients %e"), NumCells, Hours, MaxRelativeError);
+	UE_LOG(SimulationLog, Display, TEXT("Vegetation factor from the parameters took %f ns per cell and hour, precomputed %f ns (%.2fx)"),
+		ParameterSeconds * 1e9 / Evaluations, PrecomputedSeconds * 1e9 / Evaluations, ParameterSeconds / FMath::Max(PrecomputedSeconds, 1e-9));
+	UE_LOG(SimulationLog, Display, TEXT("Mean snow with a vegetation density of %.1f %.1f mm, with the random raster and %.0f%% interception %.1f mm"),
+		Parameters.VegetationDensity, NumCells > 0 ? ParameterSnow / NumCells : 0.0, RasterParameters.CanopyInterception * 100, NumCells > 0 ? RasterSnow / NumCells : 0.0);
+}
+
+static FAutoConsoleCommand BenchmarkVegetationCommand(
+	TEXT("Simulation.BenchmarkVegetation"),
+	TEXT("Compares the precomputed melt coefficients of the cells with the vegetation factor of the parameters. Arguments: [CellsX] [CellsY] [Hours]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkVegetation));
+
+/**
+* Simulates a synthetic valley on the uniform grid and on the leaves of the adaptive quadtree and reports the compression
+* and the error of the reconstructed snow against the uniform grid.
+*/
+static void ValidateQuadtree(const TArray<FString>& Args)
+{
+	const int32 DimensionX = FSimulationBenchmark::GetArgument(Args, 0, 256);
+	const int32 DimensionY = FSimulationBenchmark::GetArgument(Args, 1, 256);
+	const int32 Hours = FSimulationBenchmark::GetArgument(Args, 2, 24 * 180);
+
+	FCellQuadtreeTolerances Tolerances;
+	Tolerances.Altitude = FSimulationBenchmark::GetArgument(Args, 3, 20) * 100;
+	Tolerances.MaxLevel = FSimulationBenchmark::GetArgument(Args, 4, Tolerances.MaxLevel);
+
+	TArray<FLandscapeCell> LandscapeCells;
+	FSimulationBenchmark::CreateValleyTerrain(DimensionX, DimensionY, LandscapeCells);
+
+	TArray<FClimateData> ClimateData;
+	FSimulationBenchmark::CreateClimate(Hours, ClimateData);
+
+	FCellQuadtree Quadtree;
+	TArray<FLandscapeCell> LeafLandscapeCells;
+	Quadtree.Build(LandscapeCells, DimensionX, DimensionY, Tolerances, LeafLandscapeCells);
+
+	FSimulationCellStore GridCells;
+	GridCells.Initialize(LandscapeCells, DimensionX, DimensionY);
+
+	FSimulationCellStore LeafCells;
+	LeafCells.Initialize(LeafLandscapeCells, LeafLandscapeCells.Num(), 1);
+
+	FBloeschlParameters Interpolation;
+	for (int32 Index = 0; Index < GridCells.Num(); ++Index)
+	{
+		GridCells.InterpolationFactor[Index] = Interpolation.GetInterpolationFactor(GridCells.Inclination[Index], GridCells.Curvature[Index]);
+	}
+	FSimulationCellStore ReconstructedCells = GridCells;
+
+	FSolarRadiationTable GridRadiationTable;
+	GridRadiationTable.Build(GridCells, 1);
+	FSolarRadiationTable LeafRadiationTable;
+	LeafRadiationTable.Build(LeafCells, 1);
+
+	const FDegreeDayParameters Parameters;
+	FDegreeDayKernelFeatures Features;
+	Features.Interpolation = false;
+	const FDegreeDayKernelFunction Kernel = FDegreeDayCPUKernel::GetVectorKernel(Features);
+
+	const int32 NumCells = GridCells.Num();
+	const int32 NumLeaves = LeafCells.Num();
+
+	double GridSeconds = 0;
+	double LeafSeconds = 0;
+	for (int32 Hour = 0; Hour < Hours; ++Hour)
+	{
+		const FDegreeDayForcing Forcing = GetBenchmarkForcing(ClimateData, Hour);
+
+		double StartSeconds = FPlatformTime::Seconds();
+		Kernel(FDegreeDayCellRange(GridCells, 0, NumCells, GridRadiationTable.GetDay(Forcing.DayOfYear)), Parameters, Forcing);
+		GridSeconds += FPlatformTime::Seconds() - StartSeconds;
+
+		StartSeconds = FPlatformTime::Seconds();
+		Kernel(FDegreeDayCellRange(LeafCells, 0, NumLeaves, LeafRadiationTable.GetDay(Forcing.DayOfYear)), Parameters, Forcing);
+		LeafSeconds += FPlatformTime::Seconds() - StartSeconds;
+	}
+
+	const double StartSeconds = FPlatformTime::Seconds();
+	Quadtree.Reconstruct(LeafCells, ReconstructedCells, 0, DimensionY);
+	const double ReconstructionSeconds = FPlatformTime::Seconds() - StartSeconds;
+
+	// Error of the interpolated snow height of the grid cells
+	double GridSnow = 0;
+	double ReconstructedSnow = 0;
+	double SumAbsoluteError = 0;
+	float MaxAbsoluteError = 0;
+	for (int32 Index = 0; Index < NumCells; ++Index)
+	{
+		const float Expected = FMath::Max(0.0f, GridCells.SnowWaterEquivalent[Index] * GridCells.InterpolationFactor[Index]) * GridCells.InverseAreaSquareMeters[Index];
+		const float Actual = ReconstructedCells.GetInterpolatedSnowHeight(Index);
+		const float AbsoluteError = FMath::Abs(Expected - Actual);
+
+		GridSnow += GridCells.SnowWaterEquivalent[Index];
+		ReconstructedSnow += ReconstructedCells.SnowWaterEquivalent[Index];
+		SumAbsoluteError += AbsoluteError;
+		MaxAbsoluteError = FMath::Max(MaxAbsoluteError, AbsoluteError);
+	}
+
+	UE_LOG(SimulationLog, Display, TEXT("Quadtree: %d cells merged into %d leaves, compression ratio %.2f, %d hours"), NumCells, NumLeaves, Quadtree.GetCompressionRatio(), Hours);
+	UE_LOG(SimulationLog, Display, TEXT("Quadtree: mean absolute error %.3f mm, max absolute error %.3f mm, relative error of the total SWE %e"),
+		NumCells > 0 ? SumAbsoluteError / NumCells : 0.0, MaxAbsoluteError, GridSnow > 0 ? (ReconstructedSnow - GridSnow) / GridSnow : 0.0);
+	UE_LOG(SimulationLog, Display, TEXT("Quadtree: uniform grid took %f ms, leaves %f ms (%.2fx) and one reconstruction %f ms"),
+		GridSeconds * 1000, LeafSeconds * 1000, GridSeconds / FMath::Max(LeafSeconds, 1e-9), ReconstructionSeconds * 1000);
+}
+
+static FAutoConsoleCommand ValidateQuadtreeCommand(
+	TEXT("Simulation.ValidateQuadtree"),
+	TEXT("Compares the adaptive quadtree of a synthetic valley with the uniform grid. Arguments: [CellsX] [CellsY] [Hours] [AltitudeTolerance m] [MaxLevel]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&ValidateQuadtree));
+
+/**
+* Simulates growing square landscapes with the camera in the center of the multi resolution grid hour by hour like
+* UDegreeDayMultiResolutionCPUSimulation with a time step of one hour. Every step advances the tiles at their levels
+* and then reads the interpolated snow of all grid cells like the snow map. The time per step of both and the number of
+* simulated cells are reported for every size, then the camera moves to a corner and back and the conservation of the
+* snow is checked. The default sizes of 256 to 2048 cells per dimension cover landscapes of 6.5 to 420 km^2.
+*/
+static void BenchmarkMultiResolution(const TArray<FString>& Args)
+{
+	const int32 MaxDimension = FSimulationBenchmark::GetArgument(Args, 0, 2048);
+	const int32 Hours = FMath::Max(1, FSimulationBenchmark::GetArgument(Args, 1, 24 * 7));
+	const float FineRadius = FSimulationBenchmark::GetArgument(Args, 2, 500) * 100.0f;
+	const int32 NumLevels = FSimulationBenchmark::GetArgument(Args, 3, 5);
+
+	TArray<FClimateData> ClimateData;
+	FSimulationBenchmark::CreateClimate(Hours, ClimateData);
+
+	TArray<FDegreeDayForcing> HourForcing;
+	for (int32 Hour = 0; Hour < Hours; ++Hour)
+	{
+		HourForcing.Add(GetBenchmarkForcing(ClimateData, Hour));
+	}
+
+	const FDegreeDayParameters Parameters;
+	FDegreeDayKernelFeatures Features;
+	Features.DiurnalRadiation = false;
+	Features.Vegetation = false;
+	Features.Interpolation = false;
+	const FDegreeDayKernelFunction Kernel = FDegreeDayCPUKernel::GetVectorKernel(Features);
+	const int32 NumTasks = FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+
+	// Every tile is advanced every hour, so only the spatial levels reduce the work
+	FTemporalTileSettings Settings;
+	Settings.MaxUpdateInterval = 1;
+	Settings.MaxCatchUpTiles = 0;
+
+	double SmallestStepSeconds = 0;
+
+	for (int32 Dimension = 256; Dimension <= MaxDimension; Dimension *= 2)
+	{
+		TArray<FLandscapeCell> LandscapeCells;
+		FSimulationBenchmark::CreateTerrain(Dimension, Dimension, LandscapeCells);
+
+		FMultiResolutionGrid Grid;
+		Grid.Initialize(LandscapeCells, Dimension, Dimension, NumLevels);
+		for (int32 Level = 0; Level < Grid.GetNumLevels(); ++Level)
+		{
+			FDegreeDayCPUKernel::UpdateMeltCoefficients(Grid.GetLevelCells(Level), Parameters);
+		}
+
+		// The cells of the benchmark terrain are 10m wide
+		const FVector Center(Dimension * 1000.0f / 2, Dimension * 1000.0f / 2, 0);
+		Grid.UpdateLevels(Center, FineRadius, 0);
+
+		FTemporalTileScheduler Scheduler;
+		Scheduler.Initialize(Grid, 1000.0f);
+
+		const int32 NumCells = Dimension * Dimension;
+		TArray<float> SnowMap;
+		SnowMap.SetNumUninitialized(NumCells);
+
+		double StepSeconds = 0;
+		double MaxStepSeconds = 0;
+		double SnowMapSeconds = 0;
+		for (int32 Hour = 0; Hour < Hours; ++Hour)
+		{
+			const double StartSeconds = FPlatformTime::Seconds();
+			Grid.UpdateLevels(Center, FineRadius, 0);
+			Scheduler.Schedule(Grid, Center, Hour, Hour + 1, Settings);
+			Scheduler.Advance(Grid, HourForcing, 0, Parameters, Kernel, NumTasks);
+			const double SnowMapStartSeconds = FPlatformTime::Seconds();
+
+			const float MaxSnow = FMath::Max(Scheduler.GetMaxSnow(), 1.0f);
+			for (int32 Index = 0; Index < NumCells; ++Index)
+			{
+				SnowMap[Index] = Grid.GetInterpolatedSnowHeight(Index) / MaxSnow;
+			}
+			const double EndSeconds = FPlatformTime::Seconds();
+
+			StepSeconds += SnowMapStartSeconds - StartSeconds;
+			MaxStepSeconds = FMath::Max(MaxStepSeconds, SnowMapStartSeconds - StartSeconds);
+			SnowMapSeconds += EndSeconds - SnowMapStartSeconds;
+		}
+
+		if (Dimension == 256)
+		{
+			SmallestStepSeconds = StepSeconds;
+		}
+
+		// The snow moves between the levels when the camera moves to a corner and back
+		const double SnowBefore = Grid.GetSnowWaterEquivalent();
+		const double TransferStartSeconds = FPlatformTime::Seconds();
+		const int32 NumChangedTiles = Grid.UpdateLevels(FVector::ZeroVector, FineRadius, 0) + Grid.UpdateLevels(Center, FineRadius, 0);
+		const double TransferSeconds = FPlatformTime::Seconds() - TransferStartSeconds;
+		const double SnowAfter = Grid.GetSnowWaterEquivalent();
+
+		UE_LOG(SimulationLog, Display, TEXT("Multi resolution: %.1f km^2, %d of %d cells simulated (%.2f%%), %f ms per step (max %f ms, %.2f times the smallest landscape), snow map %f ms per step"),
+			NumCells * 1e-4f, Grid.GetNumSimulatedCells(), NumCells, 100.0f * Grid.GetNumSimulatedCells() / NumCells, StepSeconds * 1000 / Hours, MaxStepSeconds * 1000,
+			SmallestStepSeconds > 0 ? StepSeconds / SmallestStepSeconds : 0.0, SnowMapSeconds * 1000 / Hours);
+		UE_LOG(SimulationLog, Display, TEXT("Multi resolution: %d tile level changes took %f ms, relative change of the snow %e"),
+			NumChangedTiles, TransferSeconds * 1000, SnowBefore > 0 ? (SnowAfter - SnowBefore) / SnowBefore : 0.0);
+	}
+}
+
+static FAutoConsoleCommand BenchmarkMultiResolutionCommand(
+	TEXT("Simulation.BenchmarkMultiResolution"),
+	TEXT("Simulates growing landscapes with a multi resolution grid around the center hour by hour. Arguments: [MaxCellsPerDimension] [Hours] [FineRadius m] [NumLevels]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkMultiResolution));
+
+/**
+* Simulates a synthetic valley on a multi resolution grid hour by hour with every tile advanced every hour and with the
+* temporal level of detail. The camera moves to a corner halfway through, so the tiles around it have to catch up. At
+* the end all tiles catch up and the snow is compared with the hourly simulation.
+*/
+static void BenchmarkTemporalLOD(const TArray<FString>& Args)
+{
+	const int32 Dimension = FSimulationBenchmark::GetArgument(Args, 0, 512);
+	const int32 Hours = FSimulationBenchmark::GetArgument(Args, 1, 24 * 30);
+
+	FTemporalTileSettings Settings;
+	Settings.HourlyRadius = FSimulationBenchmark::GetArgument(Args, 2, 1000) * 100.0f;
+	Settings.MaxUpdateInterval = FSimulationBenchmark::GetArgument(Args, 3, 8);
+	Settings.MaxCatchUpTiles = FSimulationBenchmark::GetArgument(Args, 4, 16);
+
+	FTemporalTileSettings HourlySettings;
+	HourlySettings.MaxUpdateInterval = 1;
+	HourlySettings.MaxCatchUpTiles = 0;
+
+	const float FineRadius = 500 * 100.0f;
+	const int32 NumLevels = 5;
+	const float BandWidth = 10 * 100.0f;
+
+	TArray<FClimateData> ClimateData;
+	FSimulationBenchmark::CreateClimate(Hours, ClimateData);
+
+	TArray<FDegreeDayForcing> HourForcing;
+	for (int32 Hour = 0; Hour < Hours; ++Hour)
+	{
+		HourForcing.Add(GetBenchmarkForcing(ClimateData, Hour));
+	}
+
+	const FDegreeDayParameters Parameters;
+	FDegreeDayKernelFeatures Features;
+	Features.DiurnalRadiation = false;
+	Features.Vegetation = false;
+	Features.Interpolation = false;
+	const FDegreeDayKernelFunction Kernel = FDegreeDayCPUKernel::GetVectorKernel(Features);
+	const int32 NumTasks = FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+
+	TArray<FLandscapeCell> LandscapeCells;
+	FSimulationBenchmark::CreateValleyTerrain(Dimension, Dimension, LandscapeCells);
+
+	FMultiResolutionGrid Grids[2];
+	FTemporalTileScheduler Schedulers[2];
+	const FTemporalTileSettings* GridSettings[2] = { &HourlySettings, &Settings };
+	double Seconds[2] = { 0, 0 };
+	double MaxStepSeconds[2] = { 0, 0 };
+	int64 NumCellUpdates[2] = { 0, 0 };
+
+	// The cells of the valley are 10m wide
+	const FVector Center(Dimension * 1000.0f / 2, Dimension * 1000.0f / 2, 0);
+	const FVector Corner = FVector::ZeroVector;
+
+	for (int32 Run = 0; Run < 2; ++Run)
+	{
+		FMultiResolutionGrid& Grid = Grids[Run];
+		FTemporalTileScheduler& Scheduler = Schedulers[Run];
+
+		Grid.Initialize(LandscapeCells, Dimension, Dimension, NumLevels);
+		for (int32 Level = 0; Level < Grid.GetNumLevels(); ++Level)
+		{
+			FDegreeDayCPUKernel::UpdateMeltCoefficients(Grid.GetLevelCells(Level), Parameters);
+		}
+		Grid.UpdateLevels(Center, FineRadius, 0);
+		Scheduler.Initialize(Grid, BandWidth);
+	}
+
+	int32 MaxCatchUpTiles = 0;
+	int32 CatchUpSteps = 0;
+
+	for (int32 Hour = 0; Hour < Hours; ++Hour)
+	{
+		const FVector& Camera = Hour < Hours / 2 ? Center : Corner;
+
+		for (int32 Run = 0; Run < 2; ++Run)
+		{
+			FMultiResolutionGrid& Grid = Grids[Run];
+			FTemporalTileScheduler& Scheduler = Schedulers[Run];
+
+			const double StartSeconds = FPlatformTime::Seconds();
+			Grid.UpdateLevels(Camera, FineRadius, 0);
+			Scheduler.Schedule(Grid, Camera, Hour, Hour + 1, *GridSettings[Run]);
+			Scheduler.Advance(Grid, HourForcing, 0, Parameters, Kernel, NumTasks);
+			const double StepSeconds = FPlatformTime::Seconds() - StartSeconds;
+
+			Seconds[Run] += StepSeconds;
+			MaxStepSeconds[Run] = FMath::Max(MaxStepSeconds[Run], StepSeconds);
+			NumCellUpdates[Run] += Scheduler.GetNumCellUpdates();
+		}
+
+		// The tiles around the corner catch up after the camera moved
+		const FTemporalTileScheduler& Scheduler = Schedulers[1];
+		MaxCatchUpTiles = FMath::Max(MaxCatchUpTiles, Scheduler.GetNumCatchUpTiles());
+		if (Scheduler.GetNumCatchUpTiles() > 0 && Hour >= Hours / 2)
+		{
+			CatchUpSteps++;
+		}
+	}
+
+	// All tiles catch up to the end
+	FTemporalTileSettings SynchronizeSettings;
+	SynchronizeSettings.HourlyRadius = MAX_FLT;
+	SynchronizeSettings.MaxCatchUpTiles = 0;
+
+	const double SynchronizeStartSeconds = FPlatformTime::Seconds();
+	Schedulers[1].Schedule(Grids[1], Corner, Hours, Hours, SynchronizeSettings);
+	const int32 NumSynchronizedTiles = Schedulers[1].GetNumScheduledTiles();
+	Schedulers[1].Advance(Grids[1], HourForcing, 0, Parameters, Kernel, NumTasks);
+	const double SynchronizeSeconds = FPlatformTime::Seconds() - SynchronizeStartSeconds;
+
+	int32 NumLaggingTiles = 0;
+	for (int32 Tile = 0; Tile < Grids[1].GetNumTiles(); ++Tile)
+	{
+		if (Schedulers[1].GetTileTime(Tile) != Hours)
+		{
+			NumLaggingTiles++;
+		}
+	}
+
+	// Error of the interpolated snow height of the grid cells, both grids have the same levels
+	const int32 NumCells = Dimension * Dimension;
+	const double HourlySnow = Grids[0].GetSnowWaterEquivalent();
+	const double TemporalSnow = Grids[1].GetSnowWaterEquivalent();
+
+	double SumAbsoluteError = 0;
+	float MaxAbsoluteError = 0;
+	for (int32 Index = 0; Index < NumCells; ++Index)
+	{
+		const float AbsoluteError = FMath::Abs(Grids[0].GetInterpolatedSnowHeight(Index) - Grids[1].GetInterpolatedSnowHeight(Index));
+		SumAbsoluteError += AbsoluteError;
+		MaxAbsoluteError = FMath::Max(MaxAbsoluteError, AbsoluteError);
+	}
+
+	UE_LOG(SimulationLog, Display, TEXT("Temporal LOD: %d tiles, %d hours, hourly radius %.0f m, update interval up to %d hours, up to %d catch up tiles per step"),
+		Grids[1].GetNumTiles(), Hours, Settings.HourlyRadius / 100, Settings.MaxUpdateInterval, Settings.MaxCatchUpTiles);
+	UE_LOG(SimulationLog, Display, TEXT("Temporal LOD: hourly %lld cell updates, %f ms per hour, max step %f ms"),
+		NumCellUpdates[0], Seconds[0] * 1000 / FMath::Max(1, Hours), MaxStepSeconds[0] * 1000);
+	UE_LOG(SimulationLog, Display, TEXT("Temporal LOD: temporal %lld cell updates (%.2f%%), %f ms per hour, max step %f ms"),
+		NumCellUpdates[1], NumCellUpdates[0] > 0 ? 100.0 * NumCellUpdates[1] / NumCellUpdates[0] : 0.0, Seconds[1] * 1000 / FMath::Max(1, Hours), MaxStepSeconds[1] * 1000);
+	UE_LOG(SimulationLog, Display, TEXT("Temporal LOD: up to %d tiles caught up per step, catch up after the camera moved took %d steps"), MaxCatchUpTiles, CatchUpSteps);
+	UE_LOG(SimulationLog, Display, TEXT("Temporal LOD: %d tiles caught up to the end in %f ms, %d tiles lag behind"), NumSynchronizedTiles, SynchronizeSeconds * 1000, NumLaggingTiles);
+	UE_LOG(SimulationLog, Display, TEXT("Temporal LOD: mean absolute error %.3f mm, max absolute error %.3f mm, relative error of the total SWE %e"),
+		NumCells > 0 ? SumAbsoluteError / NumCells : 0.0, MaxAbsoluteError, HourlySnow > 0 ? (TemporalSnow - HourlySnow) / HourlySnow : 0.0);
+}
+
+static FAutoConsoleCommand BenchmarkTemporalLODCommand(
+	TEXT("Simulation.BenchmarkTemporalLOD"),
+	TEXT("Compares the temporal level of detail of a multi resolution grid with advancing every tile every hour. Arguments: [CellsPerDimension] [Hours] [HourlyRadius m] [MaxUpdateInterval] [MaxCatchUpTiles]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkTemporalLOD));
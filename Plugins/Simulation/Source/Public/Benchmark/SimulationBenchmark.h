@@ -0,0 +1,53 @@
+#pragma once
+
+#include "ClimateData.h"
+#include "Cells/LandscapeCell.h"
+
+/**
+* Synthetic input data for the benchmark and validation console commands of the simulation. The data is generated from
+* a fixed seed so runs are comparable.
+*/
+class SIMULATION_API FSimulationBenchmark
+{
+public:
+	/** Returns the altitude of the synthetic measurement station in cm. */
+	static float GetMeasurementAltitude()
+	{
+		return 150000.0f;
+	}
+
+	/**
+	* Creates a synthetic terrain of rolling hills with cells of 10m x 10m between 500m and 2500m.
+	*
+	* @param DimensionX	Number of cells in x direction
+	* @param DimensionY	Number of cells in y direction
+	* @param OutCells		The created cells stored row by row
+	* @param LatitudeSpan	Difference of the latitude between the first and the last row in degrees
+	*/
+	static void CreateTerrain(int32 DimensionX, int32 DimensionY, TArray<FLandscapeCell>& OutCells, float LatitudeSpan = 0);
+
+	/**
+	* Creates a synthetic valley of cells of 10m x 10m along the y axis: a flat floor at 1200m in the middle third, uniform
+	* slopes of 25 degrees on both sides and rough ridges in the outer tenth.
+	*
+	* @param DimensionX	Number of cells in x direction
+	* @param DimensionY	Number of cells in y direction
+	* @param OutCells		The created cells stored row by row
+	*/
+	static void CreateValleyTerrain(int32 DimensionX, int32 DimensionY, TArray<FLandscapeCell>& OutCells);
+
+	/**
+	* Creates a synthetic hourly climate series starting on the first of october with a seasonal temperature cycle and
+	* random precipitation events.
+	*
+	* @param Hours			Number of hours
+	* @param OutClimateData	The created climate data
+	*/
+	static void CreateClimate(int32 Hours, TArray<FClimateData>& OutClimateData);
+
+	/** Returns the integer argument at the given index or the default value if there is no such argument. */
+	static int32 GetArgument(const TArray<FString>& Args, int32 Index, int32 DefaultValue)
+	{
+		return Args.IsValidIndex(Index) ? FCString::Atoi(*Args[Index]) : DefaultValue;
+	}
+};
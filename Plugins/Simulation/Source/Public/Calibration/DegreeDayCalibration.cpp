@@ -0,0 +1,263 @@
+#include "Simulation.h"
+#include "DegreeDayCalibration.h"
+#include "NelderMead.h"
+#include "SnowSimulationActor.h"
+#include "Util/RasterUtil.h"
+#include "ParallelFor.h"
+
+const int32 FCalibrationCandidate::NumDimensions;
+
+TArray<float> FCalibrationCandidate::ToPoint() const
+{
+	TArray<float> Point;
+	Point.Add(DegreeDay.k_m);
+	Point.Add(DegreeDay.k_e);
+	Point.Add(DegreeDay.TMeltA);
+	Point.Add(DegreeDay.TMeltB);
+	Point.Add(DegreeDay.TSnowA);
+	Point.Add(DegreeDay.TSnowB);
+	Point.Add(Interpolation.a3);
+	Point.Add(Interpolation.MinSlope);
+	Point.Add(Interpolation.MaxSlope);
+	return Point;
+}
+
+FCalibrationCandidate FCalibrationCandidate::FromPoint(const TArray<float>& Point, const FCalibrationCandidate& Initial)
+{
+	FCalibrationCandidate Candidate = Initial;
+	Candidate.DegreeDay.k_m = FMath::Clamp(Point[0], 0.1f, 20.0f);
+	Candidate.DegreeDay.k_e = FMath::Clamp(Point[1], 0.01f, 2.0f);
+	Candidate.DegreeDay.TMeltA = FMath::Clamp(Point[2], -15.0f, 5.0f);
+	Candidate.DegreeDay.TMeltB = FMath::Clamp(Point[3], Candidate.DegreeDay.TMeltA + 0.1f, 10.0f);
+	Candidate.DegreeDay.TSnowA = FMath::Clamp(Point[4], -5.0f, 5.0f);
+	Candidate.DegreeDay.TSnowB = FMath::Clamp(Point[5], Candidate.DegreeDay.TSnowA + 0.1f, 8.0f);
+	Candidate.Interpolation.a3 = FMath::Clamp(Point[6], 0.0f, 200.0f);
+	Candidate.Interpolation.MinSlope = FMath::Clamp(Point[7], 0.0f, 60.0f);
+	Candidate.Interpolation.MaxSlope = FMath::Clamp(Point[8], Candidate.Interpolation.MinSlope + 1, 90.0f);
+	return Candidate;
+}
+
+TArray<float> FCalibrationCandidate::GetSteps()
+{
+	return TArray<float>({ 1.0f, 0.1f, 1.0f, 1.0f, 0.5f, 0.5f, 20.0f, 5.0f, 10.0f });
+}
+
+void FDegreeDayCalibrationCache::Initialize(const TArray<FLandscapeCell>& LandscapeCells, int32 DimensionX, int32 DimensionY, const FClimateDataView& ClimateData, FDateTime CacheStartTime, float MeasurementAltitude)
+{
+	StartTime = CacheStartTime;
+
+	Cells.Initialize(LandscapeCells, DimensionX, DimensionY);
+	RadiationTable.Build(Cells, 1);
+
+	HourForcing.Reset(ClimateData.Num());
+	for (int32 Hour = 0; Hour < ClimateData.Num(); ++Hour)
+	{
+		FDegreeDayForcing Forcing;
+		Forcing.Temperature = ClimateData.Get(Hour).Temperature;
+		Forcing.Precipitation = ClimateData.Get(Hour).Precipitation;
+		Forcing.MeasurementAltitude = MeasurementAltitude;
+		Forcing.DayOfYear = (StartTime + FTimespan(Hour, 0, 0)).GetDayOfYear();
+		HourForcing.Add(Forcing);
+	}
+
+	Observations.Empty();
+}
+
+bool FDegreeDayCalibrationCache::AddObservation(const FCalibrationObservation& Observation)
+{
+	FObservation Observed;
+	Observed.Hour = FMath::FloorToInt((Observation.Time - StartTime).GetTotalHours());
+	Observed.SnowCover = Observation.SnowCover;
+
+	if (Observed.Hour < 0 || Observed.Hour > HourForcing.Num()) return false;
+	if (!LoadAsciiGrid(Observation.FilePath, Cells.DimensionX, Cells.DimensionY, Observed.Values)) return false;
+
+	Observed.NumValid = 0;
+	for (float Value : Observed.Values)
+	{
+		if (Value >= 0) Observed.NumValid++;
+	}
+
+	// The observations are sorted by time
+	int32 Position = 0;
+	while (Position < Observations.Num() && Observations[Position].Hour <= Observed.Hour) Position++;
+	Observations.Insert(Observed, Position);
+
+	return true;
+}
+
+void FDegreeDayCalibrationCache::Evaluate(const TArray<FCalibrationCandidate>& Candidates, TArray<float>& OutErrors) const
+{
+	const int32 NumCandidates = Candidates.Num();
+	const int32 NumObservations = Observations.Num();
+	const int32 NumCells = Cells.Num();
+
+	// The candidates are the members of an ensemble
+	TArray<FDegreeDayParameters> Parameters;
+	for (const FCalibrationCandidate& Candidate : Candidates)
+	{
+		Parameters.Add(Candidate.DegreeDay);
+	}
+
+	FDegreeDayEnsembleMembers Members;
+	Members.Initialize(Parameters);
+
+	FDegreeDayEnsembleState State;
+	State.Initialize(Cells, Members);
+
+	const int32 Stride = State.Stride;
+	const int32 CellsPerTile = FMath::Max(1, TileRows) * Cells.DimensionX;
+	const int32 NumTiles = FMath::DivideAndRoundUp(NumCells, CellsPerTile);
+
+	// Error sums of every tile, observation and candidate
+	TArray<double> TileErrors;
+	TileErrors.SetNumZeroed(NumTiles * NumObservations * NumCandidates);
+
+	ParallelFor(NumTiles, [&](int32 Tile)
+	{
+		const int32 BeginIndex = Tile * CellsPerTile;
+		const int32 EndIndex = FMath::Min(BeginIndex + CellsPerTile, NumCells);
+
+		int32 Hour = 0;
+		for (int32 Observation = 0; Observation < NumObservations; ++Observation)
+		{
+			const FObservation& Observed = Observations[Observation];
+
+			// Simulate until the observation
+			for (; Hour < Observed.Hour; ++Hour)
+			{
+				const FDegreeDayForcing& Forcing = HourForcing[Hour];
+				FDegreeDayEnsembleKernel::Simulate(State, Members, Cells, BeginIndex, EndIndex, Forcing, RadiationTable.GetDay(Forcing.DayOfYear));
+			}
+
+			double* Errors = TileErrors.GetData() + (Tile * NumObservations + Observation) * NumCandidates;
+			for (int32 Index = BeginIndex; Index < EndIndex; ++Index)
+			{
+				const float Value = Observed.Values[Index];
+				if (Value < 0) continue;
+
+				const float AreaSquareMeters = Cells.Area[Index] / (100 * 100);
+
+				for (int32 Candidate = 0; Candidate < NumCandidates; ++Candidate)
+				{
+					const float Factor = Candidates[Candidate].Interpolation.GetInterpolationFactor(Cells.Inclination[Index], Cells.Curvature[Index]);
+					const float Snow = FMath::Max(0.0f, State.SnowWaterEquivalent[Index * Stride + Candidate] * Factor) / AreaSquareMeters;
+
+					if (Observed.SnowCover)
+					{
+						Errors[Candidate] += (Snow > SnowCoverThreshold) != (Value >= 0.5f) ? 1 : 0;
+					}
+					else
+					{
+						Errors[Candidate] += (Snow - Value) * (Snow - Value);
+					}
+				}
+			}
+		}
+	});
+
+	// Average the errors of the observations
+	OutErrors.Init(0, NumCandidates);
+	for (int32 Observation = 0; Observation < NumObservations; ++Observation)
+	{
+		const FObservation& Observed = Observations[Observation];
+		if (Observed.NumValid == 0) continue;
+
+		for (int32 Candidate = 0; Candidate < NumCandidates; ++Candidate)
+		{
+			double Sum = 0;
+			for (int32 Tile = 0; Tile < NumTiles; ++Tile)
+			{
+				Sum += TileErrors[(Tile * NumObservations + Observation) * NumCandidates + Candidate];
+			}
+
+			const double Error = Observed.SnowCover ? SnowCoverWeight * Sum / Observed.NumValid : FMath::Sqrt(Sum / Observed.NumValid);
+			OutErrors[Candidate] += Error / NumObservations;
+		}
+	}
+}
+
+FString UDegreeDayCalibration::GetSimulationName()
+{
+	return FString(TEXT("Degree Day CPU Calibration"));
+}
+
+void UDegreeDayCalibration::Initialize(ASnowSimulationActor* SimulationActor, const TArray<FLandscapeCell>& LandscapeCells, float InitialMaxSnow, UWorld* World)
+{
+	FDegreeDayCalibrationCache Cache;
+	Cache.SnowCoverThreshold = SnowCoverThreshold;
+	Cache.SnowCoverWeight = SnowCoverWeight;
+	Cache.TileRows = TileRows;
+	Cache.Initialize(LandscapeCells, SimulationActor->CellsDimensionX, SimulationActor->CellsDimensionY, SimulationActor->ClimateDataComponent->GetClimateDataView(),
+		SimulationActor->StartTime, SimulationActor->ClimateDataComponent->GetMeasurementAltitude());
+
+	for (const FCalibrationObservation& Observation : Observations)
+	{
+		if (!Cache.AddObservation(Observation))
+		{
+			UE_LOG(SimulationLog, Warning, TEXT("Observation %s could not be loaded or lies outside of the weather data"), *Observation.FilePath);
+		}
+	}
+
+	FCalibrationCandidate Calibrated;
+	Calibrated.DegreeDay = InitialParameters;
+	Calibrated.Interpolation = Interpolation;
+	CalibratedError = 0;
+
+	if (Cache.GetNumObservations() > 0)
+	{
+		const double StartSeconds = FPlatformTime::Seconds();
+
+		// The points are clamped to the valid parameters, so the simplex does not drift outside of the valid range
+		const FCalibrationCandidate Initial = Calibrated;
+		auto Function = [&Cache, &Initial](TArray<TArray<float>>& Points, TArray<float>& OutValues)
+		{
+			TArray<FCalibrationCandidate> Candidates;
+			for (TArray<float>& Point : Points)
+			{
+				Candidates.Add(FCalibrationCandidate::FromPoint(Point, Initial));
+				Point = Candidates.Last().ToPoint();
+			}
+			Cache.Evaluate(Candidates, OutValues);
+		};
+
+		auto Progress = [](int32 Iteration, float Error)
+		{
+			if (Iteration % 10 == 0)
+			{
+				UE_LOG(SimulationLog, Display, TEXT("Calibration iteration %d, error %f"), Iteration, Error);
+			}
+		};
+
+		const FNelderMead::FResult Result = FNelderMead::Minimize(Function, Calibrated.ToPoint(), FCalibrationCandidate::GetSteps(), MaxIterations, Tolerance, Progress);
+
+		Calibrated = FCalibrationCandidate::FromPoint(Result.Point, Initial);
+		CalibratedError = Result.Value;
+
+		UE_LOG(SimulationLog, Display, TEXT("Calibration took %f s, %d iterations and %d evaluations, error %f"), FPlatformTime::Seconds() - StartSeconds,
+			Result.Iterations, Result.Evaluations, CalibratedError);
+		UE_LOG(SimulationLog, Display, TEXT("Calibrated parameters: k_m %f, k_e %f, TMeltA %f, TMeltB %f, TSnowA %f, TSnowB %f, a3 %f, MinSlope %f, MaxSlope %f"),
+			Calibrated.DegreeDay.k_m, Calibrated.DegreeDay.k_e, Calibrated.DegreeDay.TMeltA, Calibrated.DegreeDay.TMeltB, Calibrated.DegreeDay.TSnowA, Calibrated.DegreeDay.TSnowB,
+			Calibrated.Interpolation.a3, Calibrated.Interpolation.MinSlope, Calibrated.Interpolation.MaxSlope);
+	}
+	else
+	{
+		UE_LOG(SimulationLog, Warning, TEXT("No observations to calibrate against, the initial parameters are used"));
+	}
+
+	CalibratedParameters = Calibrated.DegreeDay;
+	CalibratedInterpolation = Calibrated.Interpolation;
+
+	// Show the snow of the calibrated parameters, see GetSimulatedMembers
+	Super::Initialize(SimulationActor, LandscapeCells, InitialMaxSnow, World);
+}
+
+TArray<FDegreeDayParameters> UDegreeDayCalibration::GetSimulatedMembers() const
+{
+	return TArray<FDegreeDayParameters>({ CalibratedParameters });
+}
+
+const FBloeschlParameters& UDegreeDayCalibration::GetSimulatedInterpolation() const
+{
+	return CalibratedInterpolation;
+}
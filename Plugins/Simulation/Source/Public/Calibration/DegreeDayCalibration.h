@@ -0,0 +1,174 @@
+#pragma once
+
+#include "DegreeDay/CPU/DegreeDayEnsembleSimulation.h"
+#include "DegreeDayCalibration.generated.h"
+
+/** An observed snow raster the parameters are calibrated against. */
+USTRUCT(BlueprintType)
+struct SIMULATION_API FCalibrationObservation
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** Path of the raster in the ESRI ASCII grid format, it is resampled to the cells. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Calibration")
+	FString FilePath;
+
+	/** The time of the observation. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Calibration")
+	FDateTime Time;
+
+	/** Whether the raster contains the snow cover (0-1) instead of the snow water equivalent (mm). */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Calibration")
+	bool SnowCover = false;
+};
+
+/** A set of calibrated parameters. */
+struct SIMULATION_API FCalibrationCandidate
+{
+	FDegreeDayParameters DegreeDay;
+
+	FBloeschlParameters Interpolation;
+
+	/** Number of calibrated parameters. */
+	static const int32 NumDimensions = 9;
+
+	/** Returns the parameters as a point of the search space. */
+	TArray<float> ToPoint() const;
+
+	/**
+	* Returns the parameters of the given point of the search space clamped to their valid range. The parameters which are
+	* not calibrated, like the vegetation density and the canopy interception, are taken from the initial candidate.
+	*/
+	static FCalibrationCandidate FromPoint(const TArray<float>& Point, const FCalibrationCandidate& Initial);
+
+	/** Returns the size of the initial simplex in every dimension of the search space. */
+	static TArray<float> GetSteps();
+};
+
+/**
+* The terrain, the radiation table and the forcing of all hours up to the last observation, shared by all evaluations of
+* a calibration. A batch of candidates is simulated as the members of an ensemble in one pass over the cells, the tiles
+* of the pass are distributed on the worker threads.
+*/
+class SIMULATION_API FDegreeDayCalibrationCache
+{
+public:
+	/** An observation resampled to the cells. */
+	struct FObservation
+	{
+		/** The hour after the start of the simulation. */
+		int32 Hour;
+
+		bool SnowCover;
+
+		/** The observed value of every cell, -1 if there is no data. */
+		TArray<float> Values;
+
+		/** Number of cells with data. */
+		int32 NumValid;
+	};
+
+	/**
+	* Creates the cache.
+	*
+	* @param LandscapeCells		The cells of the terrain
+	* @param ClimateData			The weather data starting at the start time
+	* @param StartTime				Time of the first hour of the weather data
+	* @param MeasurementAltitude	Altitude of the measurements in cm
+	*/
+	void Initialize(const TArray<FLandscapeCell>& LandscapeCells, int32 DimensionX, int32 DimensionY, const FClimateDataView& ClimateData, FDateTime StartTime, float MeasurementAltitude);
+
+	/** Loads the given observation and returns true if it lies within the weather data. */
+	bool AddObservation(const FCalibrationObservation& Observation);
+
+	/** Returns the number of observations. */
+	int32 GetNumObservations() const
+	{
+		return Observations.Num();
+	}
+
+	/**
+	* Returns the error of every candidate. The error of an observation of the snow water equivalent is the root mean
+	* square error in mm, the error of an observation of the snow cover is the fraction of misclassified cells times the
+	* weight. The errors are averaged over all observations.
+	*/
+	void Evaluate(const TArray<FCalibrationCandidate>& Candidates, TArray<float>& OutErrors) const;
+
+	/** Snow in mm above which a cell is considered as covered with snow. */
+	float SnowCoverThreshold = 10;
+
+	/** Weight of the error of the snow cover observations. */
+	float SnowCoverWeight = 100;
+
+	/** Number of cell rows per tile. */
+	int32 TileRows = 8;
+
+private:
+	FSimulationCellStore Cells;
+
+	FSolarRadiationTable RadiationTable;
+
+	TArray<FDegreeDayForcing> HourForcing;
+
+	TArray<FObservation> Observations;
+
+	FDateTime StartTime;
+};
+
+/**
+* Calibrates the parameters of the degree day model and the interpolation against observed snow rasters with the
+* Nelder-Mead method and shows the snow of the calibrated parameters. The calibration runs during initialization, the
+* ensemble then simulates the calibrated parameters instead of its members. The members and the interpolation of the
+* ensemble keep the values they were set to.
+*/
+UCLASS(Blueprintable, BlueprintType)
+class SIMULATION_API UDegreeDayCalibration : public UDegreeDayEnsembleSimulation
+{
+	GENERATED_BODY()
+
+public:
+	/** The observations the parameters are calibrated against. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Calibration")
+	TArray<FCalibrationObservation> Observations;
+
+	/** The parameters the search starts with, the interpolation starts with the interpolation of the simulation. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Calibration")
+	FDegreeDayParameters InitialParameters;
+
+	/** Maximum number of iterations of the search. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Calibration", meta = (ClampMin = "1"))
+	int32 MaxIterations = 200;
+
+	/** The search stops if the errors of the simplex differ by less than this fraction of the best error. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Calibration", meta = (ClampMin = "0"))
+	float Tolerance = 1e-3f;
+
+	/** Snow in mm above which a cell is considered as covered with snow. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Calibration")
+	float SnowCoverThreshold = 10;
+
+	/** Weight of the error of the snow cover observations relative to the error of the snow water equivalent in mm. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Calibration")
+	float SnowCoverWeight = 100;
+
+	/** The calibrated parameters. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Calibration")
+	FDegreeDayParameters CalibratedParameters;
+
+	/** The calibrated interpolation. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Calibration")
+	FBloeschlParameters CalibratedInterpolation;
+
+	/** The error of the calibrated parameters. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Calibration")
+	float CalibratedError = 0;
+
+	virtual FString GetSimulationName() override final;
+
+	virtual void Initialize(ASnowSimulationActor* SimulationActor, const TArray<FLandscapeCell>& Cells, float InitialMaxSnow, UWorld* World) override final;
+
+protected:
+	virtual TArray<FDegreeDayParameters> GetSimulatedMembers() const override;
+
+	virtual const FBloeschlParameters& GetSimulatedInterpolation() const override;
+};
@@ -0,0 +1,145 @@
+#include "Simulation.h"
+#include "NelderMead.h"
+
+/** Returns A + Factor * (B - A). */
+static TArray<float> Lerp(const TArray<float>& A, const TArray<float>& B, float Factor)
+{
+	TArray<float> Result;
+	Result.SetNumUninitialized(A.Num());
+	for (int32 Dimension = 0; Dimension < A.Num(); ++Dimension)
+	{
+		Result[Dimension] = A[Dimension] + Factor * (B[Dimension] - A[Dimension]);
+	}
+	return Result;
+}
+
+FNelderMead::FResult FNelderMead::Minimize(const FBatchFunction& Function, const TArray<float>& InitialPoint, const TArray<float>& Steps, int32 MaxIterations, float Tolerance,
+	const FProgressFunction& Progress)
+{
+	const int32 NumDimensions = InitialPoint.Num();
+
+	FResult Result;
+
+	// Initial simplex
+	TArray<TArray<float>> Simplex;
+	TArray<float> Values;
+
+	Simplex.Add(InitialPoint);
+	for (int32 Dimension = 0; Dimension < NumDimensions; ++Dimension)
+	{
+		TArray<float> Vertex = InitialPoint;
+		Vertex[Dimension] += Steps[Dimension];
+		Simplex.Add(Vertex);
+	}
+
+	Function(Simplex, Values);
+	Result.Evaluations += Simplex.Num();
+
+	TArray<int32> Order;
+	for (int32 Vertex = 0; Vertex <= NumDimensions; ++Vertex)
+	{
+		Order.Add(Vertex);
+	}
+
+	TArray<TArray<float>> Candidates;
+	TArray<float> CandidateValues;
+
+	for (Result.Iterations = 0; Result.Iterations < MaxIterations; ++Result.Iterations)
+	{
+		Order.Sort([&Values](int32 A, int32 B) { return Values[A] < Values[B]; });
+
+		const int32 Best = Order[0];
+		const int32 SecondWorst = Order[NumDimensions - 1];
+		const int32 Worst = Order[NumDimensions];
+
+		if (Progress)
+		{
+			Progress(Result.Iterations, Values[Best]);
+		}
+
+		if (Values[Worst] - Values[Best] <= Tolerance * FMath::Max(FMath::Abs(Values[Best]), SMALL_NUMBER))
+		{
+			break;
+		}
+
+		// Centroid of all vertices except the worst
+		TArray<float> Centroid;
+		Centroid.SetNumZeroed(NumDimensions);
+		for (int32 Vertex = 0; Vertex <= NumDimensions; ++Vertex)
+		{
+			if (Vertex == Worst) continue;
+			for (int32 Dimension = 0; Dimension < NumDimensions; ++Dimension)
+			{
+				Centroid[Dimension] += Simplex[Vertex][Dimension] / NumDimensions;
+			}
+		}
+
+		// Reflection, expansion, outside and inside contraction
+		Candidates.Reset();
+		Candidates.Add(Lerp(Centroid, Simplex[Worst], -1.0f));
+		Candidates.Add(Lerp(Centroid, Simplex[Worst], -2.0f));
+		Candidates.Add(Lerp(Centroid, Simplex[Worst], -0.5f));
+		Candidates.Add(Lerp(Centroid, Simplex[Worst], 0.5f));
+
+		Function(Candidates, CandidateValues);
+		Result.Evaluations += Candidates.Num();
+
+		const float Reflection = CandidateValues[0];
+		int32 Accepted = INDEX_NONE;
+
+		if (Reflection < Values[Best])
+		{
+			Accepted = CandidateValues[1] < Reflection ? 1 : 0;
+		}
+		else if (Reflection < Values[SecondWorst])
+		{
+			Accepted = 0;
+		}
+		else if (Reflection < Values[Worst])
+		{
+			if (CandidateValues[2] <= Reflection) Accepted = 2;
+		}
+		else if (CandidateValues[3] < Values[Worst])
+		{
+			Accepted = 3;
+		}
+
+		if (Accepted != INDEX_NONE)
+		{
+			Simplex[Worst] = Candidates[Accepted];
+			Values[Worst] = CandidateValues[Accepted];
+			continue;
+		}
+
+		// Shrink towards the best vertex
+		Candidates.Reset();
+		for (int32 Vertex = 0; Vertex <= NumDimensions; ++Vertex)
+		{
+			if (Vertex == Best) continue;
+			Simplex[Vertex] = Lerp(Simplex[Best], Simplex[Vertex], 0.5f);
+			Candidates.Add(Simplex[Vertex]);
+		}
+
+		Function(Candidates, CandidateValues);
+		Result.Evaluations += Candidates.Num();
+
+		int32 Candidate = 0;
+		for (int32 Vertex = 0; Vertex <= NumDimensions; ++Vertex)
+		{
+			if (Vertex == Best) continue;
+			Simplex[Vertex] = Candidates[Candidate];
+			Values[Vertex] = CandidateValues[Candidate++];
+		}
+	}
+
+	int32 Best = 0;
+	for (int32 Vertex = 1; Vertex <= NumDimensions; ++Vertex)
+	{
+		if (Values[Vertex] < Values[Best]) Best = Vertex;
+	}
+
+	Result.Point = Simplex[Best];
+	Result.Value = Values[Best];
+
+	return Result;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+/**
+* Derivative free minimization with the downhill simplex method of Nelder and Mead. The function is evaluated for batches
+* of points, so the caller can evaluate the points of a batch concurrently. Every iteration evaluates the reflection, the
+* expansion and both contractions of the worst point as one batch instead of one after another.
+*/
+class SIMULATION_API FNelderMead
+{
+public:
+	/**
+	* Evaluates the function at all given points. The function may move a point into the valid region of the search space,
+	* the simplex then continues with the moved point, so its vertices are always the points which were evaluated.
+	*/
+	typedef TFunction<void(TArray<TArray<float>>& Points, TArray<float>& OutValues)> FBatchFunction;
+
+	/** Called after every iteration with the iteration and the best value. */
+	typedef TFunction<void(int32 Iteration, float BestValue)> FProgressFunction;
+
+	/** The result of a minimization. */
+	struct FResult
+	{
+		/** The best point found. */
+		TArray<float> Point;
+
+		/** The value at the best point. */
+		float Value = MAX_FLT;
+
+		/** Number of iterations. */
+		int32 Iterations = 0;
+
+		/** Number of evaluated points. */
+		int32 Evaluations = 0;
+	};
+
+	/**
+	* Minimizes the given function.
+	*
+	* @param Function		The function to minimize
+	* @param InitialPoint	The start of the search
+	* @param Steps			The size of the initial simplex in every dimension
+	* @param MaxIterations	Maximum number of iterations
+	* @param Tolerance		The search stops if the values of the simplex differ by less than this fraction of the best value
+	* @param Progress		Called after every iteration, may be null
+	*/
+	static FResult Minimize(const FBatchFunction& Function, const TArray<float>& InitialPoint, const TArray<float>& Steps, int32 MaxIterations, float Tolerance,
+		const FProgressFunction& Progress = nullptr);
+};
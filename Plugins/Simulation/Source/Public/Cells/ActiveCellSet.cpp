@@ -0,0 +1,162 @@
+#include "Simulation.h"
+#include "ActiveCellSet.h"
+
+const uint8 FActiveCellSet::Active;
+const uint8 FActiveCellSet::Changed;
+
+void FActiveCellSet::Initialize(const FSimulationCellStore& Cells, int32 CellsPerTile)
+{
+	const int32 NumCells = Cells.Num();
+	TileSize = CellsPerTile;
+
+	// All cells have to be interpolated once
+	Flags.Init(Changed, NumCells);
+
+	Tiles.Empty();
+	Tiles.SetNum(FMath::DivideAndRoundUp(NumCells, FMath::Max(1, CellsPerTile)));
+
+	for (int32 Tile = 0; Tile < Tiles.Num(); ++Tile)
+	{
+		FTile& TileCells = Tiles[Tile];
+		TileCells.BeginIndex = Tile * CellsPerTile;
+		TileCells.EndIndex = FMath::Min(TileCells.BeginIndex + CellsPerTile, NumCells);
+
+		for (int32 Index = TileCells.BeginIndex; Index < TileCells.EndIndex; ++Index)
+		{
+			TileCells.AltitudeOrder.Add(Index);
+
+			if (Cells.SnowWaterEquivalent[Index] > 0)
+			{
+				Flags[Index] |= Active;
+				TileCells.ActiveCells.Add(Index);
+			}
+		}
+
+		TileCells.AltitudeOrder.Sort([&Cells](int32 A, int32 B)
+		{
+			return Cells.Altitude[A] > Cells.Altitude[B];
+		});
+
+		for (int32 Index : TileCells.AltitudeOrder)
+		{
+			TileCells.SortedAltitude.Add(Cells.Altitude[Index]);
+		}
+	}
+}
+
+void FActiveCellSet::Reset()
+{
+	Tiles.Empty();
+	Flags.Empty();
+	TileSize = 0;
+}
+
+int32 FActiveCellSet::BeginHour(int32 Tile, float MinPrecipitationAltitude)
+{
+	FTile& TileCells = Tiles[Tile];
+	const int32 NumTileCells = TileCells.EndIndex - TileCells.BeginIndex;
+
+	// Number of cells above the altitude
+	int32 Low = 0;
+	int32 High = TileCells.SortedAltitude.Num();
+	while (Low < High)
+	{
+		const int32 Middle = (Low + High) / 2;
+		if (TileCells.SortedAltitude[Middle] > MinPrecipitationAltitude)
+		{
+			Low = Middle + 1;
+		}
+		else
+		{
+			High = Middle;
+		}
+	}
+	const int32 NumPrecipitation = Low;
+
+	if (NumPrecipitation == 0)
+	{
+		// Only the cells with snow
+		TileCells.ProcessAll = false;
+		TileCells.ProcessCells = TileCells.ActiveCells;
+		return TileCells.ProcessCells.Num();
+	}
+	else if (NumPrecipitation + TileCells.ActiveCells.Num() >= NumTileCells / 2)
+	{
+		// Most of the tile, simulating all cells is cheaper than collecting them
+		TileCells.ProcessAll = true;
+		return NumTileCells;
+	}
+	else
+	{
+		// Mark the cells which receive precipitation and collect them with the active cells in ascending order
+		for (int32 Order = 0; Order < NumPrecipitation; ++Order)
+		{
+			Flags[TileCells.AltitudeOrder[Order]] |= Active;
+		}
+
+		TileCells.ProcessAll = false;
+		TileCells.ProcessCells.Reset();
+		for (int32 Index = TileCells.BeginIndex; Index < TileCells.EndIndex; ++Index)
+		{
+			if (Flags[Index] & Active) TileCells.ProcessCells.Add(Index);
+		}
+		return TileCells.ProcessCells.Num();
+	}
+}
+
+void FActiveCellSet::EndHour(int32 Tile, const FSimulationCellStore& Cells, bool Interpolated)
+{
+	FTile& TileCells = Tiles[Tile];
+	TileCells.ActiveCells.Reset();
+
+	const uint8 ChangedFlag = Interpolated ? 0 : Changed;
+
+	auto UpdateCell = [&](int32 Index)
+	{
+		if (Cells.SnowWaterEquivalent[Index] > 0)
+		{
+			Flags[Index] = Active | ChangedFlag;
+			TileCells.ActiveCells.Add(Index);
+		}
+		else
+		{
+			Flags[Index] = ChangedFlag;
+		}
+	};
+
+	if (TileCells.ProcessAll)
+	{
+		for (int32 Index = TileCells.BeginIndex; Index < TileCells.EndIndex; ++Index)
+		{
+			UpdateCell(Index);
+		}
+	}
+	else
+	{
+		for (int32 Index : TileCells.ProcessCells)
+		{
+			UpdateCell(Index);
+		}
+	}
+}
+
+int32 FActiveCellSet::GetNumActive() const
+{
+	int32 NumActive = 0;
+	for (const FTile& TileCells : Tiles)
+	{
+		NumActive += TileCells.ActiveCells.Num();
+	}
+	return NumActive;
+}
+
+SIZE_T FActiveCellSet::GetAllocatedSize() const
+{
+	SIZE_T Size = Tiles.GetAllocatedSize() + Flags.GetAllocatedSize();
+	for (const FTile& TileCells : Tiles)
+	{
+		Size += TileCells.AltitudeOrder.GetAllocatedSize() + TileCells.SortedAltitude.GetAllocatedSize()
+			+ TileCells.ActiveCells.GetAllocatedSize() + TileCells.ProcessCells.GetAllocatedSize();
+	}
+	return Size;
+}
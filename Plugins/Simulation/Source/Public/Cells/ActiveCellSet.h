@@ -0,0 +1,148 @@
+#pragma once
+
+#include "Cells/SimulationCellStore.h"
+
+/**
+* Tracks the cells of every tile which have to be simulated. A cell is active as long as it holds snow. Cells without
+* snow only have to be simulated in hours in which they receive precipitation, otherwise the simulation only advances
+* their days since the last snowfall which is reset by the next precipitation anyway.
+*
+* Precipitation increases with altitude, so the cells of a tile are additionally kept sorted by altitude and the cells
+* which receive precipitation in an hour are a prefix of this order.
+*/
+class SIMULATION_API FActiveCellSet
+{
+public:
+	/** Creates the set for the given cells which are split into tiles of CellsPerTile cells. All cells with snow are active. */
+	void Initialize(const FSimulationCellStore& Cells, int32 CellsPerTile);
+
+	/** Frees the set. */
+	void Reset();
+
+	/** Returns true if the set has been created for the given cells and tile size. */
+	bool IsInitialized(const FSimulationCellStore& Cells, int32 CellsPerTile) const
+	{
+		return Flags.Num() == Cells.Num() && TileSize == CellsPerTile;
+	}
+
+	/**
+	* Collects the cells of the tile which have to be simulated in the next hour: the active cells and the cells above the
+	* given altitude which receive precipitation.
+	*
+	* @return the number of cells to simulate
+	*/
+	int32 BeginHour(int32 Tile, float MinPrecipitationAltitude);
+
+	/** Calls Function(BeginIndex, EndIndex) for every contiguous range of the cells collected by BeginHour. */
+	template<typename FunctionType>
+	void ForEachRange(int32 Tile, FunctionType Function) const
+	{
+		const FTile& TileCells = Tiles[Tile];
+		if (TileCells.ProcessAll)
+		{
+			Function(TileCells.BeginIndex, TileCells.EndIndex);
+		}
+		else
+		{
+			ForEachRange(TileCells.ProcessCells, Function);
+		}
+	}
+
+	/**
+	* Updates the active cells of the tile after the cells collected by BeginHour have been simulated.
+	*
+	* @param Interpolated	Whether the snow of the simulated cells has been interpolated, they are not reported as changed
+	*/
+	void EndHour(int32 Tile, const FSimulationCellStore& Cells, bool Interpolated = false);
+
+	/** Collects the active cells of the tile from the current snow, e.g. after snow has been moved between the cells. */
+	void UpdateTile(int32 Tile, const FSimulationCellStore& Cells)
+	{
+		Tiles[Tile].ProcessAll = true;
+		EndHour(Tile, Cells, true);
+	}
+
+	/**
+	* Calls Function(BeginIndex, EndIndex) for every contiguous range of cells of the tile which have been simulated since
+	* the last call or, if IncludeActive is set, which hold snow. The snow of all other cells has not changed and is zero.
+	*/
+	template<typename FunctionType>
+	void ForEachChangedRange(int32 Tile, FunctionType Function, bool IncludeActive = true)
+	{
+		FTile& TileCells = Tiles[Tile];
+		TileCells.ProcessCells.Reset();
+
+		const uint8 Mask = IncludeActive ? (Changed | Active) : Changed;
+
+		for (int32 Index = TileCells.BeginIndex; Index < TileCells.EndIndex; ++Index)
+		{
+			if (Flags[Index] & Mask)
+			{
+				TileCells.ProcessCells.Add(Index);
+				Flags[Index] &= ~Changed;
+			}
+		}
+
+		ForEachRange(TileCells.ProcessCells, Function);
+	}
+
+	/** Returns the number of active cells. */
+	int32 GetNumActive() const;
+
+	/** Returns the number of bytes allocated by the set. */
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	/** Flag of the cells which hold snow. */
+	static const uint8 Active = 1;
+
+	/** Flag of the cells which have been simulated since the last call to ForEachChangedRange. */
+	static const uint8 Changed = 2;
+
+	struct FTile
+	{
+		int32 BeginIndex = 0;
+
+		int32 EndIndex = 0;
+
+		/** The cells of the tile sorted by descending altitude. */
+		TArray<int32> AltitudeOrder;
+
+		/** The altitudes of the cells in AltitudeOrder. */
+		TArray<float> SortedAltitude;
+
+		/** The active cells of the tile in ascending order. */
+		TArray<int32> ActiveCells;
+
+		/** The cells simulated in the current hour in ascending order. */
+		TArray<int32> ProcessCells;
+
+		/** Whether all cells of the tile are simulated in the current hour. */
+		bool ProcessAll = false;
+	};
+
+	/** Calls Function(BeginIndex, EndIndex) for every contiguous range of the given ascending cells. */
+	template<typename FunctionType>
+	static void ForEachRange(const TArray<int32>& Indices, FunctionType Function)
+	{
+		int32 Index = 0;
+		while (Index < Indices.Num())
+		{
+			const int32 BeginIndex = Indices[Index];
+			int32 EndIndex = BeginIndex + 1;
+			for (++Index; Index < Indices.Num() && Indices[Index] == EndIndex; ++Index)
+			{
+				++EndIndex;
+			}
+
+			Function(BeginIndex, EndIndex);
+		}
+	}
+
+	TArray<FTile> Tiles;
+
+	/** The flags of every cell. */
+	TArray<uint8> Flags;
+
+	int32 TileSize = 0;
+};
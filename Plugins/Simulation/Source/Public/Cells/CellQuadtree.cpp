@@ -0,0 +1,289 @@
+#include "Simulation.h"
+#include "CellQuadtree.h"
+
+/** Ranges of the terrain of the cells of a quadtree node. */
+struct FCellQuadtreeNode
+{
+	float MinAltitude;
+	float MaxAltitude;
+	float MinInclination;
+	float MaxInclination;
+	float MinCurvature;
+	float MaxCurvature;
+
+	/** Sum of the unit vectors of the aspect of the cells. */
+	float AspectX;
+	float AspectY;
+
+	int32 NumCells;
+
+	/** Whether all cells of the node lie within the grid. */
+	bool Complete;
+
+	/** Whether the cells of the node can be merged into one leaf. */
+	bool Homogeneous;
+};
+
+void FCellQuadtree::Build(const TArray<FLandscapeCell>& Cells, int32 CellsDimensionX, int32 CellsDimensionY, const FCellQuadtreeTolerances& Tolerances, TArray<FLandscapeCell>& OutLeafCells)
+{
+	DimensionX = CellsDimensionX;
+	const int32 MaxLevel = FMath::Max(0, Tolerances.MaxLevel);
+	const float MinAspectCosine = FMath::Cos(Tolerances.Aspect);
+
+	// Dimensions of the nodes of every level, the nodes of the last column and row can be partially outside of the grid
+	TArray<FIntPoint> LevelDimensions;
+	TArray<TArray<FCellQuadtreeNode>> Levels;
+	Levels.SetNum(MaxLevel + 1);
+
+	LevelDimensions.Add(FIntPoint(CellsDimensionX, CellsDimensionY));
+	Levels[0].SetNumUninitialized(CellsDimensionX * CellsDimensionY);
+
+	for (int32 Index = 0; Index < Cells.Num(); ++Index)
+	{
+		const FLandscapeCell& Cell = Cells[Index];
+		FCellQuadtreeNode& Node = Levels[0][Index];
+
+		Node.MinAltitude = Node.MaxAltitude = Cell.Altitude;
+		Node.MinInclination = Node.MaxInclination = Cell.Inclination;
+		Node.MinCurvature = Node.MaxCurvature = Cell.Curvature;
+		Node.AspectX = FMath::Cos(Cell.Aspect);
+		Node.AspectY = FMath::Sin(Cell.Aspect);
+		Node.NumCells = 1;
+		Node.Complete = true;
+		Node.Homogeneous = true;
+	}
+
+	// Whether the aspect of no cell of the complete node deviates further than the tolerance from the mean aspect of the node
+	auto IsAspectWithinTolerance = [&](const FCellQuadtreeNode& Node, int32 Level, int32 X, int32 Y)
+	{
+		const float Length = FMath::Sqrt(Node.AspectX * Node.AspectX + Node.AspectY * Node.AspectY);
+		if (Length <= 0)
+		{
+			return false;
+		}
+
+		const float MeanX = Node.AspectX / Length;
+		const float MeanY = Node.AspectY / Length;
+		for (int32 CellY = Y << Level; CellY < (Y + 1) << Level; ++CellY)
+		{
+			for (int32 CellX = X << Level; CellX < (X + 1) << Level; ++CellX)
+			{
+				const FCellQuadtreeNode& Cell = Levels[0][CellY * CellsDimensionX + CellX];
+				if (Cell.AspectX * MeanX + Cell.AspectY * MeanY < MinAspectCosine) return false;
+			}
+		}
+		return true;
+	};
+
+	// Merge the ranges of the four children of every node bottom up
+	for (int32 Level = 1; Level <= MaxLevel; ++Level)
+	{
+		const FIntPoint ChildDimensions = LevelDimensions[Level - 1];
+		const FIntPoint Dimensions((ChildDimensions.X + 1) / 2, (ChildDimensions.Y + 1) / 2);
+		const TArray<FCellQuadtreeNode>& Children = Levels[Level - 1];
+
+		LevelDimensions.Add(Dimensions);
+		Levels[Level].SetNumUninitialized(Dimensions.X * Dimensions.Y);
+
+		for (int32 Y = 0; Y < Dimensions.Y; ++Y)
+		{
+			for (int32 X = 0; X < Dimensions.X; ++X)
+			{
+				FCellQuadtreeNode Node;
+				Node.MinAltitude = Node.MinInclination = Node.MinCurvature = MAX_FLT;
+				Node.MaxAltitude = Node.MaxInclination = Node.MaxCurvature = -MAX_FLT;
+				Node.AspectX = Node.AspectY = 0;
+				Node.NumCells = 0;
+				Node.Complete = true;
+				Node.Homogeneous = true;
+
+				for (int32 Child = 0; Child < 4; ++Child)
+				{
+					const int32 ChildX = 2 * X + (Child & 1);
+					const int32 ChildY = 2 * Y + (Child >> 1);
+
+					if (ChildX >= ChildDimensions.X || ChildY >= ChildDimensions.Y)
+					{
+						Node.Complete = false;
+						continue;
+					}
+
+					const FCellQuadtreeNode& ChildNode = Children[ChildY * ChildDimensions.X + ChildX];
+					Node.MinAltitude = FMath::Min(Node.MinAltitude, ChildNode.MinAltitude);
+					Node.MaxAltitude = FMath::Max(Node.MaxAltitude, ChildNode.MaxAltitude);
+					Node.MinInclination = FMath::Min(Node.MinInclination, ChildNode.MinInclination);
+					Node.MaxInclination = FMath::Max(Node.MaxInclination, ChildNode.MaxInclination);
+					Node.MinCurvature = FMath::Min(Node.MinCurvature, ChildNode.MinCurvature);
+					Node.MaxCurvature = FMath::Max(Node.MaxCurvature, ChildNode.MaxCurvature);
+					Node.AspectX += ChildNode.AspectX;
+					Node.AspectY += ChildNode.AspectY;
+					Node.NumCells += ChildNode.NumCells;
+					Node.Complete &= ChildNode.Complete;
+					Node.Homogeneous &= ChildNode.Homogeneous;
+				}
+
+				// The mean resultant length of the aspects is at least cos(Aspect) if no aspect deviates further from the mean, which
+				// rejects most inhomogeneous nodes before the deviation of every cell from the mean is checked
+				const bool FlatNode = Node.MaxInclination <= Tolerances.Inclination;
+				const float AspectResultant = FMath::Sqrt(Node.AspectX * Node.AspectX + Node.AspectY * Node.AspectY) / Node.NumCells;
+
+				Node.Homogeneous = Node.Homogeneous && Node.Complete
+					&& Node.MaxAltitude - Node.MinAltitude <= Tolerances.Altitude
+					&& Node.MaxInclination - Node.MinInclination <= Tolerances.Inclination
+					&& Node.MaxCurvature - Node.MinCurvature <= Tolerances.Curvature
+					&& (FlatNode || (AspectResultant >= MinAspectCosine && IsAspectWithinTolerance(Node, Level, X, Y)));
+
+				Levels[Level][Y * Dimensions.X + X] = Node;
+			}
+		}
+	}
+
+	// Collect the leaves top down, the children of a node are visited in Z order
+	Leaves.Reset();
+	CellLeaf.SetNumUninitialized(CellsDimensionX * CellsDimensionY);
+
+	TFunction<void(int32, int32, int32)> CollectLeaves = [&](int32 Level, int32 X, int32 Y)
+	{
+		const FIntPoint Dimensions = LevelDimensions[Level];
+		if (X >= Dimensions.X || Y >= Dimensions.Y)
+		{
+			return;
+		}
+
+		if (Levels[Level][Y * Dimensions.X + X].Homogeneous)
+		{
+			FCellQuadtreeLeaf Leaf;
+			Leaf.X = X << Level;
+			Leaf.Y = Y << Level;
+			Leaf.Size = 1 << Level;
+			Leaves.Add(Leaf);
+			return;
+		}
+
+		for (int32 Child = 0; Child < 4; ++Child)
+		{
+			CollectLeaves(Level - 1, 2 * X + (Child & 1), 2 * Y + (Child >> 1));
+		}
+	};
+
+	const FIntPoint RootDimensions = LevelDimensions[MaxLevel];
+	for (int32 Y = 0; Y < RootDimensions.Y; ++Y)
+	{
+		for (int32 X = 0; X < RootDimensions.X; ++X)
+		{
+			CollectLeaves(MaxLevel, X, Y);
+		}
+	}
+
+	// Aggregate the cells of every leaf
+	OutLeafCells.Empty(Leaves.Num());
+
+	for (int32 LeafIndex = 0; LeafIndex < Leaves.Num(); ++LeafIndex)
+	{
+		const FCellQuadtreeLeaf& Leaf = Leaves[LeafIndex];
+
+		for (int32 Y = Leaf.Y; Y < Leaf.Y + Leaf.Size; ++Y)
+		{
+			for (int32 X = Leaf.X; X < Leaf.X + Leaf.Size; ++X)
+			{
+				CellLeaf[Y * CellsDimensionX + X] = LeafIndex;
+			}
+		}
+
+		OutLeafCells.Add(AggregateCells(Cells, CellsDimensionX, FIntRect(Leaf.X, Leaf.Y, Leaf.X + Leaf.Size, Leaf.Y + Leaf.Size), LeafIndex));
+	}
+}
+
+FLandscapeCell FCellQuadtree::AggregateCells(const TArray<FLandscapeCell>& Cells, int32 CellsDimensionX, const FIntRect& Block, int32 Index)
+{
+	FVector Normal = FVector::ZeroVector;
+	FVector Centroid = FVector::ZeroVector;
+	float Area = 0;
+	float AreaXY = 0;
+	float Altitude = 0;
+	float Inclination = 0;
+	float Latitude = 0;
+	float Curvature = 0;
+	float AspectX = 0;
+	float AspectY = 0;
+	float InitialWaterEquivalent = 0;
+	float VegetationDensity = 0;
+	int32 NumVegetationCells = 0;
+
+	for (int32 Y = Block.Min.Y; Y < Block.Max.Y; ++Y)
+	{
+		for (int32 X = Block.Min.X; X < Block.Max.X; ++X)
+		{
+			const FLandscapeCell& Cell = Cells[Y * CellsDimensionX + X];
+
+			Normal += Cell.Normal;
+			Centroid += Cell.Centroid * Cell.AreaXY;
+			Area += Cell.Area;
+			AreaXY += Cell.AreaXY;
+			Altitude += Cell.Altitude * Cell.AreaXY;
+			Inclination += Cell.Inclination * Cell.AreaXY;
+			Latitude += Cell.Latitude * Cell.AreaXY;
+			Curvature += Cell.Curvature * Cell.AreaXY;
+			AspectX += FMath::Cos(Cell.Aspect) * Cell.AreaXY;
+			AspectY += FMath::Sin(Cell.Aspect) * Cell.AreaXY;
+			InitialWaterEquivalent += Cell.InitialWaterEquivalent;
+
+			if (Cell.VegetationDensity >= 0)
+			{
+				VegetationDensity += Cell.VegetationDensity;
+				NumVegetationCells++;
+			}
+		}
+	}
+
+	const float InverseAreaXY = AreaXY > 0 ? 1.0f / AreaXY : 0.0f;
+	const int32 MaxX = Block.Max.X - 1;
+	const int32 MaxY = Block.Max.Y - 1;
+
+	FVector P1 = Cells[Block.Min.Y * CellsDimensionX + Block.Min.X].P1;
+	FVector P2 = Cells[Block.Min.Y * CellsDimensionX + MaxX].P2;
+	FVector P3 = Cells[MaxY * CellsDimensionX + Block.Min.X].P3;
+	FVector P4 = Cells[MaxY * CellsDimensionX + MaxX].P4;
+
+	float Aspect = FMath::Atan2(AspectY, AspectX);
+	Aspect = Aspect < 0 ? Aspect + 2 * PI : Aspect;
+
+	FLandscapeCell Cell(Index, P1, P2, P3, P4, Normal, Area, AreaXY, Centroid * InverseAreaXY, Altitude * InverseAreaXY, Aspect,
+		Inclination * InverseAreaXY, Latitude * InverseAreaXY, InitialWaterEquivalent);
+	Cell.Curvature = Curvature * InverseAreaXY;
+	Cell.VegetationDensity = NumVegetationCells > 0 ? VegetationDensity / NumVegetationCells : -1.0f;
+	return Cell;
+}
+
+void FCellQuadtree::Reset()
+{
+	Leaves.Empty();
+	CellLeaf.Empty();
+	DimensionX = 0;
+}
+
+float FCellQuadtree::Reconstruct(const FSimulationCellStore& LeafCells, FSimulationCellStore& GridCells, int32 BeginRow, int32 EndRow) const
+{
+	float RowsMaxSnow = 0;
+
+	for (int32 Index = BeginRow * DimensionX; Index < EndRow * DimensionX; ++Index)
+	{
+		const int32 Leaf = CellLeaf[Index];
+
+		// The snow height of the leaf in mm, so the snow of the cells of a leaf sums up to the snow of the leaf
+		const float SnowHeight = LeafCells.SnowWaterEquivalent[Leaf] * LeafCells.InverseAreaSquareMeters[Leaf];
+		const float SnowWaterEquivalent = SnowHeight * GridCells.Area[Index] / (100 * 100);
+
+		GridCells.SnowWaterEquivalent[Index] = SnowWaterEquivalent;
+		GridCells.SnowAlbedo[Index] = LeafCells.SnowAlbedo[Leaf];
+		GridCells.DaysSinceLastSnowfall[Index] = LeafCells.DaysSinceLastSnowfall[Leaf];
+
+		// Interpolation according to Bloeschl with the factor of the grid cell
+		const float we = FMath::Max(0.0f, SnowWaterEquivalent * GridCells.InterpolationFactor[Index]);
+		GridCells.InterpolatedSnowWaterEquivalent[Index] = we;
+
+		RowsMaxSnow = FMath::Max(we * GridCells.InverseAreaSquareMeters[Index], RowsMaxSnow);
+	}
+
+	return RowsMaxSnow;
+}
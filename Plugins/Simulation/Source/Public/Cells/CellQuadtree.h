@@ -0,0 +1,127 @@
+#pragma once
+
+#include "Cells/SimulationCellStore.h"
+
+/** Tolerances within which the cells of a quadtree node are merged into one leaf. */
+struct FCellQuadtreeTolerances
+{
+	/** Maximum difference of the altitude of the cells in cm. */
+	float Altitude = 2000;
+
+	/** Maximum difference of the inclination of the cells in radians. */
+	float Inclination = FMath::DegreesToRadians(3);
+
+	/**
+	* Maximum deviation of the aspect of the cells from their mean in radians. It is only checked for nodes which contain
+	* a cell steeper than the inclination tolerance, the aspect of flatter cells has little effect on the radiation.
+	*/
+	float Aspect = FMath::DegreesToRadians(20);
+
+	/** Maximum difference of the curvature of the cells. */
+	float Curvature = 0.002f;
+
+	/** Highest level of the leaves, a leaf of level L covers 2^L x 2^L cells. */
+	int32 MaxLevel = 4;
+};
+
+/** A leaf of the quadtree which covers Size x Size cells starting at cell (X, Y). */
+struct FCellQuadtreeLeaf
+{
+	int32 X;
+	int32 Y;
+	int32 Size;
+};
+
+/**
+* Adaptive aggregation of a grid of cells. Aligned blocks of 2^L x 2^L cells whose terrain is homogeneous within the
+* tolerances are merged into one leaf cell, so flat valley floors and uniform slopes are simulated as a few large cells
+* while ridges keep the resolution of the grid. A leaf has the summed area and snow of its cells and their area weighted
+* altitude, inclination, curvature and vegetation density.
+*
+* The snow of the leaves is reconstructed to the grid by giving every cell the snow height of its leaf and interpolating
+* it with the interpolation factor of the cell, so the snow map keeps the detail of the curvature and slope of the grid.
+*/
+class SIMULATION_API FCellQuadtree
+{
+public:
+	/**
+	* Builds the quadtree of the given cells which are stored row by row.
+	*
+	* @param Cells			The cells of the grid
+	* @param CellsDimensionX	Number of cells in x direction
+	* @param CellsDimensionY	Number of cells in y direction
+	* @param Tolerances		The tolerances of the merged cells
+	* @param OutLeafCells	The aggregated cell of every leaf
+	*/
+	void Build(const TArray<FLandscapeCell>& Cells, int32 CellsDimensionX, int32 CellsDimensionY, const FCellQuadtreeTolerances& Tolerances, TArray<FLandscapeCell>& OutLeafCells);
+
+	/**
+	* Returns a cell which covers the given block of cells: the summed area and snow of the cells and their area weighted
+	* altitude, inclination, aspect, latitude and curvature. The block must not be empty.
+	*
+	* @param Cells			The cells of the grid stored row by row
+	* @param CellsDimensionX	Number of cells in x direction
+	* @param Block			The cells [Min, Max) of the block
+	* @param Index			Index of the returned cell
+	*/
+	static FLandscapeCell AggregateCells(const TArray<FLandscapeCell>& Cells, int32 CellsDimensionX, const FIntRect& Block, int32 Index);
+
+	/** Frees the quadtree. */
+	void Reset();
+
+	/** Returns the number of leaves. */
+	int32 GetNumLeaves() const
+	{
+		return Leaves.Num();
+	}
+
+	/** Returns the number of cells of the grid. */
+	int32 GetNumCells() const
+	{
+		return CellLeaf.Num();
+	}
+
+	/** Returns the number of grid cells per leaf. */
+	float GetCompressionRatio() const
+	{
+		return Leaves.Num() > 0 ? static_cast<float>(CellLeaf.Num()) / Leaves.Num() : 1.0f;
+	}
+
+	/** Returns the leaf with the given index. */
+	const FCellQuadtreeLeaf& GetLeaf(int32 Leaf) const
+	{
+		return Leaves[Leaf];
+	}
+
+	/** Returns the index of the leaf which contains the given grid cell. */
+	int32 GetCellLeaf(int32 Cell) const
+	{
+		return CellLeaf[Cell];
+	}
+
+	/**
+	* Sets the snow of the grid cells in the rows [BeginRow, EndRow) to the snow height of their leaves and interpolates it
+	* with the interpolation factors of the grid cells.
+	*
+	* @param LeafCells	The simulated leaves
+	* @param GridCells	The cells of the grid
+	* @return the maximum snow amount (mm) of the rows after interpolation
+	*/
+	float Reconstruct(const FSimulationCellStore& LeafCells, FSimulationCellStore& GridCells, int32 BeginRow, int32 EndRow) const;
+
+	/** Returns the number of bytes allocated by the quadtree. */
+	SIZE_T GetAllocatedSize() const
+	{
+		return Leaves.GetAllocatedSize() + CellLeaf.GetAllocatedSize();
+	}
+
+private:
+	/** The leaves ordered along the quadtree, so the leaves of a node are contiguous. */
+	TArray<FCellQuadtreeLeaf> Leaves;
+
+	/** The leaf of every grid cell. */
+	TArray<int32> CellLeaf;
+
+	/** Number of cells in x direction. */
+	int32 DimensionX = 0;
+};
@@ -0,0 +1,153 @@
+#include "Simulation.h"
+#include "CompactCellStore.h"
+
+/** Returns the half float which is nearest to the given value, the conversion of FFloat16 does not round to nearest. */
+static FFloat16 RoundToHalf(float Value)
+{
+	const FFloat16 Lower(Value);
+
+	// The next value away from zero
+	FFloat16 Upper;
+	Upper.Encoded = Lower.Encoded + 1;
+
+	return FMath::Abs(Upper.GetFloat() - Value) < FMath::Abs(Lower.GetFloat() - Value) ? Upper : Lower;
+}
+
+/** Returns the fixed point snow height of the given snow height in mm, rounded to the nearest step. */
+static uint32 QuantizeSnowHeight(float SnowHeight)
+{
+	const double Steps = static_cast<double>(SnowHeight) * FCompactCellStore::SnowHeightStepsPerMM;
+	return static_cast<uint32>(FMath::Clamp(Steps + 0.5, 0.0, static_cast<double>(MAX_uint32)));
+}
+
+/** Quantizes the given value of the range [Min, Max] to 16 bits. */
+static uint16 Quantize16(float Value, float Min, float Max)
+{
+	return static_cast<uint16>(FMath::Clamp(FMath::RoundToInt((Value - Min) / (Max - Min) * MAX_uint16), 0, static_cast<int32>(MAX_uint16)));
+}
+
+/** Returns the value of the range [Min, Max] of the given quantized value. */
+static float Dequantize16(uint16 Value, float Min, float Max)
+{
+	return Min + Value * ((Max - Min) / MAX_uint16);
+}
+
+void FCompactCellStore::Initialize(const TArray<FLandscapeCell>& LandscapeCells, int32 CellsDimensionX, int32 CellsDimensionY)
+{
+	DimensionX = CellsDimensionX;
+	DimensionY = CellsDimensionY;
+
+	const int32 NumCells = LandscapeCells.Num();
+
+	// Altitude range of the terrain
+	float MinAltitude = MAX_FLT;
+	float MaxAltitude = -MAX_FLT;
+	for (const FLandscapeCell& Cell : LandscapeCells)
+	{
+		MinAltitude = FMath::Min(MinAltitude, Cell.Altitude);
+		MaxAltitude = FMath::Max(MaxAltitude, Cell.Altitude);
+	}
+	BaseAltitude = NumCells > 0 ? MinAltitude : 0;
+	AltitudeStep = NumCells > 0 ? FMath::Max(1.0f, (MaxAltitude - MinAltitude) / MAX_uint16) : 1;
+
+	// The projected area is stored relative to the largest cell, so cells of any size stay within the range of half floats
+	float MaxAreaXY = 0;
+	for (const FLandscapeCell& Cell : LandscapeCells)
+	{
+		MaxAreaXY = FMath::Max(MaxAreaXY, Cell.AreaXY);
+	}
+	AreaXYScale = MaxAreaXY > 0 ? MaxAreaXY / (100 * 100) : 1;
+
+	SnowHeight.SetNumUninitialized(NumCells);
+	InterpolatedSnowHeight.SetNumZeroed(NumCells);
+	SnowAlbedo.SetNumZeroed(NumCells);
+	HoursSinceLastSnowfall.SetNumZeroed(NumCells);
+
+	AreaXY.SetNumUninitialized(NumCells);
+	AreaFactor.SetNumUninitialized(NumCells);
+	Inclination.SetNumUninitialized(NumCells);
+	Aspect.SetNumUninitialized(NumCells);
+	Latitude.SetNumUninitialized(NumCells);
+	Curvature.SetNumUninitialized(NumCells);
+	Altitude.SetNumUninitialized(NumCells);
+
+	for (int32 Index = 0; Index < NumCells; ++Index)
+	{
+		const FLandscapeCell& Cell = LandscapeCells[Index];
+
+		SnowHeight[Index] = QuantizeSnowHeight(Cell.InitialWaterEquivalent / (Cell.Area / (100 * 100)));
+
+		AreaXY[Index] = RoundToHalf(Cell.AreaXY / (100 * 100) / AreaXYScale);
+		AreaFactor[Index] = RoundToHalf(Cell.Area / Cell.AreaXY);
+		Inclination[Index] = Quantize16(Cell.Inclination, 0, PI / 2);
+		Aspect[Index] = static_cast<uint16>(FMath::RoundToInt(Cell.Aspect / (2 * PI) * 65536) & 0xFFFF);
+		Latitude[Index] = Quantize16(Cell.Latitude, -PI / 2, PI / 2);
+		Curvature[Index] = RoundToHalf(Cell.Curvature);
+		Altitude[Index] = Quantize16(Cell.Altitude, BaseAltitude, BaseAltitude + AltitudeStep * MAX_uint16);
+	}
+}
+
+void FCompactCellStore::Decompress(int32 BeginIndex, int32 EndIndex, FSimulationCellStore& OutCells) const
+{
+	const int32 NumCells = EndIndex - BeginIndex;
+
+	OutCells.DimensionX = DimensionX;
+	OutCells.DimensionY = FMath::DivideAndRoundUp(NumCells, FMath::Max(1, DimensionX));
+
+	OutCells.SnowWaterEquivalent.SetNumUninitialized(NumCells, false);
+	OutCells.InterpolatedSnowWaterEquivalent.SetNumUninitialized(NumCells, false);
+	OutCells.SnowAlbedo.SetNumUninitialized(NumCells, false);
+	OutCells.DaysSinceLastSnowfall.SetNumUninitialized(NumCells, false);
+	OutCells.Area.SetNumUninitialized(NumCells, false);
+	OutCells.AreaXY.SetNumUninitialized(NumCells, false);
+	OutCells.Inclination.SetNumUninitialized(NumCells, false);
+	OutCells.Aspect.SetNumUninitialized(NumCells, false);
+	OutCells.Latitude.SetNumUninitialized(NumCells, false);
+	OutCells.Curvature.SetNumUninitialized(NumCells, false);
+	OutCells.Altitude.SetNumUninitialized(NumCells, false);
+	OutCells.InverseAreaSquareMeters.SetNumUninitialized(NumCells, false);
+	OutCells.InterpolationFactor.SetNumUninitialized(NumCells, false);
+
+	for (int32 Cell = 0; Cell < NumCells; ++Cell)
+	{
+		const int32 Index = BeginIndex + Cell;
+
+		const float AreaXYSquareMeters = AreaXY[Index].GetFloat() * AreaXYScale;
+		const float AreaSquareMeters = AreaXYSquareMeters * AreaFactor[Index].GetFloat();
+
+		OutCells.Area[Cell] = AreaSquareMeters * (100 * 100);
+		OutCells.AreaXY[Cell] = AreaXYSquareMeters * (100 * 100);
+		OutCells.InverseAreaSquareMeters[Cell] = 1.0f / AreaSquareMeters;
+		OutCells.Inclination[Cell] = Dequantize16(Inclination[Index], 0, PI / 2);
+		OutCells.Aspect[Cell] = Aspect[Index] * (2 * PI / 65536);
+		OutCells.Latitude[Cell] = Dequantize16(Latitude[Index], -PI / 2, PI / 2);
+		OutCells.Curvature[Cell] = Curvature[Index].GetFloat();
+		OutCells.Altitude[Cell] = BaseAltitude + Altitude[Index] * AltitudeStep;
+		OutCells.InterpolationFactor[Cell] = 1.0f;
+
+		OutCells.SnowWaterEquivalent[Cell] = GetSnowHeight(Index) * AreaSquareMeters;
+		OutCells.InterpolatedSnowWaterEquivalent[Cell] = InterpolatedSnowHeight[Index].GetFloat() * AreaSquareMeters;
+		OutCells.SnowAlbedo[Cell] = SnowAlbedo[Index] / 255.0f;
+		OutCells.DaysSinceLastSnowfall[Cell] = HoursSinceLastSnowfall[Index] / 24.0f;
+	}
+}
+
+void FCompactCellStore::Compress(int32 BeginIndex, const FSimulationCellStore& Cells)
+{
+	for (int32 Cell = 0; Cell < Cells.Num(); ++Cell)
+	{
+		const int32 Index = BeginIndex + Cell;
+
+		SnowHeight[Index] = QuantizeSnowHeight(Cells.SnowWaterEquivalent[Cell] * Cells.InverseAreaSquareMeters[Cell]);
+		InterpolatedSnowHeight[Index] = RoundToHalf(Cells.InterpolatedSnowWaterEquivalent[Cell] * Cells.InverseAreaSquareMeters[Cell]);
+		SnowAlbedo[Index] = static_cast<uint8>(FMath::Clamp(FMath::RoundToInt(Cells.SnowAlbedo[Cell] * 255), 0, 255));
+		HoursSinceLastSnowfall[Index] = static_cast<uint16>(FMath::Clamp(FMath::RoundToInt(Cells.DaysSinceLastSnowfall[Cell] * 24), 0, static_cast<int32>(MAX_uint16)));
+	}
+}
+
+SIZE_T FCompactCellStore::GetAllocatedSize() const
+{
+	return SnowHeight.GetAllocatedSize() + InterpolatedSnowHeight.GetAllocatedSize() + SnowAlbedo.GetAllocatedSize() + HoursSinceLastSnowfall.GetAllocatedSize()
+		+ AreaXY.GetAllocatedSize() + AreaFactor.GetAllocatedSize() + Inclination.GetAllocatedSize() + Aspect.GetAllocatedSize()
+		+ Latitude.GetAllocatedSize() + Curvature.GetAllocatedSize() + Altitude.GetAllocatedSize();
+}
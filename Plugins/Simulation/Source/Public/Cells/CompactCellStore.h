@@ -0,0 +1,116 @@
+#pragma once
+
+#include "Cells/SimulationCellStore.h"
+
+/**
+* Quantized storage for the cells of very large grids. The simulation decompresses a tile of cells into a
+* FSimulationCellStore, advances it with the full precision kernels and compresses the state again. A cell needs 23
+* bytes instead of the 52 bytes of FSimulationCellStore.
+*
+* Errors of the decompressed values:
+* - Inclination, aspect and latitude are uint16 angles with an error of at most 1.2e-5, 4.8e-5 and 2.4e-5 radians.
+* - Altitude is a uint16 offset from the lowest cell in steps of at least 1 cm, the error is at most half a step, which
+*   is 1.5 cm for a terrain spanning 2000 m.
+* - Projected area, the ratio of area and projected area, and curvature are half floats which are rounded to the nearest
+*   value, the relative error is at most 4.9e-4. The projected area is stored relative to the largest cell, so it does
+*   not overflow the largest half float of 65504 for large cells.
+* - Snow is stored as a uint32 snow height in steps of 1/4096 mm, which covers heights up to 1048 m. The state is
+*   compressed after every time step, so the error accumulates over the steps, but an hourly change is only lost if it
+*   is smaller than 1/8192 mm and a season of 4320 hourly steps drifts by at most 0.53 mm. A half float would drop
+*   changes smaller than 0.5 mm on a snowpack of 1 m, so light snowfall and slow melt would stall on deep snowpacks.
+*   Simulation.ValidateCompactStorage reports the drift against full precision.
+* - The interpolated snow height is only an output of the kernels and is stored as a half float with a relative error
+*   of at most 4.9e-4.
+* - The albedo is a uint8 with an error of at most 2e-3. It only affects the hours in which no albedo decay is computed.
+* - The days since the last snowfall are stored as uint16 hours, which is exact up to 2730 days.
+*/
+struct SIMULATION_API FCompactCellStore
+{
+	/** Number of cells in x direction. */
+	int32 DimensionX = 0;
+
+	/** Number of cells in y direction. */
+	int32 DimensionY = 0;
+
+	// State
+
+	/** Number of steps of the stored snow height per mm. */
+	static const int32 SnowHeightStepsPerMM = 4096;
+
+	/** Snow height in 1/SnowHeightStepsPerMM mm (or liters/m^2). */
+	TArray<uint32> SnowHeight;
+
+	/** Snow height after interpolation in mm. */
+	TArray<FFloat16> InterpolatedSnowHeight;
+
+	/** The albedo of the snow in 1/255. */
+	TArray<uint8> SnowAlbedo;
+
+	/** The hours since the last snow has fallen on the cell. */
+	TArray<uint16> HoursSinceLastSnowfall;
+
+	// Invariants
+
+	/** Area of the cell projected onto the XY plane in AreaXYScale. */
+	TArray<FFloat16> AreaXY;
+
+	/** Area divided by the projected area. */
+	TArray<FFloat16> AreaFactor;
+
+	/** The slope in 65535ths of PI / 2. */
+	TArray<uint16> Inclination;
+
+	/** The compass direction the cell faces in 65536ths of 2 * PI. */
+	TArray<uint16> Aspect;
+
+	/** The latitude in 65535ths of PI starting at -PI / 2. */
+	TArray<uint16> Latitude;
+
+	/** The curvature (second derivative) of the terrain. */
+	TArray<FFloat16> Curvature;
+
+	/** Altitude above BaseAltitude in steps of AltitudeStep. */
+	TArray<uint16> Altitude;
+
+	/** The altitude of the lowest cell in cm. */
+	float BaseAltitude = 0;
+
+	/** The altitude difference of one step in cm. */
+	float AltitudeStep = 1;
+
+	/** The projected area of the largest cell in m^2, the unit of AreaXY. */
+	float AreaXYScale = 1;
+
+	/** Creates the quantized cells from the given landscape cells which are stored row by row. */
+	void Initialize(const TArray<FLandscapeCell>& LandscapeCells, int32 CellsDimensionX, int32 CellsDimensionY);
+
+	/**
+	* Decompresses the cells [BeginIndex, EndIndex) into the given store, which then holds these cells starting at index
+	* zero. The interpolation factor is set to 1.
+	*/
+	void Decompress(int32 BeginIndex, int32 EndIndex, FSimulationCellStore& OutCells) const;
+
+	/** Compresses the state of the given store, which holds the cells starting at BeginIndex, back into this store. */
+	void Compress(int32 BeginIndex, const FSimulationCellStore& Cells);
+
+	/** Returns the number of cells. */
+	int32 Num() const
+	{
+		return SnowHeight.Num();
+	}
+
+	/** Returns the snow amount of the given cell in mm (or liters/m^2). */
+	float GetSnowHeight(int32 Index) const
+	{
+		return SnowHeight[Index] * (1.0f / SnowHeightStepsPerMM);
+	}
+
+	/** Returns the snow amount of the given cell after interpolation in mm (or liters/m^2). */
+	float GetInterpolatedSnowHeight(int32 Index) const
+	{
+		return InterpolatedSnowHeight[Index].GetFloat();
+	}
+
+	/** Returns the number of bytes allocated by the arrays. */
+	SIZE_T GetAllocatedSize() const;
+};
@@ -0,0 +1,187 @@
+#pragma once
+
+/** The directions of the eight neighbourhood starting from north, N is towards -Y and E towards +X. */
+enum class ENeighbour : int32
+{
+	N = 0,
+	NE,
+	E,
+	SE,
+	S,
+	SW,
+	W,
+	NW,
+	Num
+};
+
+/**
+* Row major grid of values surrounded by a border of one ghost cell. Every interior cell has all eight neighbours in the
+* padded storage, so stencils access them with constant index offsets and without bounds checks. The ghost cells are
+* not part of the grid, they are filled by FillBorder or ReplicateBorder before a stencil is evaluated.
+*
+* Cells are addressed by their padded index which GetIndex returns for the interior coordinates.
+*/
+template<typename T>
+class THaloGrid
+{
+public:
+	/** Creates the grid with the given interior dimensions, all cells including the border are set to the given value. */
+	void Initialize(int32 InDimensionX, int32 InDimensionY, const T& Value = T())
+	{
+		DimensionX = InDimensionX;
+		DimensionY = InDimensionY;
+		Stride = DimensionX + 2;
+
+		Values.Init(Value, Stride * (DimensionY + 2));
+
+		NeighbourOffsets[static_cast<int32>(ENeighbour::N)] = -Stride;
+		NeighbourOffsets[static_cast<int32>(ENeighbour::NE)] = -Stride + 1;
+		NeighbourOffsets[static_cast<int32>(ENeighbour::E)] = 1;
+		NeighbourOffsets[static_cast<int32>(ENeighbour::SE)] = Stride + 1;
+		NeighbourOffsets[static_cast<int32>(ENeighbour::S)] = Stride;
+		NeighbourOffsets[static_cast<int32>(ENeighbour::SW)] = Stride - 1;
+		NeighbourOffsets[static_cast<int32>(ENeighbour::W)] = -1;
+		NeighbourOffsets[static_cast<int32>(ENeighbour::NW)] = -Stride - 1;
+	}
+
+	/** Returns the padded index of the interior cell at the given position, -1 <= X <= DimensionX addresses the border. */
+	FORCEINLINE int32 GetIndex(int32 X, int32 Y) const
+	{
+		return (Y + 1) * Stride + X + 1;
+	}
+
+	/** Returns the index offset of the given neighbour. */
+	FORCEINLINE int32 GetNeighbourOffset(ENeighbour Neighbour) const
+	{
+		return NeighbourOffsets[static_cast<int32>(Neighbour)];
+	}
+
+	/** Returns the value of the neighbour of the cell with the given padded index. */
+	FORCEINLINE const T& GetNeighbour(int32 Index, ENeighbour Neighbour) const
+	{
+		return Values[Index + NeighbourOffsets[static_cast<int32>(Neighbour)]];
+	}
+
+	FORCEINLINE T& operator[](int32 Index)
+	{
+		return Values[Index];
+	}
+
+	FORCEINLINE const T& operator[](int32 Index) const
+	{
+		return Values[Index];
+	}
+
+	/** Returns the value of the interior cell at the given position. */
+	FORCEINLINE T& Get(int32 X, int32 Y)
+	{
+		return Values[GetIndex(X, Y)];
+	}
+
+	FORCEINLINE const T& Get(int32 X, int32 Y) const
+	{
+		return Values[GetIndex(X, Y)];
+	}
+
+	/** Copies the interior cells from the given row major array of DimensionX * DimensionY values. */
+	template<typename SourceType, typename ProjectionType>
+	void CopyInterior(const SourceType& Source, ProjectionType Projection)
+	{
+		for (int32 Y = 0; Y < DimensionY; ++Y)
+		{
+			T* Row = &Values[GetIndex(0, Y)];
+			for (int32 X = 0; X < DimensionX; ++X)
+			{
+				Row[X] = Projection(Source[X + Y * DimensionX]);
+			}
+		}
+	}
+
+	/** Sets all ghost cells to the given value, e.g. zero for an absorbing border of a transport kernel. */
+	void FillBorder(const T& Value)
+	{
+		for (int32 X = -1; X <= DimensionX; ++X)
+		{
+			Get(X, -1) = Value;
+			Get(X, DimensionY) = Value;
+		}
+		for (int32 Y = 0; Y < DimensionY; ++Y)
+		{
+			Get(-1, Y) = Value;
+			Get(DimensionX, Y) = Value;
+		}
+	}
+
+	/** Sets every ghost cell to the value of the nearest interior cell, so gradients across the border are zero. */
+	void ReplicateBorder()
+	{
+		if (DimensionX == 0 || DimensionY == 0) return;
+
+		for (int32 Y = 0; Y < DimensionY; ++Y)
+		{
+			Get(-1, Y) = Get(0, Y);
+			Get(DimensionX, Y) = Get(DimensionX - 1, Y);
+		}
+
+		// The rows include the corners
+		for (int32 X = -1; X <= DimensionX; ++X)
+		{
+			Get(X, -1) = Get(X, 0);
+			Get(X, DimensionY) = Get(X, DimensionY - 1);
+		}
+	}
+
+	/**
+	* Calls Function(X, Y, Index) for the interior cells inset by the given number of cells from every side. The rows are
+	* iterated in order and the padded index of the cells of a row is contiguous.
+	*/
+	template<typename FunctionType>
+	void ForEachCell(FunctionType Function, int32 Inset = 0) const
+	{
+		for (int32 Y = Inset; Y < DimensionY - Inset; ++Y)
+		{
+			const int32 RowIndex = GetIndex(0, Y);
+			for (int32 X = Inset; X < DimensionX - Inset; ++X)
+			{
+				Function(X, Y, RowIndex + X);
+			}
+		}
+	}
+
+	/** Returns the number of interior cells in x direction. */
+	int32 GetDimensionX() const
+	{
+		return DimensionX;
+	}
+
+	/** Returns the number of interior cells in y direction. */
+	int32 GetDimensionY() const
+	{
+		return DimensionY;
+	}
+
+	/** Returns the number of values in a padded row. */
+	int32 GetStride() const
+	{
+		return Stride;
+	}
+
+	/** Returns the number of bytes allocated by the grid. */
+	SIZE_T GetAllocatedSize() const
+	{
+		return Values.GetAllocatedSize();
+	}
+
+private:
+	/** The padded values row by row. */
+	TArray<T> Values;
+
+	int32 DimensionX = 0;
+
+	int32 DimensionY = 0;
+
+	int32 Stride = 2;
+
+	/** Index offsets of the eight neighbourhood in the order of ENeighbour. */
+	int32 NeighbourOffsets[static_cast<int32>(ENeighbour::Num)] = { 0 };
+};
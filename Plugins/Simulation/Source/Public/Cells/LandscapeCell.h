@@ -41,6 +41,9 @@ struct FLandscapeCell
 	/** The curvature (second derivative) of the terrain for this cell. */
 	float Curvature = 0.0f;
 
+	/** Density of the vegetation [0-1] of this cell, negative if the landscape has no vegetation data. */
+	float VegetationDensity = -1.0f;
+
 
 
 	FLandscapeCell() : Index(0), P1(FVector::ZeroVector), P2(FVector::ZeroVector), P3(FVector::ZeroVector), P4(FVector::ZeroVector),
@@ -0,0 +1,322 @@
+#include "Simulation.h"
+#include "MultiResolutionGrid.h"
+#include "Cells/CellQuadtree.h"
+#include "Radiation/SolarRadiation.h"
+
+void FMultiResolutionGrid::Initialize(const TArray<FLandscapeCell>& Cells, int32 CellsDimensionX, int32 CellsDimensionY, int32 NumLevels)
+{
+	NumLevels = FMath::Clamp(NumLevels, 1, 8);
+	const int32 TileSize = 1 << (NumLevels - 1);
+	NumTilesX = FMath::DivideAndRoundUp(CellsDimensionX, TileSize);
+	const int32 NumTilesY = FMath::DivideAndRoundUp(CellsDimensionY, TileSize);
+	const int32 NumTiles = NumTilesX * NumTilesY;
+
+	DimensionX = CellsDimensionX;
+	TileShift = NumLevels - 1;
+
+	Levels.SetNum(NumLevels);
+	TileBegin.SetNum(NumLevels);
+	LevelCells.SetNum(NumLevels);
+	RadiationIndex.SetNum(NumLevels);
+	GridCells.SetNumUninitialized(CellsDimensionX * CellsDimensionY);
+	TileBounds.SetNumUninitialized(NumTiles);
+
+	TArray<FLandscapeCell> LevelLandscapeCells;
+
+	for (int32 Level = 0; Level < NumLevels; ++Level)
+	{
+		const int32 LevelTileSize = TileSize >> Level;
+
+		LevelLandscapeCells.Empty(Level == 0 ? Cells.Num() : LevelLandscapeCells.Num() / 4 + NumTiles);
+		TileBegin[Level].SetNumUninitialized(NumTiles + 1);
+		LevelCells[Level].SetNumUninitialized(Cells.Num());
+
+		for (int32 Tile = 0; Tile < NumTiles; ++Tile)
+		{
+			const int32 TileX = (Tile % NumTilesX) * TileSize;
+			const int32 TileY = (Tile / NumTilesX) * TileSize;
+
+			TileBegin[Level][Tile] = LevelLandscapeCells.Num();
+
+			// The cells of the tiles of the last column and row are clipped at the border of the grid
+			for (int32 Y = 0; Y < LevelTileSize; ++Y)
+			{
+				for (int32 X = 0; X < LevelTileSize; ++X)
+				{
+					const FIntRect Block(TileX + (X << Level), TileY + (Y << Level),
+						FMath::Min(TileX + ((X + 1) << Level), CellsDimensionX), FMath::Min(TileY + ((Y + 1) << Level), CellsDimensionY));
+
+					if (Block.Min.X >= Block.Max.X || Block.Min.Y >= Block.Max.Y)
+					{
+						continue;
+					}
+
+					const int32 Index = LevelLandscapeCells.Num();
+					for (int32 CellY = Block.Min.Y; CellY < Block.Max.Y; ++CellY)
+					{
+						for (int32 CellX = Block.Min.X; CellX < Block.Max.X; ++CellX)
+						{
+							const int32 GridIndex = CellY * CellsDimensionX + CellX;
+							if (Level == 0)
+							{
+								GridCells[GridIndex] = Index;
+							}
+							LevelCells[Level][GridCells[GridIndex]] = Index;
+						}
+					}
+
+					if (Level == 0)
+					{
+						LevelLandscapeCells.Add(Cells[Block.Min.Y * CellsDimensionX + Block.Min.X]);
+					}
+					else
+					{
+						LevelLandscapeCells.Add(FCellQuadtree::AggregateCells(Cells, CellsDimensionX, Block, Index));
+					}
+				}
+			}
+		}
+		TileBegin[Level][NumTiles] = LevelLandscapeCells.Num();
+
+		// The cells of a level are only simulated tile by tile, they are stored as a single row
+		Levels[Level].Initialize(LevelLandscapeCells, LevelLandscapeCells.Num(), 1);
+		RadiationIndex[Level].SetNumZeroed(LevelLandscapeCells.Num());
+	}
+
+	// Bounds of the tiles from the vertices of their cells
+	for (int32 Tile = 0; Tile < NumTiles; ++Tile)
+	{
+		const int32 TileX = (Tile % NumTilesX) * TileSize;
+		const int32 TileY = (Tile / NumTilesX) * TileSize;
+
+		FBox2D Bounds(ForceInit);
+		for (int32 Y = TileY; Y < FMath::Min(TileY + TileSize, CellsDimensionY); ++Y)
+		{
+			for (int32 X = TileX; X < FMath::Min(TileX + TileSize, CellsDimensionX); ++X)
+			{
+				const FLandscapeCell& Cell = Cells[Y * CellsDimensionX + X];
+				Bounds += FVector2D(Cell.P1);
+				Bounds += FVector2D(Cell.P2);
+				Bounds += FVector2D(Cell.P3);
+				Bounds += FVector2D(Cell.P4);
+			}
+		}
+		TileBounds[Tile] = Bounds;
+	}
+
+	// The coarsest level already holds the summed initial snow of its cells
+	TileLevels.Init(NumLevels - 1, NumTiles);
+	TileRadiationDay.Init(-1, NumTiles);
+
+	MaxInterpolationFactor.SetNum(NumLevels);
+	UpdateMaxInterpolationFactors();
+}
+
+void FMultiResolutionGrid::Reset()
+{
+	Levels.Empty();
+	TileBegin.Empty();
+	LevelCells.Empty();
+	GridCells.Empty();
+	TileBounds.Empty();
+	TileLevels.Empty();
+	RadiationIndex.Empty();
+	TileRadiationDay.Empty();
+	MaxInterpolationFactor.Empty();
+	DimensionX = 0;
+	NumTilesX = 0;
+	TileShift = 0;
+}
+
+int32 FMultiResolutionGrid::UpdateLevels(const FVector& Center, float FineRadius, float Hysteresis)
+{
+	const int32 MaxLevel = Levels.Num() - 1;
+
+	// A radius of less than 1 cm would divide by zero
+	const float Radius = FMath::Max(FineRadius, 1.0f);
+
+	auto GetLevel = [&](float Distance)
+	{
+		return Distance < Radius ? 0 : FMath::Clamp(1 + FMath::FloorToInt(FMath::Log2(Distance / Radius)), 0, MaxLevel);
+	};
+
+	int32 NumChangedTiles = 0;
+	for (int32 Tile = 0; Tile < TileLevels.Num(); ++Tile)
+	{
+		const float Distance = GetTileDistance(Tile, Center);
+		const int32 CurrentLevel = TileLevels[Tile];
+		int32 Level = GetLevel(Distance);
+		if (Level > CurrentLevel)
+		{
+			Level = FMath::Max(CurrentLevel, GetLevel(Distance / (1 + Hysteresis)));
+		}
+
+		if (Level != CurrentLevel)
+		{
+			SetTileLevel(Tile, Level);
+			NumChangedTiles++;
+		}
+	}
+
+	return NumChangedTiles;
+}
+
+void FMultiResolutionGrid::SetTileLevel(int32 Tile, int32 Level)
+{
+	const int32 CurrentLevel = TileLevels[Tile];
+	if (Level == CurrentLevel)
+	{
+		return;
+	}
+
+	Scatter(Tile, CurrentLevel);
+	Gather(Tile, Level);
+
+	TileLevels[Tile] = Level;
+	TileRadiationDay[Tile] = -1;
+}
+
+void FMultiResolutionGrid::Scatter(int32 Tile, int32 Level)
+{
+	if (Level == 0)
+	{
+		return;
+	}
+
+	FSimulationCellStore& BaseCells = Levels[0];
+	const FSimulationCellStore& CoarseCells = Levels[Level];
+	const TArray<int32>& CoarseIndex = LevelCells[Level];
+
+	for (int32 Index = TileBegin[0][Tile]; Index < TileBegin[0][Tile + 1]; ++Index)
+	{
+		const int32 Coarse = CoarseIndex[Index];
+
+		// Every cell receives the snow height of the coarse cell
+		BaseCells.SnowWaterEquivalent[Index] = CoarseCells.SnowWaterEquivalent[Coarse] * CoarseCells.InverseAreaSquareMeters[Coarse] * BaseCells.Area[Index] / (100 * 100);
+		BaseCells.SnowAlbedo[Index] = CoarseCells.SnowAlbedo[Coarse];
+		BaseCells.DaysSinceLastSnowfall[Index] = CoarseCells.DaysSinceLastSnowfall[Coarse];
+	}
+}
+
+void FMultiResolutionGrid::Gather(int32 Tile, int32 Level)
+{
+	if (Level == 0)
+	{
+		return;
+	}
+
+	const FSimulationCellStore& BaseCells = Levels[0];
+	FSimulationCellStore& CoarseCells = Levels[Level];
+	const TArray<int32>& CoarseIndex = LevelCells[Level];
+
+	const int32 BeginIndex = TileBegin[Level][Tile];
+	const int32 EndIndex = TileBegin[Level][Tile + 1];
+
+	for (int32 Coarse = BeginIndex; Coarse < EndIndex; ++Coarse)
+	{
+		CoarseCells.SnowWaterEquivalent[Coarse] = 0;
+		CoarseCells.SnowAlbedo[Coarse] = 0;
+		CoarseCells.DaysSinceLastSnowfall[Coarse] = 0;
+	}
+
+	// The snow is summed up, the albedo and the days since the last snowfall are weighted by the area
+	for (int32 Index = TileBegin[0][Tile]; Index < TileBegin[0][Tile + 1]; ++Index)
+	{
+		const int32 Coarse = CoarseIndex[Index];
+
+		CoarseCells.SnowWaterEquivalent[Coarse] += BaseCells.SnowWaterEquivalent[Index];
+		CoarseCells.SnowAlbedo[Coarse] += BaseCells.SnowAlbedo[Index] * BaseCells.Area[Index];
+		CoarseCells.DaysSinceLastSnowfall[Coarse] += BaseCells.DaysSinceLastSnowfall[Index] * BaseCells.Area[Index];
+	}
+
+	for (int32 Coarse = BeginIndex; Coarse < EndIndex; ++Coarse)
+	{
+		CoarseCells.SnowAlbedo[Coarse] /= CoarseCells.Area[Coarse];
+		CoarseCells.DaysSinceLastSnowfall[Coarse] /= CoarseCells.Area[Coarse];
+	}
+}
+
+float FMultiResolutionGrid::GetTileMaxSnow(int32 Tile) const
+{
+	const int32 Level = TileLevels[Tile];
+	const FSimulationCellStore& Cells = Levels[Level];
+	const float* InterpolationFactor = Level == 0 ? Levels[0].InterpolationFactor.GetData() : MaxInterpolationFactor[Level].GetData();
+
+	float TileMaxSnow = 0;
+	for (int32 Index = TileBegin[Level][Tile]; Index < TileBegin[Level][Tile + 1]; ++Index)
+	{
+		TileMaxSnow = FMath::Max(TileMaxSnow, Cells.SnowWaterEquivalent[Index] * Cells.InverseAreaSquareMeters[Index] * InterpolationFactor[Index]);
+	}
+
+	return TileMaxSnow;
+}
+
+void FMultiResolutionGrid::UpdateMaxInterpolationFactors()
+{
+	const FAlignedFloatArray& BaseFactor = Levels[0].InterpolationFactor;
+
+	for (int32 Level = 1; Level < Levels.Num(); ++Level)
+	{
+		const TArray<int32>& CoarseIndex = LevelCells[Level];
+
+		MaxInterpolationFactor[Level].Init(0.0f, Levels[Level].Num());
+		for (int32 Index = 0; Index < BaseFactor.Num(); ++Index)
+		{
+			float& Factor = MaxInterpolationFactor[Level][CoarseIndex[Index]];
+			Factor = FMath::Max(Factor, BaseFactor[Index]);
+		}
+	}
+}
+
+const float* FMultiResolutionGrid::GetRadiationIndex(int32 Tile, int32 DayOfYear)
+{
+	const int32 Level = TileLevels[Tile];
+	const FSimulationCellStore& Cells = Levels[Level];
+	FAlignedFloatArray& LevelRadiationIndex = RadiationIndex[Level];
+
+	if (TileRadiationDay[Tile] != DayOfYear)
+	{
+		for (int32 Index = TileBegin[Level][Tile]; Index < TileBegin[Level][Tile + 1]; ++Index)
+		{
+			LevelRadiationIndex[Index] = FSolarRadiation::SolarRadiationIndex(Cells.Inclination[Index], Cells.Aspect[Index], Cells.Latitude[Index], DayOfYear);
+		}
+		TileRadiationDay[Tile] = DayOfYear;
+	}
+
+	return LevelRadiationIndex.GetData();
+}
+
+int32 FMultiResolutionGrid::GetNumSimulatedCells() const
+{
+	int32 NumCells = 0;
+	for (int32 Tile = 0; Tile < TileLevels.Num(); ++Tile)
+	{
+		NumCells += GetTileEnd(Tile, TileLevels[Tile]) - GetTileBegin(Tile, TileLevels[Tile]);
+	}
+	return NumCells;
+}
+
+double FMultiResolutionGrid::GetSnowWaterEquivalent() const
+{
+	double SnowWaterEquivalent = 0;
+	for (int32 Tile = 0; Tile < TileLevels.Num(); ++Tile)
+	{
+		const FSimulationCellStore& Cells = Levels[TileLevels[Tile]];
+		for (int32 Index = GetTileBegin(Tile, TileLevels[Tile]); Index < GetTileEnd(Tile, TileLevels[Tile]); ++Index)
+		{
+			SnowWaterEquivalent += Cells.SnowWaterEquivalent[Index];
+		}
+	}
+	return SnowWaterEquivalent;
+}
+
+SIZE_T FMultiResolutionGrid::GetAllocatedSize() const
+{
+	SIZE_T Size = GridCells.GetAllocatedSize() + TileBounds.GetAllocatedSize() + TileLevels.GetAllocatedSize() + TileRadiationDay.GetAllocatedSize();
+	for (int32 Level = 0; Level < Levels.Num(); ++Level)
+	{
+		Size += Levels[Level].GetAllocatedSize() + TileBegin[Level].GetAllocatedSize() + LevelCells[Level].GetAllocatedSize() + RadiationIndex[Level].GetAllocatedSize()
+			+ MaxInterpolationFactor[Level].GetAllocatedSize();
+	}
+	return Size;
+}
@@ -0,0 +1,184 @@
+#pragma once
+
+#include "Cells/SimulationCellStore.h"
+
+/**
+* Cells of a grid at several resolutions. Level L merges blocks of 2^L x 2^L cells of the grid into one cell (see
+* FCellQuadtree::AggregateCells), so all levels are derived from the same landscape vertices. The grid is split into
+* square tiles of 2^(NumLevels - 1) cells and every tile is simulated at one level. The cells of every level are stored
+* tile by tile, so the cells of a tile are a contiguous range at every level.
+*
+* The snow moves between the levels through level 0 when a tile changes its level: a coarse cell gives every grid cell
+* below it its snow height, a coarse cell receives the sum of the snow of the grid cells below it. Both conserve the mass
+* of the snow. Level 0 is not updated when a coarse tile is advanced, the interpolated snow of a grid cell is read from
+* the cell of the level of its tile instead, so a step costs the simulated cells and not the cells of the grid.
+*/
+class SIMULATION_API FMultiResolutionGrid
+{
+public:
+	/**
+	* Creates the levels of the given cells which are stored row by row. All tiles start at the coarsest level.
+	*
+	* @param Cells			The cells of the grid
+	* @param CellsDimensionX	Number of cells in x direction
+	* @param CellsDimensionY	Number of cells in y direction
+	* @param NumLevels		Number of levels, a tile covers 2^(NumLevels - 1) x 2^(NumLevels - 1) cells
+	*/
+	void Initialize(const TArray<FLandscapeCell>& Cells, int32 CellsDimensionX, int32 CellsDimensionY, int32 NumLevels);
+
+	/** Frees the levels. */
+	void Reset();
+
+	/** Returns the number of levels. */
+	int32 GetNumLevels() const
+	{
+		return Levels.Num();
+	}
+
+	/** Returns the number of tiles. */
+	int32 GetNumTiles() const
+	{
+		return TileLevels.Num();
+	}
+
+	/** Returns the cells of the given level. */
+	FSimulationCellStore& GetLevelCells(int32 Level)
+	{
+		return Levels[Level];
+	}
+
+	/** Returns the cells of the given level. */
+	const FSimulationCellStore& GetLevelCells(int32 Level) const
+	{
+		return Levels[Level];
+	}
+
+	/** Returns the level at which the tile is simulated. */
+	int32 GetTileLevel(int32 Tile) const
+	{
+		return TileLevels[Tile];
+	}
+
+	/** Returns the index of the first cell of the tile in the cells of the given level. */
+	int32 GetTileBegin(int32 Tile, int32 Level) const
+	{
+		return TileBegin[Level][Tile];
+	}
+
+	/** Returns the index after the last cell of the tile in the cells of the given level. */
+	int32 GetTileEnd(int32 Tile, int32 Level) const
+	{
+		return TileBegin[Level][Tile + 1];
+	}
+
+	/** Returns the index in the cells of level 0 of the grid cell with the given row by row index. */
+	int32 GetGridCell(int32 Index) const
+	{
+		return GridCells[Index];
+	}
+
+	/** Returns the distance in the XY plane from the given center to the closest point of the tile. */
+	float GetTileDistance(int32 Tile, const FVector& Center) const
+	{
+		const FBox2D& Bounds = TileBounds[Tile];
+		const float DistanceX = FMath::Max3(Bounds.Min.X - Center.X, 0.0f, Center.X - Bounds.Max.X);
+		const float DistanceY = FMath::Max3(Bounds.Min.Y - Center.Y, 0.0f, Center.Y - Bounds.Max.Y);
+		return FMath::Sqrt(DistanceX * DistanceX + DistanceY * DistanceY);
+	}
+
+	/**
+	* Assigns every tile the level of its distance from the given center in the XY plane. Tiles closer than FineRadius
+	* are simulated at level 0, the radius of the following levels doubles. A tile is only moved to a coarser level once it
+	* is farther than the radius of that level times 1 + Hysteresis, so it does not alternate between two levels.
+	*
+	* @return the number of tiles which changed their level
+	*/
+	int32 UpdateLevels(const FVector& Center, float FineRadius, float Hysteresis);
+
+	/** Moves the snow of the tile to the given level. */
+	void SetTileLevel(int32 Tile, int32 Level);
+
+	/**
+	* Returns the snow height in mm of the grid cell with the given row by row index after interpolation. The snow height
+	* of the cell of the level of its tile is interpolated with the interpolation factor of the level 0 cell.
+	*/
+	float GetInterpolatedSnowHeight(int32 Index) const
+	{
+		const int32 X = Index % DimensionX;
+		const int32 Y = Index / DimensionX;
+		const int32 Tile = (Y >> TileShift) * NumTilesX + (X >> TileShift);
+		const int32 Level = TileLevels[Tile];
+		const int32 BaseIndex = GridCells[Index];
+		const int32 CellIndex = LevelCells[Level][BaseIndex];
+
+		const FSimulationCellStore& Cells = Levels[Level];
+		return FMath::Max(0.0f, Cells.SnowWaterEquivalent[CellIndex] * Cells.InverseAreaSquareMeters[CellIndex] * Levels[0].InterpolationFactor[BaseIndex]);
+	}
+
+	/**
+	* Returns the maximum snow amount (mm) of the grid cells of the tile after interpolation. Only the cells of the level
+	* of the tile are read, with the largest interpolation factor of the level 0 cells below every cell.
+	*/
+	float GetTileMaxSnow(int32 Tile) const;
+
+	/** Updates the largest interpolation factor below the cells of the coarser levels after the factors of level 0 changed. */
+	void UpdateMaxInterpolationFactors();
+
+	/**
+	* Returns the radiation index of the cells of the tile at its level for the given day. The radiation index is evaluated
+	* once per day and tile.
+	*/
+	const float* GetRadiationIndex(int32 Tile, int32 DayOfYear);
+
+	/** Returns the number of cells which are simulated at the current levels of the tiles. */
+	int32 GetNumSimulatedCells() const;
+
+	/** Returns the snow water equivalent in liters of all cells at the current levels of the tiles. */
+	double GetSnowWaterEquivalent() const;
+
+	/** Returns the number of bytes allocated by the levels. */
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	/** The cells of every level. */
+	TArray<FSimulationCellStore> Levels;
+
+	/** The index of the first cell of every tile and the number of cells of every level. */
+	TArray<TArray<int32>> TileBegin;
+
+	/** The index of the cell of every level which covers every cell of level 0. */
+	TArray<TArray<int32>> LevelCells;
+
+	/** The index in the cells of level 0 of every grid cell. */
+	TArray<int32> GridCells;
+
+	/** The bounds of every tile in the XY plane. */
+	TArray<FBox2D> TileBounds;
+
+	/** The level of every tile. */
+	TArray<uint8> TileLevels;
+
+	/** The largest interpolation factor of the level 0 cells below every cell of every level, empty for level 0. */
+	TArray<TArray<float>> MaxInterpolationFactor;
+
+	/** Number of cells of the grid in x direction. */
+	int32 DimensionX = 0;
+
+	/** Number of tiles in x direction. */
+	int32 NumTilesX = 0;
+
+	/** Log2 of the number of cells of a tile in each direction. */
+	int32 TileShift = 0;
+
+	/** The radiation index of the cells of every level. */
+	TArray<FAlignedFloatArray> RadiationIndex;
+
+	/** The day of the year of the radiation index of every tile, -1 if it has not been evaluated at the current level. */
+	TArray<int32> TileRadiationDay;
+
+	/** Sets the snow of the level 0 cells of the tile from the cells of the given level, without interpolation. */
+	void Scatter(int32 Tile, int32 Level);
+
+	/** Sets the snow of the cells of the tile at the given level from the level 0 cells. */
+	void Gather(int32 Tile, int32 Level);
+};
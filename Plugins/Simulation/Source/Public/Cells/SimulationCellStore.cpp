@@ -0,0 +1,55 @@
+#include "Simulation.h"
+#include "SimulationCellStore.h"
+
+void FSimulationCellStore::Initialize(const TArray<FLandscapeCell>& LandscapeCells, int32 CellsDimensionX, int32 CellsDimensionY)
+{
+	DimensionX = CellsDimensionX;
+	DimensionY = CellsDimensionY;
+
+	const int32 NumCells = LandscapeCells.Num();
+
+	SnowWaterEquivalent.SetNumUninitialized(NumCells);
+	InterpolatedSnowWaterEquivalent.SetNumZeroed(NumCells);
+	SnowAlbedo.SetNumZeroed(NumCells);
+	DaysSinceLastSnowfall.SetNumZeroed(NumCells);
+
+	Area.SetNumUninitialized(NumCells);
+	AreaXY.SetNumUninitialized(NumCells);
+	Inclination.SetNumUninitialized(NumCells);
+	Aspect.SetNumUninitialized(NumCells);
+	Latitude.SetNumUninitialized(NumCells);
+	Curvature.SetNumUninitialized(NumCells);
+	Altitude.SetNumUninitialized(NumCells);
+	InverseAreaSquareMeters.SetNumUninitialized(NumCells);
+	VegetationDensity.SetNumUninitialized(NumCells);
+	InterpolationFactor.Init(1.0f, NumCells);
+	MeltCoefficient.Empty();
+	SnowfallArea.Empty();
+
+	for (int32 Index = 0; Index < NumCells; ++Index)
+	{
+		const FLandscapeCell& Cell = LandscapeCells[Index];
+
+		SnowWaterEquivalent[Index] = Cell.InitialWaterEquivalent;
+
+		Area[Index] = Cell.Area;
+		AreaXY[Index] = Cell.AreaXY;
+		Inclination[Index] = Cell.Inclination;
+		Aspect[Index] = Cell.Aspect;
+		Latitude[Index] = Cell.Latitude;
+		Curvature[Index] = Cell.Curvature;
+		Altitude[Index] = Cell.Altitude;
+		InverseAreaSquareMeters[Index] = (100 * 100) / Cell.Area;
+		VegetationDensity[Index] = Cell.VegetationDensity;
+	}
+}
+
+SIZE_T FSimulationCellStore::GetAllocatedSize() const
+{
+	return SnowWaterEquivalent.GetAllocatedSize() + InterpolatedSnowWaterEquivalent.GetAllocatedSize()
+		+ SnowAlbedo.GetAllocatedSize() + DaysSinceLastSnowfall.GetAllocatedSize()
+		+ Area.GetAllocatedSize() + AreaXY.GetAllocatedSize() + Inclination.GetAllocatedSize() + Aspect.GetAllocatedSize()
+		+ Latitude.GetAllocatedSize() + Curvature.GetAllocatedSize() + Altitude.GetAllocatedSize()
+		+ InverseAreaSquareMeters.GetAllocatedSize() + VegetationDensity.GetAllocatedSize() + InterpolationFactor.GetAllocatedSize()
+		+ MeltCoefficient.GetAllocatedSize() + SnowfallArea.GetAllocatedSize();
+}
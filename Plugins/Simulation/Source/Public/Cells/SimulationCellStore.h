@@ -0,0 +1,94 @@
+#pragma once
+
+#include "Cells/LandscapeCell.h"
+
+/** Float array which is aligned for vector loads and stores. */
+typedef TArray<float, TAlignedHeapAllocator<16>> FAlignedFloatArray;
+
+/**
+* Structure of arrays storage for the cells of the CPU simulation. The state which is written every time step is kept
+* apart from the invariants of the terrain, so a time step only streams the arrays it actually reads. The geometry of the
+* cells (vertices, normal, centroid) is not stored at all since the simulation never uses it.
+*/
+struct SIMULATION_API FSimulationCellStore
+{
+	/** Number of cells in x direction. */
+	int32 DimensionX = 0;
+
+	/** Number of cells in y direction. */
+	int32 DimensionY = 0;
+
+	// Hot state
+
+	/** Snow water equivalent (SWE) as the mass of water stored in liters. */
+	FAlignedFloatArray SnowWaterEquivalent;
+
+	/** Snow water equivalent (SWE) after interpolation according to Bloeschl. */
+	FAlignedFloatArray InterpolatedSnowWaterEquivalent;
+
+	/** The albedo of the snow [0-1.0]. */
+	FAlignedFloatArray SnowAlbedo;
+
+	/** The days since the last snow has fallen on the cell. */
+	FAlignedFloatArray DaysSinceLastSnowfall;
+
+	// Cold invariants
+
+	/** Area in cm^2. */
+	FAlignedFloatArray Area;
+
+	/** Area of the cell projected onto the XY plane in cm^2. */
+	FAlignedFloatArray AreaXY;
+
+	/** The slope (in radians) of the cell. */
+	FAlignedFloatArray Inclination;
+
+	/** The compass direction the cell faces. */
+	FAlignedFloatArray Aspect;
+
+	/** The latitude of the center of the cell. */
+	FAlignedFloatArray Latitude;
+
+	/** The curvature (second derivative) of the terrain for the cell. */
+	FAlignedFloatArray Curvature;
+
+	/** The altitude (in cm) of the cell's mid point. */
+	FAlignedFloatArray Altitude;
+
+	/** 1 / Area in 1/m^2. */
+	FAlignedFloatArray InverseAreaSquareMeters;
+
+	/** Density of the vegetation [0-1] of the cell, negative if the landscape has no vegetation data. */
+	FAlignedFloatArray VegetationDensity;
+
+	/** Factor of the snow water equivalent after interpolation, it depends on the parameters and is set by the simulation. */
+	FAlignedFloatArray InterpolationFactor;
+
+	/**
+	* Melt in liters per degree Celsius of the melt factor and unit radiation index of snow with albedo 0 during one hour,
+	* k_m * k_v * AreaXY / 24 with the vegetation factor k_v of the cell. It depends on the parameters and is set by the
+	* simulation, empty if the kernels compute it from the parameters.
+	*/
+	FAlignedFloatArray MeltCoefficient;
+
+	/** Area in m^2 of the cell which receives snowfall below the canopy. Set by the simulation together with MeltCoefficient. */
+	FAlignedFloatArray SnowfallArea;
+
+	/** Creates the arrays from the given landscape cells which are stored row by row. */
+	void Initialize(const TArray<FLandscapeCell>& LandscapeCells, int32 CellsDimensionX, int32 CellsDimensionY);
+
+	/** Returns the number of cells. */
+	int32 Num() const
+	{
+		return SnowWaterEquivalent.Num();
+	}
+
+	/** Returns the snow amount of the given cell after interpolation in mm (or liters/m^2). */
+	float GetInterpolatedSnowHeight(int32 Index) const
+	{
+		return InterpolatedSnowWaterEquivalent[Index] / (Area[Index] / (100 * 100));
+	}
+
+	/** Returns the number of bytes allocated by the arrays. */
+	SIZE_T GetAllocatedSize() const;
+};
@@ -0,0 +1,63 @@
+#include "Simulation.h"
+#include "SnowLayerStore.h"
+
+void FSnowLayerStore::Initialize(const FSimulationCellStore& Cells, float InitialDensity)
+{
+	const int32 NumCells = Cells.Num();
+
+	NumLayers.SetNumZeroed(NumCells);
+	Ice.SetNumZeroed(NumCells * MaxLayers);
+	LiquidWater.SetNumZeroed(NumCells * MaxLayers);
+	Density.SetNumZeroed(NumCells * MaxLayers);
+	Age.SetNumZeroed(NumCells * MaxLayers);
+	Runoff.SetNumZeroed(NumCells);
+
+	for (int32 Cell = 0; Cell < NumCells; ++Cell)
+	{
+		if (Cells.SnowWaterEquivalent[Cell] > 0)
+		{
+			const int32 Index = GetIndex(Cell, 0);
+			NumLayers[Cell] = 1;
+			Ice[Index] = Cells.SnowWaterEquivalent[Cell] / (Cells.AreaXY[Cell] / (100 * 100));
+			Density[Index] = InitialDensity;
+		}
+	}
+}
+
+void FSnowLayerStore::Reset()
+{
+	NumLayers.Empty();
+	Ice.Empty();
+	LiquidWater.Empty();
+	Density.Empty();
+	Age.Empty();
+	Runoff.Empty();
+}
+
+float FSnowLayerStore::GetSnowWaterEquivalent(int32 Cell) const
+{
+	float SnowWaterEquivalent = 0;
+	for (int32 Layer = 0; Layer < NumLayers[Cell]; ++Layer)
+	{
+		SnowWaterEquivalent += Ice[GetIndex(Cell, Layer)] + LiquidWater[GetIndex(Cell, Layer)];
+	}
+	return SnowWaterEquivalent;
+}
+
+float FSnowLayerStore::GetDepth(int32 Cell) const
+{
+	// mm = kg/m^2 and kg/m^2 / (kg/m^3) = m
+	float Depth = 0;
+	for (int32 Layer = 0; Layer < NumLayers[Cell]; ++Layer)
+	{
+		const int32 Index = GetIndex(Cell, Layer);
+		Depth += Density[Index] > 0 ? (Ice[Index] + LiquidWater[Index]) / Density[Index] : 0.0f;
+	}
+	return Depth;
+}
+
+SIZE_T FSnowLayerStore::GetAllocatedSize() const
+{
+	return NumLayers.GetAllocatedSize() + Ice.GetAllocatedSize() + LiquidWater.GetAllocatedSize() + Density.GetAllocatedSize()
+		+ Age.GetAllocatedSize() + Runoff.GetAllocatedSize();
+}
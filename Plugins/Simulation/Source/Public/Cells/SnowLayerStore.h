@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Cells/SimulationCellStore.h"
+
+/**
+* Layers of the snowpack of every cell. Every cell owns a block of MaxLayers slots in each array, so the layers of a
+* cell are contiguous and aligned for vector loads and no memory is allocated while the simulation runs. The layers of a
+* cell are stored from the ground up, only the first NumLayers slots of a block are used and the unused slots are zero.
+*/
+struct SIMULATION_API FSnowLayerStore
+{
+	/** Maximum number of layers of a cell, two vectors of four lanes. */
+	static const int32 MaxLayers = 8;
+
+	/** Number of layers of every cell. */
+	TArray<uint8> NumLayers;
+
+	/** Frozen water of the layers in mm (or liters/m^2). */
+	FAlignedFloatArray Ice;
+
+	/** Liquid water held by the layers in mm. */
+	FAlignedFloatArray LiquidWater;
+
+	/** Density of the layers in kg/m^3. */
+	FAlignedFloatArray Density;
+
+	/** Days since the snow of the layers has fallen. */
+	FAlignedFloatArray Age;
+
+	/** Water in liters which left the bottom layer of every cell since Initialize. */
+	FAlignedFloatArray Runoff;
+
+	/**
+	* Creates the layers of the given cells. Cells with snow start with a single layer of settled snow.
+	*
+	* @param Cells				The cells with their initial snow water equivalent
+	* @param InitialDensity	Density of the initial snow in kg/m^3
+	*/
+	void Initialize(const FSimulationCellStore& Cells, float InitialDensity);
+
+	/** Frees the layers. */
+	void Reset();
+
+	/** Returns the number of cells. */
+	int32 Num() const
+	{
+		return NumLayers.Num();
+	}
+
+	/** Returns the index of the given layer of the given cell in the layer arrays. */
+	static int32 GetIndex(int32 Cell, int32 Layer)
+	{
+		return Cell * MaxLayers + Layer;
+	}
+
+	/** Returns the frozen and liquid water of all layers of the given cell in mm. */
+	float GetSnowWaterEquivalent(int32 Cell) const;
+
+	/** Returns the depth of the snowpack of the given cell in m. */
+	float GetDepth(int32 Cell) const;
+
+	/** Returns the number of bytes allocated by the arrays. */
+	SIZE_T GetAllocatedSize() const;
+};
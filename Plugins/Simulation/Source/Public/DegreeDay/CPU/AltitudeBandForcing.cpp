@@ -0,0 +1,77 @@
+#include "Simulation.h"
+#include "AltitudeBandForcing.h"
+
+void FAltitudeBandForcing::Initialize(const FSimulationCellStore& Cells, float BandWidth)
+{
+	Reset();
+
+	if (Cells.Num() == 0) return;
+
+	// Altitude range of the terrain
+	MinAltitude = MAX_FLT;
+	float MaxAltitude = -MAX_FLT;
+	for (int32 Index = 0; Index < Cells.Num(); ++Index)
+	{
+		MinAltitude = FMath::Min(MinAltitude, Cells.Altitude[Index]);
+		MaxAltitude = FMath::Max(MaxAltitude, Cells.Altitude[Index]);
+	}
+
+	// The band index has to fit into 16 bits, very high terrains use wider bands
+	InitializedBandWidth = BandWidth;
+	BandWidth = FMath::Max(BandWidth, (MaxAltitude - MinAltitude) / (MAX_uint16 - 1));
+	NumBands = FMath::Min(FMath::FloorToInt((MaxAltitude - MinAltitude) / BandWidth) + 1, (int32)MAX_uint16);
+
+	CellBand.SetNumUninitialized(Cells.Num());
+	for (int32 Index = 0; Index < Cells.Num(); ++Index)
+	{
+		CellBand[Index] = (uint16)FMath::Clamp(FMath::FloorToInt((Cells.Altitude[Index] - MinAltitude) / BandWidth), 0, NumBands - 1);
+	}
+
+	ActualBandWidth = BandWidth;
+}
+
+void FAltitudeBandForcing::Reset()
+{
+	CellBand.Empty();
+	MinAltitude = 0;
+	InitializedBandWidth = 0;
+	ActualBandWidth = 0;
+	NumBands = 0;
+}
+
+void FAltitudeBandForcing::ComputeForcing(const FDegreeDayForcing& Forcing, const FDegreeDayParameters& Parameters, FDegreeDayCellForcing* OutBands) const
+{
+	for (int32 Band = 0; Band < NumBands; ++Band)
+	{
+		OutBands[Band] = FDegreeDayCPUKernel::GetCellForcing(Forcing, Parameters, MinAltitude + (Band + 0.5f) * ActualBandWidth);
+	}
+}
+
+void FAltitudeBandForcing::AccumulateForcing(const FDegreeDayForcing* HourForcing, int32 NumHours, const FDegreeDayParameters& Parameters, FDegreeDayCellForcing* OutBands, int32* OutLastWetHour) const
+{
+	for (int32 Band = 0; Band < NumBands; ++Band)
+	{
+		const float Altitude = MinAltitude + (Band + 0.5f) * ActualBandWidth;
+
+		FDegreeDayCellForcing Accumulated = { 0, 0, 0, 0 };
+		int32 LastWetHour = -1;
+
+		for (int32 Hour = 0; Hour < NumHours; ++Hour)
+		{
+			const FDegreeDayCellForcing CellForcing = FDegreeDayCPUKernel::GetCellForcing(HourForcing[Hour], Parameters, Altitude);
+
+			// The kernels only apply the precipitation of wet hours, the lapse can make it negative below the measurement
+			if (CellForcing.Precipitation > 0)
+			{
+				Accumulated.Precipitation += CellForcing.Precipitation;
+				Accumulated.Snowfall += CellForcing.Snowfall;
+				Accumulated.NewAlbedo = CellForcing.NewAlbedo;
+				LastWetHour = Hour;
+			}
+			Accumulated.MeltFactor += CellForcing.MeltFactor;
+		}
+
+		OutBands[Band] = Accumulated;
+		OutLastWetHour[Band] = LastWetHour;
+	}
+}
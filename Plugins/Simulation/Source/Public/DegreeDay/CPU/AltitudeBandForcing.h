@@ -0,0 +1,84 @@
+#pragma once
+
+#include "DegreeDayCPUKernel.h"
+
+/**
+* Assigns the cells to altitude bands of a fixed width. The lapse rate adjusted forcing of an hour is computed once per
+* band at its center and gathered by the kernels instead of being computed for every cell. The air temperature of a cell
+* deviates by at most half a band width times the temperature lapse rate, 0.025 degree Celsius for bands of 10m.
+*/
+class SIMULATION_API FAltitudeBandForcing
+{
+public:
+	/**
+	* Assigns the given cells to altitude bands.
+	*
+	* @param Cells		The cells of the terrain
+	* @param BandWidth	Width of the altitude bands in cm
+	*/
+	void Initialize(const FSimulationCellStore& Cells, float BandWidth);
+
+	/** Frees the bands. */
+	void Reset();
+
+	/** Returns true if the bands have been built for the given cells and band width. */
+	bool IsInitialized(const FSimulationCellStore& Cells, float BandWidth) const
+	{
+		return NumBands > 0 && CellBand.Num() == Cells.Num() && InitializedBandWidth == BandWidth;
+	}
+
+	/** Computes the forcing of every band for the given hour into OutBands which has to hold GetNumBands() elements. */
+	void ComputeForcing(const FDegreeDayForcing& Forcing, const FDegreeDayParameters& Parameters, FDegreeDayCellForcing* OutBands) const;
+
+	/**
+	* Accumulates the forcing of consecutive hours for every band. The precipitation and snowfall are summed over the hours
+	* with precipitation and the new albedo is the one of the last of them. The melt factor is summed over all hours, so
+	* it holds the degree hours of the interval.
+	*
+	* @param HourForcing		The forcing of the hours
+	* @param NumHours			Number of hours
+	* @param Parameters		The degree day parameters
+	* @param OutBands			The accumulated forcing of every band, GetNumBands() elements
+	* @param OutLastWetHour	Index of the last hour with precipitation of every band or -1, GetNumBands() elements
+	*/
+	void AccumulateForcing(const FDegreeDayForcing* HourForcing, int32 NumHours, const FDegreeDayParameters& Parameters, FDegreeDayCellForcing* OutBands, int32* OutLastWetHour) const;
+
+	/** Returns the altitude band of every cell. */
+	const uint16* GetCellBands() const
+	{
+		return CellBand.GetData();
+	}
+
+	/** Returns the width of the bands in cm. */
+	float GetBandWidth() const
+	{
+		return ActualBandWidth;
+	}
+
+	/** Returns the number of altitude bands. */
+	int32 GetNumBands() const
+	{
+		return NumBands;
+	}
+
+	/** Returns the number of bytes allocated by the bands. */
+	SIZE_T GetAllocatedSize() const
+	{
+		return CellBand.GetAllocatedSize();
+	}
+
+private:
+	/** Altitude band of every cell. */
+	TArray<uint16> CellBand;
+
+	/** Altitude of the lower edge of the lowest band in cm. */
+	float MinAltitude = 0;
+
+	/** Requested width of the bands in cm. */
+	float InitializedBandWidth = 0;
+
+	/** Width of the bands in cm, wider than requested if the terrain needs more than 65535 bands. */
+	float ActualBandWidth = 0;
+
+	int32 NumBands = 0;
+};
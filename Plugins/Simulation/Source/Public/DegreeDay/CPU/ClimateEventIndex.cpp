@@ -0,0 +1,169 @@
+#include "Simulation.h"
+#include "ClimateEventIndex.h"
+
+void FClimateEventIndex::Build(const FClimateDataView& ClimateData, const FSimulationCellStore& Cells, float MeasurementAltitude, const FDegreeDayParameters& Parameters, float BandWidth)
+{
+	Reset();
+
+	BuildParameters = Parameters;
+	BuildBandWidth = BandWidth;
+	NumHours = ClimateData.Num();
+
+	// Altitude range of the terrain
+	MinAltitude = MAX_FLT;
+	float MaxAltitude = -MAX_FLT;
+	for (int32 Index = 0; Index < Cells.Num(); ++Index)
+	{
+		MinAltitude = FMath::Min(MinAltitude, Cells.Altitude[Index]);
+		MaxAltitude = FMath::Max(MaxAltitude, Cells.Altitude[Index]);
+	}
+	if (Cells.Num() == 0) MinAltitude = MaxAltitude = MeasurementAltitude;
+
+	NumEdges = FMath::FloorToInt((MaxAltitude - MinAltitude) / BandWidth) + 2;
+
+	// Hours in which no snow melts, the air temperature at the lowest cell is at most TMeltA
+	ColdRangeEnd.SetNumUninitialized(NumHours);
+	NextWetHour.SetNumUninitialized(NumHours + 1);
+	ColdHoursBefore.SetNumUninitialized(NumHours + 1);
+
+	NextWetHour[NumHours] = NumHours;
+	for (int32 Hour = NumHours - 1; Hour >= 0; --Hour)
+	{
+		FDegreeDayForcing Forcing;
+		Forcing.Temperature = ClimateData.Get(Hour).Temperature;
+		Forcing.Precipitation = ClimateData.Get(Hour).Precipitation;
+		Forcing.MeasurementAltitude = MeasurementAltitude;
+
+		const bool Cold = FDegreeDayCPUKernel::GetAirTemperature(Forcing, MinAltitude) + 1e-3f <= Parameters.TMeltA;
+
+		ColdRangeEnd[Hour] = Cold ? (Hour + 1 < NumHours ? FMath::Max(Hour + 1, ColdRangeEnd[Hour + 1]) : Hour + 1) : Hour;
+		NextWetHour[Hour] = Forcing.Precipitation > 0 ? Hour : NextWetHour[Hour + 1];
+	}
+
+	NumColdHours = 0;
+	NumDryColdHours = 0;
+	for (int32 Hour = 0; Hour < NumHours; ++Hour)
+	{
+		ColdHoursBefore[Hour] = NumColdHours;
+		if (ColdRangeEnd[Hour] > Hour)
+		{
+			NumColdHours++;
+			if (ClimateData.Get(Hour).Precipitation <= 0) NumDryColdHours++;
+		}
+	}
+	ColdHoursBefore[NumHours] = NumColdHours;
+
+	// Prefix sums of the snowfall and the last wet hour at every band edge over the cold hours
+	SnowfallPrefix.SetNumZeroed((NumColdHours + 1) * NumEdges);
+	LastWetHourPrefix.Init(-1, (NumColdHours + 1) * NumEdges);
+
+	const float SnowRange = Parameters.TSnowB - Parameters.TSnowA;
+
+	for (int32 Hour = 0; Hour < NumHours; ++Hour)
+	{
+		if (ColdRangeEnd[Hour] == Hour) continue;
+
+		FDegreeDayForcing Forcing;
+		Forcing.Temperature = ClimateData.Get(Hour).Temperature;
+		Forcing.Precipitation = ClimateData.Get(Hour).Precipitation;
+		Forcing.MeasurementAltitude = MeasurementAltitude;
+
+		const int32 Previous = ColdHoursBefore[Hour] * NumEdges;
+		const int32 Next = Previous + NumEdges;
+
+		for (int32 Edge = 0; Edge < NumEdges; ++Edge)
+		{
+			const float Altitude = MinAltitude + Edge * BandWidth;
+			const float TAir = FDegreeDayCPUKernel::GetAirTemperature(Forcing, Altitude);
+			const float Precipitation = FDegreeDayCPUKernel::GetPrecipitation(Forcing, Altitude);
+
+			float Snowfall = 0;
+			if (Precipitation > 0 && TAir <= Parameters.TSnowB)
+			{
+				Snowfall = Precipitation * FMath::Clamp(1 - (TAir - Parameters.TSnowA) / SnowRange, 0.0f, 1.0f);
+			}
+
+			SnowfallPrefix[Next + Edge] = SnowfallPrefix[Previous + Edge] + Snowfall;
+			LastWetHourPrefix[Next + Edge] = Precipitation > 0 ? Hour : LastWetHourPrefix[Previous + Edge];
+		}
+	}
+}
+
+void FClimateEventIndex::Reset()
+{
+	ColdRangeEnd.Empty();
+	NextWetHour.Empty();
+	ColdHoursBefore.Empty();
+	SnowfallPrefix.Empty();
+	LastWetHourPrefix.Empty();
+	NumHours = 0;
+	NumColdHours = 0;
+	NumDryColdHours = 0;
+	NumEdges = 0;
+}
+
+void FClimateEventIndex::SimulateRange(const FDegreeDayCellRange& Cells, const FDegreeDayParameters& Parameters, int32 BeginHour, int32 EndHour) const
+{
+	const int32 Hours = EndHour - BeginHour;
+
+	if (IsDry(BeginHour, EndHour))
+	{
+		// Only the days since the last snowfall advance, the albedo is aged as in the last hour of the range
+		for (int32 Index = 0; Index < Cells.Num; ++Index)
+		{
+			float& DaysSinceLastSnowfall = Cells.DaysSinceLastSnowfall[Index];
+
+			if (Cells.SnowWaterEquivalent[Index] > 0 && DaysSinceLastSnowfall >= 0)
+			{
+				Cells.SnowAlbedo[Index] = 0.4 * (1 + FMath::Exp(-Parameters.k_e * (DaysSinceLastSnowfall + (Hours - 1) / 24.0f)));
+			}
+
+			DaysSinceLastSnowfall += Hours / 24.0f;
+		}
+		return;
+	}
+
+	const int32 Begin = ColdHoursBefore[BeginHour] * NumEdges;
+	const int32 End = ColdHoursBefore[EndHour] * NumEdges;
+
+	for (int32 Index = 0; Index < Cells.Num; ++Index)
+	{
+		float& SnowWaterEquivalent = Cells.SnowWaterEquivalent[Index];
+		float& DaysSinceLastSnowfall = Cells.DaysSinceLastSnowfall[Index];
+
+		const float Band = FMath::Max(0.0f, (Cells.Altitude[Index] - MinAltitude) / BuildBandWidth);
+		const int32 Edge = FMath::Min(FMath::FloorToInt(Band), NumEdges - 2);
+		const float Alpha = Band - Edge;
+
+		// Snowfall of the range linearly interpolated between the band edges
+		const double LowerSnowfall = SnowfallPrefix[End + Edge] - SnowfallPrefix[Begin + Edge];
+		const double UpperSnowfall = SnowfallPrefix[End + Edge + 1] - SnowfallPrefix[Begin + Edge + 1];
+		const float Snowfall = LowerSnowfall + (UpperSnowfall - LowerSnowfall) * Alpha; // l/m^2
+
+		// The canopy intercepts a part of the snow
+		const float SnowfallArea = Cells.SnowfallArea ? Cells.SnowfallArea[Index] : Cells.AreaXY[Index] / (100 * 100); // m^2
+		SnowWaterEquivalent += Snowfall * SnowfallArea;
+
+		// Last hour with precipitation
+		const int32 LastWetHour = LastWetHourPrefix[End + Edge];
+		if (LastWetHour >= BeginHour)
+		{
+			DaysSinceLastSnowfall = (EndHour - LastWetHour) / 24.0f;
+		}
+		else
+		{
+			DaysSinceLastSnowfall += Hours / 24.0f;
+		}
+
+		if (SnowWaterEquivalent > 0 && DaysSinceLastSnowfall >= 1 / 24.0f)
+		{
+			Cells.SnowAlbedo[Index] = 0.4 * (1 + FMath::Exp(-Parameters.k_e * (DaysSinceLastSnowfall - 1 / 24.0f)));
+		}
+	}
+}
+
+SIZE_T FClimateEventIndex::GetAllocatedSize() const
+{
+	return ColdRangeEnd.GetAllocatedSize() + NextWetHour.GetAllocatedSize() + ColdHoursBefore.GetAllocatedSize()
+		+ SnowfallPrefix.GetAllocatedSize() + LastWetHourPrefix.GetAllocatedSize();
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "DegreeDayCPUKernel.h"
+#include "ClimateData.h"
+
+/**
+* Index over the weather data which marks the hours in which no snow can melt anywhere on the terrain, because the air
+* temperature at the lowest cell is below TMeltA. In ranges of such cold hours the simulation only accumulates snow and
+* ages the days since the last snowfall, so the ranges can be applied to a cell at once:
+*
+*  - Dry cold ranges only advance the days since the last snowfall.
+*  - Wet cold ranges add the snowfall of the range which only depends on the altitude of the cell. It is stored as prefix
+*    sums over the cold hours for altitudes in steps of the band width and linearly interpolated between them.
+*
+* The days since the last snowfall of a cell use the last hour in which the lower edge of the altitude band of the cell
+* received precipitation.
+*/
+class SIMULATION_API FClimateEventIndex
+{
+public:
+	/**
+	* Builds the index.
+	*
+	* @param ClimateData			The weather data
+	* @param Cells					The cells of the terrain
+	* @param MeasurementAltitude	Altitude of the measurements in cm
+	* @param Parameters			The parameters of the model
+	* @param BandWidth				Width of the altitude bands in cm
+	*/
+	void Build(const FClimateDataView& ClimateData, const FSimulationCellStore& Cells, float MeasurementAltitude, const FDegreeDayParameters& Parameters, float BandWidth);
+
+	/** Frees the index. */
+	void Reset();
+
+	/** Returns true if the index has been built with the given parameters. */
+	bool IsBuiltFor(const FDegreeDayParameters& Parameters, float BandWidth) const
+	{
+		return NumHours > 0 && BuildParameters.TSnowA == Parameters.TSnowA && BuildParameters.TSnowB == Parameters.TSnowB
+			&& BuildParameters.TMeltA == Parameters.TMeltA && BuildBandWidth == BandWidth;
+	}
+
+	/** Returns the end of the range of cold hours starting at the given hour or the hour itself if no snow can melt. */
+	int32 GetColdRangeEnd(int32 Hour) const
+	{
+		return Hour < NumHours ? ColdRangeEnd[Hour] : Hour;
+	}
+
+	/** Returns true if there is no precipitation in the hours [BeginHour, EndHour). */
+	bool IsDry(int32 BeginHour, int32 EndHour) const
+	{
+		return NextWetHour[BeginHour] >= EndHour;
+	}
+
+	/** Simulates the cold hours [BeginHour, EndHour) for the given cells at once. */
+	void SimulateRange(const FDegreeDayCellRange& Cells, const FDegreeDayParameters& Parameters, int32 BeginHour, int32 EndHour) const;
+
+	/** Returns the number of hours in which no snow can melt. */
+	int32 GetNumColdHours() const
+	{
+		return NumColdHours;
+	}
+
+	/** Returns the number of cold hours without precipitation. */
+	int32 GetNumDryColdHours() const
+	{
+		return NumDryColdHours;
+	}
+
+	/** Returns the number of bytes allocated by the index. */
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	/** End of the range of cold hours for every hour, the hour itself for hours in which snow can melt. */
+	TArray<int32> ColdRangeEnd;
+
+	/** The first hour with precipitation at or after every hour. */
+	TArray<int32> NextWetHour;
+
+	/** Number of cold hours before every hour. */
+	TArray<int32> ColdHoursBefore;
+
+	/** Snowfall in l/m^2 at every band edge summed over the cold hours before every cold hour. */
+	TArray<double> SnowfallPrefix;
+
+	/** The last cold hour with precipitation at every band edge before every cold hour or -1. */
+	TArray<int32> LastWetHourPrefix;
+
+	int32 NumHours = 0;
+
+	int32 NumColdHours = 0;
+
+	int32 NumDryColdHours = 0;
+
+	/** Altitude of the lowest band edge in cm. */
+	float MinAltitude = 0;
+
+	int32 NumEdges = 0;
+
+	FDegreeDayParameters BuildParameters;
+
+	float BuildBandWidth = 0;
+};
@@ -0,0 +1,140 @@
+#include "Simulation.h"
+#include "ComputeShaderCPUKernel.h"
+#include "Radiation/SolarRadiation.h"
+
+/** Returns the weather data of the given hour, reads outside of a structured buffer return zero. */
+static FClimateData GetWeatherData(const TArray<FClimateData>& WeatherData, int32 Hour)
+{
+	return WeatherData.IsValidIndex(Hour) ? WeatherData[Hour] : FClimateData();
+}
+
+uint32 FComputeShaderCPUKernel::SimulateRows(FGPUSimulationCell* Cells, const TArray<FClimateData>& WeatherData, const FComputeShaderConstantParameters& Constants,
+	const FComputeShaderVariableParameters& Variables, int32 BeginRow, int32 EndRow, float* SnowOutput)
+{
+	const int32 NumColumns = GetNumDispatchedColumns(Constants);
+
+	uint32 MaxSnow = 0;
+
+	for (int32 Y = BeginRow; Y < EndRow; ++Y)
+	{
+		for (int32 X = 0; X < NumColumns; ++X)
+		{
+			const int32 CellIndex = X + Y * Constants.CellsDimensionX;
+
+			FGPUSimulationCell& Cell = Cells[CellIndex];
+			const float AreaSquareMeters = Cell.AreaXY / (100 * 100); // m^2
+
+			for (int32 Time = 0; Time < Variables.Timesteps; ++Time)
+			{
+				const FClimateData HourWeatherData = GetWeatherData(WeatherData, Variables.CurrentSimulationStep + Time);
+
+				const float StationAltitudeOffset = Cell.Altitude - Constants.MeasurementAltitude;
+				const float TemperatureLapse = -0.5f * StationAltitudeOffset / (100 * 100);
+				const float TAir = HourWeatherData.Temperature + TemperatureLapse; // degree Celsius
+
+				const float PrecipitationLapse = 10.0f / 24.0f * StationAltitudeOffset / (100 * 1000);
+				float Precipitation = HourWeatherData.Precipitation;
+
+				Cell.DaysSinceLastSnowfall += 1.0f / 24.0f;
+
+				// Apply precipitation
+				if (Precipitation > 0)
+				{
+					Precipitation += PrecipitationLapse;
+					Cell.DaysSinceLastSnowfall = 0;
+
+					// New snow/rainfall
+					if (TAir > Constants.TSnowB)
+					{
+						Cell.SnowAlbedo = 0.4f; // New rain drops the albedo to 0.4
+					}
+					else
+					{
+						// Variable lapse rate as described in "A variable lapse rate snowline model for the Remarkables, Central Otago, New Zealand"
+						const float SnowRate = FMath::Clamp(1 - (TAir - Constants.TSnowA) / (Constants.TSnowB - Constants.TSnowA), 0.0f, 1.0f);
+
+						Cell.SnowWaterEquivalent += (Precipitation * AreaSquareMeters * SnowRate); // l/m^2 * m^2 = l
+						Cell.SnowAlbedo = 0.8f; // New snow sets the albedo to 0.8
+					}
+				}
+
+				// Apply melt
+				if (Cell.SnowWaterEquivalent > 0)
+				{
+					if (Cell.DaysSinceLastSnowfall >= 0)
+					{
+						Cell.SnowAlbedo = 0.4f * (1 + FMath::Exp(-Constants.k_e * Cell.DaysSinceLastSnowfall));
+					}
+
+					// Temperature higher than melt threshold and cell contains snow
+					if (TAir > Constants.TMeltA)
+					{
+						const float DayNormalization = 1.0f / 24.0f; // day
+
+						float T4;
+						float T5;
+
+						// Radiation Index
+						const float R_i = FSolarRadiation::SolarRadiationIndex(Cell.Inclination, Cell.Aspect, Cell.Latitude, Variables.DayOfYear, T4, T5); // 1
+
+						// Diurnal approximation
+						const float t = Variables.HourOfDay;
+						const float D = FMath::Abs(T4) + FMath::Abs(T5);
+						const float R_i_t = FMath::Max(PI * R_i / 2 * FMath::Sin(PI * t / D - FMath::Abs(T4) / PI), 0.0f);
+
+						// Melt factor
+						const float VegetationDensity = 0;
+						const float k_v = FMath::Exp(-4 * VegetationDensity); // 1
+						const float c_m = Constants.k_m * k_v * R_i_t * (1 - Cell.SnowAlbedo) * DayNormalization * AreaSquareMeters; // l/C
+						const float MeltFactor = TAir < Constants.TMeltB ?
+							(TAir - Constants.TMeltA) * (TAir - Constants.TMeltA) / (Constants.TMeltB - Constants.TMeltA) :
+							(TAir - Constants.TMeltA);
+
+						const float M = c_m * MeltFactor; // l/C * C = l
+
+						// Apply melt
+						Cell.SnowWaterEquivalent -= M;
+						Cell.SnowWaterEquivalent = FMath::Max(0.0f, Cell.SnowWaterEquivalent);
+					}
+				}
+			}
+
+			// Interpolation with the constants of the shader
+			const float Slope = FMath::RadiansToDegrees(Cell.Inclination);
+			const float f = Slope < 15 ? 0 : Slope / 60;
+			const float a3 = 50;
+
+			const float we = FMath::Max(0.0f, Cell.SnowWaterEquivalent * (1 - f) * (1 + a3 * Cell.Curvature));
+
+			Cell.InterpolatedSWE = we;
+
+			// Maximum of the rows, the shader reduces it with InterlockedMax
+			MaxSnow = FMath::Max(MaxSnow, ToUint(we / AreaSquareMeters * GetUintFloatScale()));
+
+			// Used for the pixel shader
+			SnowOutput[CellIndex] = we / AreaSquareMeters;
+		}
+	}
+
+	return MaxSnow;
+}
+
+int32 FComputeShaderCPUKernel::CompareWithRecord(const TArray<float>& SnowOutput, uint32 MaxSnow, const TArray<float>& RecordedSnowOutput, uint32 RecordedMaxSnow,
+	float Tolerance, float& OutMaxAbsoluteError)
+{
+	check(SnowOutput.Num() == RecordedSnowOutput.Num());
+
+	OutMaxAbsoluteError = 0;
+	int32 NumMismatches = 0;
+	for (int32 Index = 0; Index < SnowOutput.Num(); ++Index)
+	{
+		const float AbsoluteError = FMath::Abs(SnowOutput[Index] - RecordedSnowOutput[Index]);
+		OutMaxAbsoluteError = FMath::Max(OutMaxAbsoluteError, AbsoluteError);
+		if (AbsoluteError > Tolerance * FMath::Max(FMath::Abs(RecordedSnowOutput[Index]), 1.0f)) NumMismatches++;
+	}
+
+	const float MaxSnowError = FMath::Abs(static_cast<float>(MaxSnow) - static_cast<float>(RecordedMaxSnow)) / GetUintFloatScale();
+	if (MaxSnowError > Tolerance * FMath::Max(RecordedMaxSnow / GetUintFloatScale(), 1.0f)) NumMismatches++;
+
+	return NumMismatches;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "SimulationComputeShader.h"
+
+/**
+* CPU execution of MainComputeShader of SimulationComputeShader.usf. The kernel works on the same cell and weather data
+* layouts, uses the same constant and variable parameters and produces the same snow output and integer-scaled maximum
+* snow as the compute shader. Every statement of the shader has its counterpart here, so changes to the shader have to
+* be made to both.
+*/
+class SIMULATION_API FComputeShaderCPUKernel
+{
+public:
+	/** Returns the scale of the maximum snow stored as integer, UINT_FLOAT_SCALE of the shader. */
+	static float GetUintFloatScale()
+	{
+		return 100000.0f;
+	}
+
+	/** Returns the number of threads of a thread group in x and y direction, numthreads of the shader. */
+	static int32 GetNumThreadsPerGroupDimension()
+	{
+		return 4;
+	}
+
+	/** Returns the number of cell rows which are covered by the thread groups of a dispatch. */
+	static int32 GetNumDispatchedRows(const FComputeShaderConstantParameters& Constants)
+	{
+		return FMath::TruncToInt(Constants.ThreadGroupCountY) * GetNumThreadsPerGroupDimension();
+	}
+
+	/** Returns the number of cell columns which are covered by the thread groups of a dispatch. */
+	static int32 GetNumDispatchedColumns(const FComputeShaderConstantParameters& Constants)
+	{
+		return FMath::TruncToInt(Constants.ThreadGroupCountX) * GetNumThreadsPerGroupDimension();
+	}
+
+	/** Converts the given float to an unsigned integer like the conversion of the shader, which saturates. */
+	static uint32 ToUint(float Value)
+	{
+		return Value > 0 ? (Value < 4294967040.0f ? static_cast<uint32>(Value) : MAX_uint32) : 0;
+	}
+
+	/**
+	* Simulates the dispatched cells of the rows [BeginRow, EndRow) like the threads of the compute shader.
+	*
+	* @param Cells			The cells of the whole grid, SimulationCellsBuffer of the shader
+	* @param WeatherData	The weather data of all hours, WeatherDataBuffer of the shader
+	* @param Constants		The constant parameters of the shader
+	* @param Variables		The variable parameters of the shader
+	* @param SnowOutput		The snow output of all cells, SnowOutputBuffer of the shader
+	* @return the integer-scaled maximum snow of the rows which the shader reduces into MaxSnowBuffer
+	*/
+	static uint32 SimulateRows(FGPUSimulationCell* Cells, const TArray<FClimateData>& WeatherData, const FComputeShaderConstantParameters& Constants,
+		const FComputeShaderVariableParameters& Variables, int32 BeginRow, int32 EndRow, float* SnowOutput);
+
+	/**
+	* Compares the output of an execution with the output recorded by the GPU simulation. A cell or the maximum snow is a
+	* mismatch if it differs by more than the tolerance relative to the recorded value, at least 1 mm.
+	*
+	* @param SnowOutput			The snow output of all cells
+	* @param MaxSnow				The integer-scaled maximum snow
+	* @param RecordedSnowOutput	The recorded snow output, it must have the same number of cells
+	* @param RecordedMaxSnow		The recorded integer-scaled maximum snow
+	* @param Tolerance				The relative tolerance
+	* @param OutMaxAbsoluteError	The largest absolute difference of the snow output in mm
+	* @return the number of mismatches
+	*/
+	static int32 CompareWithRecord(const TArray<float>& SnowOutput, uint32 MaxSnow, const TArray<float>& RecordedSnowOutput, uint32 RecordedMaxSnow,
+		float Tolerance, float& OutMaxAbsoluteError);
+};
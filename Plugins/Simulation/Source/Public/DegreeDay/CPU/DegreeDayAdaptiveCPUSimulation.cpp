@@ -0,0 +1,245 @@
+#include "Simulation.h"
+#include "DegreeDayAdaptiveCPUSimulation.h"
+#include "SnowSimulationActor.h"
+#include "Util/TextureUtil.h"
+#include "ParallelFor.h"
+
+FString UDegreeDayAdaptiveCPUSimulation::GetSimulationName()
+{
+	return FString(TEXT("Degree Day CPU Adaptive"));
+}
+
+DECLARE_CYCLE_STAT(TEXT("Degree Day Adaptive CPU Simulate"), STAT_DegreeDayAdaptiveCPUSimulate, STATGROUP_SnowSimulation);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Degree Day Adaptive CPU Leaves"), STAT_DegreeDayAdaptiveCPULeaves, STATGROUP_SnowSimulation);
+
+FCellQuadtreeTolerances UDegreeDayAdaptiveCPUSimulation::GetQuadtreeTolerances() const
+{
+	FCellQuadtreeTolerances Tolerances;
+	Tolerances.Altitude = AltitudeTolerance * 100;
+	Tolerances.Inclination = FMath::DegreesToRadians(InclinationTolerance);
+	Tolerances.Aspect = FMath::DegreesToRadians(AspectTolerance);
+	Tolerances.Curvature = CurvatureTolerance;
+	Tolerances.MaxLevel = MaxLeafLevel;
+	return Tolerances;
+}
+
+void UDegreeDayAdaptiveCPUSimulation::Simulate(ASnowSimulationActor* SimulationActor, int32 CurrentSimulationStep, int32 Timesteps, bool SaveSnowMap, bool CaptureDebugInformation, TArray<FDebugCell>& DebugCells)
+{
+	SCOPE_CYCLE_COUNTER(STAT_DegreeDayAdaptiveCPUSimulate);
+
+	const double StartSeconds = FPlatformTime::Seconds();
+
+	const int32 NumLeaves = LeafCells.Num();
+	const int32 NumHours = FMath::Clamp(ClimateData.Num() - CurrentSimulationStep, 0, Timesteps);
+	const FDegreeDayParameters Parameters = GetParameters();
+	const float MeasurementAltitude = SimulationActor->ClimateDataComponent->GetMeasurementAltitude();
+
+	if (NumHours == 0) return;
+
+	// The interpolation factors of the grid cells and the melt coefficients of the leaves depend on the parameters
+	if (!(InterpolationFactorParameters == Interpolation))
+	{
+		UpdateInterpolationFactors();
+	}
+
+	if (MeltCoefficientParameters.k_m != Parameters.k_m || MeltCoefficientParameters.VegetationDensity != Parameters.VegetationDensity
+		|| MeltCoefficientParameters.CanopyInterception != Parameters.CanopyInterception)
+	{
+		FDegreeDayCPUKernel::UpdateMeltCoefficients(LeafCells, Parameters);
+		MeltCoefficientParameters = Parameters;
+	}
+
+	// Forcing of all hours of this step
+	TArray<FDegreeDayForcing> HourForcing;
+	for (int32 Hour = 0; Hour < NumHours; ++Hour)
+	{
+		const FClimateData& HourClimateData = ClimateData.Get(CurrentSimulationStep + Hour);
+		const FDateTime Time = SimulationActor->CurrentSimulationTime + FTimespan(Hour, 0, 0);
+
+		FDegreeDayForcing Forcing;
+		Forcing.Temperature = HourClimateData.Temperature;
+		Forcing.Precipitation = HourClimateData.Precipitation;
+		Forcing.MeasurementAltitude = MeasurementAltitude;
+		Forcing.DayOfYear = Time.GetDayOfYear();
+		Forcing.DiurnalFactor = RadiationTable.GetDiurnalFactor(Forcing.DayOfYear, Time.GetHour());
+		HourForcing.Add(Forcing);
+	}
+
+	// The grid cells are interpolated when they are read, so the leaves are never interpolated
+	FDegreeDayKernelFeatures Features;
+	Features.DiurnalRadiation = DiurnalRadiation;
+	Features.Vegetation = false; // Folded into the melt coefficients of the leaves
+	Features.Interpolation = false;
+	Features.QuadraticMelt = Parameters.TMeltB > Parameters.TMeltA;
+	const FDegreeDayKernelFunction Kernel = UseVectorKernel ? FDegreeDayCPUKernel::GetVectorKernel(Features) : FDegreeDayCPUKernel::GetScalarKernel(Features);
+
+	// Every task advances a contiguous range of leaves through all hours, the leaves of a quadtree node are adjacent
+	const int32 MaxWorkers = NumWorkers > 0 ? NumWorkers : FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+	const int32 NumTasks = ParallelExecution ? FMath::Max(1, FMath::Min(FMath::DivideAndRoundUp(NumLeaves, 1024), MaxWorkers)) : 1;
+	const int32 LeavesPerTask = FMath::DivideAndRoundUp(NumLeaves, NumTasks);
+
+	auto SimulateTask = [&](int32 Task)
+	{
+		const int32 BeginIndex = FMath::Min(Task * LeavesPerTask, NumLeaves);
+		const int32 EndIndex = FMath::Min(BeginIndex + LeavesPerTask, NumLeaves);
+
+		for (const FDegreeDayForcing& Forcing : HourForcing)
+		{
+			Kernel(FDegreeDayCellRange(LeafCells, BeginIndex, EndIndex, RadiationTable.GetDay(Forcing.DayOfYear)), Parameters, Forcing);
+		}
+	};
+
+	if (ParallelExecution)
+	{
+		ParallelFor(NumTasks, SimulateTask);
+	}
+	else
+	{
+		SimulateTask(0);
+	}
+
+	const double KernelSeconds = FPlatformTime::Seconds() - StartSeconds;
+
+	MaxSnow = ComputeMaxSnow();
+
+	SET_DWORD_STAT(STAT_DegreeDayAdaptiveCPULeaves, NumLeaves);
+
+	if (CaptureDebugInformation)
+	{
+		// Fill debug array
+		for (int32 Index = 0; Index < GridCells.Num() && Index < DebugCells.Num(); ++Index)
+		{
+			DebugCells[Index].SnowMM = GetInterpolatedSnowHeight(Index);
+		}
+	}
+
+	UE_LOG(SimulationLog, Display, TEXT("Iteration %d (%d hours) took %f ms, %d leaves simulated for %d cells, kernels %.2f ms"), CurrentSimulationStep, NumHours,
+		(FPlatformTime::Seconds() - StartSeconds) * 1000, NumLeaves, GridCells.Num(), KernelSeconds * 1000);
+}
+
+void UDegreeDayAdaptiveCPUSimulation::UpdateInterpolationFactors()
+{
+	LeafMaxInterpolationFactor.Init(0.0f, LeafCells.Num());
+
+	for (int32 Index = 0; Index < GridCells.Num(); ++Index)
+	{
+		const float InterpolationFactor = Interpolation.GetInterpolationFactor(GridCells.Inclination[Index], GridCells.Curvature[Index]);
+		float& LeafMax = LeafMaxInterpolationFactor[Quadtree.GetCellLeaf(Index)];
+
+		GridCells.InterpolationFactor[Index] = InterpolationFactor;
+		LeafMax = FMath::Max(LeafMax, InterpolationFactor);
+	}
+	InterpolationFactorParameters = Interpolation;
+}
+
+float UDegreeDayAdaptiveCPUSimulation::ComputeMaxSnow() const
+{
+	// All cells of a leaf have the snow height of the leaf, so the cell with the largest factor has the most snow
+	float LeavesMaxSnow = 0;
+
+	for (int32 Leaf = 0; Leaf < LeafCells.Num(); ++Leaf)
+	{
+		const float SnowHeight = LeafCells.SnowWaterEquivalent[Leaf] * LeafCells.InverseAreaSquareMeters[Leaf];
+		LeavesMaxSnow = FMath::Max(LeavesMaxSnow, SnowHeight * LeafMaxInterpolationFactor[Leaf]);
+	}
+
+	return LeavesMaxSnow;
+}
+
+void UDegreeDayAdaptiveCPUSimulation::Initialize(ASnowSimulationActor* SimulationActor, const TArray<FLandscapeCell>& LandscapeCells, float InitialMaxSnow, UWorld* World)
+{
+	CellsDimensionX = SimulationActor->CellsDimensionX;
+	CellsDimensionY = SimulationActor->CellsDimensionY;
+
+	// The weather data is owned by the provider and does not change during the simulation
+	ClimateData = SimulationActor->ClimateDataComponent->GetClimateDataView();
+
+	const double StartSeconds = FPlatformTime::Seconds();
+
+	// Merge the homogeneous cells, the leaves are stored as a single row since the simulation has no stencils
+	TArray<FLandscapeCell> LeafLandscapeCells;
+	Quadtree.Build(LandscapeCells, CellsDimensionX, CellsDimensionY, GetQuadtreeTolerances(), LeafLandscapeCells);
+	LeafCells.Initialize(LeafLandscapeCells, LeafLandscapeCells.Num(), 1);
+	GridCells.Initialize(LandscapeCells, CellsDimensionX, CellsDimensionY);
+	UpdateInterpolationFactors();
+
+	LeafCorners.Empty(LeafLandscapeCells.Num() * 4);
+	for (const FLandscapeCell& Leaf : LeafLandscapeCells)
+	{
+		LeafCorners.Add(Leaf.P1);
+		LeafCorners.Add(Leaf.P2);
+		LeafCorners.Add(Leaf.P3);
+		LeafCorners.Add(Leaf.P4);
+	}
+
+	MeltCoefficientParameters = GetParameters();
+	FDegreeDayCPUKernel::UpdateMeltCoefficients(LeafCells, MeltCoefficientParameters);
+
+	RadiationTable.Reset();
+	RadiationTable.Build(LeafCells, 1);
+	if (DiurnalRadiation)
+	{
+		RadiationTable.BuildDiurnalFactors(GridCells);
+	}
+
+	UE_LOG(SimulationLog, Display, TEXT("Quadtree took %f ms to build and merged %d cells into %d leaves (%.1f cells per leaf), leaves use %.2f MB, grid uses %.2f MB"),
+		(FPlatformTime::Seconds() - StartSeconds) * 1000, Quadtree.GetNumCells(), Quadtree.GetNumLeaves(), Quadtree.GetCompressionRatio(),
+		(LeafCells.GetAllocatedSize() + RadiationTable.GetAllocatedSize()) / (1024.0f * 1024.0f), (GridCells.GetAllocatedSize() + Quadtree.GetAllocatedSize()) / (1024.0f * 1024.0f));
+
+	MaxSnow = FMath::Max(InitialMaxSnow, ComputeMaxSnow());
+}
+
+UTexture* UDegreeDayAdaptiveCPUSimulation::GetSnowMapTexture()
+{
+	SnowMapTexture = UTexture2D::CreateTransient(CellsDimensionX, CellsDimensionY, EPixelFormat::PF_G16);
+
+	SnowMapTexture->UpdateResource();
+	SnowMapTextureData.Empty(GridCells.Num());
+
+	for (int32 Index = 0; Index < GridCells.Num(); ++Index)
+	{
+		float Gray = GetInterpolatedSnowHeight(Index) / GetMaxSnow() * 255;
+		uint8 GrayInt = static_cast<uint8>(Gray);
+		SnowMapTextureData.Add(FColor(GrayInt, GrayInt, GrayInt));
+	}
+
+	FRenderCommandFence UpdateTextureFence;
+
+	UpdateTextureFence.BeginFence();
+
+	UpdateTexture(SnowMapTexture, SnowMapTextureData);
+
+	UpdateTextureFence.Wait();
+
+	return SnowMapTexture;
+}
+
+float UDegreeDayAdaptiveCPUSimulation::GetMaxSnow()
+{
+	return MaxSnow;
+}
+
+void UDegreeDayAdaptiveCPUSimulation::RenderDebug(UWorld* World, int CellDebugInfoDisplayDistance, EDebugVisualizationType DebugVisualizationType)
+{
+	APlayerController* PlayerController = World ? World->GetFirstPlayerController() : nullptr;
+	if (PlayerController == nullptr || PlayerController->PlayerCameraManager == nullptr) return;
+
+	const FVector Location = PlayerController->PlayerCameraManager->GetCameraLocation();
+
+	// Draw the outlines of the leaves close to the camera, the grid cells are drawn by the actor
+	for (int32 Corner = 0; Corner + 3 < LeafCorners.Num(); Corner += 4)
+	{
+		const FVector& P1 = LeafCorners[Corner];
+		const FVector& P2 = LeafCorners[Corner + 1];
+		const FVector& P3 = LeafCorners[Corner + 2];
+		const FVector& P4 = LeafCorners[Corner + 3];
+
+		if (FVector::Dist(P1, Location) < CellDebugInfoDisplayDistance)
+		{
+			DrawDebugLine(World, P1, P2, FColor(0, 255, 0), false, -1, 0, 0.0f);
+			DrawDebugLine(World, P1, P3, FColor(0, 255, 0), false, -1, 0, 0.0f);
+			DrawDebugLine(World, P2, P4, FColor(0, 255, 0), false, -1, 0, 0.0f);
+			DrawDebugLine(World, P3, P4, FColor(0, 255, 0), false, -1, 0, 0.0f);
+		}
+	}
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "DegreeDay/DegreeDaySimulation.h"
+#include "Cells/SimulationCellStore.h"
+#include "Cells/CellQuadtree.h"
+#include "DegreeDayCPUKernel.h"
+#include "ClimateData.h"
+#include "Radiation/SolarRadiationTable.h"
+#include "DegreeDayAdaptiveCPUSimulation.generated.h"
+
+/**
+* Degree day simulation of the leaves of an adaptive quadtree of the cells, see FCellQuadtree. Blocks of cells whose
+* terrain is homogeneous within the tolerances are simulated as one leaf with the kernels of the CPU simulation. A time
+* step only touches the leaves, the snow of a grid cell is read from its leaf and interpolated with the factor of the
+* cell when the snow map or the debug cells are requested. Simulation.ValidateQuadtree reports the compression and the
+* error against the uniform grid.
+*/
+UCLASS(Blueprintable, BlueprintType)
+class SIMULATION_API UDegreeDayAdaptiveCPUSimulation : public UDegreeDaySimulation
+{
+	GENERATED_BODY()
+private:
+	/** The leaves of the cells. */
+	FCellQuadtree Quadtree;
+
+	/** The aggregated cells of the leaves which are simulated. */
+	FSimulationCellStore LeafCells;
+
+	/** The cells of the grid, only their terrain and interpolation factors are used, their snow is read from the leaves. */
+	FSimulationCellStore GridCells;
+
+	/** The largest interpolation factor of the grid cells of every leaf. */
+	TArray<float> LeafMaxInterpolationFactor;
+
+	/** The corners P1, P2, P3 and P4 of every leaf for the debug rendering. */
+	TArray<FVector> LeafCorners;
+
+	/** The weather data of the provider. */
+	FClimateDataView ClimateData;
+
+	/** Precomputed solar radiation index of the leaves and the diurnal factors if enabled. */
+	FSolarRadiationTable RadiationTable;
+
+	/** The snow mask used by the landscape material. */
+	UTexture2D* SnowMapTexture;
+
+	/** Color buffer for the snow mask texture. */
+	TArray<FColor> SnowMapTextureData;
+
+	/** The maximum snow amount (mm) of the current time step. */
+	float MaxSnow;
+
+	/** The interpolation parameters of the interpolation factors of the grid cells. */
+	FBloeschlParameters InterpolationFactorParameters;
+
+	/** The parameters of the melt coefficients of the leaves. */
+	FDegreeDayParameters MeltCoefficientParameters;
+
+	/** Updates the interpolation factors of the grid cells and the largest factor of every leaf. */
+	void UpdateInterpolationFactors();
+
+	/** Returns the maximum interpolated snow amount (mm) of the grid cells, which only depends on the leaves. */
+	float ComputeMaxSnow() const;
+
+	/** Returns the interpolated snow height (mm) of the grid cell with the given index from the snow of its leaf. */
+	float GetInterpolatedSnowHeight(int32 Index) const
+	{
+		const int32 Leaf = Quadtree.GetCellLeaf(Index);
+		return FMath::Max(0.0f, LeafCells.SnowWaterEquivalent[Leaf] * LeafCells.InverseAreaSquareMeters[Leaf] * GridCells.InterpolationFactor[Index]);
+	}
+
+public:
+	/** Maximum difference of the altitude of merged cells in m. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance", meta = (ClampMin = "0"))
+	float AltitudeTolerance = 20;
+
+	/** Maximum difference of the inclination of merged cells in degrees. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance", meta = (ClampMin = "0"))
+	float InclinationTolerance = 3;
+
+	/** Maximum deviation of the aspect of merged cells from their mean in degrees, only checked for slopes steeper than InclinationTolerance. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance", meta = (ClampMin = "0", ClampMax = "180"))
+	float AspectTolerance = 20;
+
+	/** Maximum difference of the curvature of merged cells. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance", meta = (ClampMin = "0"))
+	float CurvatureTolerance = 0.002f;
+
+	/** Highest level of the quadtree, a leaf covers at most 2^MaxLeafLevel x 2^MaxLeafLevel cells. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance", meta = (ClampMin = "0", ClampMax = "10"))
+	int32 MaxLeafLevel = 4;
+
+	/** Whether the leaves are simulated in parallel on the task graph or serially on the game thread. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance")
+	bool ParallelExecution = true;
+
+	/** Maximum number of tasks which simulate leaves in parallel, 0 uses all worker threads. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance", meta = (ClampMin = "0"))
+	int32 NumWorkers = 0;
+
+	/** Whether the vectorized kernel is used, the scalar kernel is used otherwise. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance")
+	bool UseVectorKernel = true;
+
+	/** Whether the daily radiation index is distributed over the hours of the day according to the sun position. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation")
+	bool DiurnalRadiation = false;
+
+	/** Returns the tolerances of the quadtree for the current properties. */
+	FCellQuadtreeTolerances GetQuadtreeTolerances() const;
+
+	virtual FString GetSimulationName() override final;
+
+	virtual void Simulate(ASnowSimulationActor* SimulationActor, int32 CurrentSimulationStep, int32 Timesteps, bool SaveSnowMap, bool CaptureDebugInformation, TArray<FDebugCell>& DebugCells) override final;
+
+	virtual void Initialize(ASnowSimulationActor* SimulationActor, const TArray<FLandscapeCell>& Cells, float InitialMaxSnow, UWorld* World) override final;
+
+	virtual void RenderDebug(UWorld* World, int CellDebugInfoDisplayDistance, EDebugVisualizationType DebugVisualizationType) override;
+
+	virtual UTexture* GetSnowMapTexture() override final;
+
+	virtual float GetMaxSnow() override final;
+};
@@ -0,0 +1,427 @@
+#include "Simulation.h"
+#include "DegreeDayCPUKernel.h"
+#include "Radiation/SolarRadiation.h"
+
+FString FDegreeDayKernelFeatures::ToString() const
+{
+	return FString::Printf(TEXT("Rain %d, Diurnal radiation %d, Vegetation %d, Interpolation %d, Quadratic melt %d"), Rain, DiurnalRadiation, Vegetation, Interpolation, QuadraticMelt);
+}
+
+/** Feature policy of the kernel variant with the given index, see FDegreeDayKernelFeatures::GetVariant. */
+template<int32 Variant>
+struct TDegreeDayFeatures
+{
+	static const bool Rain = (Variant & 1) != 0;
+	static const bool DiurnalRadiation = (Variant & 2) != 0;
+	static const bool Vegetation = (Variant & 4) != 0;
+	static const bool Interpolation = (Variant & 8) != 0;
+	static const bool QuadraticMelt = (Variant & 16) != 0;
+};
+
+/** Degree day kernels with the features of the given policy, the disabled features are compiled out. */
+template<typename Features>
+struct TDegreeDayKernel
+{
+	static FDegreeDayCellForcing GetCellForcing(const FDegreeDayForcing& Forcing, const FDegreeDayParameters& Parameters, float Altitude);
+
+	static float SimulateScalar(const FDegreeDayCellRange& Cells, const FDegreeDayParameters& Parameters, const FDegreeDayForcing& Forcing);
+
+	static float SimulateVector(const FDegreeDayCellRange& Cells, const FDegreeDayParameters& Parameters, const FDegreeDayForcing& Forcing);
+};
+
+/** The kernel with all features which is exact for any parameters and forcing. */
+typedef TDegreeDayKernel<TDegreeDayFeatures<FDegreeDayKernelFeatures::NumVariants - 1>> FDegreeDayGeneralKernel;
+
+template<typename Features>
+FDegreeDayCellForcing TDegreeDayKernel<Features>::GetCellForcing(const FDegreeDayForcing& Forcing, const FDegreeDayParameters& Parameters, float Altitude)
+{
+	const float TAir = FDegreeDayCPUKernel::GetAirTemperature(Forcing, Altitude); // degree Celsius
+
+	FDegreeDayCellForcing CellForcing;
+	CellForcing.Precipitation = FDegreeDayCPUKernel::GetPrecipitation(Forcing, Altitude); // l/m^2 or mm
+
+	if (Features::Rain && TAir > Parameters.TSnowB)
+	{
+		CellForcing.Snowfall = 0;
+		CellForcing.NewAlbedo = 0.4; // New rain drops the albedo to 0.4
+	}
+	else
+	{
+		// Variable lapse rate as described in "A variable lapse rate snowline model for the Remarkables, Central Otago, New Zealand"
+		float SnowRate = FMath::Clamp(1 - (TAir - Parameters.TSnowA) / (Parameters.TSnowB - Parameters.TSnowA), 0.0f, 1.0f);
+
+		CellForcing.Snowfall = CellForcing.Precipitation * SnowRate;
+		CellForcing.NewAlbedo = 0.8; // New snow sets the albedo to 0.8
+	}
+
+	// Quadratic melt factor below TMeltB, linear above
+	if (TAir > Parameters.TMeltA)
+	{
+		CellForcing.MeltFactor = Features::QuadraticMelt && TAir < Parameters.TMeltB ? (TAir - Parameters.TMeltA) * (TAir - Parameters.TMeltA) / (Parameters.TMeltB - Parameters.TMeltA) : (TAir - Parameters.TMeltA);
+	}
+	else
+	{
+		CellForcing.MeltFactor = 0;
+	}
+
+	return CellForcing;
+}
+
+template<typename Features>
+float TDegreeDayKernel<Features>::SimulateScalar(const FDegreeDayCellRange& Cells, const FDegreeDayParameters& Parameters, const FDegreeDayForcing& Forcing)
+{
+	const float k_v = Features::Vegetation ? FMath::Exp(-4 * Parameters.VegetationDensity) : 1.0f; // 1
+	const float DiurnalFactor = Features::DiurnalRadiation ? Forcing.DiurnalFactor : 1.0f;
+
+	float MaxSnow = 0;
+
+	for (int32 Index = 0; Index < Cells.Num; ++Index)
+	{
+		float& SnowWaterEquivalent = Cells.SnowWaterEquivalent[Index];
+		float& SnowAlbedo = Cells.SnowAlbedo[Index];
+		float& DaysSinceLastSnowfall = Cells.DaysSinceLastSnowfall[Index];
+
+		// Lapse rate adjusted forcing of the cell or its altitude band
+		const FDegreeDayCellForcing CellForcing = (Cells.AltitudeBand && Forcing.AltitudeBands) ?
+			Forcing.AltitudeBands[Cells.AltitudeBand[Index]] : GetCellForcing(Forcing, Parameters, Cells.Altitude[Index]);
+
+		// @TODO use AreaXY because very steep slopes with big areas would receive too much snow
+		const float AreaSquareMeters = Cells.AreaXY[Index] / (100 * 100); // m^2
+
+		// Apply precipitation
+		if (CellForcing.Precipitation > 0)
+		{
+			DaysSinceLastSnowfall = 0;
+
+			// New snow/rainfall, the canopy intercepts a part of the snow
+			SnowWaterEquivalent += CellForcing.Snowfall * (Cells.SnowfallArea ? Cells.SnowfallArea[Index] : AreaSquareMeters); // l/m^2 * m^2 = l
+			SnowAlbedo = CellForcing.NewAlbedo;
+		}
+
+		// Apply melt
+		if (SnowWaterEquivalent > 0)
+		{
+			if (DaysSinceLastSnowfall >= 0) {
+				// @TODO is time T the degree-days or the time since the last snowfall?
+				SnowAlbedo = 0.4 * (1 + FMath::Exp(-Parameters.k_e * DaysSinceLastSnowfall));
+			}
+
+			// Temperature higher than melt threshold and cell contains snow
+			if (CellForcing.MeltFactor > 0)
+			{
+				const float DayNormalization = 1.0f / 24.0f; // day
+
+				// @TODO radiation index at nighttime? How about newer simulations?
+				// @TODO Bloeschl (???) used different radiation values during night
+
+				// Radiation Index
+				const float R_i = DiurnalFactor * (Cells.RadiationIndex ? Cells.RadiationIndex[Index] :
+					FSolarRadiation::SolarRadiationIndex(Cells.Inclination[Index], Cells.Aspect[Index], Cells.Latitude[Index], Forcing.DayOfYear)); // 1
+
+				// Melt factor, k_m * k_v * DayNormalization * AreaSquareMeters can be precomputed for every cell
+				const float MeltCoefficient = Cells.MeltCoefficient ? Cells.MeltCoefficient[Index] : Parameters.k_m * k_v * DayNormalization * AreaSquareMeters; // l/m^2/C/day * day * m^2 = l/C
+				const float c_m = MeltCoefficient * R_i * (1 - SnowAlbedo); // l/C
+
+				const float M = c_m * CellForcing.MeltFactor; // l/C * C = l
+
+				// Apply melt
+				SnowWaterEquivalent -= M;
+				SnowWaterEquivalent = FMath::Max(0.0f, SnowWaterEquivalent);
+			}
+		}
+
+		DaysSinceLastSnowfall += Forcing.Hours / 24.0f;
+
+		// Interpolation according to Bloeschls "Distributed Snowmelt Simulations in an Alpine Catchment"
+		if (Features::Interpolation)
+		{
+			const float we = FMath::Max(0.0f, SnowWaterEquivalent * Cells.InterpolationFactor[Index]);
+			Cells.InterpolatedSnowWaterEquivalent[Index] = we;
+			MaxSnow = FMath::Max(MaxSnow, we * Cells.InverseAreaSquareMeters[Index]);
+		}
+	}
+
+	return MaxSnow;
+}
+
+template<typename Features>
+float TDegreeDayKernel<Features>::SimulateVector(const FDegreeDayCellRange& Cells, const FDegreeDayParameters& Parameters, const FDegreeDayForcing& Forcing)
+{
+	const int32 NumVectorized = Cells.Num & ~3;
+
+	const float k_v = Features::Vegetation ? FMath::Exp(-4 * Parameters.VegetationDensity) : 1.0f; // 1
+	const float DiurnalFactor = Features::DiurnalRadiation ? Forcing.DiurnalFactor : 1.0f;
+
+	const VectorRegister Zero = VectorZero();
+	const VectorRegister One = VectorOne();
+	const VectorRegister Temperature = VectorSetFloat1(Forcing.Temperature);
+	const VectorRegister Precipitation = VectorSetFloat1(Forcing.Precipitation);
+	const VectorRegister MeasurementAltitude = VectorSetFloat1(Forcing.MeasurementAltitude);
+	const VectorRegister TemperatureLapseRate = VectorSetFloat1(-0.5f / (100 * 100));
+	const VectorRegister PrecipitationLapseRate = VectorSetFloat1(Forcing.Precipitation > 0 ? 0.5f / (100 * 1000) : 0.0f);
+	const VectorRegister SquareCentimetersToSquareMeters = VectorSetFloat1(1.0f / (100 * 100));
+	const VectorRegister TSnowA = VectorSetFloat1(Parameters.TSnowA);
+	const VectorRegister TSnowB = VectorSetFloat1(Parameters.TSnowB);
+	const VectorRegister InvSnowRange = VectorSetFloat1(1.0f / (Parameters.TSnowB - Parameters.TSnowA));
+	const VectorRegister TMeltA = VectorSetFloat1(Parameters.TMeltA);
+	const VectorRegister TMeltB = VectorSetFloat1(Parameters.TMeltB);
+	const VectorRegister InvMeltRange = VectorSetFloat1(1.0f / (Parameters.TMeltB - Parameters.TMeltA));
+	const VectorRegister RainAlbedo = VectorSetFloat1(0.4f);
+	const VectorRegister NewSnowAlbedo = VectorSetFloat1(0.8f);
+	const VectorRegister HourInDays = VectorSetFloat1(Forcing.Hours / 24.0f);
+	const VectorRegister MeltScale = VectorSetFloat1(Cells.MeltCoefficient ? DiurnalFactor : Parameters.k_m * k_v * DiurnalFactor / 24.0f);
+
+	const bool UseAltitudeBands = Cells.AltitudeBand && Forcing.AltitudeBands;
+
+	VectorRegister MaxSnow = Zero;
+
+	float Lanes[4];
+
+	for (int32 Index = 0; Index < NumVectorized; Index += 4)
+	{
+		VectorRegister SnowWaterEquivalent = VectorLoad(Cells.SnowWaterEquivalent + Index);
+		VectorRegister SnowAlbedo = VectorLoad(Cells.SnowAlbedo + Index);
+		VectorRegister DaysSinceLastSnowfall = VectorLoad(Cells.DaysSinceLastSnowfall + Index);
+
+		VectorRegister CellPrecipitation;
+		VectorRegister Snowfall;
+		VectorRegister NewAlbedo;
+		VectorRegister MeltFactor;
+		VectorRegister MeltMask;
+
+		if (UseAltitudeBands)
+		{
+			// Gather the forcing of the altitude bands of the four cells and transpose it
+			const VectorRegister Band0 = VectorLoad(reinterpret_cast<const float*>(&Forcing.AltitudeBands[Cells.AltitudeBand[Index]]));
+			const VectorRegister Band1 = VectorLoad(reinterpret_cast<const float*>(&Forcing.AltitudeBands[Cells.AltitudeBand[Index + 1]]));
+			const VectorRegister Band2 = VectorLoad(reinterpret_cast<const float*>(&Forcing.AltitudeBands[Cells.AltitudeBand[Index + 2]]));
+			const VectorRegister Band3 = VectorLoad(reinterpret_cast<const float*>(&Forcing.AltitudeBands[Cells.AltitudeBand[Index + 3]]));
+
+			const VectorRegister Low01 = VectorShuffle(Band0, Band1, 0, 1, 0, 1);
+			const VectorRegister Low23 = VectorShuffle(Band2, Band3, 0, 1, 0, 1);
+			const VectorRegister High01 = VectorShuffle(Band0, Band1, 2, 3, 2, 3);
+			const VectorRegister High23 = VectorShuffle(Band2, Band3, 2, 3, 2, 3);
+
+			CellPrecipitation = VectorShuffle(Low01, Low23, 0, 2, 0, 2);
+			Snowfall = VectorShuffle(Low01, Low23, 1, 3, 1, 3);
+			NewAlbedo = VectorShuffle(High01, High23, 0, 2, 0, 2);
+			MeltFactor = VectorShuffle(High01, High23, 1, 3, 1, 3);
+			MeltMask = VectorCompareGT(MeltFactor, Zero);
+		}
+		else
+		{
+			const VectorRegister Altitude = VectorSubtract(VectorLoad(Cells.Altitude + Index), MeasurementAltitude);
+			const VectorRegister TAir = VectorMultiplyAdd(Altitude, TemperatureLapseRate, Temperature);
+			const VectorRegister SnowRate = VectorMin(VectorMax(VectorSubtract(One, VectorMultiply(VectorSubtract(TAir, TSnowA), InvSnowRange)), Zero), One);
+
+			CellPrecipitation = VectorMultiplyAdd(Altitude, PrecipitationLapseRate, Precipitation);
+			Snowfall = VectorMultiply(CellPrecipitation, SnowRate);
+			NewAlbedo = NewSnowAlbedo;
+
+			if (Features::Rain)
+			{
+				const VectorRegister RainMask = VectorCompareGT(TAir, TSnowB);
+				Snowfall = VectorSelect(RainMask, Zero, Snowfall);
+				NewAlbedo = VectorSelect(RainMask, RainAlbedo, NewSnowAlbedo);
+			}
+
+			// Quadratic melt factor below TMeltB, linear above
+			MeltFactor = VectorSubtract(TAir, TMeltA);
+
+			if (Features::QuadraticMelt)
+			{
+				MeltFactor = VectorSelect(VectorCompareGT(TMeltB, TAir), VectorMultiply(VectorMultiply(MeltFactor, MeltFactor), InvMeltRange), MeltFactor);
+			}
+
+			MeltMask = VectorCompareGT(TAir, TMeltA);
+		}
+
+		// The melt coefficient and the area below the canopy are either precomputed or follow from the area
+		VectorRegister SnowfallArea;
+		VectorRegister MeltCoefficient;
+		if (Cells.MeltCoefficient)
+		{
+			SnowfallArea = VectorLoad(Cells.SnowfallArea + Index);
+			MeltCoefficient = VectorLoad(Cells.MeltCoefficient + Index);
+		}
+		else
+		{
+			SnowfallArea = VectorMultiply(VectorLoad(Cells.AreaXY + Index), SquareCentimetersToSquareMeters);
+			MeltCoefficient = SnowfallArea;
+		}
+
+		// Apply precipitation
+		const VectorRegister PrecipitationMask = VectorCompareGT(CellPrecipitation, Zero);
+
+		SnowWaterEquivalent = VectorAdd(SnowWaterEquivalent, VectorSelect(PrecipitationMask, VectorMultiply(Snowfall, SnowfallArea), Zero));
+		SnowAlbedo = VectorSelect(PrecipitationMask, NewAlbedo, SnowAlbedo);
+		DaysSinceLastSnowfall = VectorSelect(PrecipitationMask, Zero, DaysSinceLastSnowfall);
+
+		// Apply melt
+		const VectorRegister SnowMask = VectorCompareGT(SnowWaterEquivalent, Zero);
+		const int32 SnowBits = VectorMaskBits(SnowMask);
+
+		if (SnowBits)
+		{
+			// Albedo decay, exp is evaluated per lane
+			const int32 AgingBits = VectorMaskBits(VectorBitwiseAnd(SnowMask, VectorCompareGE(DaysSinceLastSnowfall, Zero)));
+
+			float Days[4];
+			VectorStore(DaysSinceLastSnowfall, Days);
+			VectorStore(SnowAlbedo, Lanes);
+			for (int32 Lane = 0; Lane < 4; ++Lane)
+			{
+				if (AgingBits & (1 << Lane))
+				{
+					Lanes[Lane] = 0.4 * (1 + FMath::Exp(-Parameters.k_e * Days[Lane]));
+				}
+			}
+			SnowAlbedo = VectorLoad(Lanes);
+
+			// Temperature higher than melt threshold and cell contains snow
+			MeltMask = VectorBitwiseAnd(SnowMask, MeltMask);
+			const int32 MeltBits = VectorMaskBits(MeltMask);
+
+			if (MeltBits)
+			{
+				// Radiation index of the melting lanes
+				VectorRegister R_i;
+				if (Cells.RadiationIndex)
+				{
+					R_i = VectorLoad(Cells.RadiationIndex + Index);
+				}
+				else
+				{
+					for (int32 Lane = 0; Lane < 4; ++Lane)
+					{
+						const int32 CellIndex = Index + Lane;
+						Lanes[Lane] = (MeltBits & (1 << Lane)) ?
+							FSolarRadiation::SolarRadiationIndex(Cells.Inclination[CellIndex], Cells.Aspect[CellIndex], Cells.Latitude[CellIndex], Forcing.DayOfYear) : 0;
+					}
+					R_i = VectorLoad(Lanes);
+				}
+
+				const VectorRegister c_m = VectorMultiply(VectorMultiply(VectorMultiply(MeltScale, R_i), VectorSubtract(One, SnowAlbedo)), MeltCoefficient);
+				const VectorRegister Melt = VectorSelect(MeltMask, VectorMultiply(c_m, MeltFactor), Zero);
+
+				SnowWaterEquivalent = VectorMax(Zero, VectorSubtract(SnowWaterEquivalent, Melt));
+			}
+		}
+
+		DaysSinceLastSnowfall = VectorAdd(DaysSinceLastSnowfall, HourInDays);
+
+		VectorStore(SnowWaterEquivalent, Cells.SnowWaterEquivalent + Index);
+		VectorStore(SnowAlbedo, Cells.SnowAlbedo + Index);
+		VectorStore(DaysSinceLastSnowfall, Cells.DaysSinceLastSnowfall + Index);
+
+		// Interpolation according to Bloeschls "Distributed Snowmelt Simulations in an Alpine Catchment"
+		if (Features::Interpolation)
+		{
+			const VectorRegister InterpolatedSnowWaterEquivalent = VectorMax(Zero, VectorMultiply(SnowWaterEquivalent, VectorLoad(Cells.InterpolationFactor + Index)));
+			VectorStore(InterpolatedSnowWaterEquivalent, Cells.InterpolatedSnowWaterEquivalent + Index);
+			MaxSnow = VectorMax(MaxSnow, VectorMultiply(InterpolatedSnowWaterEquivalent, VectorLoad(Cells.InverseAreaSquareMeters + Index)));
+		}
+	}
+
+	VectorStore(MaxSnow, Lanes);
+	float RangeMaxSnow = FMath::Max(FMath::Max(Lanes[0], Lanes[1]), FMath::Max(Lanes[2], Lanes[3]));
+
+	// Remaining cells which do not fill a vector
+	if (NumVectorized < Cells.Num)
+	{
+		RangeMaxSnow = FMath::Max(RangeMaxSnow, SimulateScalar(Cells.Slice(NumVectorized), Parameters, Forcing));
+	}
+
+	return RangeMaxSnow;
+}
+
+/** Fills the kernel tables with the variants up to the given index. */
+template<int32 Variant>
+struct TDegreeDayKernelTable
+{
+	static void Fill(FDegreeDayKernelFunction* ScalarKernels, FDegreeDayKernelFunction* VectorKernels)
+	{
+		ScalarKernels[Variant] = &TDegreeDayKernel<TDegreeDayFeatures<Variant>>::SimulateScalar;
+		VectorKernels[Variant] = &TDegreeDayKernel<TDegreeDayFeatures<Variant>>::SimulateVector;
+		TDegreeDayKernelTable<Variant - 1>::Fill(ScalarKernels, VectorKernels);
+	}
+};
+
+template<>
+struct TDegreeDayKernelTable<-1>
+{
+	static void Fill(FDegreeDayKernelFunction* ScalarKernels, FDegreeDayKernelFunction* VectorKernels)
+	{
+	}
+};
+
+/** The scalar and vector kernels of all variants. */
+struct FDegreeDayKernelTable
+{
+	FDegreeDayKernelFunction ScalarKernels[FDegreeDayKernelFeatures::NumVariants];
+	FDegreeDayKernelFunction VectorKernels[FDegreeDayKernelFeatures::NumVariants];
+
+	FDegreeDayKernelTable()
+	{
+		TDegreeDayKernelTable<FDegreeDayKernelFeatures::NumVariants - 1>::Fill(ScalarKernels, VectorKernels);
+	}
+
+	static const FDegreeDayKernelTable& Get()
+	{
+		static const FDegreeDayKernelTable Table;
+		return Table;
+	}
+};
+
+FDegreeDayCellForcing FDegreeDayCPUKernel::GetCellForcing(const FDegreeDayForcing& Forcing, const FDegreeDayParameters& Parameters, float Altitude)
+{
+	return FDegreeDayGeneralKernel::GetCellForcing(Forcing, Parameters, Altitude);
+}
+
+FDegreeDayKernelFeatures FDegreeDayCPUKernel::GetFeatures(const FDegreeDayCellRange& Cells, const FDegreeDayParameters& Parameters, const FDegreeDayForcing& Forcing)
+{
+	FDegreeDayKernelFeatures Features;
+	// Only the cells above the lowest wet altitude receive precipitation, the warmest of them lie at that altitude
+	Features.Rain = GetAirTemperature(Forcing, GetMinPrecipitationAltitude(Forcing)) + 1e-3f > Parameters.TSnowB;
+	Features.DiurnalRadiation = Forcing.DiurnalFactor != 1.0f;
+	Features.Vegetation = Parameters.VegetationDensity != 0 && !Cells.MeltCoefficient;
+	Features.Interpolation = Cells.Interpolate;
+	Features.QuadraticMelt = Parameters.TMeltB > Parameters.TMeltA;
+	return Features;
+}
+
+void FDegreeDayCPUKernel::UpdateMeltCoefficients(FSimulationCellStore& Cells, const FDegreeDayParameters& Parameters)
+{
+	Cells.MeltCoefficient.SetNumUninitialized(Cells.Num());
+	Cells.SnowfallArea.SetNumUninitialized(Cells.Num());
+
+	for (int32 Index = 0; Index < Cells.Num(); ++Index)
+	{
+		const float VegetationDensity = Cells.VegetationDensity[Index] >= 0 ? Cells.VegetationDensity[Index] : Parameters.VegetationDensity;
+		const float k_v = FMath::Exp(-4 * VegetationDensity); // 1
+		const float AreaSquareMeters = Cells.AreaXY[Index] / (100 * 100); // m^2
+
+		Cells.MeltCoefficient[Index] = Parameters.k_m * k_v / 24.0f * AreaSquareMeters; // l/m^2/C/day * day * m^2 = l/C
+		Cells.SnowfallArea[Index] = (1 - Parameters.CanopyInterception * VegetationDensity) * AreaSquareMeters; // m^2
+	}
+}
+
+FDegreeDayKernelFunction FDegreeDayCPUKernel::GetScalarKernel(const FDegreeDayKernelFeatures& Features)
+{
+	return FDegreeDayKernelTable::Get().ScalarKernels[Features.GetVariant()];
+}
+
+FDegreeDayKernelFunction FDegreeDayCPUKernel::GetVectorKernel(const FDegreeDayKernelFeatures& Features)
+{
+	return FDegreeDayKernelTable::Get().VectorKernels[Features.GetVariant()];
+}
+
+float FDegreeDayCPUKernel::SimulateScalar(const FDegreeDayCellRange& Cells, const FDegreeDayParameters& Parameters, const FDegreeDayForcing& Forcing)
+{
+	return GetScalarKernel(GetFeatures(Cells, Parameters, Forcing))(Cells, Parameters, Forcing);
+}
+
+float FDegreeDayCPUKernel::SimulateVector(const FDegreeDayCellRange& Cells, const FDegreeDayParameters& Parameters, const FDegreeDayForcing& Forcing)
+{
+	return GetVectorKernel(GetFeatures(Cells, Parameters, Forcing))(Cells, Parameters, Forcing);
+}
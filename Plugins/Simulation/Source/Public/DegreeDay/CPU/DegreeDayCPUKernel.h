@@ -0,0 +1,260 @@
+#pragma once
+
+#include "DegreeDay/DegreeDaySimulation.h"
+#include "Cells/SimulationCellStore.h"
+
+/**
+* Pointers to the arrays of a contiguous range of cells. The first element of every array belongs to the first cell of
+* the range.
+*/
+struct FDegreeDayCellRange
+{
+	/** Number of cells in the range. */
+	int32 Num;
+
+	float* SnowWaterEquivalent;
+	float* SnowAlbedo;
+	float* DaysSinceLastSnowfall;
+
+	const float* AreaXY;
+	const float* Altitude;
+	const float* Inclination;
+	const float* Aspect;
+	const float* Latitude;
+
+	/** Precomputed radiation index of the current day or null if the radiation index is computed by the kernel. */
+	const float* RadiationIndex;
+
+	/** Altitude band of the cells or null if the forcing is computed for every cell. */
+	const uint16* AltitudeBand;
+
+	/** Precomputed melt coefficient of the cells or null if the kernel computes it from the parameters, see FSimulationCellStore::MeltCoefficient. */
+	const float* MeltCoefficient;
+
+	/** Area in m^2 of the cells which receives snowfall below the canopy, null together with MeltCoefficient. */
+	const float* SnowfallArea;
+
+	float* InterpolatedSnowWaterEquivalent;
+	const float* InterpolationFactor;
+	const float* InverseAreaSquareMeters;
+
+	/** Whether the kernel interpolates the snow of the cells after the hour. */
+	bool Interpolate = false;
+
+	/**
+	* Creates the range [BeginIndex, EndIndex) of the given cells.
+	*
+	* @param DayRadiationIndex	Precomputed radiation index of all cells for the current day or null
+	* @param CellAltitudeBand	Altitude band of all cells or null
+	*/
+	FDegreeDayCellRange(FSimulationCellStore& Cells, int32 BeginIndex, int32 EndIndex, const float* DayRadiationIndex = nullptr, const uint16* CellAltitudeBand = nullptr) :
+		Num(EndIndex - BeginIndex),
+		SnowWaterEquivalent(Cells.SnowWaterEquivalent.GetData() + BeginIndex),
+		SnowAlbedo(Cells.SnowAlbedo.GetData() + BeginIndex),
+		DaysSinceLastSnowfall(Cells.DaysSinceLastSnowfall.GetData() + BeginIndex),
+		AreaXY(Cells.AreaXY.GetData() + BeginIndex),
+		Altitude(Cells.Altitude.GetData() + BeginIndex),
+		Inclination(Cells.Inclination.GetData() + BeginIndex),
+		Aspect(Cells.Aspect.GetData() + BeginIndex),
+		Latitude(Cells.Latitude.GetData() + BeginIndex),
+		RadiationIndex(DayRadiationIndex ? DayRadiationIndex + BeginIndex : nullptr),
+		AltitudeBand(CellAltitudeBand ? CellAltitudeBand + BeginIndex : nullptr),
+		MeltCoefficient(Cells.MeltCoefficient.Num() > 0 ? Cells.MeltCoefficient.GetData() + BeginIndex : nullptr),
+		SnowfallArea(Cells.SnowfallArea.Num() > 0 ? Cells.SnowfallArea.GetData() + BeginIndex : nullptr),
+		InterpolatedSnowWaterEquivalent(Cells.InterpolatedSnowWaterEquivalent.GetData() + BeginIndex),
+		InterpolationFactor(Cells.InterpolationFactor.GetData() + BeginIndex),
+		InverseAreaSquareMeters(Cells.InverseAreaSquareMeters.GetData() + BeginIndex)
+	{
+	}
+
+	/** Returns the cells of this range starting at the given offset. */
+	FDegreeDayCellRange Slice(int32 Offset) const
+	{
+		FDegreeDayCellRange Range = *this;
+		Range.Num -= Offset;
+		Range.SnowWaterEquivalent += Offset;
+		Range.SnowAlbedo += Offset;
+		Range.DaysSinceLastSnowfall += Offset;
+		Range.AreaXY += Offset;
+		Range.Altitude += Offset;
+		Range.Inclination += Offset;
+		Range.Aspect += Offset;
+		Range.Latitude += Offset;
+		if (Range.RadiationIndex) Range.RadiationIndex += Offset;
+		if (Range.AltitudeBand) Range.AltitudeBand += Offset;
+		if (Range.MeltCoefficient) Range.MeltCoefficient += Offset;
+		if (Range.SnowfallArea) Range.SnowfallArea += Offset;
+		Range.InterpolatedSnowWaterEquivalent += Offset;
+		Range.InterpolationFactor += Offset;
+		Range.InverseAreaSquareMeters += Offset;
+		return Range;
+	}
+};
+
+/** Lapse rate adjusted forcing at the altitude of a cell. */
+struct FDegreeDayCellForcing
+{
+	/** Precipitation in l/m^2 or mm. */
+	float Precipitation;
+
+	/** The part of the precipitation which falls as snow in l/m^2 or mm. */
+	float Snowfall;
+
+	/** The albedo after precipitation. */
+	float NewAlbedo;
+
+	/** Factor of the melt in degree Celsius, zero if the air temperature is below TMeltA. */
+	float MeltFactor;
+};
+
+/** Climate forcing of a simulation hour or of several hours. */
+struct FDegreeDayForcing
+{
+	/** Air temperature at the measurement altitude in degree Celsius. */
+	float Temperature;
+
+	/** Precipitation at the measurement altitude in l/m^2 or mm. */
+	float Precipitation;
+
+	/** Altitude of the measurement in cm. */
+	float MeasurementAltitude;
+
+	/** Day of the year of the hour. */
+	int32 DayOfYear;
+
+	/** Factor of the radiation index for the hour of the day. */
+	float DiurnalFactor = 1.0f;
+
+	/** Forcing of every altitude band or null if the forcing is computed for every cell. */
+	const FDegreeDayCellForcing* AltitudeBands = nullptr;
+
+	/**
+	* Number of hours the forcing covers. Forcing of several hours is only given by altitude bands which hold the sums of
+	* the hours, see FAltitudeBandForcing::AccumulateForcing.
+	*/
+	float Hours = 1.0f;
+};
+
+/**
+* Features of the degree day kernels which are fixed for a whole run. Every combination is compiled into its own kernel
+* variant, so the checks of disabled features do not remain in the inner loop.
+*/
+struct FDegreeDayKernelFeatures
+{
+	/** Whether precipitation can fall as rain, false if no cell is warmer than TSnowB in any hour with precipitation. */
+	bool Rain = true;
+
+	/** Whether the radiation index is scaled by the diurnal factor of the forcing. */
+	bool DiurnalRadiation = true;
+
+	/** Whether the vegetation density of the parameters reduces the melt, false if it is zero or the cells have a precomputed melt coefficient. */
+	bool Vegetation = true;
+
+	/** Whether the kernel interpolates the snow of the cells after the hour. */
+	bool Interpolation = true;
+
+	/** Whether the melt factor is quadratic between TMeltA and TMeltB, false if TMeltB is not above TMeltA. */
+	bool QuadraticMelt = true;
+
+	/** Number of kernel variants. */
+	static const int32 NumVariants = 32;
+
+	/** Returns the index of the kernel variant with these features. */
+	int32 GetVariant() const
+	{
+		return (Rain ? 1 : 0) | (DiurnalRadiation ? 2 : 0) | (Vegetation ? 4 : 0) | (Interpolation ? 8 : 0) | (QuadraticMelt ? 16 : 0);
+	}
+
+	/** Returns the features of the kernel variant with the given index. */
+	static FDegreeDayKernelFeatures FromVariant(int32 Variant)
+	{
+		FDegreeDayKernelFeatures Features;
+		Features.Rain = (Variant & 1) != 0;
+		Features.DiurnalRadiation = (Variant & 2) != 0;
+		Features.Vegetation = (Variant & 4) != 0;
+		Features.Interpolation = (Variant & 8) != 0;
+		Features.QuadraticMelt = (Variant & 16) != 0;
+		return Features;
+	}
+
+	bool operator==(const FDegreeDayKernelFeatures& Other) const
+	{
+		return GetVariant() == Other.GetVariant();
+	}
+
+	bool operator!=(const FDegreeDayKernelFeatures& Other) const
+	{
+		return GetVariant() != Other.GetVariant();
+	}
+
+	FString ToString() const;
+};
+
+/** Advances a range of cells by one hour, see FDegreeDayCPUKernel. */
+typedef float (*FDegreeDayKernelFunction)(const FDegreeDayCellRange& Cells, const FDegreeDayParameters& Parameters, const FDegreeDayForcing& Forcing);
+
+/**
+* Degree day kernels which advance a range of cells by one hour.
+*
+* The vector kernel processes four cells per instruction and turns the precipitation and melt branches into masks.
+* Divisions are replaced by multiplications with reciprocals, so its results agree with the scalar kernel within a
+* relative error of 1e-5 of the snow water equivalent per hour. Cells with an air temperature which lies within rounding
+* of one of the thresholds can take the other branch and deviate further.
+*
+* If the range interpolates, the kernels also store the snow water equivalent after interpolation in the same pass and
+* return the maximum snow amount (mm) of the range, they return zero otherwise.
+*
+* SimulateScalar and SimulateVector select the variant for their arguments on every call. Simulations should select
+* the variant once with GetScalarKernel or GetVectorKernel and call it directly. A variant with a disabled feature
+* gives the same results as the general kernel as long as the condition of the feature in FDegreeDayKernelFeatures
+* holds, Interpolation overrides the Interpolate flag of the range.
+*/
+class SIMULATION_API FDegreeDayCPUKernel
+{
+public:
+	/** Simulates one hour for the given cells using scalar code. */
+	static float SimulateScalar(const FDegreeDayCellRange& Cells, const FDegreeDayParameters& Parameters, const FDegreeDayForcing& Forcing);
+
+	/** Simulates one hour for the given cells using vector instructions. */
+	static float SimulateVector(const FDegreeDayCellRange& Cells, const FDegreeDayParameters& Parameters, const FDegreeDayForcing& Forcing);
+
+	/** Returns the scalar kernel variant with the given features. */
+	static FDegreeDayKernelFunction GetScalarKernel(const FDegreeDayKernelFeatures& Features);
+
+	/** Returns the vector kernel variant with the given features. */
+	static FDegreeDayKernelFunction GetVectorKernel(const FDegreeDayKernelFeatures& Features);
+
+	/**
+	* Computes the melt coefficient and the area below the canopy of the given cells for the given parameters, see
+	* FSimulationCellStore::MeltCoefficient. Cells without vegetation data use the vegetation density of the parameters.
+	*/
+	static void UpdateMeltCoefficients(FSimulationCellStore& Cells, const FDegreeDayParameters& Parameters);
+
+	/** Returns the features which are needed to simulate the given cells, parameters and forcing. */
+	static FDegreeDayKernelFeatures GetFeatures(const FDegreeDayCellRange& Cells, const FDegreeDayParameters& Parameters, const FDegreeDayForcing& Forcing);
+
+	/** Returns the air temperature in degree Celsius at the given altitude in cm. */
+	static float GetAirTemperature(const FDegreeDayForcing& Forcing, float Altitude)
+	{
+		return Forcing.Temperature - 0.5f * (Altitude - Forcing.MeasurementAltitude) / (100 * 100);
+	}
+
+	/** Returns the precipitation in l/m^2 or mm at the given altitude in cm. The lapse is only applied in wet hours. */
+	static float GetPrecipitation(const FDegreeDayForcing& Forcing, float Altitude)
+	{
+		return Forcing.Precipitation > 0 ? Forcing.Precipitation + 0.5f * (Altitude - Forcing.MeasurementAltitude) / (100 * 1000) : 0.0f;
+	}
+
+	/** Returns the lapse rate adjusted forcing at the given altitude in cm. */
+	static FDegreeDayCellForcing GetCellForcing(const FDegreeDayForcing& Forcing, const FDegreeDayParameters& Parameters, float Altitude);
+
+	/**
+	* Returns an altitude in cm below which no cell receives precipitation in the hour of the given forcing. Cells below
+	* this altitude without snow are not changed by the kernels except for their days since the last snowfall.
+	*/
+	static float GetMinPrecipitationAltitude(const FDegreeDayForcing& Forcing)
+	{
+		// Precipitation + 0.5 * (Altitude - MeasurementAltitude) / (100 * 1000) > 0, lowered by a margin for rounding
+		return Forcing.Precipitation > 0 ? Forcing.MeasurementAltitude - Forcing.Precipitation * 2 * (100 * 1000) - 100 : MAX_FLT;
+	}
+};
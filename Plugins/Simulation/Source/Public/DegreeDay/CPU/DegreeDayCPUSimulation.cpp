@@ -8,6 +8,7 @@
 #include "Util/TextureUtil.h"
 #include "Util/MathUtil.h"
 #include "LandscapeComponent.h"
+#include "ParallelFor.h"
 
 
 // @TODO Use Fearings stability method for small scale snow?
@@ -19,133 +20,591 @@ FString UDegreeDayCPUSimulation::GetSimulationName()
 	return FString(TEXT("Degree Day CPU"));
 }
 
+DECLARE_CYCLE_STAT(TEXT("Degree Day CPU Simulate"), STAT_DegreeDayCPUSimulate, STATGROUP_SnowSimulation);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Degree Day CPU Active Cells"), STAT_DegreeDayCPUActiveCells, STATGROUP_SnowSimulation);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Degree Day CPU Separately Interpolated Cells"), STAT_DegreeDayCPUSeparatelyInterpolatedCells, STATGROUP_SnowSimulation);
+
 // Flops per iteration: (2 * 20 + 6 * 2) + (20 * 20 + 38 * 2)
 void UDegreeDayCPUSimulation::Simulate(ASnowSimulationActor* SimulationActor, int32 CurrentSimulationStep, int32 Timesteps, bool SaveSnowMap, bool CaptureDebugInformation, TArray<FDebugCell>& DebugCells)
 {
-	MaxSnow = 0;
+	SCOPE_CYCLE_COUNTER(STAT_DegreeDayCPUSimulate);
+
+	const double StartSeconds = FPlatformTime::Seconds();
+
+	const int32 NumCells = Cells.Num();
+	const int32 NumHours = FMath::Clamp(ClimateData.Num() - CurrentSimulationStep, 0, Timesteps);
+	const FDegreeDayParameters Parameters = GetParameters();
+	const float MeasurementAltitude = SimulationActor->ClimateDataComponent->GetMeasurementAltitude();
+	const bool FactoredRadiationInitialized = FactoredRadiationIndex.Num() == NumCells;
+
+	// The interpolation factors of the cells depend on the parameters
+	if (!(InterpolationFactorParameters == Interpolation))
+	{
+		UpdateInterpolationFactors();
+	}
+
+	// The melt coefficients of the cells depend on the parameters
+	if (MeltCoefficientParameters.k_m != Parameters.k_m || MeltCoefficientParameters.VegetationDensity != Parameters.VegetationDensity
+		|| MeltCoefficientParameters.CanopyInterception != Parameters.CanopyInterception)
+	{
+		UpdateMeltCoefficients(Parameters);
+	}
+
+	// The event index depends on the parameters
+	if (!UseEventIndex)
+	{
+		EventIndex.Reset();
+	}
+	else if (!EventIndex.IsBuiltFor(Parameters, EventIndexBandWidth * 100))
+	{
+		BuildEventIndex(MeasurementAltitude);
+	}
+
+	// The altitude bands depend on the band width
+	if (!UseAltitudeBands)
+	{
+		AltitudeBands.Reset();
+	}
+	else if (!AltitudeBands.IsInitialized(Cells, AltitudeBandWidth * 100))
+	{
+		AltitudeBands.Initialize(Cells, AltitudeBandWidth * 100);
+	}
+
+	const int32 NumBands = AltitudeBands.GetNumBands();
+	const uint16* CellBands = NumBands > 0 ? AltitudeBands.GetCellBands() : nullptr;
+
+	// Cells close to the lowest altitude with precipitation receive the forcing of their band
+	const float PrecipitationAltitudeMargin = NumBands > 0 ? AltitudeBands.GetBandWidth() : 0;
+
+	// Forcing of all hours of this step
+	HourForcing.Reset();
+	HourBandForcing.SetNumUninitialized(NumHours * NumBands);
+	HourRadiationIndex.Reset();
+	HourFactoredRadiationDay.Reset();
+
+	// The days keep their constants between the time steps, so a day is only computed again when its slot changes
+	int32 NumFactoredRadiationDays = 0;
 
-	auto ClimateDataArray = SimulationActor->ClimateDataComponent->CreateRawClimateDataResourceArray(SimulationActor->StartTime, SimulationActor->EndTime);
-	
-	// Simulation
-	for (auto& Cell : Cells)
+	for (int32 Hour = 0; Hour < NumHours; ++Hour)
+	{
+		const FClimateData& HourClimateData = ClimateData.Get(CurrentSimulationStep + Hour);
+		const FDateTime Time = SimulationActor->CurrentSimulationTime + FTimespan(Hour, 0, 0);
+
+		FDegreeDayForcing Forcing;
+		Forcing.Temperature = HourClimateData.Temperature;
+		Forcing.Precipitation = HourClimateData.Precipitation;
+		Forcing.MeasurementAltitude = MeasurementAltitude;
+		Forcing.DayOfYear = Time.GetDayOfYear();
+		Forcing.DiurnalFactor = RadiationTable.GetDiurnalFactor(Forcing.DayOfYear, Time.GetHour());
+
+		if (NumBands > 0)
+		{
+			AltitudeBands.ComputeForcing(Forcing, Parameters, HourBandForcing.GetData() + Hour * NumBands);
+			Forcing.AltitudeBands = HourBandForcing.GetData() + Hour * NumBands;
+		}
+
+		HourForcing.Add(Forcing);
+
+		if (FactoredRadiationInitialized)
+		{
+			// The factored radiation index is evaluated by the tiles once per day
+			if (NumFactoredRadiationDays == 0 || FactoredRadiationDays[NumFactoredRadiationDays - 1].DayOfYear != Forcing.DayOfYear)
+			{
+				if (NumFactoredRadiationDays == FactoredRadiationDays.Num())
+				{
+					FactoredRadiationDays.AddDefaulted();
+				}
+
+				FFactoredSolarRadiation::FDay& Day = FactoredRadiationDays[NumFactoredRadiationDays++];
+				if (Day.DayOfYear != Forcing.DayOfYear)
+				{
+					FactoredRadiation.ComputeDay(Forcing.DayOfYear, Day);
+				}
+			}
+			HourFactoredRadiationDay.Add(NumFactoredRadiationDays - 1);
+			HourRadiationIndex.Add(FactoredRadiationIndex.GetData());
+		}
+		else
+		{
+			HourRadiationIndex.Add(RadiationTable.IsBuilt() ? RadiationTable.GetDay(Forcing.DayOfYear) : nullptr);
+		}
+	}
+
+	// The kernel variants are selected during initialization and only change if the properties are edited
+	const FDegreeDayKernelFeatures Features = GetKernelFeatures(Parameters);
+	if (Features != KernelFeatures || VectorKernelSelected != UseVectorKernel)
+	{
+		SelectKernels(Features);
+	}
+
+	// Split the grid into tiles of rows
+	const int32 RowsPerTile = FMath::Max(1, TileRows);
+	const int32 CellsPerTile = RowsPerTile * CellsDimensionX;
+	const int32 NumTiles = FMath::DivideAndRoundUp(CellsDimensionY, RowsPerTile);
+	TileMaxSnow.SetNumZeroed(NumTiles);
+
+	if (TileRadiationDay.Num() != NumTiles)
+	{
+		TileRadiationDay.Init(0, NumTiles);
+	}
+
+	// The active cells are collected from the current snow if the tiles change
+	if (!UseActiveCells)
+	{
+		ActiveCells.Reset();
+	}
+	else if (!ActiveCells.IsInitialized(Cells, CellsPerTile))
 	{
-		const FVector& CellCentroid = Cell.Centroid;
+		ActiveCells.Initialize(Cells, CellsPerTile);
+	}
+	TileSimulatedCells.Init(0, NumTiles);
+	TileInterpolatedCells.Init(0, NumTiles);
 
-		
-		auto ClimateData = (*ClimateDataArray)[CurrentSimulationStep];
-			
-		float Altitude = CellCentroid.Z - SimulationActor->ClimateDataComponent->GetMeasurementAltitude(); // Altitude in cm
-		
-		float TemperatureLapse = -0.5f * Altitude / (100 * 100);
-		float PrecipitationLapse = 0.5f * Altitude / (100 * 1000);
+	// Split the hours into blocks, every tile is advanced through all hours of a block before the next tile is processed
+	const int32 HoursPerBlock = TimeBlockHours > 0 ? TimeBlockHours : FMath::Max(1, NumHours);
+	const int32 NumBlocks = FMath::DivideAndRoundUp(NumHours, HoursPerBlock);
 
-		const float TAir = ClimateData.Temperature + TemperatureLapse; // degree Celsius
+	auto SimulateTile = [&](int32 Tile, int32 Block)
+	{
+		const int32 BeginIndex = Tile * CellsPerTile;
+		const int32 EndIndex = FMath::Min(BeginIndex + CellsPerTile, NumCells);
+		const int32 BeginHour = Block * HoursPerBlock;
+		const int32 EndHour = FMath::Min(BeginHour + HoursPerBlock, NumHours);
 
-		const float Precipitation = ClimateData.Precipitation + PrecipitationLapse; // l/m^2 or mm
-			
-		// @TODO use AreaXY because very steep slopes with big areas would receive too much snow
-		const float AreaSquareMeters = Cell.AreaXY / (100 * 100); // m^2
+		// The kernel interpolates the snow during the last hour, unless the last hour is part of a cold range
+		bool Interpolated = false;
+		float InterpolatedMaxSnow = 0;
 
-		// Apply precipitation
-		if (Precipitation > 0)
+		for (int32 Hour = BeginHour; Hour < EndHour; ++Hour)
 		{
-			Cell.DaysSinceLastSnowfall = 0;
+			const bool InterpolateHour = Hour == NumHours - 1;
+
+			// Hours in which no snow melts are simulated at once
+			const int32 ColdRangeEnd = UseEventIndex ? FMath::Min(EventIndex.GetColdRangeEnd(CurrentSimulationStep + Hour) - CurrentSimulationStep, EndHour) : Hour;
 
-			// New snow/rainfall
-			const bool Rain = TAir > TSnowB;
+			if (ColdRangeEnd - Hour > 1)
+			{
+				if (UseActiveCells)
+				{
+					float MinPrecipitationAltitude = MAX_FLT;
+					for (int32 RangeHour = Hour; RangeHour < ColdRangeEnd; ++RangeHour)
+					{
+						MinPrecipitationAltitude = FMath::Min(MinPrecipitationAltitude, FDegreeDayCPUKernel::GetMinPrecipitationAltitude(HourForcing[RangeHour]));
+					}
+
+					TileSimulatedCells[Tile] += ActiveCells.BeginHour(Tile, MinPrecipitationAltitude);
+
+					ActiveCells.ForEachRange(Tile, [&](int32 RangeBeginIndex, int32 RangeEndIndex)
+					{
+						EventIndex.SimulateRange(FDegreeDayCellRange(Cells, RangeBeginIndex, RangeEndIndex), Parameters, CurrentSimulationStep + Hour, CurrentSimulationStep + ColdRangeEnd);
+					});
+
+					ActiveCells.EndHour(Tile, Cells);
+				}
+				else
+				{
+					TileSimulatedCells[Tile] += EndIndex - BeginIndex;
+					EventIndex.SimulateRange(FDegreeDayCellRange(Cells, BeginIndex, EndIndex), Parameters, CurrentSimulationStep + Hour, CurrentSimulationStep + ColdRangeEnd);
+				}
+
+				Hour = ColdRangeEnd - 1;
+				continue;
+			}
 
-			if (TAir > TSnowB)
+			if (FactoredRadiationInitialized)
 			{
-				Cell.SnowAlbedo = 0.4; // New rain drops the albedo to 0.4
+				const FFactoredSolarRadiation::FDay& Day = FactoredRadiationDays[HourFactoredRadiationDay[Hour]];
+				if (TileRadiationDay[Tile] != Day.DayOfYear)
+				{
+					FactoredRadiation.Evaluate(Day, BeginIndex, EndIndex, FactoredRadiationIndex.GetData() + BeginIndex);
+					TileRadiationDay[Tile] = Day.DayOfYear;
+				}
 			}
-			else 
+
+			auto SimulateRange = [&](int32 RangeBeginIndex, int32 RangeEndIndex)
 			{
-				// Variable lapse rate as described in "A variable lapse rate snowline model for the Remarkables, Central Otago, New Zealand"
-				float SnowRate = FMath::Clamp(1 - (TAir - TSnowA) / (TSnowB - TSnowA), 0.0f, 1.0f);
+				FDegreeDayCellRange Range(Cells, RangeBeginIndex, RangeEndIndex, HourRadiationIndex[Hour], CellBands);
+				Range.Interpolate = InterpolateHour;
+				InterpolatedMaxSnow = FMath::Max(InterpolatedMaxSnow, (InterpolateHour ? InterpolatingKernel : Kernel)(Range, Parameters, HourForcing[Hour]));
+			};
 
-				Cell.SnowWaterEquivalent += (Precipitation * AreaSquareMeters * SnowRate); // l/m^2 * m^2 = l
-				Cell.SnowAlbedo = 0.8; // New snow sets the albedo to 0.8
+			if (UseActiveCells)
+			{
+				// Only the cells with snow or precipitation
+				TileSimulatedCells[Tile] += ActiveCells.BeginHour(Tile, FDegreeDayCPUKernel::GetMinPrecipitationAltitude(HourForcing[Hour]) - PrecipitationAltitudeMargin);
+				ActiveCells.ForEachRange(Tile, SimulateRange);
+				ActiveCells.EndHour(Tile, Cells, InterpolateHour);
+			}
+			else
+			{
+				TileSimulatedCells[Tile] += EndIndex - BeginIndex;
+				SimulateRange(BeginIndex, EndIndex);
 			}
+
+			Interpolated = InterpolateHour;
 		}
 
-		// Apply melt
-		if (Cell.SnowWaterEquivalent > 0)
+		// Interpolate the cells which have not been interpolated by the kernel after the last hour
+		if (Block == NumBlocks - 1 || NumBlocks == 0)
 		{
-			if (Cell.DaysSinceLastSnowfall >= 0) {
-				// @TODO is time T the degree-days or the time since the last snowfall?
-				Cell.SnowAlbedo = 0.4 * (1 + FMath::Exp(-k_e * Cell.DaysSinceLastSnowfall)); 
+			TileMaxSnow[Tile] = InterpolatedMaxSnow;
+
+			if (UseActiveCells)
+			{
+				// All cells with snow have been simulated and interpolated in the last hour, the remaining changed cells lost their snow
+				ActiveCells.ForEachChangedRange(Tile, [&](int32 RangeBeginIndex, int32 RangeEndIndex)
+				{
+					TileInterpolatedCells[Tile] += RangeEndIndex - RangeBeginIndex;
+					TileMaxSnow[Tile] = FMath::Max(TileMaxSnow[Tile], InterpolateCells(RangeBeginIndex, RangeEndIndex));
+				}, !Interpolated);
 			}
+			else if (!Interpolated)
+			{
+				TileInterpolatedCells[Tile] += EndIndex - BeginIndex;
+				TileMaxSnow[Tile] = InterpolateCells(BeginIndex, EndIndex);
+			}
+		}
+	};
+
+	auto SimulateBlock = [&](int32 Block)
+	{
+		if (ParallelExecution)
+		{
+			// Every task works through its share of the tiles, this bounds the number of workers used
+			const int32 MaxWorkers = NumWorkers > 0 ? NumWorkers : FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+			const int32 NumTasks = FMath::Min(NumTiles, MaxWorkers);
 
-			// Temperature higher than melt threshold and cell contains snow
-			if (TAir > TMeltA)
+			ParallelFor(NumTasks, [&](int32 Task)
 			{
-				const float DayNormalization = 1.0f / 24.0f; // day 
-
-				// @TODO radiation index at nighttime? How about newer simulations?
-				// @TODO Blschl (???) used different radiation values during night
-				
-				// Radiation Index
-				const float R_i = SolarRadiationIndex(Cell.Inclination, Cell.Aspect, Cell.Latitude, SimulationActor->CurrentSimulationTime.GetDayOfYear()); // 1
-
-				// Melt factor
-				const float VegetationDensity = 0;
-				const float k_v = FMath::Exp(-4 * VegetationDensity); // 1
-				const float c_m = k_m * k_v * R_i *  (1 - Cell.SnowAlbedo) * DayNormalization * AreaSquareMeters; // l/m^2/C/day * day * m^2 = l/m^2 * 1/day * day * m^2 = l/C
-				const float MeltFactor = TAir < TMeltB ? (TAir - TMeltA) * (TAir - TMeltA) / (TMeltB - TMeltA) : (TAir - TMeltA);
-			
-				const float M = c_m * MeltFactor; // l/C * C = l
-
-				// Apply melt
-				Cell.SnowWaterEquivalent -= M; 
-				Cell.SnowWaterEquivalent = FMath::Max(0.0f, Cell.SnowWaterEquivalent);
+				for (int32 Tile = Task; Tile < NumTiles; Tile += NumTasks)
+				{
+					SimulateTile(Tile, Block);
+				}
+			});
+		}
+		else
+		{
+			for (int32 Tile = 0; Tile < NumTiles; ++Tile)
+			{
+				SimulateTile(Tile, Block);
 			}
 		}
+	};
 
-		Cell.DaysSinceLastSnowfall += 1.0f / 24.0f;
+	for (int32 Block = 0; Block < FMath::Max(1, NumBlocks); ++Block)
+	{
+		SimulateBlock(Block);
 	}
 
-	// Interpolation according to Blschls "Distributed Snowmelt Simulations in an Alpine Catchment"
-	for (auto& Cell : Cells)
+	const double KernelSeconds = FPlatformTime::Seconds() - StartSeconds;
+
+	// Lateral transport of the snow after all hours of the time step
+	double WindSeconds = 0;
+	double RedistributionSeconds = 0;
+	double InterpolationSeconds = 0;
+	bool SnowMoved = false;
+
+	if (WindTransport && NumHours > 0 && WindData.Num() > 0)
+	{
+		const double StageStartSeconds = FPlatformTime::Seconds();
+		SnowMoved |= TransportSnowByWind(CurrentSimulationStep, NumHours, RowsPerTile);
+		WindSeconds = FPlatformTime::Seconds() - StageStartSeconds;
+	}
+
+	if (SnowRedistribution && NumHours > 0)
+	{
+		const double StageStartSeconds = FPlatformTime::Seconds();
+		SnowMoved |= RedistributeSnow();
+		RedistributionSeconds = FPlatformTime::Seconds() - StageStartSeconds;
+	}
+
+	if (SnowMoved)
 	{
-		float Slope = FMath::RadiansToDegrees(Cell.Inclination);
+		const double StageStartSeconds = FPlatformTime::Seconds();
+		InterpolateMovedSnow(NumTiles, CellsPerTile);
+		InterpolationSeconds = FPlatformTime::Seconds() - StageStartSeconds;
+	}
 
-		float f = Slope < 15 ? 0 : Slope / 65;
-		float a3 = 50;
-		float we = FMath::Max(0.0f, Cell.SnowWaterEquivalent * (1 - f) * (1 + a3 * Cell.Curvature));
+	// Merge the partial maxima and counts of the tiles
+	MaxSnow = 0;
+	for (float TileMax : TileMaxSnow)
+	{
+		MaxSnow = FMath::Max(MaxSnow, TileMax);
+	}
 
-		Cell.InterpolatedSnowWaterEquivalent = we;
+	int64 SimulatedCells = 0;
+	for (int64 TileCells : TileSimulatedCells)
+	{
+		SimulatedCells += TileCells;
+	}
 
-		auto AreaSquareMeters = Cell.Area / (100 * 100);
-		MaxSnow = FMath::Max(Cell.InterpolatedSnowWaterEquivalent / AreaSquareMeters, MaxSnow);
+	int32 SeparatelyInterpolatedCells = 0;
+	for (int32 TileCells : TileInterpolatedCells)
+	{
+		SeparatelyInterpolatedCells += TileCells;
 	}
 
+	const int32 NumActiveCells = UseActiveCells ? ActiveCells.GetNumActive() : NumCells;
+	SET_DWORD_STAT(STAT_DegreeDayCPUActiveCells, NumActiveCells);
+	SET_DWORD_STAT(STAT_DegreeDayCPUSeparatelyInterpolatedCells, SeparatelyInterpolatedCells);
+
 	if (CaptureDebugInformation)
 	{
 		// Fill debug array
-		for (auto& Cell : Cells)
+		for (int32 Index = 0; Index < NumCells && Index < DebugCells.Num(); ++Index)
 		{
-			/*
-			float SnowMM = Cell.InterpolatedSWE / (Cell.Area / (100 * 100));
-			DebugInformation.Add(FDebugCellInformation(SnowMM);
-			*/
+			DebugCells[Index].SnowMM = Cells.GetInterpolatedSnowHeight(Index);
+		}
+	}
+
+	UE_LOG(SimulationLog, Display, TEXT("Iteration %d (%d hours) took %f ms, %.0f of %d cells simulated per hour, %d cells active, %d cells interpolated in a separate pass"), CurrentSimulationStep, NumHours,
+		(FPlatformTime::Seconds() - StartSeconds) * 1000, NumHours > 0 ? static_cast<double>(SimulatedCells) / NumHours : 0.0, NumCells, NumActiveCells, SeparatelyInterpolatedCells);
+
+	// Time of the stages of the step
+	const double StepMilliseconds = (FPlatformTime::Seconds() - StartSeconds) * 1000;
+	const FWindTransportTimings WindTimings = WindSeconds > 0 ? WindTransportStage.GetTimings() : FWindTransportTimings();
+	const FString StepTimes = FString::Printf(TEXT("kernels %.2f ms, wind %.2f ms (transport %.2f ms, halo exchange %.2f ms, apply %.2f ms), redistribution %.2f ms, interpolation %.2f ms, total %.2f of %.2f ms"),
+		KernelSeconds * 1000, WindSeconds * 1000, WindTimings.TransportSeconds * 1000, WindTimings.ExchangeSeconds * 1000, WindTimings.ApplySeconds * 1000,
+		RedistributionSeconds * 1000, InterpolationSeconds * 1000, StepMilliseconds, StepTimeBudget);
+
+	if (StepTimeBudget > 0 && StepMilliseconds > StepTimeBudget)
+	{
+		UE_LOG(SimulationLog, Warning, TEXT("Step %d exceeded the time budget: %s"), CurrentSimulationStep, *StepTimes);
+	}
+	else
+	{
+		UE_LOG(SimulationLog, Display, TEXT("Step %d time budget: %s"), CurrentSimulationStep, *StepTimes);
+	}
+}
+
+float UDegreeDayCPUSimulation::InterpolateCells(int32 BeginIndex, int32 EndIndex)
+{
+	float RangeMaxSnow = 0;
+
+	// Interpolation according to Blschls "Distributed Snowmelt Simulations in an Alpine Catchment"
+	for (int32 Index = BeginIndex; Index < EndIndex; ++Index)
+	{
+		float we = FMath::Max(0.0f, Cells.SnowWaterEquivalent[Index] * Cells.InterpolationFactor[Index]);
+
+		Cells.InterpolatedSnowWaterEquivalent[Index] = we;
+
+		RangeMaxSnow = FMath::Max(we * Cells.InverseAreaSquareMeters[Index], RangeMaxSnow);
+	}
+
+	return RangeMaxSnow;
+}
+
+bool UDegreeDayCPUSimulation::TransportSnowByWind(int32 CurrentSimulationStep, int32 NumHours, int32 RowsPerTile)
+{
+	if (!WindTransportStage.IsInitialized(Cells, RowsPerTile))
+	{
+		WindTransportStage.Initialize(Cells, RowsPerTile);
+	}
+	WindTransportStage.ResetTimings();
+
+	FWindTransportParameters Parameters;
+	Parameters.ThresholdWindSpeed = ThresholdWindSpeed;
+	Parameters.TransportCoefficient = WindTransportCoefficient;
+
+	double TransportedSnow = 0;
+	for (int32 Hour = 0; Hour < NumHours && CurrentSimulationStep + Hour < WindData.Num(); ++Hour)
+	{
+		TransportedSnow += WindTransportStage.SimulateHour(Cells, WindData.Get(CurrentSimulationStep + Hour), HourForcing[Hour], Parameters, ParallelExecution);
+	}
+
+	UE_LOG(SimulationLog, Display, TEXT("Wind transport of %d hours moved %.0f liters"), WindTransportStage.GetTimings().NumHours, TransportedSnow);
+
+	return TransportedSnow > 0;
+}
+
+bool UDegreeDayCPUSimulation::RedistributeSnow()
+{
+	const double StartSeconds = FPlatformTime::Seconds();
+
+	if (!Redistribution.IsInitialized(Cells))
+	{
+		Redistribution.Initialize(Cells);
+	}
+
+	FSnowRedistributionParameters Parameters;
+	Parameters.SlopeThreshold = SlopeThreshold;
+	Parameters.SnowDensity = RedistributionSnowDensity;
+	Parameters.MaxIterations = MaxRedistributionIterations;
+	Parameters.Tolerance = RedistributionTolerance;
+
+	const int32 Iterations = Redistribution.Redistribute(Cells, Parameters, ParallelExecution, TileRows);
+
+	UE_LOG(SimulationLog, Display, TEXT("Snow redistribution took %f ms, %d iterations moved %.0f liters"), (FPlatformTime::Seconds() - StartSeconds) * 1000, Iterations, Redistribution.GetMovedSnow());
+
+	return Redistribution.GetMovedSnow() > 0;
+}
+
+void UDegreeDayCPUSimulation::InterpolateMovedSnow(int32 NumTiles, int32 CellsPerTile)
+{
+	// The moved snow is interpolated again and the cells which received snow become active
+	auto InterpolateTile = [&](int32 Tile)
+	{
+		const int32 BeginIndex = Tile * CellsPerTile;
+		const int32 EndIndex = FMath::Min(BeginIndex + CellsPerTile, Cells.Num());
+
+		TileMaxSnow[Tile] = InterpolateCells(BeginIndex, EndIndex);
+		if (UseActiveCells)
+		{
+			ActiveCells.UpdateTile(Tile, Cells);
+		}
+	};
+
+	if (ParallelExecution)
+	{
+		ParallelFor(NumTiles, InterpolateTile);
+	}
+	else
+	{
+		for (int32 Tile = 0; Tile < NumTiles; ++Tile)
+		{
+			InterpolateTile(Tile);
 		}
 	}
 }
 
 void UDegreeDayCPUSimulation::Initialize(ASnowSimulationActor* SimulationActor, const TArray<FLandscapeCell>& LandscapeCells, float InitialMaxSnow, UWorld* World)
 {
+	CellsDimensionX = SimulationActor->CellsDimensionX;
+	CellsDimensionY = SimulationActor->CellsDimensionY;
+
+	// The weather data is owned by the provider and does not change during the simulation
+	ClimateData = SimulationActor->ClimateDataComponent->GetClimateDataView();
+	WindData = SimulationActor->ClimateDataComponent->GetWindDataView();
+
 	// Create Cells
-	TResourceArray<FGPUSimulationCell> Cells;
-	for (const FLandscapeCell& LandscapeCell : LandscapeCells)
+	Cells.Initialize(LandscapeCells, CellsDimensionX, CellsDimensionY);
+	MaxSnow = InitialMaxSnow;
+
+	UpdateInterpolationFactors();
+	UpdateMeltCoefficients(GetParameters());
+
+	UE_LOG(SimulationLog, Display, TEXT("Cell store uses %.2f MB for %d cells"), Cells.GetAllocatedSize() / (1024.0f * 1024.0f), Cells.Num());
+
+	// Precompute the radiation
+	RadiationTable.Reset();
+	FactoredRadiationIndex.Empty();
+	FactoredRadiationDays.Empty();
+	TileRadiationDay.Empty();
+	ActiveCells.Reset();
+	Redistribution.Reset();
+	WindTransportStage.Reset();
+
+	AltitudeBands.Reset();
+	if (UseAltitudeBands)
+	{
+		AltitudeBands.Initialize(Cells, AltitudeBandWidth * 100);
+
+		UE_LOG(SimulationLog, Display, TEXT("Altitude bands use %.2f MB for %d bands of %.1f m"), AltitudeBands.GetAllocatedSize() / (1024.0f * 1024.0f),
+			AltitudeBands.GetNumBands(), AltitudeBands.GetBandWidth() / 100);
+	}
+
+	EventIndex.Reset();
+	if (UseEventIndex)
+	{
+		BuildEventIndex(SimulationActor->ClimateDataComponent->GetMeasurementAltitude());
+	}
+	if (RadiationEvaluation == ERadiationEvaluation::Table)
+	{
+		RadiationTable.Build(Cells, RadiationTableDayStride);
+	}
+	else if (RadiationEvaluation == ERadiationEvaluation::Factored)
+	{
+		const double StartSeconds = FPlatformTime::Seconds();
+		FactoredRadiation.Initialize(Cells);
+		FactoredRadiationIndex.SetNumZeroed(Cells.Num());
+
+		UE_LOG(SimulationLog, Display, TEXT("Factored radiation took %f ms to build and uses %.2f MB for %d latitudes"), (FPlatformTime::Seconds() - StartSeconds) * 1000,
+			(FactoredRadiation.GetAllocatedSize() + FactoredRadiationIndex.GetAllocatedSize()) / (1024.0f * 1024.0f), FactoredRadiation.GetNumLatitudes());
+	}
+	if (DiurnalRadiation)
 	{
-		FGPUSimulationCell Cell(LandscapeCell.Aspect, LandscapeCell.Inclination, LandscapeCell.Altitude,
-			LandscapeCell.Latitude, LandscapeCell.Area, LandscapeCell.AreaXY, LandscapeCell.InitialWaterEquivalent);
-		Cells.Add(Cell);
+		RadiationTable.BuildDiurnalFactors(Cells);
 	}
 
-	// Distance between neighboring cells in cm (calculate as in https://forums.unrealengine.com/showthread.php?57338-Calculating-Exact-Map-Size)
-	auto Scale = SimulationActor->LandscapeScale;
-	const float L = SimulationActor->LandscapeScale.X / 100 * SimulationActor->CellSize;
+	if (RadiationEvaluation == ERadiationEvaluation::Table || DiurnalRadiation)
+	{
+		UE_LOG(SimulationLog, Display, TEXT("Radiation table took %f ms to build and uses %.2f MB"), RadiationTable.GetBuildSeconds() * 1000, RadiationTable.GetAllocatedSize() / (1024.0f * 1024.0f));
+	}
+
+	// The warmest cell is the lowest one, rain only falls if it is warmer than TSnowB in an hour with precipitation
+	const float MeasurementAltitude = SimulationActor->ClimateDataComponent->GetMeasurementAltitude();
+
+	float MinAltitude = MAX_FLT;
+	for (int32 Index = 0; Index < Cells.Num(); ++Index)
+	{
+		MinAltitude = FMath::Min(MinAltitude, Cells.Altitude[Index]);
+	}
+
+	MaxWetAirTemperature = -MAX_FLT;
+	for (int32 Hour = 0; Hour < ClimateData.Num(); ++Hour)
+	{
+		FDegreeDayForcing Forcing;
+		Forcing.Temperature = ClimateData.Get(Hour).Temperature;
+		Forcing.Precipitation = ClimateData.Get(Hour).Precipitation;
+		Forcing.MeasurementAltitude = MeasurementAltitude;
+
+		if (Forcing.Precipitation > 0 && Cells.Num() > 0)
+		{
+			MaxWetAirTemperature = FMath::Max(MaxWetAirTemperature, FDegreeDayCPUKernel::GetAirTemperature(Forcing, MinAltitude));
+		}
+	}
+
+	SelectKernels(GetKernelFeatures(GetParameters()));
+}
+
+FDegreeDayKernelFeatures UDegreeDayCPUSimulation::GetKernelFeatures(const FDegreeDayParameters& Parameters) const
+{
+	FDegreeDayKernelFeatures Features;
+	// Margin for the rounding of the lapse rate in the vector kernel
+	Features.Rain = MaxWetAirTemperature + 1e-3f > Parameters.TSnowB;
+	Features.DiurnalRadiation = DiurnalRadiation;
+	Features.Vegetation = false; // Folded into the melt coefficients of the cells
+	Features.Interpolation = false;
+	Features.QuadraticMelt = Parameters.TMeltB > Parameters.TMeltA;
+	return Features;
+}
+
+void UDegreeDayCPUSimulation::SelectKernels(const FDegreeDayKernelFeatures& Features)
+{
+	FDegreeDayKernelFeatures InterpolatingFeatures = Features;
+	InterpolatingFeatures.Interpolation = true;
+
+	KernelFeatures = Features;
+	VectorKernelSelected = UseVectorKernel;
+	Kernel = UseVectorKernel ? FDegreeDayCPUKernel::GetVectorKernel(Features) : FDegreeDayCPUKernel::GetScalarKernel(Features);
+	InterpolatingKernel = UseVectorKernel ? FDegreeDayCPUKernel::GetVectorKernel(InterpolatingFeatures) : FDegreeDayCPUKernel::GetScalarKernel(InterpolatingFeatures);
+
+	UE_LOG(SimulationLog, Display, TEXT("Selected %s kernel with %s"), UseVectorKernel ? TEXT("vector") : TEXT("scalar"), *Features.ToString());
+}
+
+void UDegreeDayCPUSimulation::UpdateInterpolationFactors()
+{
+	for (int32 Index = 0; Index < Cells.Num(); ++Index)
+	{
+		Cells.InterpolationFactor[Index] = Interpolation.GetInterpolationFactor(Cells.Inclination[Index], Cells.Curvature[Index]);
+	}
+	InterpolationFactorParameters = Interpolation;
+}
+
+void UDegreeDayCPUSimulation::UpdateMeltCoefficients(const FDegreeDayParameters& Parameters)
+{
+	FDegreeDayCPUKernel::UpdateMeltCoefficients(Cells, Parameters);
+	MeltCoefficientParameters = Parameters;
+}
+
+void UDegreeDayCPUSimulation::BuildEventIndex(float MeasurementAltitude)
+{
+	const double StartSeconds = FPlatformTime::Seconds();
+
+	EventIndex.Build(ClimateData, Cells, MeasurementAltitude, GetParameters(), EventIndexBandWidth * 100);
+
+	UE_LOG(SimulationLog, Display, TEXT("Event index took %f ms to build and uses %.2f MB, %d of %d hours without melt, %d of them without precipitation"),
+		(FPlatformTime::Seconds() - StartSeconds) * 1000, EventIndex.GetAllocatedSize() / (1024.0f * 1024.0f), EventIndex.GetNumColdHours(), ClimateData.Num(), EventIndex.GetNumDryColdHours());
 }
 
 UTexture* UDegreeDayCPUSimulation::GetSnowMapTexture()
@@ -164,11 +623,8 @@ UTexture* UDegreeDayCPUSimulation::GetSnowMapTexture()
 	{
 		for (int32 X = 0; X < CellsDimensionX; ++X)
 		{
-			auto& Cell = Cells[Y * CellsDimensionX + X];
-
 			// Snow map texture
-			float AreaSquareMeters = Cell.Area / (100 * 100);
-			float SnowMM = Cell.InterpolatedSnowWaterEquivalent / AreaSquareMeters;
+			float SnowMM = Cells.GetInterpolatedSnowHeight(Y * CellsDimensionX + X);
 			float Gray = SnowMM / GetMaxSnow() * 255;
 			uint8 GrayInt = static_cast<uint8>(Gray);
 			SnowMapTextureData.Add(FColor(GrayInt, GrayInt, GrayInt));
@@ -3,8 +3,26 @@
 #pragma once
 
 #include "DegreeDay/DegreeDaySimulation.h"
+#include "Cells/SimulationCellStore.h"
+#include "Cells/ActiveCellSet.h"
+#include "DegreeDayCPUKernel.h"
+#include "ClimateEventIndex.h"
+#include "AltitudeBandForcing.h"
+#include "Radiation/SolarRadiationTable.h"
+#include "Radiation/FactoredSolarRadiation.h"
+#include "SnowRedistribution.h"
+#include "WindTransport.h"
 #include "DegreeDayCPUSimulation.generated.h"
 
+/** How the solar radiation index of the cells is evaluated during the simulation. */
+UENUM(BlueprintType)
+enum class ERadiationEvaluation : uint8
+{
+	Direct 		UMETA(DisplayName = "Direct"),
+	Table 		UMETA(DisplayName = "Precomputed Table"),
+	Factored 	UMETA(DisplayName = "Factored")
+};
+
 
 struct SIMULATION_API FCPUSimulationCell
 {
@@ -20,9 +38,6 @@ struct SIMULATION_API FCPUSimulationCell
 
 	const int Index;
 
-	/** Eight neighborhood starting from north. */
-	TArray<FCPUSimulationCell*> Neighbours;
-
 	/** Area in cm^2. */
 	const float Area;
 
@@ -59,14 +74,6 @@ struct SIMULATION_API FCPUSimulationCell
 	/** The curvature (second derivative) of the terrain for this cell. */
 	float Curvature = 0.0f;
 
-	/** Returns true if all neighbours have been set (non null). */
-	bool AllNeighboursSet() const {
-		for (auto& Neighbour : Neighbours) {
-			if (Neighbour == nullptr) return false;
-		}
-		return true;
-	}
-
 	/** Returns the altitude of the cells midpoint including the snow accumulated on the surface in cm. */
 	float GetAltitudeWithSnow() const {
 		return Altitude + GetSnowHeight() * 10;
@@ -90,9 +97,7 @@ struct SIMULATION_API FCPUSimulationCell
 		Aspect(Aspect),
 		Inclination(Inclination),
 		Latitude(Latitude)
-	{
-		Neighbours.Init(nullptr, 8);
-	}
+	{}
 };
 
 /**
@@ -105,7 +110,10 @@ class SIMULATION_API UDegreeDayCPUSimulation : public UDegreeDaySimulation
 	GENERATED_BODY()
 private:
 	/** The cells this simulation uses. */
-	TArray<FCPUSimulationCell> Cells;
+	FSimulationCellStore Cells;
+
+	/** The weather data of the provider. */
+	FClimateDataView ClimateData;
 
 	/** The snow mask used by the landscape material. */
 	UTexture2D* SnowMapTexture;
@@ -116,92 +124,207 @@ private:
 	/** The maximum snow amount (mm) of the current time step. */
 	float MaxSnow;
 
+	/** The maximum snow amount (mm) of every tile of the current time step. */
+	TArray<float> TileMaxSnow;
+
+	/** The number of cells simulated by every tile during the current time step summed over all hours. */
+	TArray<int64> TileSimulatedCells;
+
+	/** The number of cells of every tile interpolated apart from the kernel during the current time step. */
+	TArray<int32> TileInterpolatedCells;
+
+	/** The cells with snow of every tile. */
+	FActiveCellSet ActiveCells;
+
+	/** The ranges of hours without melt of the weather data. */
+	FClimateEventIndex EventIndex;
+
+	/** Builds the event index for the current parameters. */
+	void BuildEventIndex(float MeasurementAltitude);
+
+	/** The altitude bands of the cells. */
+	FAltitudeBandForcing AltitudeBands;
+
+	/** The forcing of every altitude band of every hour of the current time step. */
+	TArray<FDegreeDayCellForcing> HourBandForcing;
+
+	/** Precomputed solar radiation index of the cells. */
+	FSolarRadiationTable RadiationTable;
+
+	/** Cell and day constants of the solar radiation index. */
+	FFactoredSolarRadiation FactoredRadiation;
+
+	/** Radiation index of the cells for the current day of the factored radiation. */
+	FAlignedFloatArray FactoredRadiationIndex;
+
+	/** The day of the year of the factored radiation index of every tile. */
+	TArray<int32> TileRadiationDay;
+
+	/** The forcing of every hour of the current time step. */
+	TArray<FDegreeDayForcing> HourForcing;
+
+	/** The precomputed radiation index of every hour of the current time step. */
+	TArray<const float*> HourRadiationIndex;
+
+	/** Index into FactoredRadiationDays of every hour of the current time step. */
+	TArray<int32> HourFactoredRadiationDay;
+
+	/** The constants of the factored radiation of the days of the current time step, the slots are reused by the next time steps. */
+	TArray<FFactoredSolarRadiation::FDay> FactoredRadiationDays;
+
+	/** Interpolates the snow of the cells in the range [BeginIndex, EndIndex) and returns the maximum snow amount (mm) of the range. */
+	float InterpolateCells(int32 BeginIndex, int32 EndIndex);
+
+	/** The interpolation parameters of the interpolation factors of the cells. */
+	FBloeschlParameters InterpolationFactorParameters;
+
+	/** Computes the interpolation factors of the cells for the current interpolation parameters. */
+	void UpdateInterpolationFactors();
+
+	/** The parameters of the melt coefficients of the cells. */
+	FDegreeDayParameters MeltCoefficientParameters;
+
+	/** Computes the melt coefficients and the snowfall areas of the cells for the given parameters. */
+	void UpdateMeltCoefficients(const FDegreeDayParameters& Parameters);
+
+	/** The highest air temperature at the lowest cell in an hour with precipitation in degree Celsius. */
+	float MaxWetAirTemperature = MAX_FLT;
+
+	/** The features of the selected kernels. */
+	FDegreeDayKernelFeatures KernelFeatures;
+
+	/** Whether the selected kernels are vector kernels. */
+	bool VectorKernelSelected = false;
+
+	/** The kernel variant of the hours without interpolation. */
+	FDegreeDayKernelFunction Kernel = nullptr;
+
+	/** The kernel variant of the last hour of a time step which also interpolates the snow. */
+	FDegreeDayKernelFunction InterpolatingKernel = nullptr;
+
+	/** Returns the kernel features which are needed for the given parameters and the current properties. */
+	FDegreeDayKernelFeatures GetKernelFeatures(const FDegreeDayParameters& Parameters) const;
+
+	/** Selects the kernel variants with the given features. */
+	void SelectKernels(const FDegreeDayKernelFeatures& Features);
+
+	/** The hourly wind of the provider, empty if the provider has no wind data. */
+	FWindDataView WindData;
+
+	/** Transports the snow with the wind. */
+	FWindTransport WindTransportStage;
+
+	/** Moves the snow of steep cells to their lower neighbours. */
+	FSnowRedistribution Redistribution;
+
+	/** Transports the snow with the wind of the hours of the time step and returns true if any snow has been moved. */
+	bool TransportSnowByWind(int32 CurrentSimulationStep, int32 NumHours, int32 RowsPerTile);
+
+	/** Redistributes the snow after a time step and returns true if any snow has been moved. */
+	bool RedistributeSnow();
+
+	/** Interpolates the cells again after snow has been moved between them and updates the active cells. */
+	void InterpolateMovedSnow(int32 NumTiles, int32 CellsPerTile);
+
+
+public:
+	/** Whether the cells are simulated in parallel row tiles on the task graph or serially on the game thread. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance")
+	bool ParallelExecution = true;
+
+	/** Number of cell rows per tile, a tile should fit into the L2 cache. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance", meta = (ClampMin = "1"))
+	int32 TileRows = 8;
+
 	/**
-	* Calculates the solar radiation as described in Swifts "Algorithm for Solar Radiation on Mountain Slopes".
-	*
-	* @param I		The inclination of the slope in radians.
-	* @param A		The aspect (compass direction) that the slope faces in radians.
-	* @param L0		The latitude of the slope in radians.
-	*
-	* @return
+	* Number of hours a tile is advanced before the next tile is processed, 0 advances every tile through all timesteps of
+	* an iteration at once. A tile stays in the cache for all hours of a block.
 	*/
-	float SolarRadiationIndex(float I, float A, float L0, float J)
-	{
-		float L1 = FMath::Asin(FMath::Cos(I) * FMath::Sin(L0) + FMath::Sin(I) * FMath::Cos(L0) * FMath::Cos(A));
-		float D1 = FMath::Cos(I) * FMath::Cos(L0) - FMath::Sin(I) * FMath::Sin(L0) * FMath::Cos(A);
-		float L2 = FMath::Atan((FMath::Sin(I) * FMath::Sin(A)) / (FMath::Cos(I) * FMath::Cos(L0) - FMath::Sin(I) * FMath::Sin(L0) * FMath::Cos(A)));
-
-		float D = 0.007 - 0.4067 * FMath::Cos((J + 10) * 0.0172);
-		float E = 1.0 - 0.0167 * FMath::Cos((J - 3) * 0.0172);
-
-		const float R0 = 1.95;
-		float R1 = 60 * R0 / (E * E);
-		// float R1 = (PI / 3) * R0 / (E * E);
-
-		float T;
-
-		T = Func2(L1, D);
-		float T7 = T - L2;
-		float T6 = -T - L2;
-		T = Func2(L0, D);
-		float T1 = T;
-		float T0 = -T;
-		float T3 = FMath::Min(T7, T1);
-		float T2 = FMath::Max(T6, T0);
-
-		float T4 = T2 * (12 / PI);
-		float T5 = T3 * (12 / PI);
-
-		//float R4 = Func3(L2, L1, T3, T2, R1, D); // Figure1
-		if (T3 < T2) // Figure2
-		{
-			T2 = T3 = 0;
-		}
-
-		T6 = T6 + PI * 2;
-
-		float R4;
-		if (T6 < T1)
-		{
-			float T8 = T6;
-			float T9 = T1;
-			R4 = Func3(L2, L1, T3, T2, R1, D) + Func3(L2, L1, T9, T8, R1, D);
-		} 
-		else
-		{
-			T7 = T7 - PI * 2;
-
-			if (T7 > T0)
-			{
-				float T8 = T0;
-				float T9 = T0;
-				R4 = Func3(L2, L1, T3, T2, R1, D) + Func3(L2, L1, T9, T8, R1, D);
-			}
-			else
-			{
-				R4 = Func3(L2, L1, T3, T2, R1, D);
-			}
-		}
-
-		float R3 = Func3(0.0, L0, T1, T0, R1, D);
-
-		return R4 / R3;
-	}
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance", meta = (ClampMin = "0"))
+	int32 TimeBlockHours = 0;
 
-	// @TODO check for invalid latitudes (90)
-	float Func2(float L, float D) // sunrise/sunset
-	{
-		return FMath::Acos(FMath::Clamp(-FMath::Tan(L) * FMath::Tan(D), -1.0f, 1.0f));
-	}
+	/** Maximum number of workers the tiles are distributed on, 0 uses all worker threads of the task graph. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance", meta = (ClampMin = "0"))
+	int32 NumWorkers = 0;
 
-	float Func3(float V, float W, float X, float Y, float R1, float D) // radiation
-	{
-		return R1 * (FMath::Sin(D) * FMath::Sin(W) * (X - Y) * (12 / PI) + 
-			FMath::Cos(D) * FMath::Cos(W) * (FMath::Sin(X + V) - FMath::Sin(Y + V)) * (12 / PI));
-	}
+	/** Whether only cells with snow or precipitation are simulated. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance")
+	bool UseActiveCells = true;
 
+	/**
+	* Whether ranges of hours in which no snow melts are simulated at once. The snowfall of such ranges is interpolated
+	* between altitude bands, so the result deviates slightly from simulating every hour.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance")
+	bool UseEventIndex = true;
+
+	/** Width of the altitude bands of the event index in m. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance", meta = (ClampMin = "1"))
+	float EventIndexBandWidth = 10;
+
+	/**
+	* Whether the forcing is computed once per altitude band instead of for every cell. The forcing is computed at the
+	* center of the band, so the air temperature of a cell deviates by at most 0.025 degree Celsius for bands of 10m.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance")
+	bool UseAltitudeBands = true;
+
+	/** Width of the altitude bands of the forcing in m. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance", meta = (ClampMin = "0.1"))
+	float AltitudeBandWidth = 10;
+
+	/** Whether the vectorized kernel is used, the scalar kernel is used otherwise. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance")
+	bool UseVectorKernel = true;
+
+	/**
+	* How the solar radiation index is evaluated. The factored evaluation needs 6 floats per cell and evaluates the cells
+	* once per day. The table is built during initialization and needs 366 floats per cell, 1.4 GB per million cells,
+	* beyond 5.8 million cells it only stores some of the days, see FSolarRadiationTable::Build.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance")
+	ERadiationEvaluation RadiationEvaluation = ERadiationEvaluation::Factored;
+
+	/** Only every n-th day is stored in the radiation table, the other days use the closest stored day. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance", meta = (ClampMin = "1"))
+	int32 RadiationTableDayStride = 1;
+
+	/** Whether the daily radiation index is distributed over the hours of the day according to the sun position. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation")
+	bool DiurnalRadiation = false;
+
+	/** Whether the snow of cells steeper than SlopeThreshold slides to the lower neighbours at the end of every time step. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation")
+	bool SnowRedistribution = false;
+
+	/** Density of the sliding snow in kg/m^3 which determines the height of the snow surface. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation", meta = (ClampMin = "10"))
+	float RedistributionSnowDensity = 250;
+
+	/** Whether dry snow is transported by the wind of the weather data provider at the end of every time step. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation")
+	bool WindTransport = false;
+
+	/** Wind speed in m/s above which dry snow is transported. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation", meta = (ClampMin = "0"))
+	float ThresholdWindSpeed = 5;
+
+	/** The transport rate in kg/(m s) is this coefficient times the cube of the wind speed above the threshold. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation", meta = (ClampMin = "0"))
+	float WindTransportCoefficient = 1e-5f;
+
+	/** Maximum number of iterations of the snow redistribution per time step. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance", meta = (ClampMin = "1"))
+	int32 MaxRedistributionIterations = 32;
+
+	/** The snow redistribution stops once an iteration moves less than this fraction of the snow. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance", meta = (ClampMin = "0"))
+	float RedistributionTolerance = 1e-4f;
+
+	/** Time in ms a time step should take, steps which take longer are reported as warnings. 0 disables the warning. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance", meta = (ClampMin = "0"))
+	float StepTimeBudget = 100;
 
-public:
 	virtual FString GetSimulationName() override final;
 
 	virtual void Simulate(ASnowSimulationActor* SimulationActor, int32 CurrentSimulationStep, int32 Timesteps, bool SaveSnowMap, bool CaptureDebugInformation, TArray<FDebugCell>& DebugCells) override final;
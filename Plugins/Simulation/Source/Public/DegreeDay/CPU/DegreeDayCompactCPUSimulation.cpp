@@ -0,0 +1,202 @@
+#include "Simulation.h"
+#include "DegreeDayCompactCPUSimulation.h"
+#include "SnowSimulationActor.h"
+#include "Radiation/SolarRadiation.h"
+#include "Util/TextureUtil.h"
+#include "ParallelFor.h"
+
+FString UDegreeDayCompactCPUSimulation::GetSimulationName()
+{
+	return FString(TEXT("Degree Day CPU Compact"));
+}
+
+DECLARE_CYCLE_STAT(TEXT("Degree Day Compact CPU Simulate"), STAT_DegreeDayCompactCPUSimulate, STATGROUP_SnowSimulation);
+
+float UDegreeDayCompactCPUSimulation::SimulateTile(FCompactTileBuffers& Buffers, const FDegreeDayParameters& Parameters, const FBloeschlParameters& InterpolationParameters,
+	const TArray<FDegreeDayForcing>& HourForcing, bool VectorKernel)
+{
+	FSimulationCellStore& TileCells = Buffers.Cells;
+	const int32 NumCells = TileCells.Num();
+
+	for (int32 Index = 0; Index < NumCells; ++Index)
+	{
+		TileCells.InterpolationFactor[Index] = InterpolationParameters.GetInterpolationFactor(TileCells.Inclination[Index], TileCells.Curvature[Index]);
+	}
+
+	// The radiation index is evaluated once per day, the kernels only look it up
+	Buffers.RadiationIndex.SetNumUninitialized(NumCells, false);
+	Buffers.RadiationDay = -1;
+
+	FDegreeDayKernelFeatures Features;
+	Features.DiurnalRadiation = HourForcing.ContainsByPredicate([](const FDegreeDayForcing& Forcing) { return Forcing.DiurnalFactor != 1.0f; });
+	Features.Vegetation = Parameters.VegetationDensity != 0;
+	Features.QuadraticMelt = Parameters.TMeltB > Parameters.TMeltA;
+
+	Features.Interpolation = false;
+	const FDegreeDayKernelFunction Kernel = VectorKernel ? FDegreeDayCPUKernel::GetVectorKernel(Features) : FDegreeDayCPUKernel::GetScalarKernel(Features);
+	Features.Interpolation = true;
+	const FDegreeDayKernelFunction InterpolatingKernel = VectorKernel ? FDegreeDayCPUKernel::GetVectorKernel(Features) : FDegreeDayCPUKernel::GetScalarKernel(Features);
+
+	float TileMaxSnow = 0;
+
+	for (int32 Hour = 0; Hour < HourForcing.Num(); ++Hour)
+	{
+		const FDegreeDayForcing& Forcing = HourForcing[Hour];
+
+		if (Buffers.RadiationDay != Forcing.DayOfYear)
+		{
+			for (int32 Index = 0; Index < NumCells; ++Index)
+			{
+				Buffers.RadiationIndex[Index] = FSolarRadiation::SolarRadiationIndex(TileCells.Inclination[Index], TileCells.Aspect[Index], TileCells.Latitude[Index], Forcing.DayOfYear);
+			}
+			Buffers.RadiationDay = Forcing.DayOfYear;
+		}
+
+		const bool InterpolateHour = Hour == HourForcing.Num() - 1;
+
+		FDegreeDayCellRange Range(TileCells, 0, NumCells, Buffers.RadiationIndex.GetData());
+		Range.Interpolate = InterpolateHour;
+		TileMaxSnow = FMath::Max(TileMaxSnow, (InterpolateHour ? InterpolatingKernel : Kernel)(Range, Parameters, Forcing));
+	}
+
+	return TileMaxSnow;
+}
+
+void UDegreeDayCompactCPUSimulation::Simulate(ASnowSimulationActor* SimulationActor, int32 CurrentSimulationStep, int32 Timesteps, bool SaveSnowMap, bool CaptureDebugInformation, TArray<FDebugCell>& DebugCells)
+{
+	SCOPE_CYCLE_COUNTER(STAT_DegreeDayCompactCPUSimulate);
+
+	const double StartSeconds = FPlatformTime::Seconds();
+
+	const int32 NumCells = Cells.Num();
+	const int32 NumHours = FMath::Clamp(ClimateData.Num() - CurrentSimulationStep, 0, Timesteps);
+	const FDegreeDayParameters Parameters = GetParameters();
+	const float MeasurementAltitude = SimulationActor->ClimateDataComponent->GetMeasurementAltitude();
+
+	if (NumHours == 0) return;
+
+	// Forcing of all hours of this step
+	TArray<FDegreeDayForcing> HourForcing;
+	for (int32 Hour = 0; Hour < NumHours; ++Hour)
+	{
+		const FClimateData& HourClimateData = ClimateData.Get(CurrentSimulationStep + Hour);
+		const FDateTime Time = SimulationActor->CurrentSimulationTime + FTimespan(Hour, 0, 0);
+
+		FDegreeDayForcing Forcing;
+		Forcing.Temperature = HourClimateData.Temperature;
+		Forcing.Precipitation = HourClimateData.Precipitation;
+		Forcing.MeasurementAltitude = MeasurementAltitude;
+		Forcing.DayOfYear = Time.GetDayOfYear();
+		Forcing.DiurnalFactor = DiurnalRadiationTable.GetDiurnalFactor(Forcing.DayOfYear, Time.GetHour());
+		HourForcing.Add(Forcing);
+	}
+
+	// Split the grid into tiles of rows, every task decompresses one tile at a time
+	const int32 CellsPerTile = FMath::Max(1, TileRows) * CellsDimensionX;
+	const int32 NumTiles = FMath::DivideAndRoundUp(NumCells, CellsPerTile);
+	const int32 MaxWorkers = NumWorkers > 0 ? NumWorkers : FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+	const int32 NumTasks = ParallelExecution ? FMath::Min(NumTiles, MaxWorkers) : 1;
+	TileMaxSnow.SetNumZeroed(NumTiles);
+	TaskBuffers.SetNum(NumTasks);
+
+	auto SimulateTask = [&](int32 Task)
+	{
+		for (int32 Tile = Task; Tile < NumTiles; Tile += NumTasks)
+		{
+			const int32 BeginIndex = Tile * CellsPerTile;
+			const int32 EndIndex = FMath::Min(BeginIndex + CellsPerTile, NumCells);
+
+			Cells.Decompress(BeginIndex, EndIndex, TaskBuffers[Task].Cells);
+			TileMaxSnow[Tile] = SimulateTile(TaskBuffers[Task], Parameters, Interpolation, HourForcing, UseVectorKernel);
+			Cells.Compress(BeginIndex, TaskBuffers[Task].Cells);
+		}
+	};
+
+	if (ParallelExecution)
+	{
+		ParallelFor(NumTasks, SimulateTask);
+	}
+	else
+	{
+		SimulateTask(0);
+	}
+
+	MaxSnow = 0;
+	for (float TileMax : TileMaxSnow)
+	{
+		MaxSnow = FMath::Max(MaxSnow, TileMax);
+	}
+
+	if (CaptureDebugInformation)
+	{
+		// Fill debug array
+		for (int32 Index = 0; Index < NumCells && Index < DebugCells.Num(); ++Index)
+		{
+			DebugCells[Index].SnowMM = Cells.GetInterpolatedSnowHeight(Index);
+		}
+	}
+
+	UE_LOG(SimulationLog, Display, TEXT("Iteration %d (%d hours) took %f ms"), CurrentSimulationStep, NumHours, (FPlatformTime::Seconds() - StartSeconds) * 1000);
+}
+
+void UDegreeDayCompactCPUSimulation::Initialize(ASnowSimulationActor* SimulationActor, const TArray<FLandscapeCell>& LandscapeCells, float InitialMaxSnow, UWorld* World)
+{
+	CellsDimensionX = SimulationActor->CellsDimensionX;
+	CellsDimensionY = SimulationActor->CellsDimensionY;
+
+	// The weather data is owned by the provider and does not change during the simulation
+	ClimateData = SimulationActor->ClimateDataComponent->GetClimateDataView();
+
+	Cells.Initialize(LandscapeCells, CellsDimensionX, CellsDimensionY);
+	TaskBuffers.Empty();
+	MaxSnow = InitialMaxSnow;
+
+	DiurnalRadiationTable.Reset();
+	if (DiurnalRadiation)
+	{
+		double LatitudeSum = 0;
+		for (const FLandscapeCell& Cell : LandscapeCells)
+		{
+			LatitudeSum += Cell.Latitude;
+		}
+		DiurnalRadiationTable.BuildDiurnalFactors(LandscapeCells.Num() > 0 ? LatitudeSum / LandscapeCells.Num() : 0.0f);
+	}
+
+	UE_LOG(SimulationLog, Display, TEXT("Compact cell store uses %.2f MB for %d cells (%.1f bytes per cell)"), Cells.GetAllocatedSize() / (1024.0f * 1024.0f), Cells.Num(),
+		Cells.Num() > 0 ? static_cast<float>(Cells.GetAllocatedSize()) / Cells.Num() : 0.0f);
+}
+
+UTexture* UDegreeDayCompactCPUSimulation::GetSnowMapTexture()
+{
+	SnowMapTexture = UTexture2D::CreateTransient(CellsDimensionX, CellsDimensionY, EPixelFormat::PF_G16);
+
+	SnowMapTexture->UpdateResource();
+	SnowMapTextureData.Empty(Cells.Num());
+
+	for (int32 Index = 0; Index < Cells.Num(); ++Index)
+	{
+		float Gray = Cells.GetInterpolatedSnowHeight(Index) / GetMaxSnow() * 255;
+		uint8 GrayInt = static_cast<uint8>(Gray);
+		SnowMapTextureData.Add(FColor(GrayInt, GrayInt, GrayInt));
+	}
+
+	FRenderCommandFence UpdateTextureFence;
+
+	UpdateTextureFence.BeginFence();
+
+	UpdateTexture(SnowMapTexture, SnowMapTextureData);
+
+	UpdateTextureFence.Wait();
+
+	return SnowMapTexture;
+}
+
+float UDegreeDayCompactCPUSimulation::GetMaxSnow()
+{
+	return MaxSnow;
+}
+
+void UDegreeDayCompactCPUSimulation::RenderDebug(UWorld* World, int CellDebugInfoDisplayDistance, EDebugVisualizationType DebugVisualizationType)
+{
+
+}
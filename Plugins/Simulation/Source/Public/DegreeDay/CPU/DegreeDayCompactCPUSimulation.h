@@ -0,0 +1,103 @@
+#pragma once
+
+#include "DegreeDay/DegreeDaySimulation.h"
+#include "Cells/CompactCellStore.h"
+#include "DegreeDayCPUKernel.h"
+#include "Radiation/SolarRadiationTable.h"
+#include "ClimateData.h"
+#include "DegreeDayCompactCPUSimulation.generated.h"
+
+/** The decompressed cells of a tile and their radiation index. */
+struct FCompactTileBuffers
+{
+	/** The decompressed cells of the tile. */
+	FSimulationCellStore Cells;
+
+	/** The radiation index of the cells of the tile for RadiationDay. */
+	FAlignedFloatArray RadiationIndex;
+
+	/** The day of the year of the radiation index. */
+	int32 RadiationDay = -1;
+};
+
+/**
+* Degree day simulation of grids which do not fit into memory at full precision. The cells are stored quantized in a
+* FCompactCellStore (see its documentation for the error bounds), every tile is decompressed, simulated through all
+* hours of a time step with the kernels of the CPU simulation and compressed again. The radiation index is evaluated
+* per tile and day instead of being stored. Simulation.ValidateCompactStorage reports the error against full precision.
+*/
+UCLASS(Blueprintable, BlueprintType)
+class SIMULATION_API UDegreeDayCompactCPUSimulation : public UDegreeDaySimulation
+{
+	GENERATED_BODY()
+private:
+	/** The quantized cells. */
+	FCompactCellStore Cells;
+
+	/** The weather data of the provider. */
+	FClimateDataView ClimateData;
+
+	/** The tile buffers of every task. */
+	TArray<FCompactTileBuffers> TaskBuffers;
+
+	/** The snow mask used by the landscape material. */
+	UTexture2D* SnowMapTexture;
+
+	/** Color buffer for the snow mask texture. */
+	TArray<FColor> SnowMapTextureData;
+
+	/** The maximum snow amount (mm) of the current time step. */
+	float MaxSnow;
+
+	/** The maximum snow amount (mm) of every tile of the current time step. */
+	TArray<float> TileMaxSnow;
+
+	/** The diurnal factors of the radiation, the radiation indices of the cells are evaluated per tile instead. */
+	FSolarRadiationTable DiurnalRadiationTable;
+
+public:
+	/** Whether the cells are simulated in parallel row tiles on the task graph or serially on the game thread. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance")
+	bool ParallelExecution = true;
+
+	/** Number of cell rows per tile, every task holds one decompressed tile. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance", meta = (ClampMin = "1"))
+	int32 TileRows = 8;
+
+	/** Maximum number of tasks which simulate tiles in parallel, 0 uses all worker threads. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance", meta = (ClampMin = "0"))
+	int32 NumWorkers = 0;
+
+	/** Whether the vectorized kernel is used, the scalar kernel is used otherwise. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance")
+	bool UseVectorKernel = true;
+
+	/** Whether the daily radiation index is distributed over the hours of the day according to the sun position. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation")
+	bool DiurnalRadiation = false;
+
+	/**
+	* Advances the decompressed cells of a tile by the given hours and interpolates them after the last hour.
+	*
+	* @param Buffers				The decompressed cells and their radiation index
+	* @param Parameters				The degree day parameters
+	* @param InterpolationParameters	The parameters of the interpolation
+	* @param HourForcing			The forcing of the hours
+	* @param VectorKernel			Whether the vectorized kernel is used
+	* @return the maximum snow amount (mm) of the tile after interpolation
+	*/
+	static float SimulateTile(FCompactTileBuffers& Buffers, const FDegreeDayParameters& Parameters, const FBloeschlParameters& InterpolationParameters,
+		const TArray<FDegreeDayForcing>& HourForcing, bool VectorKernel);
+
+	virtual FString GetSimulationName() override final;
+
+	virtual void Simulate(ASnowSimulationActor* SimulationActor, int32 CurrentSimulationStep, int32 Timesteps, bool SaveSnowMap, bool CaptureDebugInformation, TArray<FDebugCell>& DebugCells) override final;
+
+	virtual void Initialize(ASnowSimulationActor* SimulationActor, const TArray<FLandscapeCell>& Cells, float InitialMaxSnow, UWorld* World) override final;
+
+	virtual void RenderDebug(UWorld* World, int CellDebugInfoDisplayDistance, EDebugVisualizationType DebugVisualizationType) override;
+
+	virtual UTexture* GetSnowMapTexture() override final;
+
+	virtual float GetMaxSnow() override final;
+};
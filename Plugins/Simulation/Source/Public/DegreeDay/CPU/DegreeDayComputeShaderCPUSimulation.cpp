@@ -0,0 +1,172 @@
+#include "Simulation.h"
+#include "DegreeDayComputeShaderCPUSimulation.h"
+#include "SnowSimulationActor.h"
+#include "Util/TextureUtil.h"
+#include "Util/SnowOutputRecord.h"
+#include "ParallelFor.h"
+
+FString UDegreeDayComputeShaderCPUSimulation::GetSimulationName()
+{
+	return FString(TEXT("Degree Day Compute Shader CPU"));
+}
+
+DECLARE_CYCLE_STAT(TEXT("Degree Day Compute Shader CPU Simulate"), STAT_DegreeDayComputeShaderCPUSimulate, STATGROUP_SnowSimulation);
+
+void UDegreeDayComputeShaderCPUSimulation::Simulate(ASnowSimulationActor* SimulationActor, int32 CurrentSimulationStep, int32 Timesteps, bool SaveSnowMap, bool CaptureDebugInformation, TArray<FDebugCell>& DebugCells)
+{
+	SCOPE_CYCLE_COUNTER(STAT_DegreeDayComputeShaderCPUSimulate);
+
+	const double StartSeconds = FPlatformTime::Seconds();
+
+	// The variable parameters are set like the GPU simulation sets them, the time of day is the one of the first hour
+	FComputeShaderVariableParameters VariableParameters;
+	VariableParameters.CurrentSimulationStep = CurrentSimulationStep;
+	VariableParameters.Timesteps = Timesteps;
+	VariableParameters.DayOfYear = SimulationActor->CurrentSimulationTime.GetDayOfYear();
+	VariableParameters.HourOfDay = SimulationActor->CurrentSimulationTime.GetHour();
+
+	// Split the rows of the dispatched thread groups into tiles
+	const int32 NumRows = FMath::Min(FComputeShaderCPUKernel::GetNumDispatchedRows(ConstantParameters), CellsDimensionY);
+	const int32 RowsPerTile = FMath::Max(1, TileRows);
+	const int32 NumTiles = FMath::DivideAndRoundUp(NumRows, RowsPerTile);
+	TileMaxSnow.Init(0, NumTiles);
+
+	auto SimulateTile = [&](int32 Tile)
+	{
+		const int32 BeginRow = Tile * RowsPerTile;
+		const int32 EndRow = FMath::Min(BeginRow + RowsPerTile, NumRows);
+
+		TileMaxSnow[Tile] = FComputeShaderCPUKernel::SimulateRows(SimulationCells.GetData(), WeatherData, ConstantParameters, VariableParameters, BeginRow, EndRow, SnowOutput.GetData());
+	};
+
+	if (ParallelExecution)
+	{
+		ParallelFor(NumTiles, SimulateTile);
+	}
+	else
+	{
+		for (int32 Tile = 0; Tile < NumTiles; ++Tile)
+		{
+			SimulateTile(Tile);
+		}
+	}
+
+	// The max snow buffer of the compute shader is not reset between the executions
+	for (uint32 TileMax : TileMaxSnow)
+	{
+		ScaledMaxSnow = FMath::Max(ScaledMaxSnow, TileMax);
+	}
+
+	if (CaptureDebugInformation)
+	{
+		// Fill debug array like the compute shader
+		for (int32 Index = 0; Index < SimulationCells.Num() && Index < DebugCells.Num(); ++Index)
+		{
+			DebugCells[Index].SnowMM = SimulationCells[Index].InterpolatedSWE / (SimulationCells[Index].Area / (100 * 100));
+		}
+	}
+
+	UE_LOG(SimulationLog, Display, TEXT("Iteration %d (%d hours) took %f ms, max snow %f"), CurrentSimulationStep, Timesteps, (FPlatformTime::Seconds() - StartSeconds) * 1000, GetMaxSnow());
+
+	if (!RecordDirectory.IsEmpty())
+	{
+		CompareWithRecord(CurrentSimulationStep);
+	}
+}
+
+void UDegreeDayComputeShaderCPUSimulation::CompareWithRecord(int32 CurrentSimulationStep)
+{
+	const FString FilePath = GetSnowOutputRecordPath(RecordDirectory, CurrentSimulationStep);
+
+	FComputeShaderVariableParameters RecordedVariables;
+	uint32 RecordedMaxSnow;
+	TArray<float> RecordedSnowOutput;
+	if (!LoadSnowOutputRecord(FilePath, RecordedVariables, RecordedMaxSnow, RecordedSnowOutput))
+	{
+		UE_LOG(SimulationLog, Warning, TEXT("No recorded GPU output %s"), *FilePath);
+		return;
+	}
+	if (RecordedSnowOutput.Num() != SnowOutput.Num())
+	{
+		UE_LOG(SimulationLog, Warning, TEXT("Recorded GPU output %s has %d cells instead of %d"), *FilePath, RecordedSnowOutput.Num(), SnowOutput.Num());
+		return;
+	}
+
+	float MaxAbsoluteError;
+	const int32 NumMismatches = FComputeShaderCPUKernel::CompareWithRecord(SnowOutput, ScaledMaxSnow, RecordedSnowOutput, RecordedMaxSnow, RecordTolerance, MaxAbsoluteError);
+	const float MaxSnowError = FMath::Abs(static_cast<float>(ScaledMaxSnow) - static_cast<float>(RecordedMaxSnow)) / FComputeShaderCPUKernel::GetUintFloatScale();
+
+	UE_LOG(SimulationLog, Display, TEXT("Comparison with the GPU output of step %d: max absolute error %f mm, %d mismatches of %d cells and the max snow outside the tolerance of %e, max snow error %f mm"),
+		CurrentSimulationStep, MaxAbsoluteError, NumMismatches, SnowOutput.Num(), RecordTolerance, MaxSnowError);
+	if (NumMismatches > 0)
+	{
+		UE_LOG(SimulationLog, Error, TEXT("The output of step %d differs from the recorded GPU output %s"), CurrentSimulationStep, *FilePath);
+	}
+}
+
+void UDegreeDayComputeShaderCPUSimulation::Initialize(ASnowSimulationActor* SimulationActor, const TArray<FLandscapeCell>& LandscapeCells, float InitialMaxSnow, UWorld* World)
+{
+	CellsDimensionX = SimulationActor->CellsDimensionX;
+	CellsDimensionY = SimulationActor->CellsDimensionY;
+
+	// Create the cells like the GPU simulation
+	SimulationCells.Empty(LandscapeCells.Num());
+	for (const FLandscapeCell& LandscapeCell : LandscapeCells)
+	{
+		SimulationCells.Add(FGPUSimulationCell(LandscapeCell.Aspect, LandscapeCell.Inclination, LandscapeCell.Altitude,
+			LandscapeCell.Latitude, LandscapeCell.Area, LandscapeCell.AreaXY, LandscapeCell.InitialWaterEquivalent));
+	}
+
+	// The weather data of the whole simulation
+	TResourceArray<FClimateData>* ClimateData = SimulationActor->ClimateDataComponent->CreateRawClimateDataResourceArray(SimulationActor->StartTime, SimulationActor->EndTime);
+	WeatherData = TArray<FClimateData>(ClimateData->GetData(), ClimateData->Num());
+	delete ClimateData;
+
+	ConstantParameters = FSimulationComputeShader::CreateConstantParameters(k_e, k_m, TMeltA, TMeltB, TSnowA, TSnowB,
+		CellsDimensionX, CellsDimensionY, SimulationActor->ClimateDataComponent->GetMeasurementAltitude());
+
+	SnowOutput.SetNumZeroed(SimulationCells.Num());
+
+	// The max snow buffer of the compute shader is initialized with the unscaled initial max snow
+	ScaledMaxSnow = static_cast<uint32>(InitialMaxSnow);
+
+	UE_LOG(SimulationLog, Display, TEXT("Compute shader CPU simulation uses %.2f MB for %d cells and %d hours"),
+		(SimulationCells.GetAllocatedSize() + WeatherData.GetAllocatedSize() + SnowOutput.GetAllocatedSize()) / (1024.0f * 1024.0f), SimulationCells.Num(), WeatherData.Num());
+}
+
+UTexture* UDegreeDayComputeShaderCPUSimulation::GetSnowMapTexture()
+{
+	SnowMapTexture = UTexture2D::CreateTransient(CellsDimensionX, CellsDimensionY, EPixelFormat::PF_G16);
+
+	SnowMapTexture->UpdateResource();
+	SnowMapTextureData.Empty(SnowOutput.Num());
+
+	// Snow output divided by the max snow like the pixel shader
+	const float DisplayedMaxSnow = FMath::Max(GetMaxSnow(), KINDA_SMALL_NUMBER);
+	for (int32 Index = 0; Index < SnowOutput.Num(); ++Index)
+	{
+		float Gray = FMath::Clamp(SnowOutput[Index] / DisplayedMaxSnow, 0.0f, 1.0f) * 255;
+		uint8 GrayInt = static_cast<uint8>(Gray);
+		SnowMapTextureData.Add(FColor(GrayInt, GrayInt, GrayInt));
+	}
+
+	FRenderCommandFence UpdateTextureFence;
+
+	UpdateTextureFence.BeginFence();
+
+	UpdateTexture(SnowMapTexture, SnowMapTextureData);
+
+	UpdateTextureFence.Wait();
+
+	return SnowMapTexture;
+}
+
+float UDegreeDayComputeShaderCPUSimulation::GetMaxSnow()
+{
+	return ScaledMaxSnow / FComputeShaderCPUKernel::GetUintFloatScale();
+}
+
+void UDegreeDayComputeShaderCPUSimulation::RenderDebug(UWorld* World, int CellDebugInfoDisplayDistance, EDebugVisualizationType DebugVisualizationType)
+{
+
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "DegreeDay/DegreeDaySimulation.h"
+#include "ComputeShaderCPUKernel.h"
+#include "DegreeDayComputeShaderCPUSimulation.generated.h"
+
+/**
+* Runs the model of the compute shader of UDegreeDayGPUSimulation on the CPU, e.g. on servers without a GPU. The cells,
+* the weather data and the parameters are prepared like for the compute shader, so the snow output and the maximum snow
+* agree with the GPU simulation up to the precision of the transcendental functions.
+*/
+UCLASS(Blueprintable, BlueprintType)
+class SIMULATION_API UDegreeDayComputeShaderCPUSimulation : public UDegreeDaySimulation
+{
+	GENERATED_BODY()
+private:
+	/** The cells in the layout of the compute shader. */
+	TArray<FGPUSimulationCell> SimulationCells;
+
+	/** The weather data of the whole simulation in the layout of the compute shader. */
+	TArray<FClimateData> WeatherData;
+
+	/** The constant parameters of the compute shader. */
+	FComputeShaderConstantParameters ConstantParameters;
+
+	/** The snow amount (mm) of every cell after interpolation, the snow output buffer of the compute shader. */
+	TArray<float> SnowOutput;
+
+	/** The integer-scaled maximum snow, the max snow buffer of the compute shader. */
+	uint32 ScaledMaxSnow;
+
+	/** The integer-scaled maximum snow of every tile of the current time step. */
+	TArray<uint32> TileMaxSnow;
+
+	/** The snow mask used by the landscape material. */
+	UTexture2D* SnowMapTexture;
+
+	/** Color buffer for the snow mask texture. */
+	TArray<FColor> SnowMapTextureData;
+
+	/** Compares the output of the given simulation step with the output recorded by the GPU simulation. */
+	void CompareWithRecord(int32 CurrentSimulationStep);
+
+public:
+	/** Whether the cells are simulated in parallel row tiles on the task graph or serially on the game thread. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance")
+	bool ParallelExecution = true;
+
+	/** Number of cell rows per tile. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance", meta = (ClampMin = "1"))
+	int32 TileRows = 8;
+
+	/**
+	* Directory with the output recorded by the GPU simulation (see UDegreeDayGPUSimulation::RecordDirectory). If set,
+	* the output of every step is compared with the recorded output of the same step.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Debug")
+	FString RecordDirectory;
+
+	/** Relative difference to the recorded output above which a cell or the maximum snow counts as a mismatch, see Simulation.ValidateComputeShaderCPU. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Debug", meta = (ClampMin = "0"))
+	float RecordTolerance = 1e-3f;
+
+	virtual FString GetSimulationName() override final;
+
+	virtual void Simulate(ASnowSimulationActor* SimulationActor, int32 CurrentSimulationStep, int32 Timesteps, bool SaveSnowMap, bool CaptureDebugInformation, TArray<FDebugCell>& DebugCells) override final;
+
+	virtual void Initialize(ASnowSimulationActor* SimulationActor, const TArray<FLandscapeCell>& Cells, float InitialMaxSnow, UWorld* World) override final;
+
+	virtual void RenderDebug(UWorld* World, int CellDebugInfoDisplayDistance, EDebugVisualizationType DebugVisualizationType) override;
+
+	virtual UTexture* GetSnowMapTexture() override final;
+
+	virtual float GetMaxSnow() override final;
+};
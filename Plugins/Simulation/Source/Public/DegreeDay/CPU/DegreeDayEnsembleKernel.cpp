@@ -0,0 +1,180 @@
+#include "Simulation.h"
+#include "DegreeDayEnsembleKernel.h"
+#include "Radiation/SolarRadiation.h"
+
+void FDegreeDayEnsembleMembers::Initialize(const TArray<FDegreeDayParameters>& Parameters)
+{
+	Num = Parameters.Num();
+	Stride = Align(FMath::Max(Num, 1), 4);
+
+	TSnowA.SetNumUninitialized(Stride);
+	TSnowB.SetNumUninitialized(Stride);
+	TMeltA.SetNumUninitialized(Stride);
+	TMeltB.SetNumUninitialized(Stride);
+	k_e.SetNumUninitialized(Stride);
+	InvSnowRange.SetNumUninitialized(Stride);
+	InvMeltRange.SetNumUninitialized(Stride);
+	MeltScale.SetNumUninitialized(Stride);
+	VegetationDensity.SetNumUninitialized(Stride);
+	CanopyInterception.SetNumUninitialized(Stride);
+	SnowfallScale.SetNumUninitialized(Stride);
+
+	MinTMeltA = MAX_FLT;
+	for (int32 Member = 0; Member < Stride; ++Member)
+	{
+		const FDegreeDayParameters& MemberParameters = Num > 0 ? Parameters[FMath::Min(Member, Num - 1)] : FDegreeDayParameters();
+
+		TSnowA[Member] = MemberParameters.TSnowA;
+		TSnowB[Member] = MemberParameters.TSnowB;
+		TMeltA[Member] = MemberParameters.TMeltA;
+		TMeltB[Member] = MemberParameters.TMeltB;
+		k_e[Member] = MemberParameters.k_e;
+		InvSnowRange[Member] = 1.0f / (MemberParameters.TSnowB - MemberParameters.TSnowA);
+		InvMeltRange[Member] = 1.0f / (MemberParameters.TMeltB - MemberParameters.TMeltA);
+		MeltScale[Member] = MemberParameters.k_m * FMath::Exp(-4 * MemberParameters.VegetationDensity) / 24.0f;
+		VegetationDensity[Member] = MemberParameters.VegetationDensity;
+		CanopyInterception[Member] = MemberParameters.CanopyInterception;
+		SnowfallScale[Member] = 1 - MemberParameters.CanopyInterception * MemberParameters.VegetationDensity;
+
+		MinTMeltA = FMath::Min(MinTMeltA, MemberParameters.TMeltA);
+	}
+}
+
+FDegreeDayParameters FDegreeDayEnsembleMembers::GetParameters(int32 Member) const
+{
+	FDegreeDayParameters Parameters;
+	Parameters.TSnowA = TSnowA[Member];
+	Parameters.TSnowB = TSnowB[Member];
+	Parameters.TMeltA = TMeltA[Member];
+	Parameters.TMeltB = TMeltB[Member];
+	Parameters.k_e = k_e[Member];
+	Parameters.k_m = MeltScale[Member] * 24.0f / FMath::Exp(-4 * VegetationDensity[Member]);
+	Parameters.VegetationDensity = VegetationDensity[Member];
+	Parameters.CanopyInterception = CanopyInterception[Member];
+	return Parameters;
+}
+
+void FDegreeDayEnsembleState::Initialize(const FSimulationCellStore& Cells, const FDegreeDayEnsembleMembers& Members)
+{
+	Stride = Members.Stride;
+
+	const int32 NumCells = Cells.Num();
+	SnowWaterEquivalent.SetNumUninitialized(NumCells * Stride);
+	SnowAlbedo.SetNumZeroed(NumCells * Stride);
+	DaysSinceLastSnowfall.SetNumZeroed(NumCells);
+
+	for (int32 Index = 0; Index < NumCells; ++Index)
+	{
+		for (int32 Member = 0; Member < Stride; ++Member)
+		{
+			SnowWaterEquivalent[Index * Stride + Member] = Cells.SnowWaterEquivalent[Index];
+		}
+	}
+}
+
+void FDegreeDayEnsembleKernel::Simulate(FDegreeDayEnsembleState& State, const FDegreeDayEnsembleMembers& Members, const FSimulationCellStore& Cells, int32 BeginIndex, int32 EndIndex,
+	const FDegreeDayForcing& Forcing, const float* RadiationIndex)
+{
+	const int32 Stride = State.Stride;
+
+	const VectorRegister Zero = VectorZero();
+	const VectorRegister One = VectorOne();
+	const VectorRegister RainAlbedo = VectorSetFloat1(0.4f);
+	const VectorRegister NewSnowAlbedo = VectorSetFloat1(0.8f);
+
+	float Lanes[4];
+
+	for (int32 Index = BeginIndex; Index < EndIndex; ++Index)
+	{
+		// Forcing of the cell shared by all members
+		const float Altitude = Cells.Altitude[Index];
+		const float TAir = FDegreeDayCPUKernel::GetAirTemperature(Forcing, Altitude); // degree Celsius
+		const float Precipitation = FDegreeDayCPUKernel::GetPrecipitation(Forcing, Altitude); // l/m^2 or mm
+		const float AreaSquareMeters = Cells.AreaXY[Index] / (100 * 100); // m^2
+
+		float& DaysSinceLastSnowfall = State.DaysSinceLastSnowfall[Index];
+		if (Precipitation > 0)
+		{
+			DaysSinceLastSnowfall = 0;
+		}
+
+		const VectorRegister VectorTAir = VectorSetFloat1(TAir);
+		const VectorRegister VectorPrecipitation = VectorSetFloat1(Precipitation * AreaSquareMeters);
+		const bool Aging = DaysSinceLastSnowfall >= 0;
+		const bool MeltPossible = TAir > Members.MinTMeltA;
+
+		// The radiation index is evaluated once if any member melts
+		float R_i = -1;
+
+		float* SnowWaterEquivalent = State.SnowWaterEquivalent.GetData() + Index * Stride;
+		float* SnowAlbedo = State.SnowAlbedo.GetData() + Index * Stride;
+
+		for (int32 Member = 0; Member < Stride; Member += 4)
+		{
+			VectorRegister MemberSnowWaterEquivalent = VectorLoad(SnowWaterEquivalent + Member);
+			VectorRegister MemberSnowAlbedo = VectorLoad(SnowAlbedo + Member);
+
+			// Apply precipitation
+			if (Precipitation > 0)
+			{
+				const VectorRegister RainMask = VectorCompareGT(VectorTAir, VectorLoad(Members.TSnowB.GetData() + Member));
+				const VectorRegister SnowRate = VectorMin(VectorMax(VectorSubtract(One, VectorMultiply(VectorSubtract(VectorTAir, VectorLoad(Members.TSnowA.GetData() + Member)),
+					VectorLoad(Members.InvSnowRange.GetData() + Member))), Zero), One);
+
+				// The canopy intercepts a part of the snow
+				const VectorRegister Snowfall = VectorMultiply(VectorMultiply(VectorPrecipitation, SnowRate), VectorLoad(Members.SnowfallScale.GetData() + Member));
+				MemberSnowWaterEquivalent = VectorAdd(MemberSnowWaterEquivalent, VectorSelect(RainMask, Zero, Snowfall));
+				MemberSnowAlbedo = VectorSelect(RainMask, RainAlbedo, NewSnowAlbedo);
+			}
+
+			// Apply melt
+			const VectorRegister SnowMask = VectorCompareGT(MemberSnowWaterEquivalent, Zero);
+			const int32 SnowBits = VectorMaskBits(SnowMask);
+
+			if (SnowBits)
+			{
+				// Albedo decay, exp is evaluated per lane
+				if (Aging)
+				{
+					VectorStore(MemberSnowAlbedo, Lanes);
+					for (int32 Lane = 0; Lane < 4; ++Lane)
+					{
+						if (SnowBits & (1 << Lane))
+						{
+							Lanes[Lane] = 0.4 * (1 + FMath::Exp(-Members.k_e[Member + Lane] * DaysSinceLastSnowfall));
+						}
+					}
+					MemberSnowAlbedo = VectorLoad(Lanes);
+				}
+
+				const VectorRegister TMeltA = VectorLoad(Members.TMeltA.GetData() + Member);
+				const VectorRegister MeltMask = VectorBitwiseAnd(SnowMask, VectorCompareGT(VectorTAir, TMeltA));
+
+				if (MeltPossible && VectorMaskBits(MeltMask))
+				{
+					if (R_i < 0)
+					{
+						R_i = Forcing.DiurnalFactor * (RadiationIndex ? RadiationIndex[Index] :
+							FSolarRadiation::SolarRadiationIndex(Cells.Inclination[Index], Cells.Aspect[Index], Cells.Latitude[Index], Forcing.DayOfYear)); // 1
+					}
+
+					// Quadratic melt factor below TMeltB, linear above
+					const VectorRegister DeltaT = VectorSubtract(VectorTAir, TMeltA);
+					const VectorRegister MeltFactor = VectorSelect(VectorCompareGT(VectorLoad(Members.TMeltB.GetData() + Member), VectorTAir),
+						VectorMultiply(VectorMultiply(DeltaT, DeltaT), VectorLoad(Members.InvMeltRange.GetData() + Member)), DeltaT);
+
+					const VectorRegister c_m = VectorMultiply(VectorMultiply(VectorLoad(Members.MeltScale.GetData() + Member), VectorSetFloat1(R_i * AreaSquareMeters)),
+						VectorSubtract(One, MemberSnowAlbedo));
+					const VectorRegister Melt = VectorSelect(MeltMask, VectorMultiply(c_m, MeltFactor), Zero);
+
+					MemberSnowWaterEquivalent = VectorMax(Zero, VectorSubtract(MemberSnowWaterEquivalent, Melt));
+				}
+			}
+
+			VectorStore(MemberSnowWaterEquivalent, SnowWaterEquivalent + Member);
+			VectorStore(MemberSnowAlbedo, SnowAlbedo + Member);
+		}
+
+		DaysSinceLastSnowfall += 1.0f / 24.0f;
+	}
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "DegreeDayCPUKernel.h"
+
+/**
+* Parameters of the members of an ensemble stored as structure of arrays. The number of members is padded to a multiple
+* of four so every group of four members fills a vector, the padding repeats the last member.
+*/
+struct SIMULATION_API FDegreeDayEnsembleMembers
+{
+	/** Number of members. */
+	int32 Num = 0;
+
+	/** Number of members including the padding. */
+	int32 Stride = 0;
+
+	FAlignedFloatArray TSnowA;
+	FAlignedFloatArray TSnowB;
+	FAlignedFloatArray TMeltA;
+	FAlignedFloatArray TMeltB;
+	FAlignedFloatArray k_e;
+
+	/** 1 / (TSnowB - TSnowA) */
+	FAlignedFloatArray InvSnowRange;
+
+	/** 1 / (TMeltB - TMeltA) */
+	FAlignedFloatArray InvMeltRange;
+
+	/** k_m * k_v / 24 with the vegetation factor k_v = exp(-4 * VegetationDensity) */
+	FAlignedFloatArray MeltScale;
+
+	FAlignedFloatArray VegetationDensity;
+
+	FAlignedFloatArray CanopyInterception;
+
+	/** 1 - CanopyInterception * VegetationDensity, the share of the snowfall which is not intercepted by the canopy */
+	FAlignedFloatArray SnowfallScale;
+
+	/** The lowest TMeltA of all members. */
+	float MinTMeltA = 0;
+
+	/** Stores the given parameters. */
+	void Initialize(const TArray<FDegreeDayParameters>& Parameters);
+
+	/** Returns the parameters of the given member. */
+	FDegreeDayParameters GetParameters(int32 Member) const;
+};
+
+/**
+* State of the cells of an ensemble. The state of all members of a cell is stored contiguously, the state of member m of
+* cell i is at i * Stride + m. The days since the last snowfall only depend on the precipitation and are shared.
+*/
+struct SIMULATION_API FDegreeDayEnsembleState
+{
+	/** Number of members including the padding. */
+	int32 Stride = 0;
+
+	/** Snow water equivalent (SWE) as the mass of water stored in liters of every member. */
+	FAlignedFloatArray SnowWaterEquivalent;
+
+	/** The albedo of the snow [0-1.0] of every member. */
+	FAlignedFloatArray SnowAlbedo;
+
+	/** The days since the last snow has fallen on the cell. */
+	FAlignedFloatArray DaysSinceLastSnowfall;
+
+	/** Creates the state of the given members from the initial snow of the cells. */
+	void Initialize(const FSimulationCellStore& Cells, const FDegreeDayEnsembleMembers& Members);
+
+	/** Returns the number of bytes allocated by the state. */
+	SIZE_T GetAllocatedSize() const
+	{
+		return SnowWaterEquivalent.GetAllocatedSize() + SnowAlbedo.GetAllocatedSize() + DaysSinceLastSnowfall.GetAllocatedSize();
+	}
+};
+
+/**
+* Degree day kernel which advances all members of an ensemble by one hour. The forcing, the area and the radiation index
+* of a cell are computed once and shared by all members, four members are processed per vector instruction. The results
+* of a member agree with the scalar kernel within the tolerance of the vector kernel.
+*/
+class SIMULATION_API FDegreeDayEnsembleKernel
+{
+public:
+	/**
+	* Simulates one hour for the cells [BeginIndex, EndIndex).
+	*
+	* @param RadiationIndex	Precomputed radiation index of all cells for the current day or null
+	*/
+	static void Simulate(FDegreeDayEnsembleState& State, const FDegreeDayEnsembleMembers& Members, const FSimulationCellStore& Cells, int32 BeginIndex, int32 EndIndex,
+		const FDegreeDayForcing& Forcing, const float* RadiationIndex);
+};
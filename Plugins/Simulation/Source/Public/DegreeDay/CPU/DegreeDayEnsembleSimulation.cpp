@@ -0,0 +1,196 @@
+#include "Simulation.h"
+#include "DegreeDayEnsembleSimulation.h"
+#include "SnowSimulationActor.h"
+#include "Util/TextureUtil.h"
+#include "ParallelFor.h"
+
+FString UDegreeDayEnsembleSimulation::GetSimulationName()
+{
+	return FString(TEXT("Degree Day CPU Ensemble"));
+}
+
+DECLARE_CYCLE_STAT(TEXT("Degree Day Ensemble Simulate"), STAT_DegreeDayEnsembleSimulate, STATGROUP_SnowSimulation);
+
+void UDegreeDayEnsembleSimulation::Simulate(ASnowSimulationActor* SimulationActor, int32 CurrentSimulationStep, int32 Timesteps, bool SaveSnowMap, bool CaptureDebugInformation, TArray<FDebugCell>& DebugCells)
+{
+	SCOPE_CYCLE_COUNTER(STAT_DegreeDayEnsembleSimulate);
+
+	const double StartSeconds = FPlatformTime::Seconds();
+
+	const int32 NumCells = Cells.Num();
+	const int32 NumHours = FMath::Clamp(ClimateData.Num() - CurrentSimulationStep, 0, Timesteps);
+	const float MeasurementAltitude = SimulationActor->ClimateDataComponent->GetMeasurementAltitude();
+
+	// Forcing of all hours of this step
+	TArray<FDegreeDayForcing> HourForcing;
+	TArray<const float*> HourRadiationIndex;
+	for (int32 Hour = 0; Hour < NumHours; ++Hour)
+	{
+		const FClimateData& HourClimateData = ClimateData.Get(CurrentSimulationStep + Hour);
+		const FDateTime Time = SimulationActor->CurrentSimulationTime + FTimespan(Hour, 0, 0);
+
+		FDegreeDayForcing Forcing;
+		Forcing.Temperature = HourClimateData.Temperature;
+		Forcing.Precipitation = HourClimateData.Precipitation;
+		Forcing.MeasurementAltitude = MeasurementAltitude;
+		Forcing.DayOfYear = Time.GetDayOfYear();
+		HourForcing.Add(Forcing);
+		HourRadiationIndex.Add(RadiationTable.GetDay(Forcing.DayOfYear));
+	}
+
+	// Split the grid into tiles of rows, every tile is advanced through all hours of the step
+	const int32 CellsPerTile = FMath::Max(1, TileRows) * CellsDimensionX;
+	const int32 NumTiles = FMath::DivideAndRoundUp(NumCells, CellsPerTile);
+	TileMaxSnow.SetNumZeroed(NumTiles);
+
+	auto SimulateTile = [&](int32 Tile)
+	{
+		const int32 BeginIndex = Tile * CellsPerTile;
+		const int32 EndIndex = FMath::Min(BeginIndex + CellsPerTile, NumCells);
+
+		for (int32 Hour = 0; Hour < NumHours; ++Hour)
+		{
+			FDegreeDayEnsembleKernel::Simulate(State, EnsembleMembers, Cells, BeginIndex, EndIndex, HourForcing[Hour], HourRadiationIndex[Hour]);
+		}
+
+		TileMaxSnow[Tile] = InterpolateCells(BeginIndex, EndIndex);
+	};
+
+	if (ParallelExecution)
+	{
+		ParallelFor(NumTiles, SimulateTile);
+	}
+	else
+	{
+		for (int32 Tile = 0; Tile < NumTiles; ++Tile)
+		{
+			SimulateTile(Tile);
+		}
+	}
+
+	MaxSnow = 0;
+	for (float TileMax : TileMaxSnow)
+	{
+		MaxSnow = FMath::Max(MaxSnow, TileMax);
+	}
+
+	if (CaptureDebugInformation)
+	{
+		// Fill debug array
+		for (int32 Index = 0; Index < NumCells && Index < DebugCells.Num(); ++Index)
+		{
+			DebugCells[Index].SnowMM = GetDisplayedSnow(Index);
+		}
+	}
+
+	UE_LOG(SimulationLog, Display, TEXT("Iteration %d (%d hours, %d members) took %f ms"), CurrentSimulationStep, NumHours, EnsembleMembers.Num, (FPlatformTime::Seconds() - StartSeconds) * 1000);
+}
+
+float UDegreeDayEnsembleSimulation::InterpolateCells(int32 BeginIndex, int32 EndIndex)
+{
+	const int32 Stride = State.Stride;
+	const int32 NumMembers = EnsembleMembers.Num;
+	const FBloeschlParameters& SimulatedInterpolation = GetSimulatedInterpolation();
+
+	float RangeMaxSnow = 0;
+
+	// Interpolation according to Bloeschls "Distributed Snowmelt Simulations in an Alpine Catchment", the factor is shared by all members
+	for (int32 Index = BeginIndex; Index < EndIndex; ++Index)
+	{
+		const float Factor = SimulatedInterpolation.GetInterpolationFactor(Cells.Inclination[Index], Cells.Curvature[Index]) / (Cells.Area[Index] / (100 * 100));
+
+		float Sum = 0;
+		float SquaredSum = 0;
+		for (int32 Member = 0; Member < NumMembers; ++Member)
+		{
+			const float Snow = FMath::Max(0.0f, State.SnowWaterEquivalent[Index * Stride + Member] * Factor);
+			MemberSnow[Index * Stride + Member] = Snow;
+			Sum += Snow;
+			SquaredSum += Snow * Snow;
+		}
+
+		const float Mean = Sum / NumMembers;
+		MeanSnow[Index] = Mean;
+		SnowSpread[Index] = FMath::Sqrt(FMath::Max(0.0f, SquaredSum / NumMembers - Mean * Mean));
+
+		RangeMaxSnow = FMath::Max(GetDisplayedSnow(Index), RangeMaxSnow);
+	}
+
+	return RangeMaxSnow;
+}
+
+float UDegreeDayEnsembleSimulation::GetDisplayedSnow(int32 Index) const
+{
+	return DisplayedMember >= 0 && DisplayedMember < EnsembleMembers.Num ? GetMemberSnowHeight(DisplayedMember, Index) : GetMeanSnowHeight(Index);
+}
+
+TArray<FDegreeDayParameters> UDegreeDayEnsembleSimulation::GetSimulatedMembers() const
+{
+	return Members;
+}
+
+const FBloeschlParameters& UDegreeDayEnsembleSimulation::GetSimulatedInterpolation() const
+{
+	return Interpolation;
+}
+
+void UDegreeDayEnsembleSimulation::Initialize(ASnowSimulationActor* SimulationActor, const TArray<FLandscapeCell>& LandscapeCells, float InitialMaxSnow, UWorld* World)
+{
+	CellsDimensionX = SimulationActor->CellsDimensionX;
+	CellsDimensionY = SimulationActor->CellsDimensionY;
+
+	ClimateData = SimulationActor->ClimateDataComponent->GetClimateDataView();
+
+	Cells.Initialize(LandscapeCells, CellsDimensionX, CellsDimensionY);
+
+	// An empty ensemble runs the default parameters
+	const TArray<FDegreeDayParameters> SimulatedMembers = GetSimulatedMembers();
+	EnsembleMembers.Initialize(SimulatedMembers.Num() > 0 ? SimulatedMembers : TArray<FDegreeDayParameters>({ FDegreeDayParameters() }));
+	State.Initialize(Cells, EnsembleMembers);
+	MaxSnow = InitialMaxSnow;
+
+	MemberSnow.SetNumZeroed(State.SnowWaterEquivalent.Num());
+	MeanSnow.SetNumZeroed(Cells.Num());
+	SnowSpread.SetNumZeroed(Cells.Num());
+
+	RadiationTable.Build(Cells, 1);
+
+	UE_LOG(SimulationLog, Display, TEXT("Ensemble of %d members uses %.2f MB for %d cells, radiation table took %f ms to build"), EnsembleMembers.Num,
+		(Cells.GetAllocatedSize() + State.GetAllocatedSize() + MemberSnow.GetAllocatedSize() + MeanSnow.GetAllocatedSize() + SnowSpread.GetAllocatedSize()
+			+ RadiationTable.GetAllocatedSize()) / (1024.0f * 1024.0f), Cells.Num(), RadiationTable.GetBuildSeconds() * 1000);
+}
+
+UTexture* UDegreeDayEnsembleSimulation::GetSnowMapTexture()
+{
+	SnowMapTexture = UTexture2D::CreateTransient(CellsDimensionX, CellsDimensionY, EPixelFormat::PF_G16);
+
+	SnowMapTexture->UpdateResource();
+	SnowMapTextureData.Empty(Cells.Num());
+
+	for (int32 Index = 0; Index < Cells.Num(); ++Index)
+	{
+		float Gray = GetDisplayedSnow(Index) / GetMaxSnow() * 255;
+		uint8 GrayInt = static_cast<uint8>(Gray);
+		SnowMapTextureData.Add(FColor(GrayInt, GrayInt, GrayInt));
+	}
+
+	FRenderCommandFence UpdateTextureFence;
+
+	UpdateTextureFence.BeginFence();
+
+	UpdateTexture(SnowMapTexture, SnowMapTextureData);
+
+	UpdateTextureFence.Wait();
+
+	return SnowMapTexture;
+}
+
+float UDegreeDayEnsembleSimulation::GetMaxSnow()
+{
+	return MaxSnow;
+}
+
+void UDegreeDayEnsembleSimulation::RenderDebug(UWorld* World, int CellDebugInfoDisplayDistance, EDebugVisualizationType DebugVisualizationType)
+{
+
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "DegreeDay/DegreeDaySimulation.h"
+#include "Cells/SimulationCellStore.h"
+#include "DegreeDayEnsembleKernel.h"
+#include "ClimateData.h"
+#include "Radiation/SolarRadiationTable.h"
+#include "DegreeDayEnsembleSimulation.generated.h"
+
+/**
+* Runs the degree day simulation for several parameter sets in one pass over the cells. The terrain, the radiation index
+* and the forcing are shared by all members. Besides the snow of every member the mean and the standard deviation of the
+* snow over all members are available.
+*/
+UCLASS(Blueprintable, BlueprintType)
+class SIMULATION_API UDegreeDayEnsembleSimulation : public USimulationBase
+{
+	GENERATED_BODY()
+private:
+	/** The cells this simulation uses, the state of the cells is not used. */
+	FSimulationCellStore Cells;
+
+	/** The weather data of the provider. */
+	FClimateDataView ClimateData;
+
+	/** The parameters of the members. */
+	FDegreeDayEnsembleMembers EnsembleMembers;
+
+	/** The state of all members. */
+	FDegreeDayEnsembleState State;
+
+	/** The snow (mm) after interpolation of every member, stored like the state. */
+	FAlignedFloatArray MemberSnow;
+
+	/** The mean snow (mm) over all members. */
+	FAlignedFloatArray MeanSnow;
+
+	/** The standard deviation of the snow (mm) over all members. */
+	FAlignedFloatArray SnowSpread;
+
+	/** Precomputed solar radiation index of the cells. */
+	FSolarRadiationTable RadiationTable;
+
+	/** The snow mask used by the landscape material. */
+	UTexture2D* SnowMapTexture;
+
+	/** Color buffer for the snow mask texture. */
+	TArray<FColor> SnowMapTextureData;
+
+	/** The maximum snow amount (mm) of the displayed member of the current time step. */
+	float MaxSnow;
+
+	/** The maximum snow amount (mm) of the displayed member of every tile of the current time step. */
+	TArray<float> TileMaxSnow;
+
+	/** Interpolates the snow of all members of the cells in the range [BeginIndex, EndIndex) and returns the maximum displayed snow amount (mm) of the range. */
+	float InterpolateCells(int32 BeginIndex, int32 EndIndex);
+
+	/** Returns the displayed snow amount (mm) of the given cell. */
+	float GetDisplayedSnow(int32 Index) const;
+
+protected:
+	/** Returns the parameters of the simulated members, the Members property by default. */
+	virtual TArray<FDegreeDayParameters> GetSimulatedMembers() const;
+
+	/** Returns the simulated interpolation, the Interpolation property by default. */
+	virtual const FBloeschlParameters& GetSimulatedInterpolation() const;
+
+public:
+	/** The parameters of the members of the ensemble. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation")
+	TArray<FDegreeDayParameters> Members;
+
+	/** Parameters of the interpolation of the snow shared by all members. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation")
+	FBloeschlParameters Interpolation;
+
+	/** The member whose snow is shown on the landscape, -1 shows the mean over all members. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation", meta = (ClampMin = "-1"))
+	int32 DisplayedMember = -1;
+
+	/** Whether the cells are simulated in parallel row tiles on the task graph or serially on the game thread. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance")
+	bool ParallelExecution = true;
+
+	/** Number of cell rows per tile. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance", meta = (ClampMin = "1"))
+	int32 TileRows = 8;
+
+	/** Returns the number of members. */
+	int32 GetNumMembers() const
+	{
+		return EnsembleMembers.Num;
+	}
+
+	/** Returns the snow amount (mm) of the given member and cell after interpolation. */
+	float GetMemberSnowHeight(int32 Member, int32 Index) const
+	{
+		return MemberSnow[Index * State.Stride + Member];
+	}
+
+	/** Returns the mean snow amount (mm) over all members of the given cell. */
+	float GetMeanSnowHeight(int32 Index) const
+	{
+		return MeanSnow[Index];
+	}
+
+	/** Returns the standard deviation of the snow amount (mm) over all members of the given cell. */
+	float GetSnowHeightSpread(int32 Index) const
+	{
+		return SnowSpread[Index];
+	}
+
+	virtual FString GetSimulationName() override;
+
+	virtual void Simulate(ASnowSimulationActor* SimulationActor, int32 CurrentSimulationStep, int32 Timesteps, bool SaveSnowMap, bool CaptureDebugInformation, TArray<FDebugCell>& DebugCells) override final;
+
+	virtual void Initialize(ASnowSimulationActor* SimulationActor, const TArray<FLandscapeCell>& Cells, float InitialMaxSnow, UWorld* World) override;
+
+	virtual void RenderDebug(UWorld* World, int CellDebugInfoDisplayDistance, EDebugVisualizationType DebugVisualizationType) override;
+
+	virtual UTexture* GetSnowMapTexture() override final;
+
+	virtual float GetMaxSnow() override final;
+};
@@ -0,0 +1,205 @@
+#include "Simulation.h"
+#include "DegreeDayMultiResolutionCPUSimulation.h"
+#include "SnowSimulationActor.h"
+#include "Util/TextureUtil.h"
+
+FString UDegreeDayMultiResolutionCPUSimulation::GetSimulationName()
+{
+	return FString(TEXT("Degree Day CPU Multi Resolution"));
+}
+
+DECLARE_CYCLE_STAT(TEXT("Degree Day Multi Resolution CPU Simulate"), STAT_DegreeDayMultiResolutionCPUSimulate, STATGROUP_SnowSimulation);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Degree Day Multi Resolution CPU Simulated Cells"), STAT_DegreeDayMultiResolutionCPUSimulatedCells, STATGROUP_SnowSimulation);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Degree Day Multi Resolution CPU Updated Tiles"), STAT_DegreeDayMultiResolutionCPUUpdatedTiles, STATGROUP_SnowSimulation);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Degree Day Multi Resolution CPU Waiting Tiles"), STAT_DegreeDayMultiResolutionCPUWaitingTiles, STATGROUP_SnowSimulation);
+
+void UDegreeDayMultiResolutionCPUSimulation::Simulate(ASnowSimulationActor* SimulationActor, int32 CurrentSimulationStep, int32 Timesteps, bool SaveSnowMap, bool CaptureDebugInformation, TArray<FDebugCell>& DebugCells)
+{
+	SCOPE_CYCLE_COUNTER(STAT_DegreeDayMultiResolutionCPUSimulate);
+
+	const double StartSeconds = FPlatformTime::Seconds();
+
+	const int32 NumHours = FMath::Clamp(ClimateData.Num() - CurrentSimulationStep, 0, Timesteps);
+	const FDegreeDayParameters Parameters = GetParameters();
+	const float MeasurementAltitude = SimulationActor->ClimateDataComponent->GetMeasurementAltitude();
+
+	if (NumHours == 0) return;
+
+	// The interpolation factors of the level 0 cells and the melt coefficients of all levels depend on the parameters
+	if (!(InterpolationFactorParameters == Interpolation))
+	{
+		FSimulationCellStore& BaseCells = Grid.GetLevelCells(0);
+		for (int32 Index = 0; Index < BaseCells.Num(); ++Index)
+		{
+			BaseCells.InterpolationFactor[Index] = Interpolation.GetInterpolationFactor(BaseCells.Inclination[Index], BaseCells.Curvature[Index]);
+		}
+		Grid.UpdateMaxInterpolationFactors();
+		InterpolationFactorParameters = Interpolation;
+	}
+
+	if (MeltCoefficientParameters.k_m != Parameters.k_m || MeltCoefficientParameters.VegetationDensity != Parameters.VegetationDensity
+		|| MeltCoefficientParameters.CanopyInterception != Parameters.CanopyInterception)
+	{
+		UpdateMeltCoefficients(Parameters);
+	}
+
+	// Move the snow of the tiles whose distance ring changed
+	const int32 NumChangedTiles = UpdateLevels(SimulationActor->GetWorld());
+	const double TransferSeconds = FPlatformTime::Seconds() - StartSeconds;
+
+	// The distant tiles are only due in some hours, the tiles which came closer catch up with the hours they skipped
+	const int32 EndHour = CurrentSimulationStep + NumHours;
+	const int32 FirstHour = Scheduler.Schedule(Grid, CameraLocation, CurrentSimulationStep, EndHour, GetTemporalSettings());
+
+	// Forcing of all hours which are needed by the scheduled tiles
+	TArray<FDegreeDayForcing> HourForcing;
+	for (int32 Hour = FirstHour; Hour < EndHour; ++Hour)
+	{
+		const FClimateData& HourClimateData = ClimateData.Get(Hour);
+		const FDateTime Time = SimulationActor->CurrentSimulationTime + FTimespan(Hour - CurrentSimulationStep, 0, 0);
+
+		FDegreeDayForcing Forcing;
+		Forcing.Temperature = HourClimateData.Temperature;
+		Forcing.Precipitation = HourClimateData.Precipitation;
+		Forcing.MeasurementAltitude = MeasurementAltitude;
+		Forcing.DayOfYear = Time.GetDayOfYear();
+		HourForcing.Add(Forcing);
+	}
+
+	// The snow is interpolated when the snow map is read, so the kernels never interpolate
+	FDegreeDayKernelFeatures Features;
+	Features.DiurnalRadiation = false;
+	Features.Vegetation = false; // Folded into the melt coefficients of the cells
+	Features.Interpolation = false;
+	Features.QuadraticMelt = Parameters.TMeltB > Parameters.TMeltA;
+	const FDegreeDayKernelFunction Kernel = UseVectorKernel ? FDegreeDayCPUKernel::GetVectorKernel(Features) : FDegreeDayCPUKernel::GetScalarKernel(Features);
+
+	const int32 MaxWorkers = NumWorkers > 0 ? NumWorkers : FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+	Scheduler.Advance(Grid, HourForcing, FirstHour, Parameters, Kernel, ParallelExecution ? MaxWorkers : 1);
+
+	MaxSnow = Scheduler.GetMaxSnow();
+
+	const int32 NumSimulatedCells = Grid.GetNumSimulatedCells();
+	SET_DWORD_STAT(STAT_DegreeDayMultiResolutionCPUSimulatedCells, NumSimulatedCells);
+	SET_DWORD_STAT(STAT_DegreeDayMultiResolutionCPUUpdatedTiles, Scheduler.GetNumScheduledTiles());
+	SET_DWORD_STAT(STAT_DegreeDayMultiResolutionCPUWaitingTiles, Scheduler.GetNumWaitingTiles());
+
+	if (CaptureDebugInformation)
+	{
+		// Fill debug array
+		for (int32 Index = 0; Index < Grid.GetLevelCells(0).Num() && Index < DebugCells.Num(); ++Index)
+		{
+			DebugCells[Index].SnowMM = Grid.GetInterpolatedSnowHeight(Index);
+		}
+	}
+
+	UE_LOG(SimulationLog, Display, TEXT("Iteration %d (%d hours) took %f ms, %d of %d cells simulated, %d tiles changed their level in %f ms"), CurrentSimulationStep, NumHours,
+		(FPlatformTime::Seconds() - StartSeconds) * 1000, NumSimulatedCells, Grid.GetLevelCells(0).Num(), NumChangedTiles, TransferSeconds * 1000);
+	UE_LOG(SimulationLog, Display, TEXT("Iteration %d: %d of %d tiles updated (%lld cell hours), %d tiles caught up, %d tiles wait for their catch up"), CurrentSimulationStep,
+		Scheduler.GetNumScheduledTiles(), Grid.GetNumTiles(), Scheduler.GetNumCellUpdates(), Scheduler.GetNumCatchUpTiles(), Scheduler.GetNumWaitingTiles());
+}
+
+int32 UDegreeDayMultiResolutionCPUSimulation::UpdateLevels(UWorld* World)
+{
+	// The tiles keep their levels if there is no camera
+	APlayerController* PlayerController = World ? World->GetFirstPlayerController() : nullptr;
+	if (!PlayerController || !PlayerController->PlayerCameraManager)
+	{
+		return 0;
+	}
+
+	CameraLocation = PlayerController->PlayerCameraManager->GetCameraLocation();
+	HasCameraLocation = true;
+
+	return Grid.UpdateLevels(CameraLocation, FineRadius * 100, LevelHysteresis);
+}
+
+FTemporalTileSettings UDegreeDayMultiResolutionCPUSimulation::GetTemporalSettings() const
+{
+	FTemporalTileSettings Settings;
+	Settings.HourlyRadius = HourlyRadius * 100;
+	Settings.MaxUpdateInterval = HasCameraLocation ? MaxUpdateInterval : 1;
+	Settings.MaxCatchUpTiles = MaxCatchUpTilesPerStep;
+	return Settings;
+}
+
+void UDegreeDayMultiResolutionCPUSimulation::UpdateMeltCoefficients(const FDegreeDayParameters& Parameters)
+{
+	for (int32 Level = 0; Level < Grid.GetNumLevels(); ++Level)
+	{
+		FDegreeDayCPUKernel::UpdateMeltCoefficients(Grid.GetLevelCells(Level), Parameters);
+	}
+	MeltCoefficientParameters = Parameters;
+}
+
+void UDegreeDayMultiResolutionCPUSimulation::Initialize(ASnowSimulationActor* SimulationActor, const TArray<FLandscapeCell>& LandscapeCells, float InitialMaxSnow, UWorld* World)
+{
+	CellsDimensionX = SimulationActor->CellsDimensionX;
+	CellsDimensionY = SimulationActor->CellsDimensionY;
+
+	// The weather data is owned by the provider and does not change during the simulation
+	ClimateData = SimulationActor->ClimateDataComponent->GetClimateDataView();
+
+	const double StartSeconds = FPlatformTime::Seconds();
+
+	Grid.Initialize(LandscapeCells, CellsDimensionX, CellsDimensionY, NumLevels);
+
+	FSimulationCellStore& BaseCells = Grid.GetLevelCells(0);
+	for (int32 Index = 0; Index < BaseCells.Num(); ++Index)
+	{
+		BaseCells.InterpolationFactor[Index] = Interpolation.GetInterpolationFactor(BaseCells.Inclination[Index], BaseCells.Curvature[Index]);
+	}
+	Grid.UpdateMaxInterpolationFactors();
+	InterpolationFactorParameters = Interpolation;
+
+	UpdateMeltCoefficients(GetParameters());
+
+	// All tiles start at the coarsest level and are refined around the camera
+	CameraLocation = FVector::ZeroVector;
+	HasCameraLocation = false;
+	UpdateLevels(World);
+
+	Scheduler.Initialize(Grid, AltitudeBandWidth * 100);
+	MaxSnow = FMath::Max(InitialMaxSnow, Scheduler.GetMaxSnow());
+
+	UE_LOG(SimulationLog, Display, TEXT("Multi resolution grid took %f ms to build and uses %.2f MB for %d levels of %d cells, %d tiles, %d cells simulated"),
+		(FPlatformTime::Seconds() - StartSeconds) * 1000, Grid.GetAllocatedSize() / (1024.0f * 1024.0f), Grid.GetNumLevels(), BaseCells.Num(), Grid.GetNumTiles(), Grid.GetNumSimulatedCells());
+}
+
+UTexture* UDegreeDayMultiResolutionCPUSimulation::GetSnowMapTexture()
+{
+	const int32 NumCells = Grid.GetLevelCells(0).Num();
+
+	SnowMapTexture = UTexture2D::CreateTransient(CellsDimensionX, CellsDimensionY, EPixelFormat::PF_G16);
+
+	SnowMapTexture->UpdateResource();
+	SnowMapTextureData.Empty(NumCells);
+
+	// The coarse tiles are rendered from the cells of their level, they are never reconstructed to level 0
+	for (int32 Index = 0; Index < NumCells; ++Index)
+	{
+		float Gray = Grid.GetInterpolatedSnowHeight(Index) / GetMaxSnow() * 255;
+		uint8 GrayInt = static_cast<uint8>(Gray);
+		SnowMapTextureData.Add(FColor(GrayInt, GrayInt, GrayInt));
+	}
+
+	FRenderCommandFence UpdateTextureFence;
+
+	UpdateTextureFence.BeginFence();
+
+	UpdateTexture(SnowMapTexture, SnowMapTextureData);
+
+	UpdateTextureFence.Wait();
+
+	return SnowMapTexture;
+}
+
+float UDegreeDayMultiResolutionCPUSimulation::GetMaxSnow()
+{
+	return MaxSnow;
+}
+
+void UDegreeDayMultiResolutionCPUSimulation::RenderDebug(UWorld* World, int CellDebugInfoDisplayDistance, EDebugVisualizationType DebugVisualizationType)
+{
+
+}
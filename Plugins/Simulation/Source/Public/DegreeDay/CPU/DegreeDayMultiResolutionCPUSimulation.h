@@ -0,0 +1,119 @@
+#pragma once
+
+#include "DegreeDay/DegreeDaySimulation.h"
+#include "Cells/MultiResolutionGrid.h"
+#include "DegreeDayCPUKernel.h"
+#include "TemporalTileScheduler.h"
+#include "ClimateData.h"
+#include "DegreeDayMultiResolutionCPUSimulation.generated.h"
+
+/**
+* Degree day simulation with a fine grid around the camera and coarser grids farther away, see FMultiResolutionGrid.
+* Every tile of the grid is simulated at the level of its distance ring from the camera. The rings around the camera
+* cost about the same number of cells each, the far field beyond them costs one cell per tile, so a landscape which is 50
+* times larger costs only a small multiple of the cells. The snow of a tile moves to its new level when the
+* camera moves. The tiles are not reconstructed to the full grid after a step, the snow map reads every grid cell from
+* the cell of the level of its tile, so a step costs the simulated cells and only the snow map costs the grid cells.
+*
+* The tiles beyond the hourly radius are also advanced less often with the forcing accumulated over the skipped hours,
+* see FTemporalTileScheduler, and catch up hour by hour when they come closer.
+* Simulation.BenchmarkMultiResolution reports the simulated cells and step times for growing landscapes,
+* Simulation.BenchmarkTemporalLOD the saved work and the error of the accumulated forcing.
+*/
+UCLASS(Blueprintable, BlueprintType)
+class SIMULATION_API UDegreeDayMultiResolutionCPUSimulation : public UDegreeDaySimulation
+{
+	GENERATED_BODY()
+private:
+	/** The cells at all levels. */
+	FMultiResolutionGrid Grid;
+
+	/** The weather data of the provider. */
+	FClimateDataView ClimateData;
+
+	/** The snow mask used by the landscape material. */
+	UTexture2D* SnowMapTexture;
+
+	/** Color buffer for the snow mask texture. */
+	TArray<FColor> SnowMapTextureData;
+
+	/** The maximum snow amount (mm) of the current time step. */
+	float MaxSnow;
+
+	/** Selects the tiles which are advanced in every time step. */
+	FTemporalTileScheduler Scheduler;
+
+	/** The location of the camera when the levels were last updated. */
+	FVector CameraLocation = FVector::ZeroVector;
+
+	/** Whether there has been a camera, all tiles are advanced every hour otherwise. */
+	bool HasCameraLocation = false;
+
+	/** The interpolation parameters of the interpolation factors of the level 0 cells. */
+	FBloeschlParameters InterpolationFactorParameters;
+
+	/** The parameters of the melt coefficients of the cells of all levels. */
+	FDegreeDayParameters MeltCoefficientParameters;
+
+	/** Computes the melt coefficients of the cells of all levels for the given parameters. */
+	void UpdateMeltCoefficients(const FDegreeDayParameters& Parameters);
+
+	/** Moves the tiles to the levels of their distance from the camera, returns the number of tiles which changed their level. */
+	int32 UpdateLevels(UWorld* World);
+
+	/** Returns the settings of the temporal level of detail. */
+	FTemporalTileSettings GetTemporalSettings() const;
+
+public:
+	/** Number of levels, a tile covers 2^(NumLevels - 1) x 2^(NumLevels - 1) cells and is simulated with 1 to 4^(NumLevels - 1) cells. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance", meta = (ClampMin = "1", ClampMax = "8"))
+	int32 NumLevels = 5;
+
+	/** Distance from the camera in m within which the tiles are simulated on the grid, the radius of every coarser level doubles. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance", meta = (ClampMin = "1"))
+	float FineRadius = 1000;
+
+	/** Fraction of the radius of a level by which a tile has to be farther away before it moves to the coarser level. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance", meta = (ClampMin = "0"))
+	float LevelHysteresis = 0.1f;
+
+	/** Distance from the camera in m within which the tiles are advanced every hour, the update interval doubles with every doubling of the distance. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance", meta = (ClampMin = "0"))
+	float HourlyRadius = 2000;
+
+	/** Maximum number of hours between two updates of a distant tile, rounded down to a power of two. One advances all tiles every hour. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance", meta = (ClampMin = "1", ClampMax = "64"))
+	int32 MaxUpdateInterval = 8;
+
+	/** Maximum number of tiles which catch up with the skipped hours in a single time step, 0 does not limit the catch up. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance", meta = (ClampMin = "0"))
+	int32 MaxCatchUpTilesPerStep = 16;
+
+	/** Width of the altitude bands of the accumulated forcing of the distant tiles in m. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance", meta = (ClampMin = "0.1"))
+	float AltitudeBandWidth = 10;
+
+	/** Whether the tiles are simulated in parallel on the task graph or serially on the game thread. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance")
+	bool ParallelExecution = true;
+
+	/** Maximum number of tasks which simulate tiles in parallel, 0 uses all worker threads. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance", meta = (ClampMin = "0"))
+	int32 NumWorkers = 0;
+
+	/** Whether the vectorized kernel is used, the scalar kernel is used otherwise. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance")
+	bool UseVectorKernel = true;
+
+	virtual FString GetSimulationName() override final;
+
+	virtual void Simulate(ASnowSimulationActor* SimulationActor, int32 CurrentSimulationStep, int32 Timesteps, bool SaveSnowMap, bool CaptureDebugInformation, TArray<FDebugCell>& DebugCells) override final;
+
+	virtual void Initialize(ASnowSimulationActor* SimulationActor, const TArray<FLandscapeCell>& Cells, float InitialMaxSnow, UWorld* World) override final;
+
+	virtual void RenderDebug(UWorld* World, int CellDebugInfoDisplayDistance, EDebugVisualizationType DebugVisualizationType) override;
+
+	virtual UTexture* GetSnowMapTexture() override final;
+
+	virtual float GetMaxSnow() override final;
+};
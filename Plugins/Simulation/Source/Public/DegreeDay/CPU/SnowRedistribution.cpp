@@ -0,0 +1,238 @@
+#include "Simulation.h"
+#include "SnowRedistribution.h"
+#include "ParallelFor.h"
+
+DECLARE_CYCLE_STAT(TEXT("Snow Redistribution"), STAT_SnowRedistribution, STATGROUP_SnowSimulation);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Snow Redistribution Iterations"), STAT_SnowRedistributionIterations, STATGROUP_SnowSimulation);
+
+static const int32 NumNeighbours = static_cast<int32>(ENeighbour::Num);
+
+void FSnowRedistribution::Initialize(const FSimulationCellStore& Cells)
+{
+	NumCells = Cells.Num();
+
+	// No snow flows into the border
+	Altitude.Initialize(Cells.DimensionX, Cells.DimensionY, MAX_FLT);
+	Area.Initialize(Cells.DimensionX, Cells.DimensionY, 0.0f);
+	Snow.Initialize(Cells.DimensionX, Cells.DimensionY, 0.0f);
+	Surface.Initialize(Cells.DimensionX, Cells.DimensionY, MAX_FLT);
+	for (int32 Direction = 0; Direction < NumNeighbours; ++Direction)
+	{
+		Outflow[Direction].Initialize(Cells.DimensionX, Cells.DimensionY, 0.0f);
+	}
+
+	Altitude.CopyInterior(Cells.Altitude, [](float CellAltitude) { return CellAltitude; });
+	Area.CopyInterior(Cells.Area, [](float CellArea) { return CellArea / (100 * 100); });
+
+	// The cells form a regular grid
+	double SumCellSize = 0;
+	for (int32 Index = 0; Index < NumCells; ++Index)
+	{
+		SumCellSize += FMath::Sqrt(Cells.AreaXY[Index]);
+	}
+	const float CellSize = NumCells > 0 ? static_cast<float>(SumCellSize / NumCells) : 0.0f;
+
+	for (int32 Direction = 0; Direction < NumNeighbours; ++Direction)
+	{
+		// Odd directions are the diagonals
+		NeighbourDistance[Direction] = (Direction % 2 == 1) ? CellSize * FMath::Sqrt(2.0f) : CellSize;
+	}
+
+	MovedSnow = 0;
+}
+
+void FSnowRedistribution::Reset()
+{
+	Altitude = THaloGrid<float>();
+	Area = THaloGrid<float>();
+	Snow = THaloGrid<float>();
+	Surface = THaloGrid<float>();
+	for (int32 Direction = 0; Direction < NumNeighbours; ++Direction)
+	{
+		Outflow[Direction] = THaloGrid<float>();
+	}
+	NumCells = 0;
+	MovedSnow = 0;
+}
+
+int32 FSnowRedistribution::Redistribute(FSimulationCellStore& Cells, const FSnowRedistributionParameters& Parameters, bool ParallelExecution, int32 RowsPerTask)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SnowRedistribution);
+
+	check(IsInitialized(Cells));
+
+	const int32 DimensionX = Cells.DimensionX;
+	const int32 DimensionY = Cells.DimensionY;
+	const int32 RowsPerChunk = FMath::Max(1, RowsPerTask);
+	const int32 NumChunks = FMath::DivideAndRoundUp(DimensionY, RowsPerChunk);
+
+	// Height of the snow surface in cm per mm snow water equivalent
+	const float SurfacePerSnowHeight = 100.0f / Parameters.SnowDensity;
+	const float SnowHeightPerSurface = Parameters.SnowDensity / 100.0f;
+	const float TanThreshold = FMath::Tan(FMath::DegreesToRadians(Parameters.SlopeThreshold));
+
+	float StableDrop[NumNeighbours];
+	int32 Offsets[NumNeighbours];
+	for (int32 Direction = 0; Direction < NumNeighbours; ++Direction)
+	{
+		StableDrop[Direction] = NeighbourDistance[Direction] * TanThreshold;
+		Offsets[Direction] = Surface.GetNeighbourOffset(static_cast<ENeighbour>(Direction));
+	}
+
+	TArray<double> ChunkSnow;
+	ChunkSnow.SetNumZeroed(NumChunks);
+
+	auto ForEachChunk = [&](TFunctionRef<void(int32, int32, int32)> Function)
+	{
+		auto ProcessChunk = [&](int32 Chunk)
+		{
+			Function(Chunk, Chunk * RowsPerChunk, FMath::Min((Chunk + 1) * RowsPerChunk, DimensionY));
+		};
+
+		if (ParallelExecution)
+		{
+			ParallelFor(NumChunks, ProcessChunk);
+		}
+		else
+		{
+			for (int32 Chunk = 0; Chunk < NumChunks; ++Chunk)
+			{
+				ProcessChunk(Chunk);
+			}
+		}
+	};
+
+	// Copy the snow into the grid and compute the snow surface
+	ForEachChunk([&](int32 Chunk, int32 BeginRow, int32 EndRow)
+	{
+		double Sum = 0;
+		for (int32 Y = BeginRow; Y < EndRow; ++Y)
+		{
+			const int32 RowIndex = Snow.GetIndex(0, Y);
+			for (int32 X = 0; X < DimensionX; ++X)
+			{
+				const int32 Index = RowIndex + X;
+				const float CellSnow = Cells.SnowWaterEquivalent[X + Y * DimensionX];
+				Snow[Index] = CellSnow;
+				Surface[Index] = Altitude[Index] + CellSnow / Area[Index] * SurfacePerSnowHeight;
+				Sum += CellSnow;
+			}
+		}
+		ChunkSnow[Chunk] = Sum;
+	});
+
+	// The partial sums are merged in a fixed order
+	double TotalSnow = 0;
+	for (double Sum : ChunkSnow)
+	{
+		TotalSnow += Sum;
+	}
+
+	MovedSnow = 0;
+	int32 Iteration = 0;
+
+	while (Iteration < Parameters.MaxIterations && TotalSnow > 0)
+	{
+		// Outflow of every cell from the snow surface of the previous iteration
+		ForEachChunk([&](int32 Chunk, int32 BeginRow, int32 EndRow)
+		{
+			double Sum = 0;
+			for (int32 Y = BeginRow; Y < EndRow; ++Y)
+			{
+				const int32 RowIndex = Surface.GetIndex(0, Y);
+				for (int32 X = 0; X < DimensionX; ++X)
+				{
+					const int32 Index = RowIndex + X;
+					const float CellSurface = Surface[Index];
+
+					float Excess[NumNeighbours];
+					float SumExcess = 0;
+					float MaxExcess = 0;
+					for (int32 Direction = 0; Direction < NumNeighbours; ++Direction)
+					{
+						Excess[Direction] = FMath::Max(0.0f, CellSurface - Surface[Index + Offsets[Direction]] - StableDrop[Direction]);
+						SumExcess += Excess[Direction];
+						MaxExcess = FMath::Max(MaxExcess, Excess[Direction]);
+					}
+
+					// Lowering the cell by half the largest excess levels it with its lowest neighbour
+					const float SnowDepth = Snow[Index] / Area[Index] * SurfacePerSnowHeight;
+					const float CellOutflow = FMath::Min(MaxExcess / 2, SnowDepth) * SnowHeightPerSurface * Area[Index];
+					const float Scale = SumExcess > 0 ? CellOutflow / SumExcess : 0.0f;
+
+					for (int32 Direction = 0; Direction < NumNeighbours; ++Direction)
+					{
+						Outflow[Direction][Index] = Excess[Direction] * Scale;
+					}
+					Sum += CellOutflow;
+				}
+			}
+			ChunkSnow[Chunk] = Sum;
+		});
+
+		// Apply the outflow and gather the inflow from the neighbours
+		ForEachChunk([&](int32 Chunk, int32 BeginRow, int32 EndRow)
+		{
+			for (int32 Y = BeginRow; Y < EndRow; ++Y)
+			{
+				const int32 RowIndex = Snow.GetIndex(0, Y);
+				for (int32 X = 0; X < DimensionX; ++X)
+				{
+					const int32 Index = RowIndex + X;
+
+					float Flow = 0;
+					for (int32 Direction = 0; Direction < NumNeighbours; ++Direction)
+					{
+						// The neighbour in this direction sends its snow in the opposite direction
+						Flow += Outflow[(Direction + NumNeighbours / 2) % NumNeighbours][Index + Offsets[Direction]] - Outflow[Direction][Index];
+					}
+
+					const float CellSnow = FMath::Max(0.0f, Snow[Index] + Flow);
+					Snow[Index] = CellSnow;
+					Surface[Index] = Altitude[Index] + CellSnow / Area[Index] * SurfacePerSnowHeight;
+				}
+			}
+		});
+
+		double IterationMovedSnow = 0;
+		for (double Sum : ChunkSnow)
+		{
+			IterationMovedSnow += Sum;
+		}
+
+		MovedSnow += IterationMovedSnow;
+		Iteration++;
+
+		if (IterationMovedSnow < Parameters.Tolerance * TotalSnow) break;
+	}
+
+	// Copy the snow back into the cells
+	if (MovedSnow > 0)
+	{
+		ForEachChunk([&](int32 Chunk, int32 BeginRow, int32 EndRow)
+		{
+			for (int32 Y = BeginRow; Y < EndRow; ++Y)
+			{
+				const int32 RowIndex = Snow.GetIndex(0, Y);
+				for (int32 X = 0; X < DimensionX; ++X)
+				{
+					Cells.SnowWaterEquivalent[X + Y * DimensionX] = Snow[RowIndex + X];
+				}
+			}
+		});
+	}
+
+	SET_DWORD_STAT(STAT_SnowRedistributionIterations, Iteration);
+
+	return Iteration;
+}
+
+SIZE_T FSnowRedistribution::GetAllocatedSize() const
+{
+	SIZE_T Size = Altitude.GetAllocatedSize() + Area.GetAllocatedSize() + Snow.GetAllocatedSize() + Surface.GetAllocatedSize();
+	for (int32 Direction = 0; Direction < NumNeighbours; ++Direction)
+	{
+		Size += Outflow[Direction].GetAllocatedSize();
+	}
+	return Size;
+}
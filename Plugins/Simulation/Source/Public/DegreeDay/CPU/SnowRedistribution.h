@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Cells/SimulationCellStore.h"
+#include "Cells/HaloGrid.h"
+
+/** Parameters of the gravitational redistribution of the snow. */
+struct FSnowRedistributionParameters
+{
+	/** Slope of the snow surface in degrees above which snow slides to the lower neighbours. */
+	float SlopeThreshold = 45;
+
+	/** Density of the sliding snow in kg/m^3, converts the snow water equivalent into the height of the snow surface. */
+	float SnowDensity = 250;
+
+	/** Maximum number of iterations per call. */
+	int32 MaxIterations = 32;
+
+	/** The iterations stop once an iteration moves less than this fraction of the total snow. */
+	float Tolerance = 1e-4f;
+};
+
+/**
+* Moves the snow of cells whose snow surface is steeper than the slope threshold towards their lower neighbours until
+* the snow cover is stable.
+*
+* An iteration first computes the outflow of every cell into each of its eight neighbours from the snow surface of the
+* previous iteration, the excess height above the stable slope is split among the neighbours in proportion to their
+* excess. The inflow of every cell is then gathered from the outflows of its neighbours. Every value is written by
+* exactly one cell, so the result does not depend on the number of threads and the snow is conserved up to the rounding
+* of the sums. The grids have a ghost border which no snow flows into.
+*/
+class SIMULATION_API FSnowRedistribution
+{
+public:
+	/** Creates the grids for the terrain of the given cells. */
+	void Initialize(const FSimulationCellStore& Cells);
+
+	/** Frees the grids. */
+	void Reset();
+
+	/** Returns true if the grids have been created for the given cells. */
+	bool IsInitialized(const FSimulationCellStore& Cells) const
+	{
+		return Snow.GetDimensionX() == Cells.DimensionX && Snow.GetDimensionY() == Cells.DimensionY && NumCells == Cells.Num() && NumCells > 0;
+	}
+
+	/**
+	* Redistributes the snow water equivalent of the cells.
+	*
+	* @param Cells				The cells, their snow water equivalent is updated
+	* @param Parameters			The parameters of the redistribution
+	* @param ParallelExecution	Whether the rows are processed in parallel on the task graph
+	* @param RowsPerTask		Number of rows processed by a task
+	* @return the number of iterations
+	*/
+	int32 Redistribute(FSimulationCellStore& Cells, const FSnowRedistributionParameters& Parameters, bool ParallelExecution = true, int32 RowsPerTask = 8);
+
+	/** Returns the snow water equivalent in liters moved by the last call to Redistribute. */
+	double GetMovedSnow() const
+	{
+		return MovedSnow;
+	}
+
+	/** Returns the number of bytes allocated by the grids. */
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	/** The altitude of the terrain in cm, the border is higher than any cell. */
+	THaloGrid<float> Altitude;
+
+	/** Area of the cells in m^2. */
+	THaloGrid<float> Area;
+
+	/** Snow water equivalent in liters. */
+	THaloGrid<float> Snow;
+
+	/** Altitude of the snow surface in cm of the previous iteration. */
+	THaloGrid<float> Surface;
+
+	/** Snow water equivalent in liters which flows into the neighbour in the direction of the index. */
+	THaloGrid<float> Outflow[static_cast<int32>(ENeighbour::Num)];
+
+	/** Distance to the cell centers of the neighbours in cm. */
+	float NeighbourDistance[static_cast<int32>(ENeighbour::Num)];
+
+	int32 NumCells = 0;
+
+	/** The snow moved by the last call to Redistribute. */
+	double MovedSnow = 0;
+};
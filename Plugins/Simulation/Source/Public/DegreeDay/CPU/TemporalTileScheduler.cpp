@@ -0,0 +1,302 @@
+#include "Simulation.h"
+#include "TemporalTileScheduler.h"
+#include "ParallelFor.h"
+
+void FTemporalTileScheduler::Initialize(const FMultiResolutionGrid& Grid, float BandWidth)
+{
+	Reset();
+
+	TileTime.Init(INDEX_NONE, Grid.GetNumTiles());
+	TileMaxSnow.SetNumUninitialized(Grid.GetNumTiles());
+	for (int32 Tile = 0; Tile < Grid.GetNumTiles(); ++Tile)
+	{
+		TileMaxSnow[Tile] = Grid.GetTileMaxSnow(Tile);
+	}
+
+	LevelBands.SetNum(Grid.GetNumLevels());
+	for (int32 Level = 0; Level < Grid.GetNumLevels(); ++Level)
+	{
+		LevelBands[Level].Initialize(Grid.GetLevelCells(Level), BandWidth);
+	}
+}
+
+void FTemporalTileScheduler::Reset()
+{
+	TileTime.Empty();
+	TileMaxSnow.Empty();
+	LevelBands.Empty();
+	Updates.Empty();
+	Intervals.Empty();
+	UpdateIntervals.Empty();
+	AccumulatedBands.Empty();
+	LastWetHour.Empty();
+	NumCatchUpTiles = 0;
+	NumWaitingTiles = 0;
+	NumCellUpdates = 0;
+}
+
+int32 FTemporalTileScheduler::AddInterval(int32 Level, int32 BeginHour, int32 EndHour, TMap<uint64, int32>& IntervalIndex)
+{
+	const uint64 Key = ((uint64)Level << 56) | ((uint64)(uint32)BeginHour << 28) | (uint64)(uint32)EndHour;
+
+	if (const int32* Index = IntervalIndex.Find(Key))
+	{
+		return *Index;
+	}
+
+	FAccumulatedInterval Interval;
+	Interval.Level = Level;
+	Interval.BeginHour = BeginHour;
+	Interval.EndHour = EndHour;
+	Interval.BandOffset = Intervals.Num() > 0 ? Intervals.Last().BandOffset + LevelBands[Intervals.Last().Level].GetNumBands() : 0;
+
+	const int32 Index = Intervals.Add(Interval);
+	IntervalIndex.Add(Key, Index);
+	return Index;
+}
+
+int32 FTemporalTileScheduler::Schedule(const FMultiResolutionGrid& Grid, const FVector& Center, int32 BeginHour, int32 EndHour, const FTemporalTileSettings& Settings)
+{
+	const int32 MaxExponent = FMath::FloorLog2(FMath::Max(1, Settings.MaxUpdateInterval));
+
+	// A radius of less than 1 cm would divide by zero
+	const float HourlyRadius = FMath::Max(Settings.HourlyRadius, 1.0f);
+
+	Updates.Reset();
+	Intervals.Reset();
+	UpdateIntervals.Reset();
+	NumCatchUpTiles = 0;
+	NumWaitingTiles = 0;
+	NumCellUpdates = 0;
+
+	TMap<uint64, int32> IntervalIndex;
+
+	// Tiles of the hourly ring which have skipped hours
+	struct FCatchUpTile
+	{
+		int32 Tile;
+		float Distance;
+	};
+	TArray<FCatchUpTile> CatchUpTiles;
+
+	int32 FirstHour = BeginHour;
+
+	auto AddHourlyUpdate = [&](int32 Tile)
+	{
+		const int32 Level = Grid.GetTileLevel(Tile);
+
+		FTileUpdate Update;
+		Update.Tile = Tile;
+		Update.BeginHour = TileTime[Tile];
+		Update.EndHour = EndHour;
+		Update.FirstInterval = INDEX_NONE;
+		Update.NumIntervals = 0;
+		Updates.Add(Update);
+
+		FirstHour = FMath::Min(FirstHour, Update.BeginHour);
+		NumCellUpdates += (int64)(Grid.GetTileEnd(Tile, Level) - Grid.GetTileBegin(Tile, Level)) * (Update.EndHour - Update.BeginHour);
+	};
+
+	for (int32 Tile = 0; Tile < TileTime.Num(); ++Tile)
+	{
+		if (TileTime[Tile] == INDEX_NONE)
+		{
+			TileTime[Tile] = BeginHour;
+		}
+
+		const int32 Time = TileTime[Tile];
+		const float Distance = Grid.GetTileDistance(Tile, Center);
+
+		// The interval doubles with every doubling of the distance beyond the hourly radius
+		const int32 Exponent = MaxExponent == 0 || Distance < HourlyRadius ? 0 : FMath::Clamp(1 + FMath::FloorToInt(FMath::Log2(Distance / HourlyRadius)), 0, MaxExponent);
+		const int32 Interval = 1 << Exponent;
+
+		if (Interval == 1)
+		{
+			if (Time >= BeginHour)
+			{
+				if (EndHour > Time)
+				{
+					AddHourlyUpdate(Tile);
+				}
+			}
+			else
+			{
+				CatchUpTiles.Add({ Tile, Distance });
+			}
+			continue;
+		}
+
+		// The tile is due at the hours at which its phase is a multiple of its interval, so the tiles of a ring are spread over the hours
+		const int32 Phase = Tile & (Interval - 1);
+		const int32 DueHour = EndHour - (EndHour + Phase) % Interval;
+		if (DueHour <= Time)
+		{
+			continue;
+		}
+
+		const int32 Level = Grid.GetTileLevel(Tile);
+
+		FTileUpdate Update;
+		Update.Tile = Tile;
+		Update.BeginHour = Time;
+		Update.EndHour = DueHour;
+		Update.FirstInterval = UpdateIntervals.Num();
+
+		// A tile which lags by more than its interval, because it was closer before, is split at its due hours
+		for (int32 Hour = Time; Hour < DueHour;)
+		{
+			const int32 NextHour = FMath::Min(Hour + Interval - (Hour + Phase) % Interval, DueHour);
+			UpdateIntervals.Add(AddInterval(Level, Hour, NextHour, IntervalIndex));
+			Hour = NextHour;
+		}
+
+		Update.NumIntervals = UpdateIntervals.Num() - Update.FirstInterval;
+		Updates.Add(Update);
+
+		FirstHour = FMath::Min(FirstHour, Time);
+		NumCellUpdates += (int64)(Grid.GetTileEnd(Tile, Level) - Grid.GetTileBegin(Tile, Level)) * Update.NumIntervals;
+	}
+
+	// The closest tiles catch up first, the others wait for the following steps
+	CatchUpTiles.Sort([](const FCatchUpTile& A, const FCatchUpTile& B) { return A.Distance < B.Distance; });
+
+	NumCatchUpTiles = Settings.MaxCatchUpTiles > 0 ? FMath::Min(CatchUpTiles.Num(), Settings.MaxCatchUpTiles) : CatchUpTiles.Num();
+	NumWaitingTiles = CatchUpTiles.Num() - NumCatchUpTiles;
+
+	for (int32 Index = 0; Index < NumCatchUpTiles; ++Index)
+	{
+		AddHourlyUpdate(CatchUpTiles[Index].Tile);
+	}
+
+	return FirstHour;
+}
+
+void FTemporalTileScheduler::AdvanceHourly(FMultiResolutionGrid& Grid, int32 Tile, const FDegreeDayParameters& Parameters, const FDegreeDayForcing* HourForcing, int32 NumHours, FDegreeDayKernelFunction Kernel)
+{
+	const int32 Level = Grid.GetTileLevel(Tile);
+	FSimulationCellStore& Cells = Grid.GetLevelCells(Level);
+	const int32 BeginIndex = Grid.GetTileBegin(Tile, Level);
+	const int32 EndIndex = Grid.GetTileEnd(Tile, Level);
+
+	for (int32 Hour = 0; Hour < NumHours; ++Hour)
+	{
+		Kernel(FDegreeDayCellRange(Cells, BeginIndex, EndIndex, Grid.GetRadiationIndex(Tile, HourForcing[Hour].DayOfYear)), Parameters, HourForcing[Hour]);
+	}
+}
+
+void FTemporalTileScheduler::AdvanceAccumulated(FMultiResolutionGrid& Grid, const FTileUpdate& Update, const TArray<FDegreeDayForcing>& HourForcing, int32 FirstHour,
+	const FDegreeDayParameters& Parameters, FDegreeDayKernelFunction Kernel) const
+{
+	const int32 Tile = Update.Tile;
+	const int32 Level = Grid.GetTileLevel(Tile);
+	FSimulationCellStore& Cells = Grid.GetLevelCells(Level);
+	const int32 BeginIndex = Grid.GetTileBegin(Tile, Level);
+	const int32 EndIndex = Grid.GetTileEnd(Tile, Level);
+	const uint16* CellBands = LevelBands[Level].GetCellBands();
+
+	for (int32 IntervalIndex = Update.FirstInterval; IntervalIndex < Update.FirstInterval + Update.NumIntervals; ++IntervalIndex)
+	{
+		const FAccumulatedInterval& Interval = Intervals[UpdateIntervals[IntervalIndex]];
+		const int32 NumHours = Interval.EndHour - Interval.BeginHour;
+		const int32* BandLastWetHour = LastWetHour.GetData() + Interval.BandOffset;
+
+		// The radiation index of the middle of the interval
+		FDegreeDayForcing Forcing = HourForcing[(Interval.BeginHour + Interval.EndHour) / 2 - FirstHour];
+		Forcing.AltitudeBands = AccumulatedBands.GetData() + Interval.BandOffset;
+		Forcing.Hours = (float)NumHours;
+
+		Kernel(FDegreeDayCellRange(Cells, BeginIndex, EndIndex, Grid.GetRadiationIndex(Tile, Forcing.DayOfYear), CellBands), Parameters, Forcing);
+
+		// The kernel restarts the days since the last snowfall at the beginning of a wet interval
+		for (int32 Index = BeginIndex; Index < EndIndex; ++Index)
+		{
+			const int32 CellLastWetHour = BandLastWetHour[CellBands[Index]];
+			if (CellLastWetHour >= 0)
+			{
+				Cells.DaysSinceLastSnowfall[Index] = (NumHours - CellLastWetHour) / 24.0f;
+			}
+		}
+	}
+}
+
+void FTemporalTileScheduler::Advance(FMultiResolutionGrid& Grid, const TArray<FDegreeDayForcing>& HourForcing, int32 FirstHour, const FDegreeDayParameters& Parameters,
+	FDegreeDayKernelFunction Kernel, int32 NumTasks)
+{
+	// Forcing of the altitude bands of every accumulated interval
+	const int32 NumBandForcing = Intervals.Num() > 0 ? Intervals.Last().BandOffset + LevelBands[Intervals.Last().Level].GetNumBands() : 0;
+	AccumulatedBands.SetNumUninitialized(NumBandForcing);
+	LastWetHour.SetNumUninitialized(NumBandForcing);
+
+	auto AccumulateInterval = [&](int32 Index)
+	{
+		const FAccumulatedInterval& Interval = Intervals[Index];
+		LevelBands[Interval.Level].AccumulateForcing(HourForcing.GetData() + Interval.BeginHour - FirstHour, Interval.EndHour - Interval.BeginHour, Parameters,
+			AccumulatedBands.GetData() + Interval.BandOffset, LastWetHour.GetData() + Interval.BandOffset);
+	};
+
+	auto AdvanceTile = [&](const FTileUpdate& Update)
+	{
+		if (Update.FirstInterval == INDEX_NONE)
+		{
+			AdvanceHourly(Grid, Update.Tile, Parameters, HourForcing.GetData() + Update.BeginHour - FirstHour, Update.EndHour - Update.BeginHour, Kernel);
+		}
+		else
+		{
+			AdvanceAccumulated(Grid, Update, HourForcing, FirstHour, Parameters, Kernel);
+		}
+
+		TileTime[Update.Tile] = Update.EndHour;
+		TileMaxSnow[Update.Tile] = Grid.GetTileMaxSnow(Update.Tile);
+	};
+
+	const int32 NumUpdates = Updates.Num();
+
+	if (NumTasks > 1)
+	{
+		ParallelFor(Intervals.Num(), AccumulateInterval);
+
+		// Every task works through its share of the tiles, this bounds the number of workers used
+		const int32 NumUpdateTasks = FMath::Min(NumUpdates, NumTasks);
+		ParallelFor(NumUpdateTasks, [&](int32 Task)
+		{
+			for (int32 Index = Task; Index < NumUpdates; Index += NumUpdateTasks)
+			{
+				AdvanceTile(Updates[Index]);
+			}
+		});
+	}
+	else
+	{
+		for (int32 Index = 0; Index < Intervals.Num(); ++Index)
+		{
+			AccumulateInterval(Index);
+		}
+
+		for (const FTileUpdate& Update : Updates)
+		{
+			AdvanceTile(Update);
+		}
+	}
+}
+
+float FTemporalTileScheduler::GetMaxSnow() const
+{
+	float MaxSnow = 0;
+	for (float TileMax : TileMaxSnow)
+	{
+		MaxSnow = FMath::Max(MaxSnow, TileMax);
+	}
+	return MaxSnow;
+}
+
+SIZE_T FTemporalTileScheduler::GetAllocatedSize() const
+{
+	SIZE_T Size = TileTime.GetAllocatedSize() + TileMaxSnow.GetAllocatedSize() + Updates.GetAllocatedSize() + Intervals.GetAllocatedSize() + UpdateIntervals.GetAllocatedSize()
+		+ AccumulatedBands.GetAllocatedSize() + LastWetHour.GetAllocatedSize();
+	for (const FAltitudeBandForcing& Bands : LevelBands)
+	{
+		Size += Bands.GetAllocatedSize();
+	}
+	return Size;
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include "DegreeDayCPUKernel.h"
+#include "AltitudeBandForcing.h"
+#include "Cells/MultiResolutionGrid.h"
+
+/** Settings of the temporal level of detail, see FTemporalTileScheduler. */
+struct FTemporalTileSettings
+{
+	/** Distance from the center in cm within which the tiles are advanced every hour. */
+	float HourlyRadius = 200000;
+
+	/** Maximum number of hours between two updates of a tile, rounded down to a power of two. One advances every tile every hour. */
+	int32 MaxUpdateInterval = 8;
+
+	/** Maximum number of tiles which catch up in a single step, 0 does not limit the catch up. */
+	int32 MaxCatchUpTiles = 16;
+};
+
+/**
+* Temporal level of detail for the tiles of a FMultiResolutionGrid. Tiles closer to the center than the hourly radius
+* are advanced every hour, the update interval of the tiles beyond doubles with every doubling of the distance up to
+* the maximum interval. The tiles of a ring are spread over the hours of the interval, so the same share of them is due
+* in every hour.
+*
+* A due tile is advanced by one kernel call per interval with the forcing of its altitude bands accumulated over the
+* interval, see FAltitudeBandForcing::AccumulateForcing. The snowfall of the interval is added before the melt of the
+* whole interval is applied, so snow which falls late in the interval can melt earlier than it would hour by hour. The
+* days since the last snowfall are set from the last wet hour of the band, so the albedo ages exactly.
+*
+* A tile which moves into the hourly ring catches up to the current hour by simulating the hours it has skipped one by
+* one. The closest tiles catch up first and at most MaxCatchUpTiles per step, so a fast moving camera does not cause a
+* hitch. The waiting tiles keep their snow and catch up in the following steps.
+*/
+class SIMULATION_API FTemporalTileScheduler
+{
+public:
+	/**
+	* Computes the maximum snow of all tiles of the grid. All tiles start at the first hour which is scheduled.
+	*
+	* @param Grid		The tiles
+	* @param BandWidth	Width of the altitude bands of the accumulated forcing in cm
+	*/
+	void Initialize(const FMultiResolutionGrid& Grid, float BandWidth);
+
+	/** Frees the scheduler. */
+	void Reset();
+
+	/**
+	* Selects the tiles which are advanced in the step [BeginHour, EndHour) for the given center. The levels of the tiles
+	* must not change until the step has been advanced.
+	*
+	* @return the first hour whose forcing is needed by Advance
+	*/
+	int32 Schedule(const FMultiResolutionGrid& Grid, const FVector& Center, int32 BeginHour, int32 EndHour, const FTemporalTileSettings& Settings);
+
+	/**
+	* Advances the scheduled tiles at their levels and updates their maximum snow.
+	*
+	* @param Grid			The tiles
+	* @param HourForcing	The forcing of the hours from FirstHour to the end of the step
+	* @param FirstHour		The hour of the first forcing, at most the hour returned by Schedule
+	* @param Parameters		The degree day parameters
+	* @param Kernel			The kernel variant, it must not interpolate
+	* @param NumTasks		Number of tasks which advance the tiles in parallel, 1 advances them on the calling thread
+	*/
+	void Advance(FMultiResolutionGrid& Grid, const TArray<FDegreeDayForcing>& HourForcing, int32 FirstHour, const FDegreeDayParameters& Parameters, FDegreeDayKernelFunction Kernel, int32 NumTasks);
+
+	/**
+	* Advances the tile at its level hour by hour.
+	*
+	* @param Grid			The tiles
+	* @param Tile			The tile
+	* @param Parameters		The degree day parameters
+	* @param HourForcing	The forcing of the hours
+	* @param NumHours		Number of hours
+	* @param Kernel			The kernel variant, it must not interpolate
+	*/
+	static void AdvanceHourly(FMultiResolutionGrid& Grid, int32 Tile, const FDegreeDayParameters& Parameters, const FDegreeDayForcing* HourForcing, int32 NumHours, FDegreeDayKernelFunction Kernel);
+
+	/** Returns the hour up to which the tile has been simulated. */
+	int32 GetTileTime(int32 Tile) const
+	{
+		return TileTime[Tile];
+	}
+
+	/** Returns the maximum snow amount (mm) of all tiles after their last update. */
+	float GetMaxSnow() const;
+
+	/** Returns the number of tiles which are advanced in the scheduled step. */
+	int32 GetNumScheduledTiles() const
+	{
+		return Updates.Num();
+	}
+
+	/** Returns the number of tiles which catch up in the scheduled step. */
+	int32 GetNumCatchUpTiles() const
+	{
+		return NumCatchUpTiles;
+	}
+
+	/** Returns the number of tiles in the hourly ring which still have to catch up after the scheduled step. */
+	int32 GetNumWaitingTiles() const
+	{
+		return NumWaitingTiles;
+	}
+
+	/** Returns the number of cells times the number of kernel calls of the scheduled step. */
+	int64 GetNumCellUpdates() const
+	{
+		return NumCellUpdates;
+	}
+
+	/** Returns the number of bytes allocated by the scheduler. */
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	/** The update of a tile in the scheduled step. */
+	struct FTileUpdate
+	{
+		int32 Tile;
+
+		/** The hours [BeginHour, EndHour) by which the tile is advanced. */
+		int32 BeginHour;
+		int32 EndHour;
+
+		/** The first accumulated interval of the update or INDEX_NONE if the tile is advanced hour by hour. */
+		int32 FirstInterval;
+
+		/** Number of accumulated intervals of the update. */
+		int32 NumIntervals;
+	};
+
+	/** Hours whose forcing is accumulated for the altitude bands of a level. */
+	struct FAccumulatedInterval
+	{
+		int32 Level;
+		int32 BeginHour;
+		int32 EndHour;
+
+		/** Index of the forcing of the first band of the level in AccumulatedBands and LastWetHour. */
+		int32 BandOffset;
+	};
+
+	/** The hour up to which every tile has been simulated, INDEX_NONE before the first step. */
+	TArray<int32> TileTime;
+
+	/** The maximum snow amount (mm) of every tile after its last update. */
+	TArray<float> TileMaxSnow;
+
+	/** The altitude bands of the cells of every level. */
+	TArray<FAltitudeBandForcing> LevelBands;
+
+	/** The updates of the scheduled step. */
+	TArray<FTileUpdate> Updates;
+
+	/** The accumulated intervals of the scheduled step, the updates of tiles of the same level and phase share them. */
+	TArray<FAccumulatedInterval> Intervals;
+
+	/** The index in Intervals of every accumulated interval of every update. */
+	TArray<int32> UpdateIntervals;
+
+	/** The accumulated forcing of the bands of every interval. */
+	TArray<FDegreeDayCellForcing> AccumulatedBands;
+
+	/** The last hour with precipitation of the bands of every interval relative to its first hour, -1 if there was none. */
+	TArray<int32> LastWetHour;
+
+	int32 NumCatchUpTiles = 0;
+	int32 NumWaitingTiles = 0;
+	int64 NumCellUpdates = 0;
+
+	/** Returns the index of the accumulated interval of the given level and hours, adds it if it does not exist. */
+	int32 AddInterval(int32 Level, int32 BeginHour, int32 EndHour, TMap<uint64, int32>& IntervalIndex);
+
+	/** Advances the tile by the accumulated intervals of the update. */
+	void AdvanceAccumulated(FMultiResolutionGrid& Grid, const FTileUpdate& Update, const TArray<FDegreeDayForcing>& HourForcing, int32 FirstHour,
+		const FDegreeDayParameters& Parameters, FDegreeDayKernelFunction Kernel) const;
+};
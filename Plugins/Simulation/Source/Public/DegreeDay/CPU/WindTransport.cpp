@@ -0,0 +1,224 @@
+#include "Simulation.h"
+#include "WindTransport.h"
+#include "ParallelFor.h"
+
+DECLARE_CYCLE_STAT(TEXT("Wind Transport"), STAT_WindTransport, STATGROUP_SnowSimulation);
+
+/** Calls Function(Tile) for all tiles, in parallel on the task graph or serially. */
+template<typename FunctionType>
+static void ForEachTile(int32 NumTiles, bool ParallelExecution, const FunctionType& Function)
+{
+	if (ParallelExecution)
+	{
+		ParallelFor(NumTiles, Function);
+	}
+	else
+	{
+		for (int32 Tile = 0; Tile < NumTiles; ++Tile)
+		{
+			Function(Tile);
+		}
+	}
+}
+
+void FWindTransport::Initialize(const FSimulationCellStore& Cells, int32 RowsPerTile)
+{
+	NumCells = Cells.Num();
+	DimensionX = Cells.DimensionX;
+	TileRows = RowsPerTile;
+
+	const int32 DimensionY = Cells.DimensionY;
+	const int32 RowsPerChunk = FMath::Max(1, RowsPerTile);
+
+	Tiles.Empty();
+	Tiles.SetNum(FMath::DivideAndRoundUp(DimensionY, RowsPerChunk));
+	for (int32 Tile = 0; Tile < Tiles.Num(); ++Tile)
+	{
+		FTile& TileCells = Tiles[Tile];
+		TileCells.BeginRow = Tile * RowsPerChunk;
+		TileCells.EndRow = FMath::Min(TileCells.BeginRow + RowsPerChunk, DimensionY);
+		TileCells.OutflowX.Initialize(DimensionX, TileCells.EndRow - TileCells.BeginRow);
+		TileCells.OutflowY.Initialize(DimensionX, TileCells.EndRow - TileCells.BeginRow);
+	}
+
+	// The exposure only depends on the terrain
+	SlopeX.SetNumUninitialized(NumCells);
+	SlopeY.SetNumUninitialized(NumCells);
+	CurvatureExposure.SetNumUninitialized(NumCells);
+
+	float MaxCurvature = 0;
+	double SumCellSize = 0;
+	for (int32 Index = 0; Index < NumCells; ++Index)
+	{
+		MaxCurvature = FMath::Max(MaxCurvature, FMath::Abs(Cells.Curvature[Index]));
+		SumCellSize += FMath::Sqrt(Cells.AreaXY[Index]) / 100;
+	}
+	CellSize = NumCells > 0 ? static_cast<float>(SumCellSize / NumCells) : 0.0f;
+
+	for (int32 Index = 0; Index < NumCells; ++Index)
+	{
+		// The normal of a cell projected onto the XY plane points in the direction (cos(Aspect), -sin(Aspect))
+		const float Gradient = FMath::Tan(FMath::Min(Cells.Inclination[Index], FMath::DegreesToRadians(89.0f)));
+		SlopeX[Index] = Gradient * FMath::Cos(Cells.Aspect[Index]);
+		SlopeY[Index] = -Gradient * FMath::Sin(Cells.Aspect[Index]);
+
+		// The curvature of the terrain is positive in hollows
+		CurvatureExposure[Index] = MaxCurvature > 0 ? -Cells.Curvature[Index] / (2 * MaxCurvature) : 0.0f;
+	}
+
+	ResetTimings();
+}
+
+void FWindTransport::Reset()
+{
+	Tiles.Empty();
+	SlopeX.Empty();
+	SlopeY.Empty();
+	CurvatureExposure.Empty();
+	NumCells = 0;
+	DimensionX = 0;
+	TileRows = 0;
+	ResetTimings();
+}
+
+double FWindTransport::SimulateHour(FSimulationCellStore& Cells, const FWindData& Wind, const FDegreeDayForcing& Forcing, const FWindTransportParameters& Parameters, bool ParallelExecution)
+{
+	SCOPE_CYCLE_COUNTER(STAT_WindTransport);
+
+	check(IsInitialized(Cells, TileRows));
+
+	Timings.NumHours++;
+
+	// No cell gets enough wind to transport snow
+	const float Speed = Wind.GetSpeed();
+	const float MaxWeight = 1 + 0.5f * (FMath::Abs(Parameters.SlopeWeight) + FMath::Abs(Parameters.CurvatureWeight));
+	if (Speed * MaxWeight <= Parameters.ThresholdWindSpeed) return 0;
+
+	const float DirectionX = Wind.VelocityX / Speed;
+	const float DirectionY = Wind.VelocityY / Speed;
+
+	// Outflow in liters during one hour per kg/(m s) of transport across the faces in x and y direction
+	const float FaceX = FMath::Abs(DirectionX) * CellSize * 3600;
+	const float FaceY = FMath::Abs(DirectionY) * CellSize * 3600;
+
+	// The neighbours the inflow comes from
+	const ENeighbour UpwindX = DirectionX >= 0 ? ENeighbour::W : ENeighbour::E;
+	const ENeighbour UpwindY = DirectionY >= 0 ? ENeighbour::N : ENeighbour::S;
+
+	const int32 NumTiles = Tiles.Num();
+
+	// Outflow of the cells of every tile
+	double StartSeconds = FPlatformTime::Seconds();
+	ForEachTile(NumTiles, ParallelExecution, [&](int32 Tile)
+	{
+		FTile& TileCells = Tiles[Tile];
+		double Outflow = 0;
+
+		for (int32 Y = TileCells.BeginRow; Y < TileCells.EndRow; ++Y)
+		{
+			const int32 RowIndex = TileCells.OutflowX.GetIndex(0, Y - TileCells.BeginRow);
+			for (int32 X = 0; X < DimensionX; ++X)
+			{
+				const int32 Index = X + Y * DimensionX;
+
+				// Wind speed of the cell, the slope in wind direction is bounded by x / (1 + |x|)
+				const float WindSlope = -(DirectionX * SlopeX[Index] + DirectionY * SlopeY[Index]);
+				const float Weight = 1 + Parameters.SlopeWeight * 0.5f * WindSlope / (1 + FMath::Abs(WindSlope)) + Parameters.CurvatureWeight * CurvatureExposure[Index];
+				const float ExcessSpeed = FMath::Max(0.0f, FMath::Max(0.0f, Weight) * Speed - Parameters.ThresholdWindSpeed);
+
+				const bool Dry = FDegreeDayCPUKernel::GetAirTemperature(Forcing, Cells.Altitude[Index]) <= Parameters.MaxAirTemperature;
+				const float Transport = Dry ? Parameters.TransportCoefficient * ExcessSpeed * ExcessSpeed * ExcessSpeed : 0.0f;
+
+				// A cell can not send more snow than it has
+				const float Snow = Cells.SnowWaterEquivalent[Index];
+				const float Capacity = Transport * (FaceX + FaceY);
+				const float Scale = Capacity > Snow ? Snow / Capacity : 1.0f;
+
+				TileCells.OutflowX[RowIndex + X] = Transport * FaceX * Scale;
+				TileCells.OutflowY[RowIndex + X] = Transport * FaceY * Scale;
+				Outflow += FMath::Min(Capacity, Snow);
+			}
+		}
+
+		TileCells.Outflow = Outflow;
+	});
+	Timings.TransportSeconds += FPlatformTime::Seconds() - StartSeconds;
+
+	StartSeconds = FPlatformTime::Seconds();
+	ForEachTile(NumTiles, ParallelExecution, [&](int32 Tile)
+	{
+		ExchangeHalo(Tile);
+	});
+	Timings.ExchangeSeconds += FPlatformTime::Seconds() - StartSeconds;
+
+	// Apply the outflow and the inflow from the upwind neighbours
+	StartSeconds = FPlatformTime::Seconds();
+	ForEachTile(NumTiles, ParallelExecution, [&](int32 Tile)
+	{
+		FTile& TileCells = Tiles[Tile];
+		const int32 UpwindOffsetX = TileCells.OutflowX.GetNeighbourOffset(UpwindX);
+		const int32 UpwindOffsetY = TileCells.OutflowY.GetNeighbourOffset(UpwindY);
+
+		for (int32 Y = TileCells.BeginRow; Y < TileCells.EndRow; ++Y)
+		{
+			const int32 RowIndex = TileCells.OutflowX.GetIndex(0, Y - TileCells.BeginRow);
+			for (int32 X = 0; X < DimensionX; ++X)
+			{
+				const int32 Index = X + Y * DimensionX;
+				const int32 PaddedIndex = RowIndex + X;
+
+				const float Flow = TileCells.OutflowX[PaddedIndex + UpwindOffsetX] + TileCells.OutflowY[PaddedIndex + UpwindOffsetY]
+					- TileCells.OutflowX[PaddedIndex] - TileCells.OutflowY[PaddedIndex];
+				Cells.SnowWaterEquivalent[Index] = FMath::Max(0.0f, Cells.SnowWaterEquivalent[Index] + Flow);
+			}
+		}
+	});
+	Timings.ApplySeconds += FPlatformTime::Seconds() - StartSeconds;
+
+	// The partial sums are merged in a fixed order
+	double Outflow = 0;
+	for (const FTile& TileCells : Tiles)
+	{
+		Outflow += TileCells.Outflow;
+	}
+	return Outflow;
+}
+
+void FWindTransport::ExchangeHalo(int32 Tile)
+{
+	FTile& TileCells = Tiles[Tile];
+	const int32 NumRows = TileCells.EndRow - TileCells.BeginRow;
+
+	auto ExchangeGrid = [&](THaloGrid<float> FTile::* Grid)
+	{
+		THaloGrid<float>& Outflow = TileCells.*Grid;
+
+		// The rows next to the tile, at the border of the grid the inflow equals the outflow of the border cells
+		const THaloGrid<float>& Previous = Tile > 0 ? Tiles[Tile - 1].*Grid : Outflow;
+		const int32 PreviousRow = Tile > 0 ? Previous.GetDimensionY() - 1 : 0;
+		const THaloGrid<float>& Next = Tile < Tiles.Num() - 1 ? Tiles[Tile + 1].*Grid : Outflow;
+		const int32 NextRow = Tile < Tiles.Num() - 1 ? 0 : NumRows - 1;
+
+		FMemory::Memcpy(&Outflow.Get(0, -1), &Previous.Get(0, PreviousRow), DimensionX * sizeof(float));
+		FMemory::Memcpy(&Outflow.Get(0, NumRows), &Next.Get(0, NextRow), DimensionX * sizeof(float));
+
+		for (int32 Y = 0; Y < NumRows; ++Y)
+		{
+			Outflow.Get(-1, Y) = Outflow.Get(0, Y);
+			Outflow.Get(DimensionX, Y) = Outflow.Get(DimensionX - 1, Y);
+		}
+	};
+
+	ExchangeGrid(&FTile::OutflowX);
+	ExchangeGrid(&FTile::OutflowY);
+}
+
+SIZE_T FWindTransport::GetAllocatedSize() const
+{
+	SIZE_T Size = Tiles.GetAllocatedSize() + SlopeX.GetAllocatedSize() + SlopeY.GetAllocatedSize() + CurvatureExposure.GetAllocatedSize();
+	for (const FTile& TileCells : Tiles)
+	{
+		Size += TileCells.OutflowX.GetAllocatedSize() + TileCells.OutflowY.GetAllocatedSize();
+	}
+	return Size;
+}
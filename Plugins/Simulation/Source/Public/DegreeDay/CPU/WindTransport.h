@@ -0,0 +1,142 @@
+#pragma once
+
+#include "Cells/SimulationCellStore.h"
+#include "Cells/HaloGrid.h"
+#include "DegreeDayCPUKernel.h"
+#include "ClimateData.h"
+
+/** Parameters of the snow transport by the wind. */
+struct FWindTransportParameters
+{
+	/** Wind speed in m/s above which dry snow is transported. */
+	float ThresholdWindSpeed = 5;
+
+	/** The transport rate in kg/(m s) is this coefficient times the cube of the wind speed above the threshold. */
+	float TransportCoefficient = 1e-5f;
+
+	/** Weight of the slope in wind direction of the wind speed of a cell. */
+	float SlopeWeight = 0.58f;
+
+	/** Weight of the curvature of the wind speed of a cell. */
+	float CurvatureWeight = 0.42f;
+
+	/** Air temperature in degree Celsius above which the snow is too wet to be transported. */
+	float MaxAirTemperature = 0;
+};
+
+/** Wall clock time spent in the phases of the wind transport. */
+struct FWindTransportTimings
+{
+	/** Computing the outflow of the cells. */
+	double TransportSeconds = 0;
+
+	/** Copying the border rows of the outflow between the tiles. */
+	double ExchangeSeconds = 0;
+
+	/** Applying the inflow and outflow to the snow. */
+	double ApplySeconds = 0;
+
+	/** Number of simulated hours. */
+	int32 NumHours = 0;
+
+	double GetTotalSeconds() const
+	{
+		return TransportSeconds + ExchangeSeconds + ApplySeconds;
+	}
+};
+
+/**
+* Transports dry snow with the wind over the cell grid. The wind speed of a cell is the speed at the station weighted by
+* the exposure of the cell as in Liston and Elder's "A Meteorological Distribution System for High-Resolution Terrestrial
+* Modeling (MicroMet)": slopes facing the wind and convex cells get more wind. The transport rate grows with the cube of
+* the speed above a threshold, so snow is eroded where the wind speeds up and deposited in the lee where it slows down.
+*
+* The transport is a first order upwind advection. Every cell sends its outflow across the faces facing downwind and
+* receives the outflow of its upwind neighbours. The grid is split into tiles of rows with their own halo grids of the
+* outflow; after the outflow of all tiles has been computed the border rows are copied into the halos of the neighbouring
+* tiles, then every tile applies the flows to its cells. The inflow across the upwind border of the grid equals the
+* outflow of the border cells and the snow blown across the downwind border leaves the grid.
+*/
+class SIMULATION_API FWindTransport
+{
+public:
+	/** Derives the exposure of the cells and creates the tiles. */
+	void Initialize(const FSimulationCellStore& Cells, int32 RowsPerTile);
+
+	/** Frees the tiles and the exposure. */
+	void Reset();
+
+	/** Returns true if the transport has been initialized for the given cells and tile size. */
+	bool IsInitialized(const FSimulationCellStore& Cells, int32 RowsPerTile) const
+	{
+		return NumCells == Cells.Num() && NumCells > 0 && DimensionX == Cells.DimensionX && TileRows == RowsPerTile;
+	}
+
+	/**
+	* Transports the snow of the cells during one hour.
+	*
+	* @param Cells				The cells, their snow water equivalent is updated
+	* @param Wind				The wind of the hour
+	* @param Forcing			The forcing of the hour, snow is only transported where the air is cold enough
+	* @param Parameters			The parameters of the transport
+	* @param ParallelExecution	Whether the tiles are processed in parallel on the task graph
+	* @return the snow water equivalent in liters which left the cells during the hour
+	*/
+	double SimulateHour(FSimulationCellStore& Cells, const FWindData& Wind, const FDegreeDayForcing& Forcing, const FWindTransportParameters& Parameters, bool ParallelExecution = true);
+
+	/** Returns the time spent in the phases since the last call to ResetTimings. */
+	const FWindTransportTimings& GetTimings() const
+	{
+		return Timings;
+	}
+
+	void ResetTimings()
+	{
+		Timings = FWindTransportTimings();
+	}
+
+	/** Returns the number of bytes allocated by the exposure and the tiles. */
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	struct FTile
+	{
+		int32 BeginRow = 0;
+
+		int32 EndRow = 0;
+
+		/** Snow water equivalent in liters leaving the cells in x direction, the halo holds the outflow of the neighbours. */
+		THaloGrid<float> OutflowX;
+
+		/** Snow water equivalent in liters leaving the cells in y direction. */
+		THaloGrid<float> OutflowY;
+
+		/** The snow which left the cells of the tile in the current hour. */
+		double Outflow = 0;
+	};
+
+	/** Copies the border rows of the neighbouring tiles into the halo of the given tile. */
+	void ExchangeHalo(int32 Tile);
+
+	TArray<FTile> Tiles;
+
+	/** The downslope gradient of the cells in x direction. */
+	FAlignedFloatArray SlopeX;
+
+	/** The downslope gradient of the cells in y direction. */
+	FAlignedFloatArray SlopeY;
+
+	/** The curvature of the cells normalized to [-0.5, 0.5], convex cells are positive. */
+	FAlignedFloatArray CurvatureExposure;
+
+	/** Width of the cells in m. */
+	float CellSize = 0;
+
+	int32 NumCells = 0;
+
+	int32 DimensionX = 0;
+
+	int32 TileRows = 0;
+
+	FWindTransportTimings Timings;
+};
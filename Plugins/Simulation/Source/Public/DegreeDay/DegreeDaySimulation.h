@@ -6,6 +6,80 @@
 #include "SimulationBase.h"
 #include "DegreeDaySimulation.generated.h"
 
+/** Parameters of the degree day model which are used by the simulation kernels. */
+USTRUCT(BlueprintType)
+struct SIMULATION_API FDegreeDayParameters
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** Threshold A air temperature above which some precipitation is assumed to be rain. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation", DisplayName = "TSnow A")
+	float TSnowA = 0;
+
+	/** Threshold B air temperature above which all precipitation is assumed to be rain. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation", DisplayName = "TSnow B")
+	float TSnowB = 2;
+
+	/** Threshold A air temperature above which some snow starts melting. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation", DisplayName = "TMelt A")
+	float TMeltA = -5;
+
+	/** Threshold B air temperature above which all snow starts melting. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation", DisplayName = "TMelt B")
+	float TMeltB = -2;
+
+	/** Time constant. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation", DisplayName = "k_e")
+	float k_e = 0.2;
+
+	/** Proportional constant. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation", DisplayName = "k_m")
+	float k_m = 4;
+
+	/** Density of the vegetation between 0 and 1 which reduces the melt by the factor k_v = exp(-4 * density), used for cells without vegetation data. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation", meta = (ClampMin = "0", ClampMax = "1"))
+	float VegetationDensity = 0;
+
+	/**
+	* Fraction of the snowfall which a canopy of density 1 intercepts, a cell loses this fraction times its vegetation density.
+	* Only the simulations with precomputed melt coefficients apply it, 0 keeps the snowfall of all simulations the same.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation", meta = (ClampMin = "0", ClampMax = "1"))
+	float CanopyInterception = 0;
+};
+
+/** Parameters of the interpolation of the snow according to Bloeschls "Distributed Snowmelt Simulations in an Alpine Catchment". */
+USTRUCT(BlueprintType)
+struct SIMULATION_API FBloeschlParameters
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** Factor of the curvature. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation", DisplayName = "a3")
+	float a3 = 50;
+
+	/** Slope in degrees below which no snow slides off. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation")
+	float MinSlope = 15;
+
+	/** Slope in degrees at which all snow slides off. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation")
+	float MaxSlope = 65;
+
+	/** Returns the factor of the snow water equivalent of a cell with the given inclination in radians and curvature. */
+	float GetInterpolationFactor(float Inclination, float Curvature) const
+	{
+		float Slope = FMath::RadiansToDegrees(Inclination);
+
+		float f = Slope < MinSlope ? 0 : Slope / MaxSlope;
+		return (1 - f) * (1 + a3 * Curvature);
+	}
+
+	bool operator==(const FBloeschlParameters& Other) const
+	{
+		return a3 == Other.a3 && MinSlope == Other.MinSlope && MaxSlope == Other.MaxSlope;
+	}
+};
 
 /**
 * Snow simulation similar to the one proposed by Simon Premoze in "Geospecific rendering of alpine terrain".
@@ -17,7 +91,7 @@ class SIMULATION_API UDegreeDaySimulation : public USimulationBase
 	GENERATED_BODY()
 
 public:
-	/** Slope threshold for the snow deposition of the cells in degrees.*/
+	/** Slope of the snow surface in degrees above which the snow slides to the lower neighbours if the simulation redistributes snow. */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation")
 	float SlopeThreshold = 45;
 
@@ -45,5 +119,34 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation", DisplayName = "k_m")
 	float k_m = 4;
 
+	/** Density of the vegetation between 0 and 1 which reduces the melt by the factor k_v = exp(-4 * density), used for cells without vegetation data. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation", meta = (ClampMin = "0", ClampMax = "1"))
+	float VegetationDensity = 0;
+
+	/**
+	* Fraction of the snowfall which a canopy of density 1 intercepts, a cell loses this fraction times its vegetation density.
+	* Only the simulations with precomputed melt coefficients apply it, 0 keeps the snowfall of all simulations the same.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation", meta = (ClampMin = "0", ClampMax = "1"))
+	float CanopyInterception = 0;
+
+	/** Parameters of the interpolation of the snow. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation")
+	FBloeschlParameters Interpolation;
+
+	/** Returns the current values of the model parameters. */
+	FDegreeDayParameters GetParameters() const
+	{
+		FDegreeDayParameters Parameters;
+		Parameters.TSnowA = TSnowA;
+		Parameters.TSnowB = TSnowB;
+		Parameters.TMeltA = TMeltA;
+		Parameters.TMeltB = TMeltB;
+		Parameters.k_e = k_e;
+		Parameters.k_m = k_m;
+		Parameters.VegetationDensity = VegetationDensity;
+		Parameters.CanopyInterception = CanopyInterception;
+		return Parameters;
+	}
 };
 
@@ -13,7 +13,8 @@ FString UDegreeDayGPUSimulation::GetSimulationName()
 
 void UDegreeDayGPUSimulation::Simulate(ASnowSimulationActor* SimulationActor, int32 CurrentSimulationStep, int32 Timesteps, bool SaveSnowMap, bool CaptureDebugInformation, TArray<FDebugCell>& DebugCells)
 {
-	SimulationComputeShader->ExecuteComputeShader(CurrentSimulationStep, Timesteps, SimulationActor->CurrentSimulationTime.GetHour(), CaptureDebugInformation, DebugCells);
+	SimulationComputeShader->ExecuteComputeShader(CurrentSimulationStep, Timesteps, SimulationActor->CurrentSimulationTime.GetDayOfYear(), SimulationActor->CurrentSimulationTime.GetHour(),
+		CaptureDebugInformation, DebugCells);
 	SimulationPixelShader->ExecutePixelShader(RenderTarget, SaveSnowMap);
 }
 
@@ -42,6 +43,8 @@ void UDegreeDayGPUSimulation::Initialize(ASnowSimulationActor* SimulationActor,
 	auto SimulationTimeSpan = SimulationActor->EndTime - SimulationActor->StartTime;
 	int32 TotalHours = static_cast<int32>(SimulationTimeSpan.GetTotalHours());
 
+	SimulationComputeShader->SetRecordDirectory(RecordDirectory);
+
 	SimulationComputeShader->Initialize(Cells, *ClimateData, k_e, k_m, TMeltA, TMeltB, TSnowA, TSnowB, TotalHours, 
 		SimulationActor->CellsDimensionX, SimulationActor->CellsDimensionY, SimulationActor->ClimateDataComponent->GetMeasurementAltitude(), InitialMaxSnow);
 
@@ -27,6 +27,13 @@ private:
 	UTextureRenderTarget2D* RenderTarget;
 
 public:
+	/**
+	* Directory to which the input and the output of every step are recorded for the comparison with the CPU execution
+	* of the compute shader, nothing is recorded if empty. The directory can be replayed as a fixture by
+	* Simulation.ValidateComputeShaderCPU.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Debug")
+	FString RecordDirectory;
 
 	virtual FString GetSimulationName() override final;
 
@@ -0,0 +1,317 @@
+#include "Simulation.h"
+#include "EnergyBalanceKernel.h"
+#include "Radiation/SolarRadiation.h"
+
+/** Stefan-Boltzmann constant in W/(m^2 K^4). */
+static const float StefanBoltzmann = 5.670e-8f;
+
+/** Factor of the sixth power of the air temperature in Swinbank's clear sky longwave radiation in W/(m^2 K^6). */
+static const float SwinbankCoefficient = 5.31e-13f;
+
+/** Latent heat of fusion in J/kg. */
+static const float LatentHeatFusion = 334000.0f;
+
+/** Latent heat of sublimation in J/kg. */
+static const float LatentHeatSublimation = 2.834e6f;
+
+/** Specific heat of water in J/(kg K). */
+static const float SpecificHeatWater = 4186.0f;
+
+/** Lowest and highest air temperature in degree Celsius for which the saturation vapour pressure polynomial holds. */
+static const float MinAirTemperature = -50.0f;
+static const float MaxAirTemperature = 50.0f;
+
+/** Constants of an hour which are shared by the scalar and the vector kernel. */
+struct FEnergyBalanceHourConstants
+{
+	/** Temperature lapse rate in degree Celsius per cm. */
+	float TemperatureLapseRate = -0.5f / (100 * 100);
+
+	/** Precipitation lapse rate in mm per cm, zero in dry hours. */
+	float PrecipitationLapseRate;
+
+	float InvSnowRange;
+
+	/** Factor of the excess albedo above 0.4 after one hour. */
+	float AlbedoDecay;
+
+	/** Absorbed incoming longwave radiation in W/m^2 per K^6 of the air temperature. */
+	float LongwaveIn;
+
+	/** Emitted longwave radiation in W/m^2 per K^4 of the surface temperature. */
+	float LongwaveOut;
+
+	/** Latent heat flux in W/m^2 per hPa of the vapour pressure difference between air and surface. */
+	float LatentTransfer;
+
+	/** Melt in mm per hour per W/m^2. */
+	float MeltPerFlux;
+
+	/** Sublimation in mm per hour per W/m^2 of the latent heat flux. */
+	float SublimationPerFlux;
+
+	/** Heat of the rain in W/m^2 per mm and degree Celsius. */
+	float RainHeat;
+
+	FEnergyBalanceHourConstants(const FEnergyBalanceParameters& Parameters, const FEnergyBalanceForcing& Forcing)
+	{
+		PrecipitationLapseRate = Forcing.Precipitation > 0 ? 0.5f / (100 * 1000) : 0.0f;
+		InvSnowRange = 1.0f / (Parameters.TSnowB - Parameters.TSnowA);
+		AlbedoDecay = FMath::Exp(-Parameters.k_e / 24.0f);
+
+		// Cloud correction of the longwave radiation of the "Tennessee Valley Authority, Heat and mass transfer between a water surface and the atmosphere"
+		LongwaveIn = Parameters.SnowEmissivity * SwinbankCoefficient * (1 + 0.17f * Forcing.CloudCover * Forcing.CloudCover);
+		LongwaveOut = Parameters.SnowEmissivity * StefanBoltzmann;
+
+		// rho_a / p = 1 / (R_d T) with the air at 0 degree Celsius, q = 0.622 e / p and hPa to Pa
+		LatentTransfer = Forcing.WindSpeed * Parameters.BulkTransferCoefficient * LatentHeatSublimation * 0.622f / (287.05f * 273.15f) * 100;
+
+		MeltPerFlux = 3600 / LatentHeatFusion;
+		SublimationPerFlux = 3600 / LatentHeatSublimation;
+		RainHeat = SpecificHeatWater / 3600;
+	}
+};
+
+FEnergyBalanceForcing FEnergyBalanceKernel::GetForcing(const FEnergyBalanceParameters& Parameters, const FClimateData& Climate, const FWindData* Wind, float MeasurementAltitude,
+	float Latitude, int32 DayOfYear, float DiurnalFactor)
+{
+	FEnergyBalanceForcing Forcing;
+	Forcing.Temperature = Climate.Temperature;
+	Forcing.Precipitation = Climate.Precipitation;
+	Forcing.MeasurementAltitude = MeasurementAltitude;
+	Forcing.CloudCover = Climate.Precipitation > 0 ? 1.0f : Parameters.DryCloudCover;
+	Forcing.WindSpeed = Wind ? Wind->GetSpeed() : Parameters.WindSpeed;
+
+	// Cloud attenuation according to Kasten and Czeplak's "Solar and terrestrial radiation dependent on the amount and type of cloud"
+	const float CloudFactor = 1 - 0.75f * FMath::Pow(Forcing.CloudCover, 3.4f);
+	Forcing.Shortwave = FSolarRadiation::DailyHorizontalRadiation(Latitude, DayOfYear) * DiurnalFactor * Parameters.Transmissivity * CloudFactor;
+
+	return Forcing;
+}
+
+float FEnergyBalanceKernel::GetSensibleTransfer(const FEnergyBalanceParameters& Parameters, float Altitude)
+{
+	// Density of the air at 0 degree Celsius in kg/m^3 with a scale height of 8434m times the specific heat of the air
+	const float AirDensity = 1.292f * FMath::Exp(-Altitude / (100 * 8434.0f));
+	return AirDensity * 1005.0f * Parameters.BulkTransferCoefficient;
+}
+
+float FEnergyBalanceKernel::SimulateScalar(const FEnergyBalanceCellRange& Cells, const FEnergyBalanceParameters& Parameters, const FEnergyBalanceForcing& Forcing)
+{
+	const FEnergyBalanceHourConstants Constants(Parameters, Forcing);
+
+	float MaxSnow = 0;
+
+	for (int32 Index = 0; Index < Cells.Num; ++Index)
+	{
+		float& SnowWaterEquivalent = Cells.SnowWaterEquivalent[Index];
+		float& SnowAlbedo = Cells.SnowAlbedo[Index];
+
+		const float Altitude = Cells.Altitude[Index] - Forcing.MeasurementAltitude;
+		const float TAir = FMath::Clamp(Forcing.Temperature + Constants.TemperatureLapseRate * Altitude, MinAirTemperature, MaxAirTemperature); // degree Celsius
+		const float Precipitation = Forcing.Precipitation + Constants.PrecipitationLapseRate * Altitude; // l/m^2 or mm
+		const float AreaSquareMeters = Cells.AreaXY[Index] / (100 * 100); // m^2
+
+		// Variable lapse rate as described in "A variable lapse rate snowline model for the Remarkables, Central Otago, New Zealand"
+		const float SnowRate = FMath::Clamp(1 - (TAir - Parameters.TSnowA) * Constants.InvSnowRange, 0.0f, 1.0f);
+
+		float Snowfall = 0;
+		float Melt = 0;
+		float Sublimation = 0;
+		float Refreezing = 0;
+
+		// Apply precipitation
+		if (Precipitation > 0)
+		{
+			Snowfall = Precipitation * SnowRate; // l/m^2 or mm
+			SnowWaterEquivalent += Snowfall * AreaSquareMeters; // l/m^2 * m^2 = l
+			SnowAlbedo = TAir > Parameters.TSnowB ? 0.4f : 0.8f;
+		}
+
+		if (SnowWaterEquivalent > 0)
+		{
+			SnowAlbedo = 0.4f + (SnowAlbedo - 0.4f) * Constants.AlbedoDecay;
+
+			// The surface can not be warmer than the melting point
+			const float TSurface = FMath::Min(TAir, 0.0f);
+			const float TAirKelvin = TAir + 273.15f;
+			const float TSurfaceKelvin = TSurface + 273.15f;
+			const float TAirKelvin2 = TAirKelvin * TAirKelvin;
+			const float TSurfaceKelvin2 = TSurfaceKelvin * TSurfaceKelvin;
+
+			const float Shortwave = (1 - SnowAlbedo) * Forcing.Shortwave * Cells.RadiationIndex[Index]; // W/m^2
+			const float Longwave = Constants.LongwaveIn * TAirKelvin2 * TAirKelvin2 * TAirKelvin2 - Constants.LongwaveOut * TSurfaceKelvin2 * TSurfaceKelvin2; // W/m^2
+			const float Sensible = Cells.SensibleTransfer[Index] * Forcing.WindSpeed * (TAir - TSurface); // W/m^2
+			const float Latent = Constants.LatentTransfer * (Parameters.RelativeHumidity * GetSaturationVapourPressure(TAir) - GetSaturationVapourPressure(TSurface)); // W/m^2
+			const float Rain = FMath::Max(0.0f, Precipitation) * (1 - SnowRate) * FMath::Max(TAir, 0.0f) * Constants.RainHeat; // W/m^2
+
+			const float NetFlux = Shortwave + Longwave + Sensible + Latent + Rain + Parameters.GroundHeatFlux;
+
+			// Melt and sublimation or deposition
+			Melt = FMath::Max(NetFlux, 0.0f) * Constants.MeltPerFlux; // mm
+			Sublimation = Latent * Constants.SublimationPerFlux; // mm
+			Refreezing = FMath::Max(-NetFlux, 0.0f) * Constants.MeltPerFlux; // mm
+
+			SnowWaterEquivalent = FMath::Max(0.0f, SnowWaterEquivalent + (Sublimation - Melt) * AreaSquareMeters);
+		}
+
+		if (Cells.Snowfall)
+		{
+			Cells.Snowfall[Index] = Snowfall;
+			Cells.Melt[Index] = Melt;
+			Cells.Sublimation[Index] = Sublimation;
+			Cells.Refreezing[Index] = Refreezing;
+		}
+
+		// Interpolation according to Bloeschls "Distributed Snowmelt Simulations in an Alpine Catchment"
+		if (Cells.Interpolate)
+		{
+			const float we = FMath::Max(0.0f, SnowWaterEquivalent * Cells.InterpolationFactor[Index]);
+			Cells.InterpolatedSnowWaterEquivalent[Index] = we;
+			MaxSnow = FMath::Max(MaxSnow, we * Cells.InverseAreaSquareMeters[Index]);
+		}
+	}
+
+	return MaxSnow;
+}
+
+/** Returns the saturation vapour pressure in hPa of four temperatures in degree Celsius. */
+static FORCEINLINE VectorRegister VectorSaturationVapourPressure(const VectorRegister& Temperature, const VectorRegister* Coefficients)
+{
+	VectorRegister Result = Coefficients[6];
+	for (int32 Coefficient = 5; Coefficient >= 0; --Coefficient)
+	{
+		Result = VectorMultiplyAdd(Result, Temperature, Coefficients[Coefficient]);
+	}
+	return Result;
+}
+
+float FEnergyBalanceKernel::SimulateVector(const FEnergyBalanceCellRange& Cells, const FEnergyBalanceParameters& Parameters, const FEnergyBalanceForcing& Forcing)
+{
+	const int32 NumVectorized = Cells.Num & ~3;
+
+	const FEnergyBalanceHourConstants Constants(Parameters, Forcing);
+
+	const VectorRegister Zero = VectorZero();
+	const VectorRegister One = VectorOne();
+	const VectorRegister Temperature = VectorSetFloat1(Forcing.Temperature);
+	const VectorRegister Precipitation = VectorSetFloat1(Forcing.Precipitation);
+	const VectorRegister MeasurementAltitude = VectorSetFloat1(Forcing.MeasurementAltitude);
+	const VectorRegister TemperatureLapseRate = VectorSetFloat1(Constants.TemperatureLapseRate);
+	const VectorRegister PrecipitationLapseRate = VectorSetFloat1(Constants.PrecipitationLapseRate);
+	const VectorRegister MinTemperature = VectorSetFloat1(MinAirTemperature);
+	const VectorRegister MaxTemperature = VectorSetFloat1(MaxAirTemperature);
+	const VectorRegister SquareCentimetersToSquareMeters = VectorSetFloat1(1.0f / (100 * 100));
+	const VectorRegister TSnowA = VectorSetFloat1(Parameters.TSnowA);
+	const VectorRegister TSnowB = VectorSetFloat1(Parameters.TSnowB);
+	const VectorRegister InvSnowRange = VectorSetFloat1(Constants.InvSnowRange);
+	const VectorRegister RainAlbedo = VectorSetFloat1(0.4f);
+	const VectorRegister NewSnowAlbedo = VectorSetFloat1(0.8f);
+	const VectorRegister AlbedoDecay = VectorSetFloat1(Constants.AlbedoDecay);
+	const VectorRegister ZeroCelsius = VectorSetFloat1(273.15f);
+	const VectorRegister Shortwave = VectorSetFloat1(Forcing.Shortwave);
+	const VectorRegister LongwaveIn = VectorSetFloat1(Constants.LongwaveIn);
+	const VectorRegister LongwaveOut = VectorSetFloat1(Constants.LongwaveOut);
+	const VectorRegister WindSpeed = VectorSetFloat1(Forcing.WindSpeed);
+	const VectorRegister LatentTransfer = VectorSetFloat1(Constants.LatentTransfer);
+	const VectorRegister RelativeHumidity = VectorSetFloat1(Parameters.RelativeHumidity);
+	const VectorRegister RainHeat = VectorSetFloat1(Constants.RainHeat);
+	const VectorRegister GroundHeatFlux = VectorSetFloat1(Parameters.GroundHeatFlux);
+	const VectorRegister MeltPerFlux = VectorSetFloat1(Constants.MeltPerFlux);
+	const VectorRegister SublimationPerFlux = VectorSetFloat1(Constants.SublimationPerFlux);
+
+	const VectorRegister VapourPressureCoefficients[7] =
+	{
+		VectorSetFloat1(6.107799961f), VectorSetFloat1(4.436518521e-1f), VectorSetFloat1(1.428945805e-2f), VectorSetFloat1(2.650648471e-4f),
+		VectorSetFloat1(3.031240396e-6f), VectorSetFloat1(2.034080948e-8f), VectorSetFloat1(6.136820929e-11f)
+	};
+
+	VectorRegister MaxSnow = Zero;
+
+	for (int32 Index = 0; Index < NumVectorized; Index += 4)
+	{
+		VectorRegister SnowWaterEquivalent = VectorLoad(Cells.SnowWaterEquivalent + Index);
+		VectorRegister SnowAlbedo = VectorLoad(Cells.SnowAlbedo + Index);
+
+		const VectorRegister Altitude = VectorSubtract(VectorLoad(Cells.Altitude + Index), MeasurementAltitude);
+		const VectorRegister TAir = VectorMin(VectorMax(VectorMultiplyAdd(Altitude, TemperatureLapseRate, Temperature), MinTemperature), MaxTemperature);
+		const VectorRegister CellPrecipitation = VectorMultiplyAdd(Altitude, PrecipitationLapseRate, Precipitation);
+		const VectorRegister AreaSquareMeters = VectorMultiply(VectorLoad(Cells.AreaXY + Index), SquareCentimetersToSquareMeters);
+		const VectorRegister SnowRate = VectorMin(VectorMax(VectorSubtract(One, VectorMultiply(VectorSubtract(TAir, TSnowA), InvSnowRange)), Zero), One);
+
+		// Apply precipitation
+		const VectorRegister PrecipitationMask = VectorCompareGT(CellPrecipitation, Zero);
+
+		SnowWaterEquivalent = VectorAdd(SnowWaterEquivalent, VectorSelect(PrecipitationMask, VectorMultiply(VectorMultiply(CellPrecipitation, SnowRate), AreaSquareMeters), Zero));
+		SnowAlbedo = VectorSelect(PrecipitationMask, VectorSelect(VectorCompareGT(TAir, TSnowB), RainAlbedo, NewSnowAlbedo), SnowAlbedo);
+
+		const VectorRegister SnowMask = VectorCompareGT(SnowWaterEquivalent, Zero);
+
+		const VectorRegister Snowfall = VectorSelect(PrecipitationMask, VectorMultiply(CellPrecipitation, SnowRate), Zero);
+		VectorRegister Melt = Zero;
+		VectorRegister Sublimation = Zero;
+		VectorRegister Refreezing = Zero;
+
+		if (VectorMaskBits(SnowMask))
+		{
+			SnowAlbedo = VectorSelect(SnowMask, VectorMultiplyAdd(VectorSubtract(SnowAlbedo, RainAlbedo), AlbedoDecay, RainAlbedo), SnowAlbedo);
+
+			// The surface can not be warmer than the melting point
+			const VectorRegister TSurface = VectorMin(TAir, Zero);
+			const VectorRegister TAirKelvin = VectorAdd(TAir, ZeroCelsius);
+			const VectorRegister TSurfaceKelvin = VectorAdd(TSurface, ZeroCelsius);
+			const VectorRegister TAirKelvin2 = VectorMultiply(TAirKelvin, TAirKelvin);
+			const VectorRegister TSurfaceKelvin2 = VectorMultiply(TSurfaceKelvin, TSurfaceKelvin);
+
+			const VectorRegister CellShortwave = VectorMultiply(VectorMultiply(VectorSubtract(One, SnowAlbedo), Shortwave), VectorLoad(Cells.RadiationIndex + Index));
+			const VectorRegister Longwave = VectorSubtract(
+				VectorMultiply(LongwaveIn, VectorMultiply(VectorMultiply(TAirKelvin2, TAirKelvin2), TAirKelvin2)),
+				VectorMultiply(LongwaveOut, VectorMultiply(TSurfaceKelvin2, TSurfaceKelvin2)));
+			const VectorRegister Sensible = VectorMultiply(VectorMultiply(VectorLoad(Cells.SensibleTransfer + Index), WindSpeed), VectorSubtract(TAir, TSurface));
+			const VectorRegister Latent = VectorMultiply(LatentTransfer, VectorSubtract(
+				VectorMultiply(RelativeHumidity, VectorSaturationVapourPressure(TAir, VapourPressureCoefficients)),
+				VectorSaturationVapourPressure(TSurface, VapourPressureCoefficients)));
+			const VectorRegister Rain = VectorMultiply(VectorMultiply(VectorMultiply(VectorMax(CellPrecipitation, Zero), VectorSubtract(One, SnowRate)), VectorMax(TAir, Zero)), RainHeat);
+
+			const VectorRegister NetFlux = VectorAdd(VectorAdd(VectorAdd(CellShortwave, Longwave), VectorAdd(Sensible, Latent)), VectorAdd(Rain, GroundHeatFlux));
+
+			// Melt and sublimation or deposition
+			Melt = VectorSelect(SnowMask, VectorMultiply(VectorMax(NetFlux, Zero), MeltPerFlux), Zero);
+			Sublimation = VectorSelect(SnowMask, VectorMultiply(Latent, SublimationPerFlux), Zero);
+			Refreezing = VectorSelect(SnowMask, VectorMultiply(VectorMax(VectorNegate(NetFlux), Zero), MeltPerFlux), Zero);
+
+			SnowWaterEquivalent = VectorSelect(SnowMask, VectorMax(Zero, VectorMultiplyAdd(VectorSubtract(Sublimation, Melt), AreaSquareMeters, SnowWaterEquivalent)), SnowWaterEquivalent);
+		}
+
+		if (Cells.Snowfall)
+		{
+			VectorStore(Snowfall, Cells.Snowfall + Index);
+			VectorStore(Melt, Cells.Melt + Index);
+			VectorStore(Sublimation, Cells.Sublimation + Index);
+			VectorStore(Refreezing, Cells.Refreezing + Index);
+		}
+
+		VectorStore(SnowWaterEquivalent, Cells.SnowWaterEquivalent + Index);
+		VectorStore(SnowAlbedo, Cells.SnowAlbedo + Index);
+
+		// Interpolation according to Bloeschls "Distributed Snowmelt Simulations in an Alpine Catchment"
+		if (Cells.Interpolate)
+		{
+			const VectorRegister InterpolatedSnowWaterEquivalent = VectorMax(Zero, VectorMultiply(SnowWaterEquivalent, VectorLoad(Cells.InterpolationFactor + Index)));
+			VectorStore(InterpolatedSnowWaterEquivalent, Cells.InterpolatedSnowWaterEquivalent + Index);
+			MaxSnow = VectorMax(MaxSnow, VectorMultiply(InterpolatedSnowWaterEquivalent, VectorLoad(Cells.InverseAreaSquareMeters + Index)));
+		}
+	}
+
+	float Lanes[4];
+	VectorStore(MaxSnow, Lanes);
+	float RangeMaxSnow = FMath::Max(FMath::Max(Lanes[0], Lanes[1]), FMath::Max(Lanes[2], Lanes[3]));
+
+	// Remaining cells which do not fill a vector
+	if (NumVectorized < Cells.Num)
+	{
+		RangeMaxSnow = FMath::Max(RangeMaxSnow, SimulateScalar(Cells.Slice(NumVectorized), Parameters, Forcing));
+	}
+
+	return RangeMaxSnow;
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include "EnergyBalanceSimulation.h"
+#include "Cells/SimulationCellStore.h"
+#include "ClimateData.h"
+
+/**
+* Pointers to the arrays of a contiguous range of cells. The first element of every array belongs to the first cell of
+* the range.
+*/
+struct FEnergyBalanceCellRange
+{
+	/** Number of cells in the range. */
+	int32 Num;
+
+	float* SnowWaterEquivalent;
+	float* SnowAlbedo;
+
+	const float* AreaXY;
+	const float* Altitude;
+
+	/** Precomputed radiation index of the current day. */
+	const float* RadiationIndex;
+
+	/** Precomputed sensible heat transfer coefficient in W/(m^2 K) per m/s of wind, see FEnergyBalanceKernel::GetSensibleTransfer. */
+	const float* SensibleTransfer;
+
+	float* InterpolatedSnowWaterEquivalent;
+	const float* InterpolationFactor;
+	const float* InverseAreaSquareMeters;
+
+	/** Snowfall of the hour in mm or null, see FSnowpackKernel. */
+	float* Snowfall = nullptr;
+
+	/** Melt of the hour in mm or null. */
+	float* Melt = nullptr;
+
+	/** Sublimation (negative) or deposition of the hour in mm or null. */
+	float* Sublimation = nullptr;
+
+	/** Liquid water in mm the energy deficit of the hour can refreeze or null. */
+	float* Refreezing = nullptr;
+
+	/** Whether the kernel interpolates the snow of the cells after the hour. */
+	bool Interpolate = false;
+
+	/**
+	* Creates the range [BeginIndex, EndIndex) of the given cells.
+	*
+	* @param DayRadiationIndex		Precomputed radiation index of all cells for the current day
+	* @param CellSensibleTransfer	Sensible heat transfer coefficient of all cells
+	*/
+	FEnergyBalanceCellRange(FSimulationCellStore& Cells, int32 BeginIndex, int32 EndIndex, const float* DayRadiationIndex, const float* CellSensibleTransfer) :
+		Num(EndIndex - BeginIndex),
+		SnowWaterEquivalent(Cells.SnowWaterEquivalent.GetData() + BeginIndex),
+		SnowAlbedo(Cells.SnowAlbedo.GetData() + BeginIndex),
+		AreaXY(Cells.AreaXY.GetData() + BeginIndex),
+		Altitude(Cells.Altitude.GetData() + BeginIndex),
+		RadiationIndex(DayRadiationIndex + BeginIndex),
+		SensibleTransfer(CellSensibleTransfer + BeginIndex),
+		InterpolatedSnowWaterEquivalent(Cells.InterpolatedSnowWaterEquivalent.GetData() + BeginIndex),
+		InterpolationFactor(Cells.InterpolationFactor.GetData() + BeginIndex),
+		InverseAreaSquareMeters(Cells.InverseAreaSquareMeters.GetData() + BeginIndex)
+	{
+	}
+
+	/** Returns the cells of this range starting at the given offset. */
+	FEnergyBalanceCellRange Slice(int32 Offset) const
+	{
+		FEnergyBalanceCellRange Range = *this;
+		Range.Num -= Offset;
+		Range.SnowWaterEquivalent += Offset;
+		Range.SnowAlbedo += Offset;
+		Range.AreaXY += Offset;
+		Range.Altitude += Offset;
+		Range.RadiationIndex += Offset;
+		Range.SensibleTransfer += Offset;
+		Range.InterpolatedSnowWaterEquivalent += Offset;
+		Range.InterpolationFactor += Offset;
+		Range.InverseAreaSquareMeters += Offset;
+		if (Range.Snowfall) Range.Snowfall += Offset;
+		if (Range.Melt) Range.Melt += Offset;
+		if (Range.Sublimation) Range.Sublimation += Offset;
+		if (Range.Refreezing) Range.Refreezing += Offset;
+		return Range;
+	}
+};
+
+/** Climate forcing of a single simulation hour, everything which does not depend on the cell is evaluated once per hour. */
+struct FEnergyBalanceForcing
+{
+	/** Air temperature at the measurement altitude in degree Celsius. */
+	float Temperature;
+
+	/** Precipitation at the measurement altitude in l/m^2 or mm. */
+	float Precipitation;
+
+	/** Altitude of the measurement in cm. */
+	float MeasurementAltitude;
+
+	/** Incoming shortwave radiation on a horizontal surface below the clouds in W/m^2. */
+	float Shortwave;
+
+	/** Fraction of the sky covered by clouds [0-1]. */
+	float CloudCover;
+
+	/** Wind speed in m/s. */
+	float WindSpeed;
+};
+
+/**
+* Energy balance kernels which advance a range of cells by one hour.
+*
+* The net energy flux into the snow surface is the sum of the absorbed shortwave radiation, the incoming longwave
+* radiation of the atmosphere minus the longwave emission of the snow, the sensible and latent heat exchanged with the
+* air, the heat of the rain and a constant ground heat flux. The surface is at the air temperature but never above
+* zero, a positive flux melts snow and the latent heat flux sublimates or deposits snow.
+*
+* All nonlinear terms are polynomials of the air temperature: the clear sky longwave radiation follows Swinbank's
+* "Long-wave radiation from clear skies" and the saturation vapour pressure Lowe's "An approximating polynomial for the
+* computation of saturation vapor pressure". The vector kernel therefore needs no transcendental functions and processes
+* four cells per instruction, the albedo ages by a constant factor per hour. Its results agree with the scalar kernel
+* within a relative error of 1e-5 of the snow water equivalent per hour.
+*
+* If the range has flux arrays, the kernels store the snowfall, melt, sublimation and refreezing of every cell in mm,
+* they are zero for cells without snow. A layered snowpack applies them instead of the kernel's own snow update.
+*
+* If the range interpolates, the kernels also store the snow water equivalent after interpolation in the same pass and
+* return the maximum snow amount (mm) of the range, they return zero otherwise.
+*/
+class SIMULATION_API FEnergyBalanceKernel
+{
+public:
+	/** Simulates one hour for the given cells using scalar code. */
+	static float SimulateScalar(const FEnergyBalanceCellRange& Cells, const FEnergyBalanceParameters& Parameters, const FEnergyBalanceForcing& Forcing);
+
+	/** Simulates one hour for the given cells using vector instructions. */
+	static float SimulateVector(const FEnergyBalanceCellRange& Cells, const FEnergyBalanceParameters& Parameters, const FEnergyBalanceForcing& Forcing);
+
+	/**
+	* Returns the forcing of an hour which is shared by all cells.
+	*
+	* @param Climate				The weather of the hour
+	* @param Wind					The wind of the hour or null if there is no wind data
+	* @param MeasurementAltitude	Altitude of the measurement in cm
+	* @param Latitude				Mean latitude of the cells in radians
+	* @param DayOfYear				Day of the year of the hour
+	* @param DiurnalFactor			Factor of the daily radiation for the hour of the day, see FSolarRadiationTable::GetDiurnalFactor
+	*/
+	static FEnergyBalanceForcing GetForcing(const FEnergyBalanceParameters& Parameters, const FClimateData& Climate, const FWindData* Wind, float MeasurementAltitude,
+		float Latitude, int32 DayOfYear, float DiurnalFactor);
+
+	/** Returns the sensible heat transfer coefficient in W/(m^2 K) per m/s of wind at the given altitude in cm. */
+	static float GetSensibleTransfer(const FEnergyBalanceParameters& Parameters, float Altitude);
+
+	/** Returns the saturation vapour pressure in hPa over water at the given temperature in degree Celsius. */
+	static float GetSaturationVapourPressure(float Temperature)
+	{
+		return 6.107799961f + Temperature * (4.436518521e-1f + Temperature * (1.428945805e-2f + Temperature * (2.650648471e-4f
+			+ Temperature * (3.031240396e-6f + Temperature * (2.034080948e-8f + Temperature * 6.136820929e-11f)))));
+	}
+};
@@ -0,0 +1,225 @@
+#include "Simulation.h"
+#include "EnergyBalanceSimulation.h"
+#include "EnergyBalanceKernel.h"
+#include "SnowpackKernel.h"
+#include "SnowSimulationActor.h"
+#include "Util/TextureUtil.h"
+#include "ParallelFor.h"
+
+FString UEnergyBalanceSimulation::GetSimulationName()
+{
+	return FString(TEXT("Energy Balance CPU"));
+}
+
+DECLARE_CYCLE_STAT(TEXT("Energy Balance Simulate"), STAT_EnergyBalanceSimulate, STATGROUP_SnowSimulation);
+
+void UEnergyBalanceSimulation::Simulate(ASnowSimulationActor* SimulationActor, int32 CurrentSimulationStep, int32 Timesteps, bool SaveSnowMap, bool CaptureDebugInformation, TArray<FDebugCell>& DebugCells)
+{
+	SCOPE_CYCLE_COUNTER(STAT_EnergyBalanceSimulate);
+
+	const double StartSeconds = FPlatformTime::Seconds();
+
+	const int32 NumCells = Cells.Num();
+	const int32 NumHours = FMath::Clamp(ClimateData.Num() - CurrentSimulationStep, 0, Timesteps);
+	const float MeasurementAltitude = SimulationActor->ClimateDataComponent->GetMeasurementAltitude();
+
+	// The precomputed factors of the cells depend on the parameters
+	if (!(InterpolationFactorParameters == Interpolation))
+	{
+		UpdateInterpolationFactors();
+	}
+	if (SensibleTransferCoefficient != Parameters.BulkTransferCoefficient)
+	{
+		UpdateSensibleTransfer();
+	}
+
+	// Forcing of all hours of this step
+	TArray<FEnergyBalanceForcing> HourForcing;
+	TArray<const float*> HourRadiationIndex;
+	for (int32 Hour = 0; Hour < NumHours; ++Hour)
+	{
+		const int32 ClimateHour = CurrentSimulationStep + Hour;
+		const FDateTime Time = SimulationActor->CurrentSimulationTime + FTimespan(Hour, 0, 0);
+		const int32 DayOfYear = Time.GetDayOfYear();
+		const FWindData* Wind = ClimateHour < WindData.Num() ? &WindData.Get(ClimateHour) : nullptr;
+
+		HourForcing.Add(FEnergyBalanceKernel::GetForcing(Parameters, ClimateData.Get(ClimateHour), Wind, MeasurementAltitude, MeanLatitude, DayOfYear,
+			RadiationTable.GetDiurnalFactor(DayOfYear, Time.GetHour())));
+		HourRadiationIndex.Add(RadiationTable.GetDay(DayOfYear));
+	}
+
+	// Split the grid into tiles of rows, every tile is advanced through all hours of the step
+	const int32 CellsPerTile = FMath::Max(1, TileRows) * CellsDimensionX;
+	const int32 NumTiles = FMath::DivideAndRoundUp(NumCells, CellsPerTile);
+	TileMaxSnow.SetNumZeroed(NumTiles);
+
+	const bool Layered = Layers.Num() == NumCells;
+
+	auto SimulateTile = [&](int32 Tile)
+	{
+		const int32 BeginIndex = Tile * CellsPerTile;
+		const int32 EndIndex = FMath::Min(BeginIndex + CellsPerTile, NumCells);
+
+		float TileMax = 0;
+		for (int32 Hour = 0; Hour < NumHours; ++Hour)
+		{
+			// Only the last hour interpolates
+			FEnergyBalanceCellRange Range(Cells, BeginIndex, EndIndex, HourRadiationIndex[Hour], SensibleTransfer.GetData());
+			Range.Interpolate = Hour == NumHours - 1 && !Layered;
+
+			if (Layered)
+			{
+				Range.Snowfall = Snowfall.GetData() + BeginIndex;
+				Range.Melt = Melt.GetData() + BeginIndex;
+				Range.Sublimation = Sublimation.GetData() + BeginIndex;
+				Range.Refreezing = Refreezing.GetData() + BeginIndex;
+			}
+
+			TileMax = UseVectorKernel ? FEnergyBalanceKernel::SimulateVector(Range, Parameters, HourForcing[Hour]) : FEnergyBalanceKernel::SimulateScalar(Range, Parameters, HourForcing[Hour]);
+
+			// The layers replace the snow update of the kernel
+			if (Layered)
+			{
+				Range.Interpolate = Hour == NumHours - 1;
+				TileMax = FSnowpackKernel::Simulate(Layers, Range, BeginIndex, Parameters, Snowpack, HourForcing[Hour]);
+			}
+		}
+
+		TileMaxSnow[Tile] = TileMax;
+	};
+
+	if (ParallelExecution)
+	{
+		ParallelFor(NumTiles, SimulateTile);
+	}
+	else
+	{
+		for (int32 Tile = 0; Tile < NumTiles; ++Tile)
+		{
+			SimulateTile(Tile);
+		}
+	}
+
+	if (NumHours > 0)
+	{
+		MaxSnow = 0;
+		for (float TileMax : TileMaxSnow)
+		{
+			MaxSnow = FMath::Max(MaxSnow, TileMax);
+		}
+	}
+
+	if (CaptureDebugInformation)
+	{
+		// Fill debug array
+		for (int32 Index = 0; Index < NumCells && Index < DebugCells.Num(); ++Index)
+		{
+			DebugCells[Index].SnowMM = Cells.GetInterpolatedSnowHeight(Index);
+		}
+	}
+
+	const double Seconds = FPlatformTime::Seconds() - StartSeconds;
+	UE_LOG(SimulationLog, Display, TEXT("Iteration %d (%d hours) took %f ms, %.1f Mcells/s"), CurrentSimulationStep, NumHours, Seconds * 1000,
+		static_cast<double>(NumCells) * NumHours / FMath::Max(Seconds, 1e-9) / 1e6);
+}
+
+void UEnergyBalanceSimulation::UpdateInterpolationFactors()
+{
+	for (int32 Index = 0; Index < Cells.Num(); ++Index)
+	{
+		Cells.InterpolationFactor[Index] = Interpolation.GetInterpolationFactor(Cells.Inclination[Index], Cells.Curvature[Index]);
+	}
+	InterpolationFactorParameters = Interpolation;
+}
+
+void UEnergyBalanceSimulation::UpdateSensibleTransfer()
+{
+	SensibleTransfer.SetNumUninitialized(Cells.Num());
+	for (int32 Index = 0; Index < Cells.Num(); ++Index)
+	{
+		SensibleTransfer[Index] = FEnergyBalanceKernel::GetSensibleTransfer(Parameters, Cells.Altitude[Index]);
+	}
+	SensibleTransferCoefficient = Parameters.BulkTransferCoefficient;
+}
+
+void UEnergyBalanceSimulation::Initialize(ASnowSimulationActor* SimulationActor, const TArray<FLandscapeCell>& LandscapeCells, float InitialMaxSnow, UWorld* World)
+{
+	CellsDimensionX = SimulationActor->CellsDimensionX;
+	CellsDimensionY = SimulationActor->CellsDimensionY;
+
+	// The weather data is owned by the provider and does not change during the simulation
+	ClimateData = SimulationActor->ClimateDataComponent->GetClimateDataView();
+	WindData = SimulationActor->ClimateDataComponent->GetWindDataView();
+
+	Cells.Initialize(LandscapeCells, CellsDimensionX, CellsDimensionY);
+	MaxSnow = InitialMaxSnow;
+
+	UpdateInterpolationFactors();
+	UpdateSensibleTransfer();
+
+	Layers.Reset();
+	Snowfall.Empty();
+	Melt.Empty();
+	Sublimation.Empty();
+	Refreezing.Empty();
+	if (LayeredSnowpack)
+	{
+		Layers.Initialize(Cells, Snowpack.InitialDensity);
+		Snowfall.SetNumZeroed(Cells.Num());
+		Melt.SetNumZeroed(Cells.Num());
+		Sublimation.SetNumZeroed(Cells.Num());
+		Refreezing.SetNumZeroed(Cells.Num());
+	}
+
+	double LatitudeSum = 0;
+	for (int32 Index = 0; Index < Cells.Num(); ++Index)
+	{
+		LatitudeSum += Cells.Latitude[Index];
+	}
+	MeanLatitude = Cells.Num() > 0 ? LatitudeSum / Cells.Num() : 0.0f;
+
+	// Precompute the radiation geometry
+	RadiationTable.Reset();
+	RadiationTable.Build(Cells, FMath::Max(1, RadiationTableDayStride));
+	RadiationTable.BuildDiurnalFactors(Cells);
+
+	UE_LOG(SimulationLog, Display, TEXT("Energy balance uses %.2f MB for %d cells, radiation table took %f ms to build, %s"),
+		(Cells.GetAllocatedSize() + SensibleTransfer.GetAllocatedSize() + RadiationTable.GetAllocatedSize() + Layers.GetAllocatedSize()
+			+ Snowfall.GetAllocatedSize() + Melt.GetAllocatedSize() + Sublimation.GetAllocatedSize() + Refreezing.GetAllocatedSize()) / (1024.0f * 1024.0f), Cells.Num(),
+		RadiationTable.GetBuildSeconds() * 1000, WindData.Num() > 0 ? TEXT("wind from the weather data") : TEXT("constant wind"));
+}
+
+UTexture* UEnergyBalanceSimulation::GetSnowMapTexture()
+{
+	SnowMapTexture = UTexture2D::CreateTransient(CellsDimensionX, CellsDimensionY, EPixelFormat::PF_G16);
+
+	SnowMapTexture->UpdateResource();
+	SnowMapTextureData.Empty(Cells.Num());
+
+	for (int32 Index = 0; Index < Cells.Num(); ++Index)
+	{
+		float Gray = Cells.GetInterpolatedSnowHeight(Index) / GetMaxSnow() * 255;
+		uint8 GrayInt = static_cast<uint8>(Gray);
+		SnowMapTextureData.Add(FColor(GrayInt, GrayInt, GrayInt));
+	}
+
+	FRenderCommandFence UpdateTextureFence;
+
+	UpdateTextureFence.BeginFence();
+
+	UpdateTexture(SnowMapTexture, SnowMapTextureData);
+
+	UpdateTextureFence.Wait();
+
+	return SnowMapTexture;
+}
+
+float UEnergyBalanceSimulation::GetMaxSnow()
+{
+	return MaxSnow;
+}
+
+void UEnergyBalanceSimulation::RenderDebug(UWorld* World, int CellDebugInfoDisplayDistance, EDebugVisualizationType DebugVisualizationType)
+{
+
+}
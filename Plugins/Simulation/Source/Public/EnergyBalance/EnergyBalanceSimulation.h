@@ -0,0 +1,206 @@
+#pragma once
+
+#include "SimulationBase.h"
+#include "DegreeDay/DegreeDaySimulation.h"
+#include "Cells/SimulationCellStore.h"
+#include "Cells/SnowLayerStore.h"
+#include "ClimateData.h"
+#include "Radiation/SolarRadiationTable.h"
+#include "EnergyBalanceSimulation.generated.h"
+
+/** Parameters of the energy balance model which are used by the simulation kernels. */
+USTRUCT(BlueprintType)
+struct SIMULATION_API FEnergyBalanceParameters
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** Threshold A air temperature above which some precipitation is assumed to be rain. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation", DisplayName = "TSnow A")
+	float TSnowA = 0;
+
+	/** Threshold B air temperature above which all precipitation is assumed to be rain. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation", DisplayName = "TSnow B")
+	float TSnowB = 2;
+
+	/** Time constant of the aging of the albedo in 1/day. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation", DisplayName = "k_e")
+	float k_e = 0.2;
+
+	/** Fraction of the extraterrestrial radiation which reaches the ground under a clear sky. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation", meta = (ClampMin = "0", ClampMax = "1"))
+	float Transmissivity = 0.75f;
+
+	/** Cloud cover [0-1] of hours without precipitation, hours with precipitation are overcast. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation", meta = (ClampMin = "0", ClampMax = "1"))
+	float DryCloudCover = 0.3f;
+
+	/** Relative humidity of the air [0-1]. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation", meta = (ClampMin = "0", ClampMax = "1"))
+	float RelativeHumidity = 0.7f;
+
+	/** Wind speed in m/s used if the weather data provider has no wind data. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation", meta = (ClampMin = "0"))
+	float WindSpeed = 2;
+
+	/** Bulk transfer coefficient of the sensible and latent heat. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation")
+	float BulkTransferCoefficient = 0.002f;
+
+	/** Heat flux from the ground into the snow in W/m^2. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation")
+	float GroundHeatFlux = 2;
+
+	/** Longwave emissivity of the snow surface. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation", meta = (ClampMin = "0", ClampMax = "1"))
+	float SnowEmissivity = 0.99f;
+};
+
+/** Parameters of the layered snowpack, see FSnowpackKernel. */
+USTRUCT(BlueprintType)
+struct SIMULATION_API FSnowpackParameters
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** Snow falling on a surface layer younger than this in days is added to it instead of starting a new layer. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation", meta = (ClampMin = "0"))
+	float NewLayerAge = 1;
+
+	/** Layers below the surface with less frozen water in mm are merged into a neighbour. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation", meta = (ClampMin = "0"))
+	float MinLayerMass = 2;
+
+	/** Liquid water a layer holds against gravity as fraction of its frozen water, the excess percolates downwards. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation", meta = (ClampMin = "0", ClampMax = "1"))
+	float HoldingCapacity = 0.05f;
+
+	/** Density in kg/m^3 which dry snow approaches by settling. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation", meta = (ClampMin = "50"))
+	float MaxDryDensity = 300;
+
+	/** Density in kg/m^3 which wet snow approaches by settling. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation", meta = (ClampMin = "50"))
+	float MaxWetDensity = 500;
+
+	/** Rate of the settling towards the maximum density in 1/hour. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation", meta = (ClampMin = "0"))
+	float CompactionRate = 0.01f;
+
+	/** Density in kg/m^3 of the snow the cells start with. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation", meta = (ClampMin = "50"))
+	float InitialDensity = 300;
+};
+
+/**
+* Snow simulation driven by the energy balance of the snow surface instead of a degree day factor. The shortwave
+* radiation of a cell is the radiation on a horizontal surface below the clouds times the precomputed radiation index of
+* the cell, the longwave radiation and the turbulent fluxes follow the lapse rate adjusted air temperature. See
+* FEnergyBalanceKernel for the fluxes.
+*
+* The cells are stored as structure of arrays and simulated in tiles of rows on the task graph, every tile is advanced
+* through all hours of a time step. Everything which only depends on the terrain, the radiation index of every day and
+* the air density of every cell, is computed once in Initialize.
+*
+* With a layered snowpack the kernel only computes the fluxes and FSnowpackKernel applies them to up to
+* FSnowLayerStore::MaxLayers layers per cell which track density, age and liquid water.
+*/
+UCLASS(Blueprintable, BlueprintType)
+class SIMULATION_API UEnergyBalanceSimulation : public USimulationBase
+{
+	GENERATED_BODY()
+private:
+	/** The cells of the simulation. */
+	FSimulationCellStore Cells;
+
+	/** The weather data of the provider. */
+	FClimateDataView ClimateData;
+
+	/** The wind data of the provider, empty if the provider has none. */
+	FWindDataView WindData;
+
+	/** Precomputed solar radiation index and diurnal factors of the cells. */
+	FSolarRadiationTable RadiationTable;
+
+	/** Sensible heat transfer coefficient of every cell. */
+	FAlignedFloatArray SensibleTransfer;
+
+	/** The snow layers of the cells, empty without a layered snowpack. */
+	FSnowLayerStore Layers;
+
+	/** Fluxes of the current hour of every cell which the kernel passes to the layered snowpack. */
+	FAlignedFloatArray Snowfall;
+	FAlignedFloatArray Melt;
+	FAlignedFloatArray Sublimation;
+	FAlignedFloatArray Refreezing;
+
+	/** Mean latitude of the cells in radians. */
+	float MeanLatitude;
+
+	/** The snow mask used by the landscape material. */
+	UTexture2D* SnowMapTexture;
+
+	/** Color buffer for the snow mask texture. */
+	TArray<FColor> SnowMapTextureData;
+
+	/** The maximum snow amount (mm) of the current time step. */
+	float MaxSnow;
+
+	/** The maximum snow amount (mm) of every tile of the current time step. */
+	TArray<float> TileMaxSnow;
+
+	/** The interpolation parameters the interpolation factors of the cells were computed with. */
+	FBloeschlParameters InterpolationFactorParameters;
+
+	/** The bulk transfer coefficient the sensible heat transfer coefficients were computed with. */
+	float SensibleTransferCoefficient;
+
+	/** Computes the interpolation factors of the cells for the current interpolation parameters. */
+	void UpdateInterpolationFactors();
+
+	/** Computes the sensible heat transfer coefficients of the cells for the current parameters. */
+	void UpdateSensibleTransfer();
+
+public:
+	/** The parameters of the energy balance. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation")
+	FEnergyBalanceParameters Parameters;
+
+	/** Whether every cell stores a snowpack of layers with their own density, age and liquid water. Takes effect on Initialize. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation")
+	bool LayeredSnowpack = false;
+
+	/** The parameters of the layered snowpack. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation")
+	FSnowpackParameters Snowpack;
+
+	/** Parameters of the interpolation of the snow. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation")
+	FBloeschlParameters Interpolation;
+
+	/** Whether the cells are simulated in parallel row tiles on the task graph or serially on the game thread. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance")
+	bool ParallelExecution = true;
+
+	/** Number of cell rows per tile. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance", meta = (ClampMin = "1"))
+	int32 TileRows = 8;
+
+	/** Whether the fluxes of four cells are evaluated at once using vector instructions. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance")
+	bool UseVectorKernel = true;
+
+	/** Only every n-th day of the radiation table is stored, the other days use the closest stored day. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Performance", meta = (ClampMin = "1"))
+	int32 RadiationTableDayStride = 1;
+
+	virtual FString GetSimulationName() override;
+
+	virtual void Simulate(ASnowSimulationActor* SimulationActor, int32 CurrentSimulationStep, int32 Timesteps, bool SaveSnowMap, bool CaptureDebugInformation, TArray<FDebugCell>& DebugCells) override final;
+
+	virtual void Initialize(ASnowSimulationActor* SimulationActor, const TArray<FLandscapeCell>& Cells, float InitialMaxSnow, UWorld* World) override;
+
+	virtual void RenderDebug(UWorld* World, int CellDebugInfoDisplayDistance, EDebugVisualizationType DebugVisualizationType) override;
+
+	virtual UTexture* GetSnowMapTexture() override final;
+
+	virtual float GetMaxSnow() override final;
+};
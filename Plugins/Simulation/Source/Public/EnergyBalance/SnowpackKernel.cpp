@@ -0,0 +1,203 @@
+#include "Simulation.h"
+#include "SnowpackKernel.h"
+
+/** The layer slots of a single cell. */
+struct FLayerBlock
+{
+	float* Ice;
+	float* LiquidWater;
+	float* Density;
+	float* Age;
+	int32 Num;
+
+	FLayerBlock(FSnowLayerStore& Layers, int32 Cell) :
+		Ice(Layers.Ice.GetData() + FSnowLayerStore::GetIndex(Cell, 0)),
+		LiquidWater(Layers.LiquidWater.GetData() + FSnowLayerStore::GetIndex(Cell, 0)),
+		Density(Layers.Density.GetData() + FSnowLayerStore::GetIndex(Cell, 0)),
+		Age(Layers.Age.GetData() + FSnowLayerStore::GetIndex(Cell, 0)),
+		Num(Layers.NumLayers[Cell])
+	{
+	}
+
+	/** Adds snow with the given water, density and age to the given layer. The depths of both add up. */
+	void Add(int32 Layer, float AddedIce, float AddedLiquidWater, float AddedDensity, float AddedAge)
+	{
+		const float Mass = Ice[Layer] + LiquidWater[Layer];
+		const float AddedMass = AddedIce + AddedLiquidWater;
+		const float TotalMass = Mass + AddedMass;
+
+		if (TotalMass > 0)
+		{
+			const float Depth = (Density[Layer] > 0 ? Mass / Density[Layer] : 0.0f) + (AddedDensity > 0 ? AddedMass / AddedDensity : 0.0f);
+			Density[Layer] = Depth > 0 ? TotalMass / Depth : AddedDensity;
+			Age[Layer] = (Age[Layer] * Mass + AddedAge * AddedMass) / TotalMass;
+		}
+
+		Ice[Layer] += AddedIce;
+		LiquidWater[Layer] += AddedLiquidWater;
+	}
+
+	/** Merges the layer From into the layer Into and removes it. */
+	void Merge(int32 Into, int32 From)
+	{
+		Add(Into, Ice[From], LiquidWater[From], Density[From], Age[From]);
+		Remove(From);
+	}
+
+	/** Removes the given layer, the layers above move down and the free slot is cleared. */
+	void Remove(int32 Layer)
+	{
+		for (int32 Above = Layer + 1; Above < Num; ++Above)
+		{
+			Ice[Above - 1] = Ice[Above];
+			LiquidWater[Above - 1] = LiquidWater[Above];
+			Density[Above - 1] = Density[Above];
+			Age[Above - 1] = Age[Above];
+		}
+
+		--Num;
+		Ice[Num] = 0;
+		LiquidWater[Num] = 0;
+		Density[Num] = 0;
+		Age[Num] = 0;
+	}
+};
+
+float FSnowpackKernel::Simulate(FSnowLayerStore& Layers, const FEnergyBalanceCellRange& Cells, int32 BeginIndex, const FEnergyBalanceParameters& Parameters, const FSnowpackParameters& Snowpack,
+	const FEnergyBalanceForcing& Forcing)
+{
+	static_assert(FSnowLayerStore::MaxLayers == 8, "The settling processes the slots of a cell as two vectors");
+
+	const float TemperatureLapseRate = -0.5f / (100 * 100);
+
+	const VectorRegister Zero = VectorZero();
+	const VectorRegister Compaction = VectorSetFloat1(FMath::Exp(-Snowpack.CompactionRate));
+	const VectorRegister MaxDryDensity = VectorSetFloat1(Snowpack.MaxDryDensity);
+	const VectorRegister MaxWetDensity = VectorSetFloat1(Snowpack.MaxWetDensity);
+	const VectorRegister HourInDays = VectorSetFloat1(1.0f / 24);
+
+	float MaxSnow = 0;
+
+	for (int32 Index = 0; Index < Cells.Num; ++Index)
+	{
+		const int32 Cell = BeginIndex + Index;
+		FLayerBlock Block(Layers, Cell);
+
+		const float AreaSquareMeters = Cells.AreaXY[Index] / (100 * 100); // m^2
+
+		// New snow continues a young surface layer or starts a new one
+		const float Snowfall = Cells.Snowfall[Index]; // mm
+		if (Snowfall > 0)
+		{
+			const float TAir = Forcing.Temperature + TemperatureLapseRate * (Cells.Altitude[Index] - Forcing.MeasurementAltitude);
+			const float NewSnowDensity = GetNewSnowDensity(TAir);
+
+			if (Block.Num > 0 && Block.Age[Block.Num - 1] < Snowpack.NewLayerAge)
+			{
+				Block.Add(Block.Num - 1, Snowfall, 0, NewSnowDensity, 0);
+			}
+			else
+			{
+				if (Block.Num == FSnowLayerStore::MaxLayers)
+				{
+					Block.Merge(0, 1);
+				}
+
+				const int32 Top = Block.Num++;
+				Block.Ice[Top] = Snowfall;
+				Block.LiquidWater[Top] = 0;
+				Block.Density[Top] = NewSnowDensity;
+				Block.Age[Top] = 0;
+			}
+		}
+
+		if (Block.Num > 0)
+		{
+			const int32 Top = Block.Num - 1;
+
+			// Sublimation and deposition at the surface
+			Block.Ice[Top] = FMath::Max(0.0f, Block.Ice[Top] + Cells.Sublimation[Index]);
+
+			// Melt from the surface downwards
+			float Melt = Cells.Melt[Index];
+			for (int32 Layer = Top; Layer >= 0 && Melt > 0; --Layer)
+			{
+				const float LayerMelt = FMath::Min(Melt, Block.Ice[Layer]);
+				Block.Ice[Layer] -= LayerMelt;
+				Block.LiquidWater[Layer] += LayerMelt;
+				Melt -= LayerMelt;
+			}
+
+			// Refreezing at the surface
+			const float Refreezing = FMath::Min(Cells.Refreezing[Index], Block.LiquidWater[Top]);
+			Block.LiquidWater[Top] -= Refreezing;
+			Block.Ice[Top] += Refreezing;
+
+			// Percolation of the water the layers can not hold
+			float Percolation = 0;
+			for (int32 Layer = Top; Layer >= 0; --Layer)
+			{
+				Block.LiquidWater[Layer] += Percolation;
+				Percolation = FMath::Max(0.0f, Block.LiquidWater[Layer] - Snowpack.HoldingCapacity * Block.Ice[Layer]);
+				Block.LiquidWater[Layer] -= Percolation;
+			}
+			Layers.Runoff[Cell] += Percolation * AreaSquareMeters; // l/m^2 * m^2 = l
+
+			// Remove melted layers and merge thin layers below the surface into a neighbour
+			for (int32 Layer = Block.Num - 1; Layer >= 0; --Layer)
+			{
+				if (Block.Ice[Layer] <= 0)
+				{
+					Layers.Runoff[Cell] += Block.LiquidWater[Layer] * AreaSquareMeters;
+					Block.Remove(Layer);
+				}
+			}
+			for (int32 Layer = Block.Num - 2; Layer >= 0; --Layer)
+			{
+				if (Block.Ice[Layer] < Snowpack.MinLayerMass)
+				{
+					Block.Merge(Layer > 0 ? Layer - 1 : 1, Layer);
+				}
+			}
+		}
+
+		Layers.NumLayers[Cell] = static_cast<uint8>(Block.Num);
+
+		// Settling and aging of all slots, unused slots have no density and stay zero
+		float SnowWaterEquivalent = 0;
+		for (int32 Slot = 0; Slot < FSnowLayerStore::MaxLayers; Slot += 4)
+		{
+			const VectorRegister Density = VectorLoad(Block.Density + Slot);
+			const VectorRegister LiquidWater = VectorLoad(Block.LiquidWater + Slot);
+			const VectorRegister UsedMask = VectorCompareGT(Density, Zero);
+			const VectorRegister MaxDensity = VectorSelect(VectorCompareGT(LiquidWater, Zero), MaxWetDensity, MaxDryDensity);
+
+			// Snow approaches the maximum density but does not loosen if it is already denser
+			const VectorRegister Settled = VectorMax(Density, VectorMultiplyAdd(VectorSubtract(Density, MaxDensity), Compaction, MaxDensity));
+			VectorStore(VectorSelect(UsedMask, Settled, Zero), Block.Density + Slot);
+			VectorStore(VectorSelect(UsedMask, VectorAdd(VectorLoad(Block.Age + Slot), HourInDays), Zero), Block.Age + Slot);
+
+			float Lanes[4];
+			VectorStore(VectorAdd(VectorLoad(Block.Ice + Slot), LiquidWater), Lanes);
+			SnowWaterEquivalent += (Lanes[0] + Lanes[1]) + (Lanes[2] + Lanes[3]);
+		}
+
+		Cells.SnowWaterEquivalent[Index] = SnowWaterEquivalent * AreaSquareMeters; // l/m^2 * m^2 = l
+
+		// The albedo decays with the age of the surface layer as in the energy balance kernel
+		if (Block.Num > 0)
+		{
+			Cells.SnowAlbedo[Index] = 0.4f + 0.4f * FMath::Exp(-Parameters.k_e * Block.Age[Block.Num - 1]);
+		}
+
+		// Interpolation according to Bloeschls "Distributed Snowmelt Simulations in an Alpine Catchment"
+		if (Cells.Interpolate)
+		{
+			const float we = FMath::Max(0.0f, Cells.SnowWaterEquivalent[Index] * Cells.InterpolationFactor[Index]);
+			Cells.InterpolatedSnowWaterEquivalent[Index] = we;
+			MaxSnow = FMath::Max(MaxSnow, we * Cells.InverseAreaSquareMeters[Index]);
+		}
+	}
+
+	return MaxSnow;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Cells/SnowLayerStore.h"
+#include "EnergyBalanceKernel.h"
+
+/**
+* Advances the layered snowpack of a range of cells by one hour with the snowfall, melt, sublimation and refreezing
+* which the energy balance kernel stored in the flux arrays of the range.
+*
+* New snow starts a layer whose density depends on the air temperature as in Hedstrom and Pomeroy's "Measurements and
+* modelling of snow interception in the boreal forest". Melt turns the frozen water of the layers into liquid water from
+* the surface downwards, every layer holds liquid water up to its holding capacity and passes the excess to the layer
+* below, the bottom layer releases it as runoff. An energy deficit refreezes liquid water of the surface layer. The
+* layers settle exponentially towards a maximum density which is higher for wet snow as in Verseghy's "CLASS - A
+* Canadian land surface scheme for GCMS". Layers below the surface which become thinner than the minimum mass are merged
+* into a neighbour and the two lowest layers are merged if a new layer needs a slot.
+*
+* The albedo of a cell follows the age of its surface layer, so old snow which melts free lowers the albedo again. The
+* snow water equivalent of the cells is the frozen and liquid water of all layers.
+*
+* The settling and aging of the eight slots of a cell use vector instructions, the transfers between the layers only
+* visit the used layers. No memory is allocated.
+*/
+class SIMULATION_API FSnowpackKernel
+{
+public:
+	/**
+	* Simulates one hour of the layers of the given cells.
+	*
+	* @param Layers			The layers of all cells
+	* @param Cells			The cells starting at BeginIndex with the fluxes of the hour, their snow water equivalent and albedo are updated
+	* @param BeginIndex		Index of the first cell of the range
+	* @param Parameters		Parameters of the energy balance
+	* @param Snowpack		Parameters of the snowpack
+	* @param Forcing		The forcing of the hour
+	* @return the maximum snow amount (mm) of the range if the range interpolates, zero otherwise
+	*/
+	static float Simulate(FSnowLayerStore& Layers, const FEnergyBalanceCellRange& Cells, int32 BeginIndex, const FEnergyBalanceParameters& Parameters, const FSnowpackParameters& Snowpack,
+		const FEnergyBalanceForcing& Forcing);
+
+	/** Returns the density of new snow in kg/m^3 which falls at the given air temperature in degree Celsius. */
+	static float GetNewSnowDensity(float Temperature)
+	{
+		return FMath::Min(67.92f + 51.25f * FMath::Exp(FMath::Min(Temperature, 2.0f) / 2.59f), 200.0f);
+	}
+};
@@ -0,0 +1,133 @@
+#include "Simulation.h"
+#include "FactoredSolarRadiation.h"
+#include "SolarRadiation.h"
+#include "ParallelFor.h"
+
+/** Resolution of the distinct latitudes in degrees, the latitude of the horizontal sunrise hardly changes within it. */
+static const float LatitudeResolution = 0.01f;
+
+/** Number of latitudes whose constants are computed by one task. */
+static const int32 LatitudesPerTask = 256;
+
+void FFactoredSolarRadiation::Initialize(const FSimulationCellStore& Cells)
+{
+	const int32 NumCells = Cells.Num();
+
+	SinL1.SetNumUninitialized(NumCells);
+	CosL1.SetNumUninitialized(NumCells);
+	TanL1.SetNumUninitialized(NumCells);
+	L2.SetNumUninitialized(NumCells);
+	LatitudeIndex.SetNumUninitialized(NumCells);
+
+	Latitudes.Empty();
+	TMap<int32, int32> LatitudeIndices;
+
+	// The latitudes are projected from the landscape and differ in the last bits even along a row, so they are quantized
+	const float LatitudeStep = FMath::DegreesToRadians(LatitudeResolution);
+
+	for (int32 Index = 0; Index < NumCells; ++Index)
+	{
+		const float I = Cells.Inclination[Index];
+		const float A = Cells.Aspect[Index];
+		const float L0 = Cells.Latitude[Index];
+
+		const float L1 = FMath::Asin(FMath::Cos(I) * FMath::Sin(L0) + FMath::Sin(I) * FMath::Cos(L0) * FMath::Cos(A));
+
+		SinL1[Index] = FMath::Sin(L1);
+		CosL1[Index] = FMath::Cos(L1);
+		TanL1[Index] = FMath::Tan(L1);
+		L2[Index] = FMath::Atan((FMath::Sin(I) * FMath::Sin(A)) / (FMath::Cos(I) * FMath::Cos(L0) - FMath::Sin(I) * FMath::Sin(L0) * FMath::Cos(A)));
+
+		const int32 LatitudeKey = FMath::RoundToInt(L0 / LatitudeStep);
+		int32* ExistingIndex = LatitudeIndices.Find(LatitudeKey);
+		if (ExistingIndex)
+		{
+			LatitudeIndex[Index] = *ExistingIndex;
+		}
+		else
+		{
+			LatitudeIndex[Index] = LatitudeIndices.Add(LatitudeKey, Latitudes.Add(LatitudeKey * LatitudeStep));
+		}
+	}
+}
+
+void FFactoredSolarRadiation::ComputeDay(int32 J, FDay& OutDay) const
+{
+	OutDay.DayOfYear = J;
+
+	const float D = 0.007 - 0.4067 * FMath::Cos((J + 10) * 0.0172);
+	OutDay.SinD = FMath::Sin(D);
+	OutDay.CosD = FMath::Cos(D);
+	OutDay.TanD = FMath::Tan(D);
+
+	OutDay.T1.SetNumUninitialized(Latitudes.Num(), false);
+	OutDay.InvR3.SetNumUninitialized(Latitudes.Num(), false);
+
+	const int32 NumTasks = FMath::DivideAndRoundUp(Latitudes.Num(), LatitudesPerTask);
+
+	ParallelFor(NumTasks, [&](int32 Task)
+	{
+		const int32 EndIndex = FMath::Min((Task + 1) * LatitudesPerTask, Latitudes.Num());
+
+		for (int32 Index = Task * LatitudesPerTask; Index < EndIndex; ++Index)
+		{
+			const float L0 = Latitudes[Index];
+
+			OutDay.T1[Index] = FSolarRadiation::Func2(L0, D);
+
+			// R1 cancels out of the index
+			const float R3 = FSolarRadiation::Func3(0.0, L0, OutDay.T1[Index], -OutDay.T1[Index], 1.0f, D);
+			OutDay.InvR3[Index] = R3 != 0 ? 1.0f / R3 : 0.0f;
+		}
+	});
+}
+
+float FFactoredSolarRadiation::Evaluate(const FDay& Day, int32 Index) const
+{
+	const float CellL2 = L2[Index];
+	const float CellT1 = Day.T1[LatitudeIndex[Index]];
+	const float CellT0 = -CellT1;
+
+	// Sunrise and sunset on the equivalent slope
+	const float T = FMath::Acos(FMath::Clamp(-TanL1[Index] * Day.TanD, -1.0f, 1.0f));
+	const float T7 = T - CellL2;
+	const float T6 = -T - CellL2;
+
+	float T3 = FMath::Min(T7, CellT1);
+	float T2 = FMath::Max(T6, CellT0);
+
+	if (T3 < T2)
+	{
+		T2 = T3 = 0;
+	}
+
+	// Func3 without R1
+	auto Radiation = [&](float X, float Y)
+	{
+		return Day.SinD * SinL1[Index] * (X - Y) * (12 / PI) + Day.CosD * CosL1[Index] * (FMath::Sin(X + CellL2) - FMath::Sin(Y + CellL2)) * (12 / PI);
+	};
+
+	float R4 = Radiation(T3, T2);
+
+	// The slope sees the sun a second time during the day, the other case of the original adds an empty interval
+	if (T6 + PI * 2 < CellT1)
+	{
+		R4 += Radiation(CellT1, T6 + PI * 2);
+	}
+
+	return R4 * Day.InvR3[LatitudeIndex[Index]];
+}
+
+void FFactoredSolarRadiation::Evaluate(const FDay& Day, int32 BeginIndex, int32 EndIndex, float* OutRadiationIndex) const
+{
+	for (int32 Index = BeginIndex; Index < EndIndex; ++Index)
+	{
+		OutRadiationIndex[Index - BeginIndex] = Evaluate(Day, Index);
+	}
+}
+
+SIZE_T FFactoredSolarRadiation::GetAllocatedSize() const
+{
+	return SinL1.GetAllocatedSize() + CosL1.GetAllocatedSize() + TanL1.GetAllocatedSize() + L2.GetAllocatedSize()
+		+ LatitudeIndex.GetAllocatedSize() + Latitudes.GetAllocatedSize();
+}
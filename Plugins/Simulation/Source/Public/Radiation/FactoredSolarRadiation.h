@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Cells/SimulationCellStore.h"
+
+/**
+* Evaluates the same solar radiation index as FSolarRadiation::SolarRadiationIndex, but splits the computation by what
+* the terms depend on:
+*
+*  - The equivalent slope (L1, L2) depends only on the cell and is computed once during initialization.
+*  - The declination D depends only on the day and is computed once per day.
+*  - The sunrise on a horizontal surface (T1) and its radiation (R3) depend on latitude and day and are computed once per
+*    day for every distinct latitude of the terrain, the latitudes are quantized to 0.01 degrees.
+*
+* Only the sunrise on the slope and its radiation remain per cell and day. R1 cancels out of the index and is never
+* computed. In contrast to FSolarRadiationTable the memory is independent of the number of days, which makes this
+* evaluation suitable for large terrains with varying latitude.
+*/
+class SIMULATION_API FFactoredSolarRadiation
+{
+public:
+	/** Computes the constants of the given cells. */
+	void Initialize(const FSimulationCellStore& Cells);
+
+	/** Constants of a single day. */
+	struct FDay
+	{
+		/** The day of the year or 0 if the constants have not been computed. */
+		int32 DayOfYear = 0;
+
+		float SinD = 0;
+		float CosD = 0;
+		float TanD = 0;
+
+		/** Sunrise on a horizontal surface for every latitude. */
+		TArray<float> T1;
+
+		/** Reciprocal of the radiation on a horizontal surface for every latitude. */
+		TArray<float> InvR3;
+	};
+
+	/** Computes the constants of the given day of the year, the latitudes are split into parallel tasks. */
+	void ComputeDay(int32 DayOfYear, FDay& OutDay) const;
+
+	/** Returns the radiation index of the given cell for the given day. */
+	float Evaluate(const FDay& Day, int32 Index) const;
+
+	/** Evaluates the radiation index of the cells in the range [BeginIndex, EndIndex) for the given day. */
+	void Evaluate(const FDay& Day, int32 BeginIndex, int32 EndIndex, float* OutRadiationIndex) const;
+
+	/** Returns the number of distinct latitudes of the cells. */
+	int32 GetNumLatitudes() const
+	{
+		return Latitudes.Num();
+	}
+
+	/** Returns the number of bytes allocated by the constants. */
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	// Cell constants
+
+	/** Latitude of the equivalent slope. */
+	FAlignedFloatArray SinL1;
+	FAlignedFloatArray CosL1;
+	FAlignedFloatArray TanL1;
+
+	/** Longitude difference of the equivalent slope. */
+	FAlignedFloatArray L2;
+
+	/** Index of the latitude of the cell in Latitudes. */
+	TArray<int32> LatitudeIndex;
+
+	/** The distinct latitudes of the cells quantized to 0.01 degrees. */
+	TArray<float> Latitudes;
+};
@@ -0,0 +1,93 @@
+#include "Simulation.h"
+#include "SolarRadiationTable.h"
+#include "SolarRadiation.h"
+#include "ParallelFor.h"
+
+const int32 FSolarRadiationTable::NumDays;
+
+void FSolarRadiationTable::Build(const FSimulationCellStore& Cells, int32 TableDayStride)
+{
+	const double StartSeconds = FPlatformTime::Seconds();
+
+	NumCells = Cells.Num();
+	DayStride = FMath::Max(1, TableDayStride);
+
+	// The table holds at most MAX_int32 floats, more than 5.8 million cells only fit with fewer days
+	const int32 MaxRows = NumCells > 0 ? FMath::Max(1, MAX_int32 / NumCells) : NumDays;
+	const int32 MinDayStride = FMath::DivideAndRoundUp(NumDays, FMath::Min(MaxRows, NumDays));
+	if (DayStride < MinDayStride)
+	{
+		UE_LOG(SimulationLog, Warning, TEXT("The radiation table of %d cells with a day stride of %d exceeds %d entries, only every %d-th day is stored. The factored radiation evaluation needs 6 floats per cell."),
+			NumCells, DayStride, MAX_int32, MinDayStride);
+		DayStride = MinDayStride;
+	}
+	NumRows = FMath::DivideAndRoundUp(NumDays, DayStride);
+
+	RadiationIndex.SetNumUninitialized(NumRows * NumCells);
+
+	ParallelFor(NumRows, [&](int32 Row)
+	{
+		const int32 DayOfYear = Row * DayStride + 1;
+		float* Day = RadiationIndex.GetData() + static_cast<SIZE_T>(Row) * NumCells;
+
+		for (int32 Index = 0; Index < NumCells; ++Index)
+		{
+			Day[Index] = FSolarRadiation::SolarRadiationIndex(Cells.Inclination[Index], Cells.Aspect[Index], Cells.Latitude[Index], DayOfYear);
+		}
+	});
+
+	BuildSeconds += FPlatformTime::Seconds() - StartSeconds;
+}
+
+void FSolarRadiationTable::BuildDiurnalFactors(const FSimulationCellStore& Cells)
+{
+	double LatitudeSum = 0;
+	for (int32 Index = 0; Index < Cells.Num(); ++Index)
+	{
+		LatitudeSum += Cells.Latitude[Index];
+	}
+
+	BuildDiurnalFactors(Cells.Num() > 0 ? LatitudeSum / Cells.Num() : 0.0f);
+}
+
+void FSolarRadiationTable::BuildDiurnalFactors(float L0)
+{
+	const double StartSeconds = FPlatformTime::Seconds();
+
+	DiurnalFactors.SetNumZeroed(NumDays * 24);
+	for (int32 Day = 0; Day < NumDays; ++Day)
+	{
+		// Radiation on a horizontal surface integrated between sunrise and sunset
+		const float D = 0.007 - 0.4067 * FMath::Cos((Day + 1 + 10) * 0.0172);
+		const float T1 = FSolarRadiation::Func2(L0, D);
+		const float Daily = FSolarRadiation::Func3(0.0, L0, T1, -T1, 1.0f, D);
+
+		if (Daily <= 0)
+		{
+			continue;
+		}
+
+		// Radiation integrated over the part of every hour during which the sun is up, solar noon is at 12:00
+		for (int32 Hour = 0; Hour < 24; ++Hour)
+		{
+			const float Begin = FMath::Max((Hour - 12) * PI / 12, -T1);
+			const float End = FMath::Min((Hour - 11) * PI / 12, T1);
+
+			if (End > Begin)
+			{
+				DiurnalFactors[Day * 24 + Hour] = 24 * FSolarRadiation::Func3(0.0, L0, End, Begin, 1.0f, D) / Daily;
+			}
+		}
+	}
+
+	BuildSeconds += FPlatformTime::Seconds() - StartSeconds;
+}
+
+void FSolarRadiationTable::Reset()
+{
+	RadiationIndex.Empty();
+	DiurnalFactors.Empty();
+	NumCells = 0;
+	NumRows = 0;
+	BuildSeconds = 0;
+}
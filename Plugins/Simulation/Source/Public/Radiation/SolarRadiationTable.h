@@ -0,0 +1,87 @@
+#pragma once
+
+#include "Cells/SimulationCellStore.h"
+
+/**
+* Solar radiation index of every cell for every day of the year, precomputed from the inclination, aspect and latitude
+* of the cells. The table is stored day by day, so the radiation indices of one day are a contiguous row which can be
+* indexed like the arrays of the cell store.
+*
+* The table optionally contains diurnal factors which distribute the daily radiation over the hours of the day.
+*/
+class SIMULATION_API FSolarRadiationTable
+{
+public:
+	/** Number of days in the table (including the 29th of february). */
+	static const int32 NumDays = 366;
+
+	/**
+	* Builds the radiation indices of the given cells. The stride is raised with a warning if the table would exceed
+	* MAX_int32 entries.
+	*
+	* @param Cells			The cells
+	* @param DayStride		Only every DayStride-th day is stored, the other days use the closest stored day
+	*/
+	void Build(const FSimulationCellStore& Cells, int32 DayStride);
+
+	/**
+	* Builds the hourly factors of the radiation. The latitude hardly varies over a landscape, so the factors of a
+	* horizontal surface at the mean latitude of the cells are used for all cells.
+	*/
+	void BuildDiurnalFactors(const FSimulationCellStore& Cells);
+
+	/** Builds the hourly factors of the radiation of a horizontal surface at the given latitude in radians. */
+	void BuildDiurnalFactors(float Latitude);
+
+	/** Frees the table. */
+	void Reset();
+
+	/** Returns true if the table has been built. */
+	bool IsBuilt() const
+	{
+		return RadiationIndex.Num() > 0;
+	}
+
+	/** Returns the radiation indices of all cells for the given day of the year [1-366]. */
+	const float* GetDay(int32 DayOfYear) const
+	{
+		const int32 Row = FMath::Min((FMath::Clamp(DayOfYear, 1, NumDays) - 1 + DayStride / 2) / DayStride, NumRows - 1);
+		return RadiationIndex.GetData() + static_cast<SIZE_T>(Row) * NumCells;
+	}
+
+	/**
+	* Returns the factor of the radiation index for the given hour of the day. The factors of a day average to one, so
+	* they distribute the daily radiation without changing its sum. Returns one if no diurnal factors have been built.
+	*/
+	float GetDiurnalFactor(int32 DayOfYear, int32 Hour) const
+	{
+		return DiurnalFactors.Num() > 0 ? DiurnalFactors[(FMath::Clamp(DayOfYear, 1, NumDays) - 1) * 24 + Hour] : 1.0f;
+	}
+
+	/** Returns the number of bytes allocated by the table. */
+	SIZE_T GetAllocatedSize() const
+	{
+		return RadiationIndex.GetAllocatedSize() + DiurnalFactors.GetAllocatedSize();
+	}
+
+	/** Returns the time in seconds it took to build the radiation indices and the diurnal factors. */
+	double GetBuildSeconds() const
+	{
+		return BuildSeconds;
+	}
+
+private:
+	/** The radiation index of every cell for every stored day, stored day by day. */
+	FAlignedFloatArray RadiationIndex;
+
+	/** The hourly factors of the radiation of a horizontal surface for every day, stored day by day. */
+	TArray<float> DiurnalFactors;
+
+	int32 NumCells = 0;
+
+	int32 NumRows = 0;
+
+	int32 DayStride = 1;
+
+	double BuildSeconds = 0;
+};
@@ -3,4 +3,6 @@
 #include "CoreUObject.h"
 #include "Engine.h"
 
+DECLARE_STATS_GROUP(TEXT("SnowSimulation"), STATGROUP_SnowSimulation, STATCAT_Advanced);
+
 
@@ -25,11 +25,15 @@ public:
 		float TMeltA, float TMeltB, float TSnowA, float TSnowB, int32 TotalSimulationHours, 
 		int32 CellsDimensionX, int32 CellsDimensionY,  float MeasurementAltitude, float MaxSnow);
 
+	/** Returns the constant parameters of the compute shader for the given parameters and cells. */
+	static FComputeShaderConstantParameters CreateConstantParameters(float k_e, float k_m, float TMeltA, float TMeltB, float TSnowA, float TSnowB,
+		int32 CellsDimensionX, int32 CellsDimensionY, float MeasurementAltitude);
+
 	/**
 	* Run this to execute the compute shader once!
 	* @param TotalElapsedTimeSeconds - We use this for simulation state 
 	*/
-	void ExecuteComputeShader(int CurrentTimeStep, int32 Timesteps, int HourOfDay, bool CaptureDebugInformation, TArray<FDebugCell>& DebugInformation);
+	void ExecuteComputeShader(int CurrentTimeStep, int32 Timesteps, int DayOfYear, int HourOfDay, bool CaptureDebugInformation, TArray<FDebugCell>& DebugInformation);
 
 	/**
 	* Only execute this from the render thread.
@@ -46,6 +50,9 @@ public:
 	FRWStructuredBuffer* GetSnowBuffer() { return SnowOutputBuffer; }
 
 	FRWStructuredBuffer* GetMaxSnowBuffer() { return MaxSnowBuffer; }
+
+	/** Sets the directory to which the input and the output of every execution are recorded, nothing is recorded if the directory is empty. Must be set before Initialize. */
+	void SetRecordDirectory(const FString& Directory) { RecordDirectory = Directory; }
 private:
 	bool IsComputeShaderExecuting;
 	bool IsUnloading;
@@ -75,4 +82,7 @@ private:
 
 	/** Output snow map array. */
 	FRWStructuredBuffer* SnowOutputBuffer;
+
+	/** Directory of the recorded output. */
+	FString RecordDirectory;
 };
@@ -3,7 +3,9 @@
 #include "SnowSimulationActor.h"
 #include "Util/MathUtil.h"
 #include "Util/TextureUtil.h"
+#include "Util/RasterUtil.h"
 #include "Util/RuntimeMaterialChange.h"
+#include "Cells/HaloGrid.h"
 #include "TextureResource.h"
 #include "RenderingThread.h"
 #include "RHICommandList.h"
@@ -361,40 +363,41 @@ void ASnowSimulationActor::Initialize()
 			}
 
 		
-			// Calculate curvature
-			for (int32 CellIndexY = 0; CellIndexY < CellsDimensionY; ++CellIndexY)
+			// Calculate curvature on a grid of the altitudes in m, the replicated border gives the cells of the outer ring a zero gradient across the edge of the landscape
+			THaloGrid<float> AltitudeGrid;
+			AltitudeGrid.Initialize(CellsDimensionX, CellsDimensionY);
+			AltitudeGrid.CopyInterior(LandscapeCells, [](const FLandscapeCell& Cell) { return Cell.Altitude / 100; });
+			AltitudeGrid.ReplicateBorder();
+
+			const int32 OffsetN = AltitudeGrid.GetNeighbourOffset(ENeighbour::N);
+			const int32 OffsetE = AltitudeGrid.GetNeighbourOffset(ENeighbour::E);
+			const int32 OffsetS = AltitudeGrid.GetNeighbourOffset(ENeighbour::S);
+			const int32 OffsetW = AltitudeGrid.GetNeighbourOffset(ENeighbour::W);
+
+			AltitudeGrid.ForEachCell([&](int32 X, int32 Y, int32 Index)
 			{
-				for (int32 CellIndexX = 0; CellIndexX < CellsDimensionX; ++CellIndexX)
+				const float Z = AltitudeGrid[Index];
+
+				float D = ((AltitudeGrid[Index + OffsetW] + AltitudeGrid[Index + OffsetE]) / 2 - Z) / (L * L);
+				float E = ((AltitudeGrid[Index + OffsetN] + AltitudeGrid[Index + OffsetS]) / 2 - Z) / (L * L);
+				LandscapeCells[X + CellsDimensionX * Y].Curvature = 2 * (D + E);
+			});
+
+			// Vegetation density of the cells, negative no data values are kept so these cells use the density of the parameters
+			if (!VegetationRasterPath.IsEmpty())
+			{
+				TArray<float> VegetationDensity;
+				if (LoadAsciiGrid(VegetationRasterPath, CellsDimensionX, CellsDimensionY, VegetationDensity))
+				{
+					for (int32 CellIndex = 0; CellIndex < LandscapeCells.Num(); ++CellIndex)
+					{
+						const float Density = VegetationDensity[CellIndex];
+						LandscapeCells[CellIndex].VegetationDensity = Density < 0 ? Density : FMath::Min(Density, 1.0f);
+					}
+				}
+				else
 				{
-					FLandscapeCell& Cell = LandscapeCells[CellIndexX + CellsDimensionX * CellIndexY];
-					FLandscapeCell* Neighbours[8];
-
-					Neighbours[0] = GetCellChecked(CellIndexX, CellIndexY - 1);						// N
-					Neighbours[1] = GetCellChecked(CellIndexX + 1, CellIndexY - 1);					// NE
-					Neighbours[2] = GetCellChecked(CellIndexX + 1, CellIndexY);						// E
-					Neighbours[3] = GetCellChecked(CellIndexX + 1, CellIndexY + 1);					// SE
-
-					Neighbours[4] = GetCellChecked(CellIndexX, CellIndexY + 1);						// S
-					Neighbours[5] = GetCellChecked(CellIndexX - 1, CellIndexY + 1); 				// SW
-					Neighbours[6] = GetCellChecked(CellIndexX - 1, CellIndexY);						// W
-					Neighbours[7] = GetCellChecked(CellIndexX - 1, CellIndexY - 1);					// NW
-
-					if (Neighbours[0] == nullptr || Neighbours[1] == nullptr || Neighbours[2] == nullptr || Neighbours[3] == nullptr
-						|| Neighbours[4] == nullptr || Neighbours[5] == nullptr || Neighbours[6] == nullptr || Neighbours[7] == nullptr) continue;
-
-					float Z1 = Neighbours[1]->Altitude / 100; // NW
-					float Z2 = Neighbours[0]->Altitude / 100; // N
-					float Z3 = Neighbours[7]->Altitude / 100; // NE
-					float Z4 = Neighbours[2]->Altitude / 100; // W
-					float Z5 = Cell.Altitude / 100;
-					float Z6 = Neighbours[6]->Altitude / 100; // E
-					float Z7 = Neighbours[3]->Altitude / 100; // SW	
-					float Z8 = Neighbours[4]->Altitude / 100; // S
-					float Z9 = Neighbours[5]->Altitude / 100; // SE
-
-					float D = ((Z4 + Z6) / 2 - Z5) / (L * L);
-					float E = ((Z2 + Z8) / 2 - Z5) / (L * L);
-					Cell.Curvature = 2 * (D + E);
+					UE_LOG(SimulationLog, Warning, TEXT("Could not read the vegetation raster %s"), *VegetationRasterPath);
 				}
 			}
 
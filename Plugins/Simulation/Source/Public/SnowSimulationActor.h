@@ -71,6 +71,14 @@ public:
 	/** The simulation used. */
 	USimulationBase* Simulation;
 
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation")
+	/**
+	* Path of a raster of the vegetation density [0-1] in the ESRI ASCII grid format which is resampled to the cells once
+	* during initialization. The simulation uses its own vegetation density for all cells if it is empty and for the no data
+	* cells of the raster.
+	*/
+	FString VegetationRasterPath;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation")
 	/** Time in seconds until the next step of the simulation is executed. */
 	float SleepTime = 1.0f;
@@ -183,29 +191,4 @@ private:
 
 	/** Renders the debug information from the simulation. */
 	void DoRenderDebugInformation();
-
-
-	/**
-	* Returns the cell at the given x and y position or a nullptr if the indices are out of bounds.
-	*
-	* @param X
-	* @param Y
-	* @return the cell at the given x and y position or a nullptr if the indices are out of bounds.
-	*/
-	FLandscapeCell* GetCellChecked(int X, int Y)
-	{
-		return GetCellChecked(X + Y * CellsDimensionX);
-	}
-
-	/**
-	* Returns the cell at the given index or nullptr if the index is out of bounds.
-	*
-	* @param Index the index of the cell
-	* @return the cell at the given index or nullptr if the index is out of bounds
-	*/
-	FLandscapeCell* GetCellChecked(int Index)
-	{
-		return (Index >= 0 && Index < LandscapeCells.Num()) ? &LandscapeCells[Index] : nullptr;
-	}
-
 };
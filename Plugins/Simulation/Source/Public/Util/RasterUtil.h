@@ -0,0 +1,53 @@
+#pragma once
+
+/**
+* Loads a raster in the ESRI ASCII grid format and resamples it to the given dimensions using the nearest value. The
+* first row of the file is mapped to the first row of cells. No data values are returned as -1.
+*
+* @param FilePath		Path of the raster file
+* @param DimensionX	Number of values in x direction
+* @param DimensionY	Number of values in y direction
+* @param OutValues		The values stored row by row
+* @return true if the file could be read
+*/
+inline bool LoadAsciiGrid(const FString& FilePath, int32 DimensionX, int32 DimensionY, TArray<float>& OutValues)
+{
+	FString Content;
+	if (!FFileHelper::LoadFileToString(Content, *FilePath)) return false;
+
+	TArray<FString> Tokens;
+	Content.ParseIntoArrayWS(Tokens);
+
+	// Header of key value pairs
+	int32 Columns = 0;
+	int32 Rows = 0;
+	float NoData = -9999;
+	int32 Token = 0;
+	while (Token + 1 < Tokens.Num() && !Tokens[Token].IsNumeric())
+	{
+		const FString Key = Tokens[Token].ToLower();
+		const FString& Value = Tokens[Token + 1];
+
+		if (Key == TEXT("ncols")) Columns = FCString::Atoi(*Value);
+		else if (Key == TEXT("nrows")) Rows = FCString::Atoi(*Value);
+		else if (Key == TEXT("nodata_value")) NoData = FCString::Atof(*Value);
+
+		Token += 2;
+	}
+
+	if (Columns <= 0 || Rows <= 0 || Tokens.Num() - Token < Columns * Rows) return false;
+
+	OutValues.SetNumUninitialized(DimensionX * DimensionY);
+	for (int32 Y = 0; Y < DimensionY; ++Y)
+	{
+		const int32 Row = FMath::Min(Y * Rows / DimensionY, Rows - 1);
+		for (int32 X = 0; X < DimensionX; ++X)
+		{
+			const int32 Column = FMath::Min(X * Columns / DimensionX, Columns - 1);
+			const float Value = FCString::Atof(*Tokens[Token + Row * Columns + Column]);
+			OutValues[Y * DimensionX + X] = Value == NoData || Value < 0 ? -1 : Value;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "SimulationComputeShader.h"
+
+/**
+* Recorded input and output of the executions of the compute shader. A record directory is a self-contained fixture: the
+* input record stores the integer-scaled initial maximum snow, the constant parameters, the cells and the weather data
+* which the compute shader was initialized with. The record of every execution stores its variable parameters and the
+* integer-scaled maximum snow of the max snow buffer followed by the snow output buffer of all cells.
+*/
+
+/** Returns the path of the record of the given simulation step in the given directory. */
+inline FString GetSnowOutputRecordPath(const FString& Directory, int32 SimulationStep)
+{
+	return FPaths::Combine(*Directory, *FString::Printf(TEXT("SnowOutput_%06d.bin"), SimulationStep));
+}
+
+/** Returns the path of the input record in the given directory. */
+inline FString GetComputeShaderInputRecordPath(const FString& Directory)
+{
+	return FPaths::Combine(*Directory, TEXT("ComputeShaderInput.bin"));
+}
+
+/** Appends the raw bytes of the given values to the record. */
+inline void AppendRecordBytes(TArray<uint8>& Bytes, const void* Data, int32 NumBytes)
+{
+	const int32 Offset = Bytes.AddUninitialized(NumBytes);
+	FMemory::Memcpy(Bytes.GetData() + Offset, Data, NumBytes);
+}
+
+/** Reads the raw bytes of the given values from the record at the offset and advances it, returns false if the record is too short. */
+inline bool ReadRecordBytes(const TArray<uint8>& Bytes, int32& Offset, void* Data, int32 NumBytes)
+{
+	if (NumBytes < 0 || Offset + NumBytes > Bytes.Num()) return false;
+
+	FMemory::Memcpy(Data, Bytes.GetData() + Offset, NumBytes);
+	Offset += NumBytes;
+	return true;
+}
+
+/**
+* Saves the input of the compute shader.
+*
+* @param FilePath		Path of the record
+* @param MaxSnow		The initial content of the max snow buffer
+* @param Constants		The constant parameters
+* @param Cells			The cells
+* @param NumCells		Number of cells
+* @param WeatherData	The weather data of all hours
+* @param NumHours		Number of hours
+* @return true if the file could be written
+*/
+inline bool SaveComputeShaderInputRecord(const FString& FilePath, uint32 MaxSnow, const FComputeShaderConstantParameters& Constants,
+	const FGPUSimulationCell* Cells, int32 NumCells, const FClimateData* WeatherData, int32 NumHours)
+{
+	TArray<uint8> Bytes;
+	AppendRecordBytes(Bytes, &MaxSnow, sizeof(uint32));
+	AppendRecordBytes(Bytes, &Constants, sizeof(FComputeShaderConstantParameters));
+	AppendRecordBytes(Bytes, &NumCells, sizeof(int32));
+	AppendRecordBytes(Bytes, Cells, NumCells * sizeof(FGPUSimulationCell));
+	AppendRecordBytes(Bytes, &NumHours, sizeof(int32));
+	AppendRecordBytes(Bytes, WeatherData, NumHours * sizeof(FClimateData));
+
+	return FFileHelper::SaveArrayToFile(Bytes, *FilePath);
+}
+
+/**
+* Loads the input of the compute shader.
+*
+* @param FilePath			Path of the record
+* @param OutMaxSnow			The initial content of the max snow buffer
+* @param OutConstants		The constant parameters
+* @param OutCells			The cells
+* @param OutWeatherData	The weather data of all hours
+* @return true if the file could be read
+*/
+inline bool LoadComputeShaderInputRecord(const FString& FilePath, uint32& OutMaxSnow, FComputeShaderConstantParameters& OutConstants,
+	TArray<FGPUSimulationCell>& OutCells, TArray<FClimateData>& OutWeatherData)
+{
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *FilePath)) return false;
+
+	int32 Offset = 0;
+	int32 NumCells = 0;
+	int32 NumHours = 0;
+	if (!ReadRecordBytes(Bytes, Offset, &OutMaxSnow, sizeof(uint32))
+		|| !ReadRecordBytes(Bytes, Offset, &OutConstants, sizeof(FComputeShaderConstantParameters))
+		|| !ReadRecordBytes(Bytes, Offset, &NumCells, sizeof(int32))
+		|| NumCells < 0 || Offset + NumCells * static_cast<int64>(sizeof(FGPUSimulationCell)) > Bytes.Num()) return false;
+
+	OutCells.SetNumUninitialized(NumCells);
+	if (!ReadRecordBytes(Bytes, Offset, OutCells.GetData(), NumCells * sizeof(FGPUSimulationCell))
+		|| !ReadRecordBytes(Bytes, Offset, &NumHours, sizeof(int32))
+		|| NumHours < 0 || Offset + NumHours * static_cast<int64>(sizeof(FClimateData)) > Bytes.Num()) return false;
+
+	OutWeatherData.SetNumUninitialized(NumHours);
+	return ReadRecordBytes(Bytes, Offset, OutWeatherData.GetData(), NumHours * sizeof(FClimateData));
+}
+
+/**
+* Saves a record of the compute shader output.
+*
+* @param FilePath		Path of the record
+* @param Variables		The variable parameters of the execution
+* @param MaxSnow		The content of the max snow buffer
+* @param SnowOutput	The content of the snow output buffer
+* @return true if the file could be written
+*/
+inline bool SaveSnowOutputRecord(const FString& FilePath, const FComputeShaderVariableParameters& Variables, uint32 MaxSnow, const TArray<float>& SnowOutput)
+{
+	TArray<uint8> Bytes;
+	AppendRecordBytes(Bytes, &Variables, sizeof(FComputeShaderVariableParameters));
+	AppendRecordBytes(Bytes, &MaxSnow, sizeof(uint32));
+	AppendRecordBytes(Bytes, SnowOutput.GetData(), SnowOutput.Num() * sizeof(float));
+
+	return FFileHelper::SaveArrayToFile(Bytes, *FilePath);
+}
+
+/**
+* Loads a record of the compute shader output.
+*
+* @param FilePath		Path of the record
+* @param OutVariables	The variable parameters of the execution
+* @param OutMaxSnow		The content of the max snow buffer
+* @param OutSnowOutput	The content of the snow output buffer
+* @return true if the file could be read
+*/
+inline bool LoadSnowOutputRecord(const FString& FilePath, FComputeShaderVariableParameters& OutVariables, uint32& OutMaxSnow, TArray<float>& OutSnowOutput)
+{
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *FilePath)) return false;
+
+	int32 Offset = 0;
+	if (!ReadRecordBytes(Bytes, Offset, &OutVariables, sizeof(FComputeShaderVariableParameters))
+		|| !ReadRecordBytes(Bytes, Offset, &OutMaxSnow, sizeof(uint32))) return false;
+
+	OutSnowOutput.SetNumUninitialized((Bytes.Num() - Offset) / sizeof(float));
+	return ReadRecordBytes(Bytes, Offset, OutSnowOutput.GetData(), OutSnowOutput.Num() * sizeof(float));
+}
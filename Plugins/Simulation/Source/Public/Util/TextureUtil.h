@@ -1,7 +1,7 @@
 #pragma once
 #include "Engine/Texture2D.h"
 
-void UpdateTexture(UTexture2D* Texture, TArray<FColor>& TextureData)
+FORCEINLINE void UpdateTexture(UTexture2D* Texture, TArray<FColor>& TextureData)
 {
 	FUpdateTextureRegion2D* RegionData = new FUpdateTextureRegion2D(0, 0, 0, 0, Texture->GetSizeX(), Texture->GetSizeY());
 
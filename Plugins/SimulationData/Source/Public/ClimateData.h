@@ -13,3 +13,105 @@ struct FClimateData {
 	{
 	}
 };
+
+/**
+* Read only view of the hourly weather data of a data provider. The data is owned by the provider and stays valid until
+* the provider is initialized again. The data of all stations of an hour is stored contiguously.
+*/
+struct FClimateDataView {
+	/** The data of the first station of the first hour. */
+	const FClimateData* Data;
+
+	/** Number of hours. */
+	int32 NumHours;
+
+	/** Number of measuring stations per hour. */
+	int32 NumStations;
+
+	FClimateDataView(const FClimateData* Data, int32 NumHours, int32 NumStations = 1) : Data(Data), NumHours(NumHours), NumStations(NumStations)
+	{
+	}
+
+	FClimateDataView() : Data(nullptr), NumHours(0), NumStations(1)
+	{
+	}
+
+	/** Returns the number of hours. */
+	int32 Num() const
+	{
+		return NumHours;
+	}
+
+	/** Returns the data of the given station at the given hour. */
+	const FClimateData& Get(int32 Hour, int32 Station = 0) const
+	{
+		return Data[Hour * NumStations + Station];
+	}
+};
+
+/**
+* Hourly wind at the measurement station. The wind is not part of FClimateData which is uploaded to the GPU as it is.
+* The velocity is given in the axes of the landscape, like the aspect of the cells north is +X and east is -Y.
+*/
+struct FWindData {
+	/** Velocity in x direction in m/s. */
+	float VelocityX;
+
+	/** Velocity in y direction in m/s. */
+	float VelocityY;
+
+	FWindData(float VelocityX, float VelocityY) : VelocityX(VelocityX), VelocityY(VelocityY)
+	{
+	}
+
+	FWindData() : VelocityX(0.0f), VelocityY(0.0f)
+	{
+	}
+
+	/**
+	* Creates the wind of the given speed blowing from the given direction.
+	*
+	* @param Speed		The wind speed in m/s
+	* @param Direction	The direction the wind blows from in degrees clockwise from north
+	*/
+	static FWindData FromDirection(float Speed, float Direction)
+	{
+		const float Radians = FMath::DegreesToRadians(Direction);
+		return FWindData(-Speed * FMath::Cos(Radians), Speed * FMath::Sin(Radians));
+	}
+
+	/** Returns the wind speed in m/s. */
+	float GetSpeed() const
+	{
+		return FMath::Sqrt(VelocityX * VelocityX + VelocityY * VelocityY);
+	}
+};
+
+/** Read only view of the hourly wind data of a data provider, which is owned by the provider. The view is empty if the provider has no wind data. */
+struct FWindDataView {
+	/** The data of the first hour. */
+	const FWindData* Data;
+
+	/** Number of hours. */
+	int32 NumHours;
+
+	FWindDataView(const FWindData* Data, int32 NumHours) : Data(Data), NumHours(NumHours)
+	{
+	}
+
+	FWindDataView() : Data(nullptr), NumHours(0)
+	{
+	}
+
+	/** Returns the number of hours. */
+	int32 Num() const
+	{
+		return NumHours;
+	}
+
+	/** Returns the wind at the given hour. */
+	const FWindData& Get(int32 Hour) const
+	{
+		return Data[Hour];
+	}
+};
@@ -2,6 +2,16 @@
 #include "SimulationWeatherDataProviderBase.h"
 #include "MeteoSwissWeatherDataProvider.h"
 
+FClimateDataView UMeteoSwissWeatherDataProvider::GetClimateDataView()
+{
+	return FClimateDataView(ClimateData.GetData(), ClimateData.Num());
+}
+
+FWindDataView UMeteoSwissWeatherDataProvider::GetWindDataView()
+{
+	return FWindDataView(WindData.GetData(), WindData.Num());
+}
+
 TResourceArray<FClimateData>* UMeteoSwissWeatherDataProvider::CreateRawClimateDataResourceArray(FDateTime StartTime, FDateTime EndTime)
 {
 	TResourceArray<FClimateData>* ClimateDataResourceArray = new TResourceArray<FClimateData>();
@@ -21,6 +31,9 @@ void UMeteoSwissWeatherDataProvider::Initialize(FDateTime StartTime, FDateTime E
 	auto SimulationTime = EndTime - StartTime;
 	auto SimulationHours = SimulationTime.GetTotalHours();
 
+	ClimateData.Empty(static_cast<int32>(SimulationHours));
+	WindData.Empty(WindTableData ? static_cast<int32>(SimulationHours) : 0);
+
 	FString ContextString;
 	for (int Hour = 0; Hour < SimulationHours; ++Hour)
 	{
@@ -34,6 +47,13 @@ void UMeteoSwissWeatherDataProvider::Initialize(FDateTime StartTime, FDateTime E
 		FPrecipitationData* Precipitation = PrecipitationData->FindRow<FPrecipitationData>(FName(*RowKey), ContextString);
 		
 		ClimateData.Push(FClimateData(Precipitation->Precipitation, Temperature->Temperature));
+
+		if (WindTableData)
+		{
+			// Hours without a measurement are calm
+			FWindTableData* Wind = WindTableData->FindRow<FWindTableData>(FName(*RowKey), ContextString);
+			WindData.Push(Wind ? FWindData::FromDirection(Wind->Speed, Wind->Direction) : FWindData());
+		}
 		CurrentTime += FTimespan(1, 0, 0);
 	}
 }
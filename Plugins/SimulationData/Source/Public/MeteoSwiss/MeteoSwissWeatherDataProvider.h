@@ -38,6 +38,28 @@ public:
 	float Temperature;
 };
 
+USTRUCT(BlueprintType)
+struct FWindTableData : public FTableRowBase
+{
+	GENERATED_USTRUCT_BODY()
+
+public:
+
+	FWindTableData() : StationName(""), Speed(0), Direction(0)
+	{}
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Wind)
+	FString StationName;
+
+	/** Mean wind speed of the hour in m/s. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Wind)
+	float Speed;
+
+	/** The direction the wind blows from in degrees clockwise from north. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Wind)
+	float Direction;
+};
+
 /**
 * 
 */
@@ -49,6 +71,8 @@ class SIMULATIONDATA_API UMeteoSwissWeatherDataProvider : public USimulationWeat
 private:
 	TArray<FClimateData> ClimateData;
 
+	TArray<FWindData> WindData;
+
 public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Climate)
 	UDataTable* TemperatureData;
@@ -56,10 +80,18 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Climate)
 	UDataTable* PrecipitationData;
 
+	/** Optional hourly wind, the provider has no wind data if it is not set. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Climate)
+	UDataTable* WindTableData = nullptr;
+
 	/** The altitude of the measuring station in cm. */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Climate)
 	float StationAltitude;
 
+	virtual FClimateDataView GetClimateDataView() override final;
+
+	virtual FWindDataView GetWindDataView() override final;
+
 	virtual TResourceArray<FClimateData>* CreateRawClimateDataResourceArray(FDateTime StartTime, FDateTime EndTime) override final;
 
 	virtual void Initialize(FDateTime StartTime, FDateTime EndTime) override final;
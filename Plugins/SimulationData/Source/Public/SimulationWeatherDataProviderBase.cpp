@@ -2,5 +2,7 @@
 #include "SimulationData.h"
 #include "SimulationWeatherDataProviderBase.h"
 
-
-
+FWindDataView USimulationWeatherDataProviderBase::GetWindDataView()
+{
+	return FWindDataView();
+}
@@ -27,7 +27,13 @@ public:
 	/** Returns the altitude at which the measurements were taken. */
 	virtual float GetMeasurementAltitude() PURE_VIRTUAL(UMeteoSwissWeatherDataProvider::GetMeasurementAltitude(), return 0.0f;);
 
-	/** Creates a resource array containing all weather data. Caller is responsible of deleting the resource. */
+	/** Returns a view of all weather data which is owned by the provider. */
+	virtual FClimateDataView GetClimateDataView() PURE_VIRTUAL(USimulationWeatherDataProviderBase::GetClimateDataView, return FClimateDataView(););
+
+	/** Returns a view of the hourly wind which is owned by the provider, the view is empty if the provider has no wind data. */
+	virtual FWindDataView GetWindDataView();
+
+	/** Creates a resource array containing all weather data for the upload to the GPU. Caller is responsible of deleting the resource. */
 	virtual TResourceArray<FClimateData>* CreateRawClimateDataResourceArray(FDateTime StartTime, FDateTime EndTime) PURE_VIRTUAL(USimulationWeatherDataProviderBase::GetInterpolatedClimateData, return nullptr;);
 };
 
@@ -31,10 +31,18 @@ void UStochasticWeatherDataProvider::Initialize(FDateTime StartTime, FDateTime E
 	auto TimeSpanHours =  static_cast<int32>(TimeSpan.GetTotalHours());
 	FDateTime CurrentTime = StartTime;
 
-	ClimateData = std::vector<std::vector<FClimateData>>(TimeSpanHours, std::vector<FClimateData>(Resolution * Resolution));
+	ClimateData.Empty();
+	ClimateData.SetNum(TimeSpanHours * Resolution * Resolution);
 
 	auto Measurement = std::vector<std::vector<float>>(Resolution, std::vector<float>(Resolution));
 
+	// The wind uses its own random stream so it does not change the precipitation and temperature series
+	FRandomStream WindRandom(GetTypeHash(StartTime));
+	float WindDirection = PrevailingWindDirection;
+
+	WindData.Empty();
+	WindData.SetNum(TimeSpanHours);
+
 	for (int32 Hour = 0; Hour < TimeSpanHours; ++Hour)
 	{
 		for (int32 Y = 0; Y < Resolution; ++Y)
@@ -69,10 +77,18 @@ void UStochasticWeatherDataProvider::Initialize(FDateTime StartTime, FDateTime E
 				const float OvercastTemperatureOffset = State == WeatherState::WET ? -8 : 0;
 				const float T = BaseTemperature + SeasonalOffset + OvercastTemperatureOffset + TemperatureNoise[X][Y];
 
-				ClimateData[Hour][X + Y * Resolution] = FClimateData(Precipitation, T);
+				ClimateData[Hour * Resolution * Resolution + X + Y * Resolution] = FClimateData(Precipitation, T);
 			}
 		}
 
+		// Wind direction as a random walk which returns to the prevailing direction, the wind is stronger in wet hours
+		const float DirectionNoise = FMath::Sqrt(-2 * FMath::Loge(FMath::Max(WindRandom.FRand(), SMALL_NUMBER))) * FMath::Cos(2 * PI * WindRandom.FRand());
+		float DirectionDelta = PrevailingWindDirection - WindDirection;
+		DirectionDelta -= 360 * FMath::RoundToFloat(DirectionDelta / 360);
+		WindDirection += 0.1f * DirectionDelta + WindDirectionVariability * DirectionNoise;
+		const float WindSpeed = -MeanWindSpeed * FMath::Loge(FMath::Max(WindRandom.FRand(), SMALL_NUMBER)) * (State == WeatherState::WET ? 1.5f : 1.0f);
+		WindData[Hour] = FWindData::FromDirection(WindSpeed, WindDirection);
+
 		// Next state
 		WeatherState NextState;
 		switch (State)
@@ -95,21 +111,24 @@ void UStochasticWeatherDataProvider::Initialize(FDateTime StartTime, FDateTime E
 	}
 }
 
+FClimateDataView UStochasticWeatherDataProvider::GetClimateDataView()
+{
+	const int32 NumStations = Resolution * Resolution;
+	return FClimateDataView(ClimateData.GetData(), NumStations > 0 ? ClimateData.Num() / NumStations : 0, NumStations);
+}
+
+FWindDataView UStochasticWeatherDataProvider::GetWindDataView()
+{
+	return FWindDataView(WindData.GetData(), WindData.Num());
+}
+
 TResourceArray<FClimateData>* UStochasticWeatherDataProvider::CreateRawClimateDataResourceArray(FDateTime StartTime, FDateTime EndTime)
 {
 	auto TimeSpan = EndTime - StartTime;
 	int32 TotalHours = static_cast<int>(TimeSpan.GetTotalHours());
 
 	TResourceArray<FClimateData>* ClimateResourceArray = new TResourceArray<FClimateData>();
-	ClimateResourceArray->Reserve(TotalHours * Resolution * Resolution);
-
-	for (int32 Hour = 0; Hour < TotalHours; ++Hour)
-	{
-		for (int32 ClimateIndex = 0; ClimateIndex < Resolution * Resolution; ++ClimateIndex)
-		{
-			ClimateResourceArray->Add(ClimateData[Hour][ClimateIndex]);
-		}
-	}
+	ClimateResourceArray->Append(ClimateData.GetData(), FMath::Min(TotalHours * Resolution * Resolution, ClimateData.Num()));
 
 	return ClimateResourceArray;
 }
@@ -27,7 +27,11 @@ private:
 	/** State of the simulation. */
 	WeatherState State;
 	
-	std::vector<std::vector<FClimateData>> ClimateData;
+	/** The data of all stations stored hour by hour. */
+	TArray<FClimateData> ClimateData;
+
+	/** The wind of every hour. */
+	TArray<FWindData> WindData;
 public:
 	// @TODO fix probabilities
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Input", DisplayName = "P_I_W")
@@ -46,8 +50,24 @@ public:
 	/** Number of measuring stations per dimension. */
 	int32 Resolution = 10;
 
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Input")
+	/** Mean wind speed in m/s, the hourly speed follows an exponential distribution. */
+	float MeanWindSpeed = 4.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Input")
+	/** The prevailing direction the wind blows from in degrees clockwise from north. */
+	float PrevailingWindDirection = 270.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Input")
+	/** Standard deviation in degrees of the hourly change of the wind direction which is pulled back to the prevailing direction. */
+	float WindDirectionVariability = 10.0f;
+
 	UStochasticWeatherDataProvider();
 
+	virtual FClimateDataView GetClimateDataView() override final;
+
+	virtual FWindDataView GetWindDataView() override final;
+
 	virtual TResourceArray<FClimateData>* CreateRawClimateDataResourceArray(FDateTime StartTime, FDateTime EndTime) override final;
 
 	virtual void Initialize(FDateTime StartTime, FDateTime EndTime) override final;
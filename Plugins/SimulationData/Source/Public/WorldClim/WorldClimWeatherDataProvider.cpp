@@ -1,6 +1,11 @@
 #include "SimulationData.h"
 #include "WorldClimWeatherDataProvider.h"
 
+FClimateDataView UWorldClimWeatherDataProvider::GetClimateDataView()
+{
+	return FClimateDataView();
+}
+
 TResourceArray<FClimateData>* UWorldClimWeatherDataProvider::CreateRawClimateDataResourceArray(FDateTime StartTime, FDateTime EndTime)
 {
 	return nullptr;
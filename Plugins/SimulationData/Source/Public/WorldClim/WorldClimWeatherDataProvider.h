@@ -19,6 +19,8 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Input")
 	TArray<UMonthlyWorldClimDataAsset*> MonthlyData;
 
+	virtual FClimateDataView GetClimateDataView() override final;
+
 	virtual TResourceArray<FClimateData>* CreateRawClimateDataResourceArray(FDateTime StartTime, FDateTime EndTime) override final;
 
 	virtual void Initialize(FDateTime StartTime, FDateTime EndTime) override final;